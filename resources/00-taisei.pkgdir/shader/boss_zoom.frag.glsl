@@ -25,7 +25,7 @@ vec3 sampleZoom(vec3 ca) {
 	const float threshold = 0.94;
 
 	if(all(greaterThan(z, vec3(threshold)))) {
-		result = texture(tex, texCoordRaw).rgb;
+		result = texture(tex, texCoord).rgb;
 	} else {
 		z = 4 * z * z * z;
 		z = tanh(z);
@@ -36,14 +36,14 @@ vec3 sampleZoom(vec3 ca) {
 		vec2 posB = distort(pos, z.b) + blur_orig;
 
 		result = vec3(
-			texture(tex, posR).r,
-			texture(tex, posG).g,
-			texture(tex, posB).b
+			texture(tex, r_transformTexCoord(posR)).r,
+			texture(tex, r_transformTexCoord(posG)).g,
+			texture(tex, r_transformTexCoord(posB)).b
 		);
 	}
 
 	#if 0
-	if(result == texture(tex, texCoordRaw).rgb) {
+	if(result == texture(tex, texCoord).rgb) {
 		result = vec3(1);
 	}
 	#endif
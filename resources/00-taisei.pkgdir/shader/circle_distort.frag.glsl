@@ -8,7 +8,7 @@ UNIFORM(1) vec2 viewport;
 UNIFORM(2) vec3 distortOriginRadius;
 
 void main(void) {
-	vec2 uv = texCoord;
+	vec2 uv = texCoordRaw;
 	vec2 uv_orig = uv;
 	vec2 distort_origin = distortOriginRadius.xy;
 	float dst = distortOriginRadius.z / length(uv * viewport - distort_origin);
@@ -22,5 +22,5 @@ void main(void) {
 	float m = log(1.0 + dst * dst);
 	uv = mix(uv_orig, uv, m);
 
-	fragColor = r_color * texture(tex, uv) * min(sqrt(m), 1.0);
+	fragColor = r_color * texture(tex, r_transformTexCoord(uv)) * min(sqrt(m), 1.0);
 }
@@ -8,7 +8,7 @@ void main(void) {
     gl_Position = r_projectionMatrix * r_modelViewMatrix * vec4(position, 1.0);
     v_rcpFrame = 1.0 / tex_size;
     fxaaCoords(
-		texCoordRawIn,
+		(r_textureMatrix * vec4(texCoordRawIn, 0.0, 1.0)).xy,
 		v_rcpFrame,
 		v_coordNW,
 		v_coordNE,
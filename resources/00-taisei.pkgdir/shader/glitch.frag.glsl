@@ -1,5 +1,6 @@
 #version 330 core
 
+#include "lib/render_context.glslh"
 #include "interface/standard.glslh"
 
 UNIFORM(1) float frames;
@@ -11,7 +12,7 @@ float f(float x) {
 }
 
 void main(void) {
-	vec2 p = texCoord;
+	vec2 p = texCoordRaw;
 
 	float t = frames / 54.3123;
 	float ft = f(t);
@@ -23,5 +24,5 @@ void main(void) {
 	p.x -= strength * 0.5 * g * s * pulse * ft;
 	p = clamp(p, 0.0, 1.0);
 
-	fragColor = texture(tex, p);
+	fragColor = texture(tex, r_transformTexCoord(p));
 }
@@ -0,0 +1,20 @@
+#version 330
+
+#include "lib/render_context.glslh"
+#include "interface/pbr.glslh"
+
+// Model-space translation of each instance, see pbr_draw_model_instanced()
+UNIFORM(28) vec3 instance_offsets[PBR_MAX_INSTANCES];
+
+void main(void) {
+	vec3 position_instanced = position + instance_offsets[gl_InstanceID];
+
+	pos = (r_modelViewMatrix * vec4(position_instanced, 1.0)).xyz;
+	normal = normalize(mat3(r_modelViewMatrix)*normalIn);
+	tangent = normalize(mat3(r_modelViewMatrix)*tangentIn.xyz);
+	bitangent = normalize(mat3(r_modelViewMatrix)*cross(normalIn.xyz, tangentIn.xyz)*tangentIn.w);
+
+	gl_Position = r_projectionMatrix * vec4(pos, 1.0);
+	texCoord = (r_textureMatrix * vec4(texCoordRawIn, 0.0, 1.0)).xy;
+	texCoordRaw = texCoordRawIn;
+}
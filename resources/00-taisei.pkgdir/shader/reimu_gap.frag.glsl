@@ -37,7 +37,7 @@ void main(void) {
 		fragColor = vec4(0);
 	}
 
-	vec2 frag_loc = texCoord * viewport;
+	vec2 frag_loc = texCoordRaw * viewport;
 
 	#ifdef BBOX_TEST
 	float gap_bbox = max(gap_size.x, gap_size.y);
@@ -73,7 +73,7 @@ void main(void) {
 			vec2 next_gap = gaps[link];
 			float next_gap_angle = gap_angles[link];
 
-			vec2 l = texCoord * viewport;
+			vec2 l = texCoordRaw * viewport;
 			l.y = viewport.y - l.y;
 
 			fragColor = mix(fragColor, vec4(float(i&1), i/float(NUM_GAPS-1), 1-i/float(NUM_GAPS-1), 1), line_segment(l, gap, next_gap, 1));
@@ -6,7 +6,8 @@
 
 void main(void) {
 	gl_Position = r_projectionMatrix * r_modelViewMatrix * vec4(position, 1.0);
-	texCoord = (r_textureMatrix * vec4(texCoordRawIn, 0.0, 1.0)).xy;
+	texCoord = r_transformTexCoord(texCoordRawIn);
+	texCoordRaw = texCoordRawIn;
 
     for(int i = 0; i < NUM_GAPS; ++i) {
 		vec2 gap = gaps[i];
@@ -14,12 +15,12 @@ void main(void) {
 		int link = gap_links[i];
 		vec2 next_gap = gaps[link];
 		float next_gap_angle = gap_angles[link];
-		vec2 tc = texCoord * viewport;
+		vec2 tc = texCoordRawIn * viewport;
 		tc -= gap.xy;
 		tc *= rot((next_gap_angle - gap_angle));
 		tc += next_gap.xy;
 		tc /= viewport;
-		gap_views[i] = tc;
+		gap_views[i] = r_transformTexCoord(tc);
 		gap_rotations[i] = vec4(rot(gap_angle));
 	}
 }
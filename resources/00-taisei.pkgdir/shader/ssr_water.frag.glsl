@@ -7,6 +7,7 @@
 
 UNIFORM(5) float wave_height;
 UNIFORM(6) sampler2D water_noisetex;
+UNIFORM(7) vec2 ss_texcoord_scale;  // maps the viewport onto the screen textures
 
 #include "lib/water.glslh"
 
@@ -14,7 +15,8 @@ const int steps = 10;
 
 vec3 pos_to_texcoord(vec3 pos) {
 	vec4 tmp = r_screenSpaceProjectionMatrix * vec4(pos, 1);
-	return tmp.xyz / tmp.w;
+	tmp.xyz /= tmp.w;
+	return vec3(tmp.xy * ss_texcoord_scale, tmp.z);
 }
 
 vec3 trace_screenspace_reflection(vec3 pos, vec3 n, sampler2D screen_depth, sampler2D screen_color) {
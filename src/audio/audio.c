@@ -9,6 +9,7 @@
 #include "audio.h"
 
 #include "backend.h"
+#include "dynarray.h"
 #include "events.h"
 #include "global.h"
 #include "resource/bgm.h"
@@ -38,6 +39,8 @@ struct SFX {
 
 static struct {
 	ht_str2int_t sfx_volumes;
+	DYNAMIC_ARRAY(SFX*) active_loops;  // sounds with looping == true
+	SDL_AtomicInt sfx_generation;      // bumped whenever an SFX is destroyed; invalidates SFXHandles
 	uint32_t *chan_play_ids;
 	uint32_t play_counter;
 	int sfx_chan_first, sfx_chan_last;
@@ -115,6 +118,7 @@ void audio_init(void) {
 	audio.sfx_chan_first = INT_MAX;
 	audio.sfx_chan_last = INT_MIN;
 	audio.sfx_enabled = true;
+	SDL_SetAtomicInt(&audio.sfx_generation, 1);
 
 	bool have_chans = false;
 
@@ -134,6 +138,7 @@ void audio_shutdown(void) {
 	events_unregister_handler(audio_config_updated);
 	B.shutdown();
 	ht_destroy(&audio.sfx_volumes);
+	dynarray_free_data(&audio.active_loops);
 }
 
 bool audio_output_works(void) {
@@ -159,7 +164,28 @@ SFX *audio_sfx_load(const char *name, const char *path) {
 	return ALLOC(SFX, { .impl = impl });
 }
 
+static void untrack_sfx_loop_at(uint idx) {
+	// Order doesn't matter; swap with the last element
+	SFX *last = dynarray_get(&audio.active_loops, audio.active_loops.num_elements - 1);
+	dynarray_set(&audio.active_loops, idx, last);
+	audio.active_loops.num_elements--;
+}
+
+static void untrack_sfx_loop(SFX *sfx) {
+	dynarray_foreach(&audio.active_loops, uint i, SFX **psfx, {
+		if(*psfx == sfx) {
+			untrack_sfx_loop_at(i);
+			break;
+		}
+	});
+}
+
 void audio_sfx_destroy(SFX *sfx) {
+	if(sfx->looping) {
+		untrack_sfx_loop(sfx);
+	}
+
+	SDL_AddAtomicInt(&audio.sfx_generation, 1);
 	B.sfx_unload(sfx->impl);
 	mem_free(sfx);
 }
@@ -235,15 +261,34 @@ static SFXPlayID submit_play_sfx(
 	return register_sfx_playback(sfx, group, ch, loop);
 }
 
-static SFXPlayID play_sfx_internal(
-	const char *name, bool is_ui, int cooldown, bool replace
-) {
-	if(!audio_output_works() || is_skip_mode() || !audio.sfx_enabled) {
-		return 0;
+static SFX *resolve_sfx_handle(SFXHandle *h) {
+	uint gen = SDL_GetAtomicInt(&audio.sfx_generation);
+
+	if(LIKELY(h->generation == gen)) {
+		return h->sfx;
+	}
+
+	if(!h->hash) {
+		h->hash = ht_str2ptr_hash(h->name);
+	}
+
+	h->sfx = _res_get_data_prehashed(RES_SFX, h->name, h->hash, RESF_OPTIONAL);
+
+	// Don't cache failures, the sound may still get loaded later
+	if(h->sfx) {
+		h->generation = gen;
 	}
 
-	SFX *sfx = res_sfx(name);
+	return h->sfx;
+}
+
+static bool sfx_playback_allowed(void) {
+	return audio_output_works() && !is_skip_mode() && audio.sfx_enabled;
+}
 
+static SFXPlayID play_sfx_internal(
+	SFX *sfx, bool is_ui, int cooldown, bool replace
+) {
 	if(!sfx || (!is_ui && sfx->lastplayframe + 3 + cooldown >= global.frames)) {
 		return 0;
 	}
@@ -262,15 +307,33 @@ static SFXPlayID play_sfx_internal(
 }
 
 SFXPlayID play_sfx(const char *name) {
-	return play_sfx_internal(name, false, 0, false);
+	return play_sfx_ex(name, 0, false);
 }
 
 SFXPlayID play_sfx_ex(const char *name, int cooldown, bool replace) {
-	return play_sfx_internal(name, false, cooldown, replace);
+	if(!sfx_playback_allowed()) {
+		return 0;
+	}
+
+	return play_sfx_internal(res_sfx(name), false, cooldown, replace);
+}
+
+SFXPlayID play_sfx_handle(SFXHandle *h) {
+	return play_sfx_ex_handle(h, 0, false);
+}
+
+SFXPlayID play_sfx_ex_handle(SFXHandle *h, int cooldown, bool replace) {
+	if(!sfx_playback_allowed()) {
+		return 0;
+	}
+
+	return play_sfx_internal(resolve_sfx_handle(h), false, cooldown, replace);
 }
 
 void play_sfx_ui(const char *name) {
-	play_sfx_internal(name, true, 0, true);
+	if(sfx_playback_allowed()) {
+		play_sfx_internal(res_sfx(name), true, 0, true);
+	}
 }
 
 static void stop_sfx_fadeout(SFXPlayID sid, double fadeout) {
@@ -290,13 +353,7 @@ void replace_sfx(SFXPlayID sid, const char *name) {
 	play_sfx(name);
 }
 
-void play_sfx_loop(const char *name) {
-	if(!audio_output_works() || is_skip_mode() || !audio.sfx_enabled) {
-		return;
-	}
-
-	SFX *sfx = res_sfx(name);
-
+static void play_sfx_loop_internal(SFX *sfx) {
 	if(!sfx) {
 		return;
 	}
@@ -308,6 +365,7 @@ void play_sfx_loop(const char *name) {
 	}
 
 	sfx->looping = true;
+	dynarray_append(&audio.active_loops, sfx);
 
 	// If a previous loop is fading out, try to quickly fade it back in.
 	// Otherwise, start a new loop.
@@ -320,6 +378,18 @@ void play_sfx_loop(const char *name) {
 	}
 }
 
+void play_sfx_loop(const char *name) {
+	if(sfx_playback_allowed()) {
+		play_sfx_loop_internal(res_sfx(name));
+	}
+}
+
+void play_sfx_loop_handle(SFXHandle *h) {
+	if(sfx_playback_allowed()) {
+		play_sfx_loop_internal(resolve_sfx_handle(h));
+	}
+}
+
 static void stop_sfx_loop(SFX *sfx, double fadeout) {
 	SFXPlayID sid = sfx->per_group[CHANGROUP_SFX_GAME].last_loop_id;
 	AudioBackendChannel ch = get_playid_chan(sid);
@@ -329,20 +399,10 @@ static void stop_sfx_loop(SFX *sfx, double fadeout) {
 	}
 }
 
-static void *update_sounds_callback(const char *name, Resource *res, void *arg) {
-	bool reset = (intptr_t)arg;
+static void *reset_sound_callback(const char *name, Resource *res, void *arg) {
 	SFX *sfx = res->data;
 
-	if(UNLIKELY(!sfx)) {
-		return NULL;
-	}
-
-	if(sfx->looping && (reset || global.frames > sfx->lastplayframe + LOOPTIMEOUTFRAMES)) {
-		stop_sfx_loop(sfx, SFX_LOOPSTOP_FADETIME);
-		sfx->looping = false;
-	}
-
-	if(reset) {
+	if(LIKELY(sfx)) {
 		sfx->lastplayframe = 0;
 	}
 
@@ -350,11 +410,27 @@ static void *update_sounds_callback(const char *name, Resource *res, void *arg)
 }
 
 void reset_all_sfx(void) {
-	res_for_each(RES_SFX, update_sounds_callback, (void*)true);
+	dynarray_foreach_elem(&audio.active_loops, SFX **psfx, {
+		stop_sfx_loop(*psfx, SFX_LOOPSTOP_FADETIME);
+		(*psfx)->looping = false;
+	});
+
+	audio.active_loops.num_elements = 0;
+	res_for_each(RES_SFX, reset_sound_callback, NULL);
 }
 
 void update_all_sfx(void) {
-	res_for_each(RES_SFX, update_sounds_callback, (void*)false);
+	for(uint i = 0; i < audio.active_loops.num_elements;) {
+		SFX *sfx = dynarray_get(&audio.active_loops, i);
+
+		if(global.frames > sfx->lastplayframe + LOOPTIMEOUTFRAMES) {
+			stop_sfx_loop(sfx, SFX_LOOPSTOP_FADETIME);
+			sfx->looping = false;
+			untrack_sfx_loop_at(i);
+		} else {
+			++i;
+		}
+	}
 }
 
 void pause_all_sfx(void) {
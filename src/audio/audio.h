@@ -11,6 +11,7 @@
 
 #include "resource/sfx.h"
 #include "resource/bgm.h"
+#include "hashtable.h"
 
 typedef struct SFXImpl SFXImpl;
 
@@ -56,10 +57,27 @@ bool audio_sfx_set_enabled(bool enabled);
 
 // TODO modernize sfx API
 
+// A sound effect name resolved once and cached until any SFX is unloaded.
+// Use SFX_HANDLE("name") in hot paths instead of looking up by name on every call.
+typedef struct SFXHandle {
+	const char *name;
+	SFX *sfx;
+	hash_t hash;
+	uint generation;
+} SFXHandle;
+
+#define SFX_HANDLE(_name) ({ \
+	static SFXHandle _sfx_handle = { .name = "" _name "" }; \
+	&_sfx_handle; \
+})
+
 SFXPlayID play_sfx(const char *name) attr_nonnull(1);
 SFXPlayID play_sfx_ex(const char *name, int cooldown, bool replace) attr_nonnull(1);
 void play_sfx_loop(const char *name) attr_nonnull(1);
 void play_sfx_ui(const char *name) attr_nonnull(1);
+SFXPlayID play_sfx_handle(SFXHandle *h) attr_nonnull(1);
+SFXPlayID play_sfx_ex_handle(SFXHandle *h, int cooldown, bool replace) attr_nonnull(1);
+void play_sfx_loop_handle(SFXHandle *h) attr_nonnull(1);
 void stop_sfx(SFXPlayID sid);
 void replace_sfx(SFXPlayID sid, const char *name) attr_nonnull(2);
 void reset_all_sfx(void);
@@ -0,0 +1,261 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "benchmark.h"
+
+#include "coroutine/coroutine.h"
+#include "dynarray.h"
+#include "log.h"
+#include "memory/scratch.h"
+#include "rwops/rwops_stdiofp.h"
+#include "stageobjects.h"
+#include "util/strbuf.h"
+#include "version.h"
+
+typedef struct BenchmarkFrame {
+	hrtime_t logic_time;
+	hrtime_t render_time;
+	uint32_t num_allocs;
+	uint32_t num_switches;
+} BenchmarkFrame;
+
+static struct {
+	char *report_path;
+	DYNAMIC_ARRAY(BenchmarkFrame) frames;
+	MemStats mem_stats_prev;
+	uint64_t switches_prev;
+	uint64_t seed;
+	uint num_frames;
+	uint pool_peaks[NUM_STAGE_OBJECT_POOLS];
+	bool have_switch_stats;
+	bool render;
+	bool active;
+} bench;
+
+void benchmark_begin(const BenchmarkParams *params) {
+	assert(!bench.active);
+
+	bench.report_path = mem_strdup(params->report_path);
+	bench.seed = params->seed;
+	bench.num_frames = params->num_frames;
+	bench.render = params->render;
+	bench.active = true;
+
+	if(bench.num_frames) {
+		dynarray_ensure_capacity(&bench.frames, bench.num_frames);
+	}
+
+	mem_stats_enable(true);
+	mem_stats_get(&bench.mem_stats_prev);
+	bench.have_switch_stats = coroutines_get_switch_count(&bench.switches_prev);
+
+	log_info("Benchmark mode: seed 0x%016"PRIx64", %u frames, rendering %s",
+		bench.seed, bench.num_frames, bench.render ? "enabled" : "disabled");
+}
+
+bool benchmark_is_active(void) {
+	return bench.active;
+}
+
+bool benchmark_render_enabled(void) {
+	return bench.render;
+}
+
+uint64_t benchmark_get_seed(void) {
+	return bench.seed;
+}
+
+bool benchmark_frame_end(hrtime_t logic_time, hrtime_t render_time) {
+	if(!bench.active) {
+		return false;
+	}
+
+	if(bench.num_frames && bench.frames.num_elements >= bench.num_frames) {
+		// Still unwinding after the last requested frame
+		return true;
+	}
+
+	MemStats mstats;
+	mem_stats_get(&mstats);
+
+	uint64_t switches = 0;
+	coroutines_get_switch_count(&switches);
+
+	dynarray_append(&bench.frames, {
+		.logic_time = logic_time,
+		.render_time = render_time,
+		.num_allocs = mstats.num_allocs - bench.mem_stats_prev.num_allocs,
+		.num_switches = switches - bench.switches_prev,
+	});
+
+	bench.mem_stats_prev = mstats;
+	bench.switches_prev = switches;
+
+	for(int i = 0; i < NUM_STAGE_OBJECT_POOLS; ++i) {
+		bench.pool_peaks[i] = max(bench.pool_peaks[i], stage_objects.pools.as_array[i].num_used);
+	}
+
+	return bench.num_frames && bench.frames.num_elements >= bench.num_frames;
+}
+
+static int cmp_hrtime(const void *a, const void *b) {
+	hrtime_t ta = *(const hrtime_t*)a;
+	hrtime_t tb = *(const hrtime_t*)b;
+	return (ta > tb) - (ta < tb);
+}
+
+static int cmp_u32(const void *a, const void *b) {
+	uint32_t ua = *(const uint32_t*)a;
+	uint32_t ub = *(const uint32_t*)b;
+	return (ua > ub) - (ua < ub);
+}
+
+#define PERCENTILE(sorted, n, p) ((sorted)[min((n) - 1, (size_t)((n) * (p)))])
+
+static void write_time_stats(StringBuffer *buf, const char *name, size_t n, hrtime_t sorted[n]) {
+	double to_ms = 1000.0 / HRTIME_RESOLUTION;
+	hrtime_t total = 0;
+
+	for(size_t i = 0; i < n; ++i) {
+		total += sorted[i];
+	}
+
+	strbuf_printf(buf,
+		"\t\t\"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"total\": %.4f}",
+		name,
+		total * to_ms / n,
+		PERCENTILE(sorted, n, 0.50) * to_ms,
+		PERCENTILE(sorted, n, 0.90) * to_ms,
+		PERCENTILE(sorted, n, 0.99) * to_ms,
+		sorted[n - 1] * to_ms,
+		total * to_ms
+	);
+}
+
+static void write_count_stats(StringBuffer *buf, const char *name, size_t n, uint32_t sorted[n]) {
+	uint64_t total = 0;
+
+	for(size_t i = 0; i < n; ++i) {
+		total += sorted[i];
+	}
+
+	strbuf_printf(buf,
+		"\t\t\"%s\": {\"mean\": %.2f, \"p50\": %u, \"p99\": %u, \"max\": %u, \"total\": %"PRIu64"}",
+		name,
+		(double)total / n,
+		PERCENTILE(sorted, n, 0.50),
+		PERCENTILE(sorted, n, 0.99),
+		sorted[n - 1],
+		total
+	);
+}
+
+static void benchmark_write_report(SDL_IOStream *out) {
+	MemArena *scratch = acquire_scratch_arena();
+	StringBuffer buf = { scratch };
+	size_t n = bench.frames.num_elements;
+
+	strbuf_printf(&buf,
+		"{\n"
+		"\t\"version\": \"%s\",\n"
+		"\t\"build_type\": \"%s\",\n"
+		"\t\"seed\": %"PRIu64",\n"
+		"\t\"render\": %s,\n"
+		"\t\"frames\": %zu",
+		TAISEI_VERSION_FULL,
+		TAISEI_VERSION_BUILD_TYPE,
+		bench.seed,
+		bench.render ? "true" : "false",
+		n
+	);
+
+	if(n > 0) {
+		auto times = ARENA_ALLOC_ARRAY(scratch, n, hrtime_t);
+		auto counts = ARENA_ALLOC_ARRAY(scratch, n, uint32_t);
+
+		strbuf_cat(&buf, ",\n\t\"time_ms\": {\n");
+
+		for(size_t i = 0; i < n; ++i) {
+			times[i] = dynarray_get(&bench.frames, i).logic_time;
+		}
+		qsort(times, n, sizeof(*times), cmp_hrtime);
+		write_time_stats(&buf, "logic", n, times);
+		strbuf_cat(&buf, ",\n");
+
+		for(size_t i = 0; i < n; ++i) {
+			times[i] = dynarray_get(&bench.frames, i).render_time;
+		}
+		qsort(times, n, sizeof(*times), cmp_hrtime);
+		write_time_stats(&buf, "render", n, times);
+		strbuf_cat(&buf, "\n\t},\n\t\"per_frame\": {\n");
+
+		for(size_t i = 0; i < n; ++i) {
+			counts[i] = dynarray_get(&bench.frames, i).num_allocs;
+		}
+		qsort(counts, n, sizeof(*counts), cmp_u32);
+		write_count_stats(&buf, "allocations", n, counts);
+
+		if(bench.have_switch_stats) {
+			strbuf_cat(&buf, ",\n");
+
+			for(size_t i = 0; i < n; ++i) {
+				counts[i] = dynarray_get(&bench.frames, i).num_switches;
+			}
+			qsort(counts, n, sizeof(*counts), cmp_u32);
+			write_count_stats(&buf, "coroutine_switches", n, counts);
+		}
+
+		strbuf_cat(&buf, "\n\t}");
+	}
+
+	const char *const pool_names[] = {
+		#define GET_POOL_NAME(t, n) #n,
+		OBJECT_POOLS(GET_POOL_NAME)
+		#undef GET_POOL_NAME
+	};
+
+	strbuf_cat(&buf, ",\n\t\"entity_peaks\": {");
+
+	for(int i = 0; i < NUM_STAGE_OBJECT_POOLS; ++i) {
+		strbuf_printf(&buf, "%s\n\t\t\"%s\": %u", i ? "," : "", pool_names[i], bench.pool_peaks[i]);
+	}
+
+	strbuf_cat(&buf, "\n\t}\n}\n");
+
+	SDL_WriteIO(out, buf.start, buf.pos - buf.start);
+	release_scratch_arena(scratch);
+}
+
+void benchmark_finish(void) {
+	if(!bench.active) {
+		return;
+	}
+
+	bench.active = false;
+	mem_stats_enable(false);
+
+	SDL_IOStream *out;
+
+	if(!strcmp(bench.report_path, "-")) {
+		out = SDL_RWFromFP(stdout, false);
+	} else {
+		out = SDL_IOFromFile(bench.report_path, "w");
+	}
+
+	if(!out) {
+		log_sdl_error(LOG_ERROR, "SDL_IOFromFile");
+	} else {
+		benchmark_write_report(out);
+		SDL_CloseIO(out);
+		log_info("Benchmark report written to %s (%u frames)", bench.report_path, bench.frames.num_elements);
+	}
+
+	dynarray_free_data(&bench.frames);
+	mem_free(bench.report_path);
+	bench.report_path = NULL;
+}
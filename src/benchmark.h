@@ -0,0 +1,38 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "hirestime.h"
+
+/*
+ * Headless benchmark mode (see --benchmark).
+ *
+ * Runs a replay or a single stage without the frame limiter, collects per-frame timings and
+ * resource usage counters, and writes a JSON report on exit.
+ */
+
+typedef struct BenchmarkParams {
+	const char *report_path;  // "-" for stdout
+	uint64_t seed;
+	uint num_frames;          // 0 = until the replay or stage ends
+	bool render;
+} BenchmarkParams;
+
+void benchmark_begin(const BenchmarkParams *params) attr_nonnull_all;
+bool benchmark_is_active(void);
+bool benchmark_render_enabled(void);
+uint64_t benchmark_get_seed(void);
+
+// Record one main loop iteration. Returns true when the requested number of frames has been reached;
+// further iterations are not recorded.
+bool benchmark_frame_end(hrtime_t logic_time, hrtime_t render_time);
+
+// Writes the report and deactivates benchmark mode. Safe to call more than once.
+void benchmark_finish(void);
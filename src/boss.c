@@ -931,9 +931,9 @@ static DamageResult ent_damage_boss(EntityInterface *ent, const DamageInfo *dmg)
 	boss->damage_to_power_accum += damage;
 
 	if(boss->current->hp < boss->current->maxhp * 0.1) {
-		play_sfx_loop("hit1");
+		play_sfx_loop_handle(SFX_HANDLE("hit1"));
 	} else {
-		play_sfx_loop("hit0");
+		play_sfx_loop_handle(SFX_HANDLE("hit0"));
 	}
 
 	return DMG_RESULT_OK;
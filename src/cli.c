@@ -31,6 +31,10 @@ enum {
 	OPT_REREPLAY,
 	OPT_POPCACHE,
 	OPT_UNLOCKALL,
+	OPT_BENCHMARK,
+	OPT_BENCHMARK_FRAMES,
+	OPT_BENCHMARK_RENDER,
+	OPT_BENCHMARK_SEED,
 };
 
 static void print_help(struct TsOption* opts) {
@@ -83,6 +87,10 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 		{{"skip-to-bookmark",   required_argument,  0, 'b'},            "Fast-forward stage to a specific STAGE_BOOKMARK call"},
 		{{"unlock-all",         no_argument,        0, OPT_UNLOCKALL},  "Unlock all content"},
 #endif
+		{{"benchmark",          required_argument,  0, OPT_BENCHMARK},  "Benchmark the -R replay (or -p stage) headlessly, write a JSON report to REPORT (- for stdout)", "REPORT"},
+		{{"benchmark-frames",   required_argument,  0, OPT_BENCHMARK_FRAMES}, "Stop the benchmark after N frames", "N"},
+		{{"benchmark-render",   no_argument,        0, OPT_BENCHMARK_RENDER}, "Also run the rendering code while benchmarking"},
+		{{"benchmark-seed",     required_argument,  0, OPT_BENCHMARK_SEED}, "RNG seed for benchmarking a stage with -p", "SEED"},
 		{{"frameskip",          optional_argument,  0, 'f'},            "Disable FPS limiter, render only every FRAME frame", "FRAME"},
 		{{"credits",            no_argument,        0, 'c'},            "Show the credits scene and exit"},
 		{{"renderer",           required_argument,  0, OPT_RENDERER},   "Choose the rendering backend", renderer_list},
@@ -254,6 +262,28 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 			break;
 		case OPT_UNLOCKALL:
 			a->unlock_all = true;
+			break;
+		case OPT_BENCHMARK:
+			stralloc(&a->benchmark_report, optarg);
+			break;
+		case OPT_BENCHMARK_FRAMES:
+			a->benchmark_frames = strtol(optarg, &endptr, 10);
+
+			if(!*optarg || *endptr || a->benchmark_frames < 0) {
+				log_fatal("Invalid frame count '%s'", optarg);
+			}
+
+			break;
+		case OPT_BENCHMARK_RENDER:
+			a->benchmark_render = true;
+			break;
+		case OPT_BENCHMARK_SEED:
+			a->benchmark_seed = strtoull(optarg, &endptr, 0);
+
+			if(!*optarg || *endptr) {
+				log_fatal("Seed '%s' is not a number", optarg);
+			}
+
 			break;
 		case 'W':
 			a->width = strtol(optarg, NULL, 10);
@@ -300,6 +330,10 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 		log_fatal("--rereplay requires --replay or --verify-replay");
 	}
 
+	if(a->benchmark_report && a->type != CLI_VerifyReplay && a->type != CLI_SelectStage) {
+		log_fatal("--benchmark requires --verify-replay or --play");
+	}
+
 	return 0;
 }
 
@@ -308,4 +342,6 @@ void free_cli_action(CLIAction *a) {
 	a->filename = NULL;
 	mem_free(a->out_replay);
 	a->out_replay = NULL;
+	mem_free(a->benchmark_report);
+	a->benchmark_report = NULL;
 }
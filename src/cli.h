@@ -28,6 +28,7 @@ typedef struct CLIAction CLIAction;
 struct CLIAction {
 	char *filename;
 	char *out_replay;
+	char *benchmark_report;
 	PlayerMode *plrmode;
 	CLIActionType type;
 	int stageid;
@@ -38,6 +39,9 @@ struct CLIAction {
 	bool unlock_all;
 	int width;
 	int height;
+	int benchmark_frames;
+	uint64_t benchmark_seed;
+	bool benchmark_render;
 };
 
 int cli_args(int argc, char **argv, CLIAction *a);
@@ -17,6 +17,25 @@ void coroutines_shutdown(void) {
 	cotask_global_shutdown();
 }
 
+bool coroutines_get_switch_count(uint64_t *count) {
+#ifdef CO_TASK_STATS
+	*count = STAT_VAL(num_switches_total);
+	return true;
+#else
+	*count = 0;
+	return false;
+#endif
+}
+
+bool coroutines_profile_dump(void) {
+#ifdef CO_TASK_PROFILE
+	cotask_profile_dump(true);
+	return true;
+#else
+	return false;
+#endif
+}
+
 #ifdef CO_TASK_STATS
 #include "video.h"
 #include "resource/font.h"
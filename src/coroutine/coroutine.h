@@ -12,3 +12,11 @@
 void coroutines_init(void);
 void coroutines_shutdown(void);
 void coroutines_draw_stats(void);
+
+// Total number of coroutine switches since startup.
+// Returns false if task statistics are not compiled in.
+bool coroutines_get_switch_count(uint64_t *count) attr_nonnull_all;
+
+// Log the coroutine CPU time accumulated so far, per task call site, sorted by cost.
+// Returns false if task profiling is not compiled in (see CO_TASK_PROFILE in cotask.h).
+bool coroutines_profile_dump(void);
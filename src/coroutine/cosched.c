@@ -20,6 +20,10 @@ CoTask *_cosched_new_task(CoSched *sched, CoTaskFunc func, void *arg, size_t arg
 	CoTask *task = cotask_new_internal(cotask_entry);
 	task->name = debug.label;
 
+#ifdef CO_TASK_PROFILE
+	task->profile_site = cotask_profile_site(&debug);
+#endif
+
 #ifdef CO_TASK_DEBUG
 	snprintf(task->debug_label, sizeof(task->debug_label), "#%i <%p> %s (%s:%i:%s)", task->unique_id, (void*)task, debug.label, debug.debug_info.file, debug.debug_info.line, debug.debug_info.func);
 #endif
@@ -66,6 +70,10 @@ uint cosched_run_tasks(CoSched *sched) {
 	}
 	TASK_DEBUG("---------------------------------------------------------------");
 
+#ifdef CO_TASK_PROFILE
+	cotask_profile_tick();
+#endif
+
 	return ran;
 }
 
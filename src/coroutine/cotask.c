@@ -14,6 +14,7 @@
 
 static CoTaskList task_pool;
 static koishi_coroutine_t *co_main;
+static uint32_t num_resumes;
 
 #ifdef CO_TASK_DEBUG
 size_t _cotask_debug_event_id;
@@ -155,9 +156,16 @@ static void estimate_stack_usage(CoTask *task) { }
 
 void cotask_global_init(void) {
 	co_main = koishi_active();
+#ifdef CO_TASK_PROFILE
+	cotask_profile_init();
+#endif
 }
 
 void cotask_global_shutdown(void) {
+#ifdef CO_TASK_PROFILE
+	cotask_profile_shutdown();
+#endif
+
 	for(CoTask *task; (task = alist_pop(&task_pool));) {
 		koishi_deinit(&task->ko);
 		mem_free(task);
@@ -225,6 +233,10 @@ CoTask *cotask_new_internal(koishi_entrypoint_t entry_point) {
 
 	task->data = NULL;
 
+#ifdef CO_TASK_PROFILE
+	task->profile_site = NULL;
+#endif
+
 #ifdef CO_TASK_DEBUG
 	snprintf(task->debug_label, sizeof(task->debug_label), "<unknown at %p; entry=%p>", (void*)task, *(void**)&entry_point);
 #endif
@@ -232,11 +244,21 @@ CoTask *cotask_new_internal(koishi_entrypoint_t entry_point) {
 	return task;
 }
 
+uint32_t cotask_get_resume_count(void) {
+	return num_resumes;
+}
+
 void *cotask_resume_internal(CoTask *task, void *arg) {
 	TASK_DEBUG_EVENT(ev);
+	++num_resumes;
 	TASK_DEBUG("[%zu] Resuming task %s", ev, task->debug_label);
 	STAT_VAL_ADD(num_switches_this_frame, 1);
+	STAT_VAL_ADD(num_switches_total, 1);
+#ifdef CO_TASK_PROFILE
+	arg = cotask_profile_resume(task, arg);
+#else
 	arg = koishi_resume(&task->ko, arg);
+#endif
 	TASK_DEBUG("[%zu] koishi_resume returned (%s)", ev, task->debug_label);
 	return arg;
 }
@@ -570,6 +592,7 @@ void *cotask_yield(void *arg) {
 	TASK_DEBUG_EVENT(ev);
 	// TASK_DEBUG("[%zu] Yielding from task %s", ev, task->debug_label);
 	STAT_VAL_ADD(num_switches_this_frame, 1);
+	STAT_VAL_ADD(num_switches_total, 1);
 	arg = koishi_yield(arg);
 	// TASK_DEBUG("[%zu] koishi_yield returned (%s)", ev, task->debug_label);
 	return arg;
@@ -16,6 +16,9 @@
 
 // #define CO_TASK_DEBUG
 
+// Per-call-site CPU time accounting, see cotask_profile.c
+// #define CO_TASK_PROFILE
+
 typedef struct CoTask CoTask;
 typedef LIST_ANCHOR(CoTask) CoTaskList;
 typedef void *(*CoTaskFunc)(void *arg, size_t argsize);
@@ -44,14 +47,30 @@ typedef struct CoTaskDebugInfo {
 #ifdef CO_TASK_DEBUG
 	DebugInfo debug_info;
 #endif
+#ifdef CO_TASK_PROFILE
+	const char *file;
+	uint line;
+#endif
 } CoTaskDebugInfo;
 
 #ifdef CO_TASK_DEBUG
-	#define COTASK_DEBUG_INFO(label) ((CoTaskDebugInfo) { (label), _DEBUG_INFO_INITIALIZER_ })
+	#define _COTASK_DEBUG_INFO_DEBUG_ .debug_info = _DEBUG_INFO_INITIALIZER_,
+#else
+	#define _COTASK_DEBUG_INFO_DEBUG_
+#endif
+
+#ifdef CO_TASK_PROFILE
+	#define _COTASK_DEBUG_INFO_PROFILE_ .file = _TAISEI_SRC_FILE, .line = __LINE__,
 #else
-	#define COTASK_DEBUG_INFO(label) ((CoTaskDebugInfo) { (label) })
+	#define _COTASK_DEBUG_INFO_PROFILE_
 #endif
 
+#define COTASK_DEBUG_INFO(_label) ((CoTaskDebugInfo) { \
+	.label = (_label), \
+	_COTASK_DEBUG_INFO_DEBUG_ \
+	_COTASK_DEBUG_INFO_PROFILE_ \
+})
+
 typedef struct CoSched CoSched;
 
 void cotask_free(CoTask *task);
@@ -72,6 +91,7 @@ void *cotask_malloc(CoTask *task, size_t size) attr_returns_allocated attr_mallo
 EntityInterface *cotask_host_entity(CoTask *task, size_t ent_size, EntityType ent_type) attr_nonnull_all attr_returns_allocated;
 void cotask_host_events(CoTask *task, uint num_events, CoEvent events[num_events]) attr_nonnull_all;
 CoSched *cotask_get_sched(CoTask *task);
+uint32_t cotask_get_resume_count(void);  // Incremented every time any task is resumed
 const char *cotask_get_name(CoTask *task) attr_nonnull(1);
 
 BoxedTask cotask_box(CoTask *task);
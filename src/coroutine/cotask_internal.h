@@ -48,6 +48,7 @@ enum {
 };
 
 typedef struct CoTaskData CoTaskData;
+typedef struct CoTaskProfileSite CoTaskProfileSite;
 
 struct CoTask {
 	LIST_INTERFACE(CoTask);
@@ -59,6 +60,10 @@ struct CoTask {
 	uint32_t unique_id;
 	const char *name;
 
+	#ifdef CO_TASK_PROFILE
+	CoTaskProfileSite *profile_site;
+	#endif
+
 	char _end[0];
 
 	#ifdef CO_TASK_DEBUG
@@ -71,6 +76,7 @@ typedef struct CoTaskStats {
 	size_t num_tasks_allocated;
 	size_t num_tasks_in_use;
 	size_t num_switches_this_frame;
+	uint64_t num_switches_total;
 	size_t peak_stack_usage;
 } CoTaskStats;
 extern CoTaskStats cotask_stats;
@@ -154,6 +160,15 @@ typedef struct CoTaskInitData {
 void cotask_global_init(void);
 void cotask_global_shutdown(void);
 
+#ifdef CO_TASK_PROFILE
+void cotask_profile_init(void);
+void cotask_profile_shutdown(void);
+CoTaskProfileSite *cotask_profile_site(const CoTaskDebugInfo *debug) attr_nonnull_all attr_returns_nonnull;
+void *cotask_profile_resume(CoTask *task, void *arg) attr_nonnull(1);
+void cotask_profile_dump(bool totals);
+void cotask_profile_tick(void);
+#endif
+
 CoTask *cotask_new_internal(koishi_entrypoint_t entry_point);
 void *cotask_resume_internal(CoTask *task, void *arg);
 CoTask *cotask_unbox_notnull(BoxedTask box);
@@ -0,0 +1,222 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "coroutine/cotask_internal.h"
+
+#ifdef CO_TASK_PROFILE
+
+#include "dynarray.h"
+#include "hashtable.h"
+#include "hirestime.h"
+#include "log.h"
+#include "util/env.h"
+#include "util/miscmath.h"
+
+/*
+ * CPU time is charged to the call site that spawned a task (task name + INVOKE_* location).
+ * Tasks resume each other synchronously (INVOKE_TASK, event signals, cancellation), so every
+ * resume only gets charged its own time: the time spent in nested resumes is subtracted from
+ * the outer one. All of this only ever runs on the main thread.
+ */
+
+typedef struct CoTaskProfileCounters {
+	hrtime_t time;
+	hrtime_t peak;
+	uint64_t resumes;
+	uint64_t spawns;
+} CoTaskProfileCounters;
+
+struct CoTaskProfileSite {
+	CoTaskProfileSite *next;            // all sites
+	CoTaskProfileSite *next_same_label; // sites sharing a label pointer
+	const char *label;
+	const char *file;
+	uint line;
+
+	CoTaskProfileCounters window;  // since the last periodic dump
+	CoTaskProfileCounters total;   // up to the last periodic dump
+};
+
+static struct {
+	ht_ptr2ptr_t sites_by_label;
+	CoTaskProfileSite *sites;
+	CoTaskProfileSite unnamed;
+	hrtime_t nested_time;
+	hrtime_t dump_interval;
+	hrtime_t next_dump;
+} profile;
+
+void cotask_profile_init(void) {
+	ht_create(&profile.sites_by_label);
+	profile.unnamed = (CoTaskProfileSite) {
+		.label = "<unnamed>",
+		.file = "?",
+	};
+	profile.sites = &profile.unnamed;
+	profile.nested_time = 0;
+
+	int interval = env_get("TAISEI_COTASK_PROFILE_INTERVAL", 0);
+	profile.dump_interval = interval > 0 ? interval * HRTIME_RESOLUTION : 0;
+	profile.next_dump = time_get() + profile.dump_interval;
+
+	log_info("Coroutine profiling enabled");
+}
+
+void cotask_profile_shutdown(void) {
+	cotask_profile_dump(true);
+
+	for(CoTaskProfileSite *s = profile.sites, *next; s; s = next) {
+		next = s->next;
+
+		if(s != &profile.unnamed) {
+			mem_free(s);
+		}
+	}
+
+	ht_destroy(&profile.sites_by_label);
+	profile.sites = NULL;
+}
+
+CoTaskProfileSite *cotask_profile_site(const CoTaskDebugInfo *debug) {
+	if(!debug->label) {
+		return &profile.unnamed;
+	}
+
+	CoTaskProfileSite *first = ht_get(&profile.sites_by_label, (void*)debug->label, NULL);
+
+	for(CoTaskProfileSite *s = first; s; s = s->next_same_label) {
+		if(s->line == debug->line && (s->file == debug->file || !strcmp(s->file, debug->file))) {
+			++s->window.spawns;
+			return s;
+		}
+	}
+
+	auto s = ALLOC(CoTaskProfileSite, {
+		.next = profile.sites,
+		.next_same_label = first,
+		.label = debug->label,
+		.file = debug->file,
+		.line = debug->line,
+		.window.spawns = 1,
+	});
+
+	profile.sites = s;
+	ht_set(&profile.sites_by_label, (void*)debug->label, s);
+	return s;
+}
+
+void *cotask_profile_resume(CoTask *task, void *arg) {
+	CoTaskProfileSite *site = task->profile_site ?: &profile.unnamed;
+	hrtime_t outer_nested_time = profile.nested_time;
+	profile.nested_time = 0;
+
+	hrtime_t start = time_get();
+	arg = koishi_resume(&task->ko, arg);
+	hrtime_t elapsed = time_get() - start;
+
+	hrtime_t self = elapsed - profile.nested_time;
+	site->window.time += self;
+	site->window.peak = max(site->window.peak, self);
+	++site->window.resumes;
+
+	profile.nested_time = outer_nested_time + elapsed;
+	return arg;
+}
+
+static void merge_counters(CoTaskProfileCounters *dst, const CoTaskProfileCounters *src) {
+	dst->time += src->time;
+	dst->peak = max(dst->peak, src->peak);
+	dst->resumes += src->resumes;
+	dst->spawns += src->spawns;
+}
+
+typedef struct ProfileRow {
+	CoTaskProfileSite *site;
+	CoTaskProfileCounters counters;
+} ProfileRow;
+
+static int cmp_rows(const void *a, const void *b) {
+	const ProfileRow *ra = a;
+	const ProfileRow *rb = b;
+	return (ra->counters.time < rb->counters.time) - (ra->counters.time > rb->counters.time);
+}
+
+static double to_ms(hrtime_t t) {
+	return t / (double)(HRTIME_RESOLUTION / 1000);
+}
+
+void cotask_profile_dump(bool totals) {
+	if(!profile.sites) {
+		return;
+	}
+
+	DYNAMIC_ARRAY(ProfileRow) rows = {};
+	hrtime_t sum = 0;
+
+	for(CoTaskProfileSite *s = profile.sites; s; s = s->next) {
+		ProfileRow row = { s, s->window };
+
+		if(totals) {
+			merge_counters(&row.counters, &s->total);
+		} else {
+			merge_counters(&s->total, &s->window);
+			s->window = (CoTaskProfileCounters) {};
+		}
+
+		if(row.counters.resumes > 0) {
+			sum += row.counters.time;
+			dynarray_append(&rows, row);
+		}
+	}
+
+	if(rows.num_elements == 0) {
+		dynarray_free_data(&rows);
+		return;
+	}
+
+	dynarray_qsort(&rows, cmp_rows);
+
+	log_info(
+		"Coroutine CPU time (%s): %.3f ms in %i call sites",
+		totals ? "total" : "since last dump", to_ms(sum), rows.num_elements
+	);
+	log_info("        time      %%   resumes    spawns   us/resume   peak us   task (site)");
+
+	dynarray_foreach_elem(&rows, ProfileRow *row, {
+		auto c = &row->counters;
+		log_info(
+			"%9.3f ms %6.2f %9"PRIu64" %9"PRIu64" %11.2f %9.1f   %s (%s:%u)",
+			to_ms(c->time),
+			sum ? 100.0 * c->time / sum : 0.0,
+			c->resumes,
+			c->spawns,
+			1000.0 * to_ms(c->time) / c->resumes,
+			1000.0 * to_ms(c->peak),
+			row->site->label,
+			row->site->file,
+			row->site->line
+		);
+	});
+
+	dynarray_free_data(&rows);
+}
+
+void cotask_profile_tick(void) {
+	if(!profile.dump_interval) {
+		return;
+	}
+
+	hrtime_t now = time_get();
+
+	if(now >= profile.next_dump) {
+		cotask_profile_dump(false);
+		profile.next_dump = now + profile.dump_interval;
+	}
+}
+
+#endif // CO_TASK_PROFILE
@@ -520,7 +520,10 @@ static void credits_draw(void) {
 	r_clear(BUFFER_ALL, RGBA(0, 0, 0, 1), 1);
 
 	r_enable(RCAP_DEPTH_TEST);
-	stage3d_draw(&stage_3d_context, 500, 2, (Stage3DSegment[]) { credits_skysphere_draw, credits_skysphere_pos, credits_towerwall_draw, credits_towerwall_pos });
+	stage3d_draw(&stage_3d_context, 500, 2, (Stage3DSegment[]) {
+		{ credits_skysphere_draw, credits_skysphere_pos },
+		{ credits_towerwall_draw, credits_towerwall_pos },
+	});
 	r_state_pop();
 	draw_framebuffer_tex(credits.fb, SCREEN_W, SCREEN_H);
 
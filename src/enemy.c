@@ -12,8 +12,10 @@
 #include "entity.h"
 #include "global.h"
 #include "list.h"
+#include "particle.h"
 #include "projectile.h"
 #include "resource/resource.h"
+#include "stage.h"
 #include "stageobjects.h"
 #include "util/glm.h"
 
@@ -30,6 +32,7 @@ Enemy *_enemy_attach_dbginfo(Enemy *e, DebugInfo *dbg) {
 #endif
 
 static void ent_draw_enemy(EntityInterface *ent);
+static bool ent_enemy_visual_bounds(EntityInterface *ent, Rect *out_bounds);
 static DamageResult ent_damage_enemy(EntityInterface *ienemy, const DamageInfo *dmg);
 
 static void fix_pos0_visual(Enemy *e) {
@@ -102,6 +105,7 @@ Enemy *create_enemy_p(EnemyList *enemies, cmplx pos, float hp) {
 
 	e->ent.draw_layer = LAYER_ENEMY;
 	e->ent.draw_func = ent_draw_enemy;
+	e->ent.visual_bounds_func = ent_enemy_visual_bounds;
 	e->ent.damage_func = ent_damage_enemy;
 
 	COEVENT_INIT_ARRAY(e->events);
@@ -114,11 +118,11 @@ Enemy *create_enemy_p(EnemyList *enemies, cmplx pos, float hp) {
 static void enemy_death_effect(cmplx pos) {
 	for(int i = 0; i < 10; i++) {
 		RNG_ARRAY(rng, 2);
-		PARTICLE(
+		FXPARTICLE(
 			.sprite = "flare",
 			.pos = pos,
 			.timeout = 10,
-			.draw_rule = pdraw_timeout_fade(1, 0),
+			.draw_rule = partdraw_timeout_fade(1, 0),
 			.move = move_linear(vrng_range(rng[0], 3, 13) * vrng_dir(rng[1])),
 		);
 	}
@@ -148,17 +152,22 @@ static void enemy_death_effect(cmplx pos) {
 	);
 }
 
+static bool is_piv_projectile(Projectile *p, void *arg) {
+	return p->type == PROJ_ENEMY && !(p->flags & PFLAG_NOCOLLISION);
+}
+
 static void *_delete_enemy(ListAnchor *enemies, List* enemy, void *arg) {
 	Enemy *e = (Enemy*)enemy;
 
 	if(e->hp <= 0 && !(e->flags & EFLAG_NO_DEATH_EXPLOSION)) {
-		play_sfx("enemydeath");
+		play_sfx_handle(SFX_HANDLE("enemydeath"));
 		enemy_death_effect(e->pos);
 
-		for(Projectile *p = global.projs.first; p; p = p->next) {
-			if(p->type == PROJ_ENEMY && !(p->flags & PFLAG_NOCOLLISION) && cabs(p->pos - e->pos) < 64) {
-				spawn_and_collect_item(e->pos, ITEM_PIV, 1);
-			}
+		// Spawning items doesn't touch projectiles, so counting first gives the same result
+		uint num_piv = stage_count_projectiles_in_circle((Circle) { e->pos, 64 }, is_piv_projectile, NULL);
+
+		for(uint i = 0; i < num_piv; ++i) {
+			spawn_and_collect_item(e->pos, ITEM_PIV, 1);
 		}
 	}
 
@@ -198,6 +207,24 @@ static void ent_draw_enemy(EntityInterface *ent) {
 	coevent_signal(&ENT_CAST(ent, Enemy)->events.draw);
 }
 
+static bool ent_enemy_visual_bounds(EntityInterface *ent, Rect *out_bounds) {
+	Enemy *e = ENT_CAST(ent, Enemy);
+
+	if(e->visual_radius <= 0) {
+		return false;
+	}
+
+	cmplx pos = enemy_visual_pos(e);
+	cmplx r = e->visual_radius * (1 + I);
+
+	*out_bounds = (Rect) {
+		.top_left = pos - r,
+		.bottom_right = pos + r,
+	};
+
+	return true;
+}
+
 bool enemy_is_vulnerable(Enemy *enemy) {
 	return !(enemy->flags & EFLAG_INVULNERABLE);
 }
@@ -263,9 +290,9 @@ static DamageResult ent_damage_enemy(EntityInterface *ienemy, const DamageInfo *
 	}
 
 	if(enemy->hp < enemy->spawn_hp * 0.1) {
-		play_sfx_loop("hit1");
+		play_sfx_loop_handle(SFX_HANDLE("hit1"));
 	} else {
-		play_sfx_loop("hit0");
+		play_sfx_loop_handle(SFX_HANDLE("hit0"));
 	}
 
 	return DMG_RESULT_OK;
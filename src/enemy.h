@@ -104,6 +104,10 @@ DEFINE_ENTITY_TYPE(Enemy, {
 
 	float max_viewport_dist;
 
+	// Radius around enemy_visual_pos() that everything drawn in response to the "draw" event stays
+	// within. Lets the enemy be skipped when it's outside of the viewport; 0 means unknown.
+	float visual_radius;
+
 	bool moving;
 
 	IF_ENEMY_DEBUG(
@@ -70,6 +70,11 @@ static cmplxf visual_pos(cmplx base_pos, const BaseEnemyVisual *visual) {
 	return clerpf(base_pos, visual->fakepos.pos, visual->fakepos.blendfactor);
 }
 
+// Radius of the circle enclosing the sprite, at any rotation
+static float sprite_visual_radius(const Sprite *spr) {
+	return 0.5f * cabsf(spr->extent.as_cmplx);
+}
+
 static void kill_projectile_after_task(Projectile *p) {
 	INVOKE_TASK_AFTER(&TASK_EVENTS(THIS_TASK)->finished, common_kill_projectile, ENT_BOX(p));
 }
@@ -144,6 +149,12 @@ static Enemy *make_fairy(FairyVisual *visual, EnemyCommonParams *pcommon, FairyP
 		.summon.progress = 1,
 	};
 
+	auto ani = pfairy->main_anim;
+
+	for(int i = 0; i < ani->sprite_count; ++i) {
+		e->visual_radius = max(e->visual_radius, sprite_visual_radius(ani->sprites[i]));
+	}
+
 	*pfairy->out = (FairyHandle) { ENT_BOX(e), visual };
 	return e;
 }
@@ -235,7 +246,8 @@ TASK(fairy_flame_emitter, {
 				.angle = M_PI/2 + rng_sreal() * M_PI/16,
 				.timeout = 50,
 				.move = move_towards(0, spawn_pos, 0.3),
-				.flags = PFLAG_MANUALANGLE,
+				// The loop above draws RNG for each live particle
+				.flags = PFLAG_MANUALANGLE | PFLAG_ALWAYSSPAWN,
 				.layer = visual->base.fakepos.blendfactor
 					? LAYER_ENEMY_PARTICLE_BACKGROUND
 					: LAYER_PARTICLE_MID,
@@ -547,6 +559,8 @@ static Enemy *make_swirl(SwirlVisual *visual, EnemyCommonParams *pcommon, SwirlP
 		.shader = res_shader("sprite_particle"),
 	};
 
+	e->visual_radius = sprite_visual_radius(visual->base.spr);
+
 	*pswirl->out = (SwirlHandle) { ENT_BOX(e), visual };
 	return e;
 }
@@ -580,14 +594,24 @@ SwirlHandle ecls_spawn_swirl(cmplx pos, const ItemCounts *item_drops) {
  * Entrances
  */
 
-static inline void entrance_util_set_flags(Enemy *e, EnemyFlag *tempflags) {
+typedef struct EntranceTempState {
+	EnemyFlag flags;
+	float visual_radius;
+} EntranceTempState;
+
+static inline void entrance_util_begin(Enemy *e, EntranceTempState *temp) {
 	EnemyFlag flags = EFLAG_NO_HIT | EFLAG_NO_HURT | EFLAG_INVULNERABLE;
-	*tempflags = flags & ~e->flags;
+	temp->flags = flags & ~e->flags;
 	e->flags |= flags;
+
+	// Entrances move and scale the visual arbitrarily, so it can't be culled meanwhile
+	temp->visual_radius = e->visual_radius;
+	e->visual_radius = 0;
 }
 
-static inline void entrance_util_restore_flags(Enemy *e, EnemyFlag *tempflags) {
-	e->flags &= ~*tempflags;
+static inline void entrance_util_end(Enemy *e, EntranceTempState *temp) {
+	e->flags &= ~temp->flags;
+	e->visual_radius = temp->visual_radius;
 }
 
 static void ecls_base_3d_move_in(
@@ -596,8 +620,8 @@ static void ecls_base_3d_move_in(
 	auto e = NOT_NULL(ENT_UNBOX(ent));
 	assert(duration > 0);
 
-	EnemyFlag tempflags;
-	entrance_util_set_flags(e, &tempflags);
+	EntranceTempState temp;
+	entrance_util_begin(e, &temp);
 
 	DrawLayer layer = e->ent.draw_layer;
 	e->ent.draw_layer = LAYER_ENEMY_BACKGROUND;
@@ -627,7 +651,7 @@ static void ecls_base_3d_move_in(
 		}
 	}
 
-	entrance_util_restore_flags(e, &tempflags);
+	entrance_util_end(e, &temp);
 	e->ent.draw_layer = layer;
 }
 
@@ -647,8 +671,8 @@ FairyHandle ecls_fairy_summon(FairyHandle fairy, int duration) {
 
 	assert(duration > 0);
 
-	EnemyFlag tempflags;
-	entrance_util_set_flags(e, &tempflags);
+	EntranceTempState temp;
+	entrance_util_begin(e, &temp);
 
 	DrawLayer elayer = e->ent.draw_layer;
 	e->ent.draw_layer = LAYER_NODRAW;
@@ -698,7 +722,7 @@ FairyHandle ecls_fairy_summon(FairyHandle fairy, int duration) {
 	}
 
 	visual->summon.progress = 1;
-	entrance_util_restore_flags(e, &tempflags);
+	entrance_util_end(e, &temp);
 
 	return fairy;
 }
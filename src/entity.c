@@ -30,6 +30,8 @@ static struct {
 		EntityDrawHookList pre_draw;
 		EntityDrawHookList post_draw;
 	} hooks;
+
+	EntityDrawStats draw_stats;
 } entities;
 
 static void add_hook(EntityDrawHookList *list, EntityDrawHookCallback cb, void *arg) {
@@ -112,6 +114,37 @@ static inline bool ent_is_drawable(EntityInterface *ent) {
 	return (ent->draw_layer & ~LAYER_LOW_MASK) > LAYER_NODRAW && ent->draw_func;
 }
 
+// Leeway for shaders that bleed slightly past the sprite quad, and for the stage 1 water distortion
+#define ENT_CULL_MARGIN 16
+
+static bool ent_is_visible(EntityInterface *ent) {
+	Rect bounds;
+
+	if(!ent->visual_bounds_func || !ent->visual_bounds_func(ent, &bounds)) {
+		return true;
+	}
+
+	return
+		rect_right(bounds)  >= -ENT_CULL_MARGIN &&
+		rect_bottom(bounds) >= -ENT_CULL_MARGIN &&
+		rect_left(bounds)   <= VIEWPORT_W + ENT_CULL_MARGIN &&
+		rect_top(bounds)    <= VIEWPORT_H + ENT_CULL_MARGIN;
+}
+
+static void ent_draw_single(EntityInterface *ent) {
+	if(!ent_is_visible(ent)) {
+		entities.draw_stats.culled++;
+		return;
+	}
+
+	entities.draw_stats.drawn++;
+	call_hooks(&entities.hooks.pre_draw, ent);
+	r_state_push();
+	ent->draw_func(ent);
+	r_state_pop();
+	call_hooks(&entities.hooks.post_draw, ent);
+}
+
 void ent_draw(EntityPredicate predicate) {
 	call_hooks(&entities.hooks.pre_draw, NULL);
 	dynarray_qsort(&entities.registered, ent_cmp);
@@ -122,11 +155,7 @@ void ent_draw(EntityPredicate predicate) {
 			ent->index = i;
 
 			if(ent_is_drawable(ent) && predicate(ent)) {
-				call_hooks(&entities.hooks.pre_draw, ent);
-				r_state_push();
-				ent->draw_func(ent);
-				r_state_pop();
-				call_hooks(&entities.hooks.post_draw, ent);
+				ent_draw_single(ent);
 			}
 		});
 	} else {
@@ -135,11 +164,7 @@ void ent_draw(EntityPredicate predicate) {
 			ent->index = i;
 
 			if(ent_is_drawable(ent)) {
-				call_hooks(&entities.hooks.pre_draw, ent);
-				r_state_push();
-				ent->draw_func(ent);
-				r_state_pop();
-				call_hooks(&entities.hooks.post_draw, ent);
+				ent_draw_single(ent);
 			}
 		});
 	}
@@ -147,6 +172,12 @@ void ent_draw(EntityPredicate predicate) {
 	call_hooks(&entities.hooks.post_draw, NULL);
 }
 
+EntityDrawStats ent_pop_draw_stats(void) {
+	auto stats = entities.draw_stats;
+	entities.draw_stats = (EntityDrawStats) {};
+	return stats;
+}
+
 DamageResult ent_damage(EntityInterface *ent, const DamageInfo *damage) {
 	if(ent->damage_func == NULL) {
 		return DMG_RESULT_INAPPLICABLE;
@@ -78,6 +78,9 @@ typedef struct DamageInfo {
 } DamageInfo;
 
 typedef void (*EntityDrawFunc)(EntityInterface *ent);
+// Computes a conservative bounding box, in viewport coordinates, of everything draw_func would draw
+// this frame. Returns false if that can't be determined; such entities are never culled.
+typedef bool (*EntityBoundsFunc)(EntityInterface *ent, Rect *out_bounds);
 typedef bool (*EntityPredicate)(EntityInterface *ent);
 typedef DamageResult (*EntityDamageFunc)(EntityInterface *target, const DamageInfo *damage);
 typedef void (*EntityDrawHookCallback)(EntityInterface *ent, void *arg);
@@ -86,6 +89,7 @@ typedef void (*EntityAreaDamageCallback)(EntityInterface *ent, cmplx ent_origin,
 #define ENTITY_INTERFACE_BASE(typename) struct { \
 	LIST_INTERFACE(typename); \
 	EntityDrawFunc draw_func; \
+	EntityBoundsFunc visual_bounds_func; \
 	EntityDamageFunc damage_func; \
 	drawlayer_t draw_layer; \
 	uint32_t spawn_id; \
@@ -134,6 +138,14 @@ void ent_shutdown(void);
 void ent_register(EntityInterface *ent, EntityType type) attr_nonnull(1);
 void ent_unregister(EntityInterface *ent) attr_nonnull(1);
 void ent_draw(EntityPredicate predicate);
+
+typedef struct EntityDrawStats {
+	uint drawn;
+	uint culled;
+} EntityDrawStats;
+
+// Returns the number of entities drawn and culled by ent_draw() since the previous call
+EntityDrawStats ent_pop_draw_stats(void);
 DamageResult ent_damage(EntityInterface *ent, const DamageInfo *damage) attr_nonnull(1, 2);
 void ent_area_damage(cmplx origin, float radius, const DamageInfo *damage, EntityAreaDamageCallback callback, void *callback_arg) attr_nonnull(3);
 void ent_area_damage_ellipse(Ellipse ellipse, const DamageInfo *damage, EntityAreaDamageCallback callback, void *callback_arg) attr_nonnull(2);
@@ -156,7 +168,8 @@ INLINE BoxedEntity _ent_box_Entity(EntityInterface *ent) {
 INLINE EntityInterface *_ent_unbox_Entity(BoxedEntity box) {
 	EntityInterface *e = box.ent;
 
-	if(e && e->spawn_id == box.spawn_id) {
+	// Registered entities never have a zero spawn_id; boxes of unregistered ones are always stale
+	if(e && box.spawn_id && e->spawn_id == box.spawn_id) {
 		return e;
 	}
 
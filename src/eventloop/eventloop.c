@@ -10,6 +10,7 @@
 #include "eventloop_private.h"
 
 #include "global.h"
+#include "profiler.h"
 #include "thread.h"
 #include "util.h"
 #include "vfs/public.h"
@@ -120,9 +121,10 @@ RenderFrameAction run_render_frame(LoopFrame *frame) {
 	r_framebuffer_clear(NULL, BUFFER_ALL, RGBA(0, 0, 0, 1), 1);
 	RenderFrameAction a = frame->render(frame->context);
 	assert(evloop.stack_ptr == stack_prev);
+	fpscounter_update(&global.fps.work);
 
 	if(a == RFRAME_SWAP) {
-		video_swap_buffers();
+		PROFILE_ZONE("Swap buffers", video_swap_buffers());
 	}
 
 	fpscounter_update(&global.fps.render);
@@ -7,8 +7,11 @@
  */
 
 #include "eventloop_private.h"
+#include "frame_pacer.h"
 
+#include "benchmark.h"
 #include "global.h"
+#include "profiler.h"
 #include "util/env.h"
 
 #define SLEEP_DEBUG 0
@@ -35,6 +38,9 @@ void eventloop_run(void) {
 
 	bool sleep_enabled = env_get("TAISEI_FRAMELIMITER_SLEEP", true);
 	bool compensate = env_get("TAISEI_FRAMELIMITER_COMPENSATE", true);
+	bool deadline_pacing = sleep_enabled && env_get("TAISEI_FRAMELIMITER_DEADLINE", false);
+	bool late_input = env_get("TAISEI_FRAMELIMITER_LATE_INPUT", false);
+	hrtime_t late_delay = 0;
 	bool uncapped_rendering_env, uncapped_rendering;
 	shrtime_t sleep_margin = 0;
 
@@ -47,6 +53,15 @@ void eventloop_run(void) {
 	uncapped_rendering = uncapped_rendering_env;
 	uint32_t frame_num = 0;
 
+	FramePacer pacer;
+	frame_pacer_init(&pacer);
+
+	bool render_enabled = !global.is_replay_verification;
+
+	if(benchmark_is_active()) {
+		render_enabled = benchmark_render_enabled();
+	}
+
 begin_main_loop:
 	while(frame != NULL) {
 
@@ -56,13 +71,17 @@ void eventloop_run(void) {
 		}
 #endif
 
-		evloop.frame_times.start = time_get();
+		// A late-started frame still belongs to the slot that began late_delay ago
+		evloop.frame_times.start = time_get() - late_delay;
+		late_delay = 0;
 
 		attr_unused shrtime_t error = (shrtime_t)evloop.frame_times.start - (shrtime_t)evloop.frame_times.next;
 		SLEEP_DEBUG("Error: %lli", (long long)error);
 
 begin_frame:
 		global.fps.busy.last_update_time = time_get();
+		global.fps.work.last_update_time = global.fps.busy.last_update_time;
+		hrtime_t logic_start = global.fps.busy.last_update_time;
 		evloop.frame_times.target = frame->frametime;
 		++frame_num;
 
@@ -72,7 +91,7 @@ void eventloop_run(void) {
 			attr_unused uint32_t logic_frames = 0;
 
 			while(lframe_action != LFRAME_STOP && evloop.frame_times.next < evloop.frame_times.start) {
-				lframe_action = handle_logic(&frame, &evloop.frame_times);
+				PROFILE_ZONE("Logic", lframe_action = handle_logic(&frame, &evloop.frame_times));
 
 				if(!frame || lframe_action == LFRAME_STOP) {
 					goto begin_main_loop;
@@ -98,18 +117,33 @@ void eventloop_run(void) {
 				);
 			}
 		} else {
-			lframe_action = handle_logic(&frame, &evloop.frame_times);
+			PROFILE_ZONE("Logic", lframe_action = handle_logic(&frame, &evloop.frame_times));
 
 			if(!frame || lframe_action == LFRAME_STOP) {
 				goto begin_main_loop;
 			}
 		}
 
-		if((uncapped_rendering || !(frame_num % get_effective_frameskip())) && !global.is_replay_verification) {
-			run_render_frame(frame);
+		hrtime_t render_start = time_get();
+
+		if((uncapped_rendering || !(frame_num % get_effective_frameskip())) && render_enabled) {
+			PROFILE_ZONE("Render", run_render_frame(frame));
+		} else {
+			fpscounter_update(&global.fps.work);
 		}
 
+		hrtime_t render_end = time_get();
+
 		fpscounter_update(&global.fps.busy);
+		profiler_frame_end();
+
+		if(benchmark_frame_end(render_start - logic_start, render_end - render_start)) {
+			// The report is written by the regular shutdown path
+			taisei_quit();
+		}
+
+		// Up to the swap, which waits for vsync and would hide any headroom
+		frame_pacer_add_work_sample(&pacer, global.fps.work.last_update_time - logic_start);
 
 		if(uncapped_rendering || global.frameskip > 0 || global.is_replay_verification) {
 			continue;
@@ -137,15 +171,29 @@ void eventloop_run(void) {
 			}
 		}
 
+		// Wait past the start of the next slot, so that its input is polled later
+		if(late_input) {
+			late_delay = frame_pacer_late_start_delay(&pacer, evloop.frame_times.target);
+		}
+
+		hrtime_t wait_until = evloop.frame_times.next + late_delay;
+		ProfilerZone limiter_zone = profiler_zone_begin("Frame limiter");
+
+		if(deadline_pacing) {
+			frame_pacer_wait(&pacer, wait_until);
+			profiler_zone_end(limiter_zone);
+			continue;
+		}
+
 		if(sleep_enabled) {
-			shrtime_t remaining_time = (shrtime_t)evloop.frame_times.next - (shrtime_t)time_get();
+			shrtime_t remaining_time = (shrtime_t)wait_until - (shrtime_t)time_get();
 			shrtime_t sleep = max(remaining_time - sleep_margin, 0);
 
 			if(sleep > 0) {
 				SDL_DelayNS(sleep);
 
 				shrtime_t old_remaining_time = remaining_time;
-				remaining_time = (shrtime_t)evloop.frame_times.next - (shrtime_t)time_get();
+				remaining_time = (shrtime_t)wait_until - (shrtime_t)time_get();
 				shrtime_t slept = old_remaining_time - remaining_time;
 				shrtime_t overshoot = slept - sleep;
 				shrtime_t min_margin = overshoot * 2;
@@ -166,6 +214,11 @@ void eventloop_run(void) {
 			sleep_margin -= (sleep_margin >> 10);
 		}
 
-		while(time_get() < evloop.frame_times.next);
+		while(time_get() < wait_until);
+		profiler_zone_end(limiter_zone);
+	}
+
+	if(deadline_pacing) {
+		frame_pacer_report(&pacer, LOG_INFO);
 	}
 }
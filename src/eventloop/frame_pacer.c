@@ -0,0 +1,155 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "frame_pacer.h"
+
+#include "log.h"
+#include "util/crap.h"
+#include "util/miscmath.h"
+
+#ifdef TAISEI_BUILDCONF_HAVE_CLOCK_NANOSLEEP
+#include <errno.h>
+#include <time.h>
+#endif
+
+#define SPIN_TAIL_MIN     (HRTIME_RESOLUTION / 50000)  // 20 µs
+#define SPIN_TAIL_MAX     (HRTIME_RESOLUTION / 250)    // 4 ms
+#define SPIN_TAIL_INITIAL (HRTIME_RESOLUTION / 1000)   // 1 ms
+
+// Frames that end later than this after their deadline are counted as late
+#define LATE_THRESHOLD    (HRTIME_RESOLUTION / 4000)   // 250 µs
+
+#define REPORT_INTERVAL 3600
+
+// Headroom left between the expected end of a late-started frame and its deadline
+#define LATE_START_MARGIN (HRTIME_RESOLUTION / 1000)   // 1 ms
+
+void frame_pacer_init(FramePacer *pacer) {
+	*pacer = (FramePacer) {
+		.latency_dev = SPIN_TAIL_INITIAL / 4,
+		.spin_tail = SPIN_TAIL_INITIAL,
+	};
+}
+
+static void sleep_until(hrtime_t target) {
+	shrtime_t remaining = (shrtime_t)target - (shrtime_t)time_get();
+
+	if(remaining <= 0) {
+		return;
+	}
+
+#ifdef TAISEI_BUILDCONF_HAVE_CLOCK_NANOSLEEP
+	// time_get() has its own epoch; translate the target into CLOCK_MONOTONIC.
+	struct timespec ts;
+
+	if(clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+		uint64_t abs_ns = ts.tv_sec * SDL_NS_PER_SECOND + ts.tv_nsec;
+		abs_ns += remaining * (SDL_NS_PER_SECOND / HRTIME_RESOLUTION);
+		ts.tv_sec = abs_ns / SDL_NS_PER_SECOND;
+		ts.tv_nsec = abs_ns % SDL_NS_PER_SECOND;
+
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+		return;
+	}
+#endif
+
+	SDL_DelayNS(remaining * (SDL_NS_PER_SECOND / HRTIME_RESOLUTION));
+}
+
+static void learn_latency(FramePacer *pacer, shrtime_t latency) {
+	shrtime_t dev = latency > pacer->latency_avg ? latency - pacer->latency_avg : pacer->latency_avg - latency;
+	pacer->latency_avg += (latency - pacer->latency_avg) / 16;
+	pacer->latency_dev += (dev - pacer->latency_dev) / 16;
+
+	shrtime_t estimate = pacer->latency_avg + 4 * pacer->latency_dev;
+
+	if(latency > pacer->spin_tail) {
+		// Overslept into the deadline: back off right away, then let the estimate bring it down
+		pacer->spin_tail = latency + latency / 4;
+	} else {
+		pacer->spin_tail = max(estimate, pacer->spin_tail - pacer->spin_tail / 64);
+	}
+
+	pacer->spin_tail = clamp(pacer->spin_tail, (shrtime_t)SPIN_TAIL_MIN, (shrtime_t)SPIN_TAIL_MAX);
+}
+
+void frame_pacer_wait(FramePacer *pacer, hrtime_t deadline) {
+	hrtime_t now = time_get();
+	hrtime_t wake_time = deadline - pacer->spin_tail;
+
+	if(now < wake_time) {
+		sleep_until(wake_time);
+		hrtime_t woke = time_get();
+		pacer->stats.sleep_total += woke - now;
+		learn_latency(pacer, (shrtime_t)woke - (shrtime_t)wake_time);
+		now = woke;
+	}
+
+	hrtime_t spin_start = now;
+
+	while(now < deadline) {
+		SDL_CPUPauseInstruction();
+		now = time_get();
+	}
+
+	FramePacerStats *s = &pacer->stats;
+	hrtime_t lateness = now - deadline;
+	s->spin_total += now - spin_start;
+	s->lateness_total += lateness;
+	s->lateness_max = max(s->lateness_max, lateness);
+	s->late_frames += lateness > LATE_THRESHOLD;
+
+	++s->frames;
+
+#ifdef DEBUG
+	if(s->frames % REPORT_INTERVAL == 0) {
+		frame_pacer_report(pacer, LOG_DEBUG);
+	}
+#endif
+}
+
+static double to_us(double t) {
+	return t * (1e6 / HRTIME_RESOLUTION);
+}
+
+void frame_pacer_report(FramePacer *pacer, LogLevel lvl) {
+	FramePacerStats *s = &pacer->stats;
+
+	if(s->frames == 0) {
+		return;
+	}
+
+	log_custom(lvl,
+		"%"PRIu64" frames, %"PRIu64" late; "
+		"lateness avg %.1f us, max %.1f us; sleep avg %.1f us, spin avg %.1f us; "
+		"wakeup latency %.1f us ± %.1f us, spin tail %.1f us",
+		s->frames, s->late_frames,
+		to_us(s->lateness_total / (double)s->frames), to_us(s->lateness_max),
+		to_us(s->sleep_total / (double)s->frames), to_us(s->spin_total / (double)s->frames),
+		to_us(pacer->latency_avg), to_us(pacer->latency_dev), to_us(pacer->spin_tail)
+	);
+}
+
+void frame_pacer_add_work_sample(FramePacer *pacer, hrtime_t work_time) {
+	pacer->work_samples[pacer->num_work_samples++ % ARRAY_SIZE(pacer->work_samples)] = work_time;
+}
+
+hrtime_t frame_pacer_late_start_delay(FramePacer *pacer, hrtime_t frametime) {
+	if(pacer->num_work_samples < ARRAY_SIZE(pacer->work_samples)) {
+		return 0;
+	}
+
+	hrtime_t work = 0;
+
+	for(uint i = 0; i < ARRAY_SIZE(pacer->work_samples); ++i) {
+		work = max(work, pacer->work_samples[i]);
+	}
+
+	work += LATE_START_MARGIN + pacer->spin_tail;
+	return frametime > work ? frametime - work : 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "hirestime.h"
+#include "log.h"
+
+/*
+ * Waits for frame deadlines by sleeping until shortly before the deadline, then spinning
+ * through the rest. The spin tail is derived from the observed wakeup latency of the sleep,
+ * so on machines with precise timers almost the whole wait is spent sleeping.
+ *
+ * Where available, the sleep targets an absolute time (clock_nanosleep with TIMER_ABSTIME),
+ * so time spent between computing the deadline and entering the sleep isn't lost.
+ */
+
+typedef struct FramePacerStats {
+	uint64_t frames;
+	uint64_t late_frames;
+	hrtime_t lateness_total;
+	hrtime_t lateness_max;
+	hrtime_t sleep_total;
+	hrtime_t spin_total;
+} FramePacerStats;
+
+#define FRAME_PACER_WORK_SAMPLES 32
+
+typedef struct FramePacer {
+	FramePacerStats stats;
+	shrtime_t latency_avg;  // moving average of the wakeup latency
+	shrtime_t latency_dev;  // moving average of its absolute deviation
+	shrtime_t spin_tail;
+
+	// logic + render time of recent frames (up to the buffer swap), for late input sampling
+	hrtime_t work_samples[FRAME_PACER_WORK_SAMPLES];
+	uint num_work_samples;
+} FramePacer;
+
+void frame_pacer_init(FramePacer *pacer) attr_nonnull_all;
+void frame_pacer_wait(FramePacer *pacer, hrtime_t deadline) attr_nonnull_all;
+void frame_pacer_report(FramePacer *pacer, LogLevel lvl) attr_nonnull_all;
+
+/*
+ * Late input sampling: instead of starting a frame as soon as its slot begins, start it as late
+ * as recent frames allow, so that input is polled closer to the point where the frame is
+ * presented. These estimate how long the start can be delayed, based on the slowest recent frame.
+ */
+void frame_pacer_add_work_sample(FramePacer *pacer, hrtime_t work_time) attr_nonnull_all;
+hrtime_t frame_pacer_late_start_delay(FramePacer *pacer, hrtime_t frametime) attr_nonnull_all;
@@ -10,6 +10,7 @@
 
 #include "config.h"
 #include "global.h"
+#include "profiler.h"
 #include "transition.h"
 #include "video.h"
 
@@ -495,6 +496,11 @@ static bool events_handler_hotkeys(SDL_Event *event, void *arg) {
 	SDL_Scancode scan = event->key.scancode;
 	SDL_Keymod mod = event->key.mod;
 
+	if(scan == config_get_int(CONFIG_KEY_SCREENSHOT) && (mod & SDL_KMOD_CTRL) && profiler_enabled()) {
+		profiler_export_trace_auto();
+		return true;
+	}
+
 	if(scan == config_get_int(CONFIG_KEY_SCREENSHOT)) {
 		bool viewport_only = (mod & SDL_KMOD_ALT);
 		video_take_screenshot(viewport_only);
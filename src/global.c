@@ -8,6 +8,7 @@
 
 #include "global.h"
 
+#include "benchmark.h"
 #include "taskmanager.h"
 #include "util/env.h"
 #include "gamepad.h"
@@ -17,8 +18,10 @@ Global global;
 void init_global(CLIAction *cli) {
 	global = (typeof(global)) {};
 
-	rng_init(&global.rand_game, time(0));
-	rng_init(&global.rand_visual, time(0));
+	uint64_t seed = benchmark_is_active() ? benchmark_get_seed() : (uint64_t)time(0);
+	rng_init(&global.rand_game, seed);
+	rng_init(&global.rand_visual, seed);
+
 	rng_make_active(&global.rand_visual);
 
 	global.frameskip = cli->frameskip;
@@ -27,6 +30,9 @@ void init_global(CLIAction *cli) {
 		global.is_headless = true;
 		global.is_replay_verification = true;
 		global.frameskip = 1;
+	} else if(benchmark_is_active()) {
+		global.is_headless = true;
+		global.frameskip = 1;
 	} else if(global.frameskip) {
 		log_warn("FPS limiter disabled. Gotta go fast! (frameskip = %i)", global.frameskip);
 	}
@@ -40,6 +46,7 @@ void init_global(CLIAction *cli) {
 	fpscounter_reset(&global.fps.logic);
 	fpscounter_reset(&global.fps.render);
 	fpscounter_reset(&global.fps.busy);
+	fpscounter_reset(&global.fps.work);
 }
 
 // Inputdevice-agnostic method of checking whether a game control is pressed.
@@ -83,6 +83,7 @@ typedef struct {
 		FPSCounter logic;
 		FPSCounter render;
 		FPSCounter busy;
+		FPSCounter work;  // like busy, but excluding the buffer swap (which may wait for vsync)
 	} fps;
 
 	struct {
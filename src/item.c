@@ -19,6 +19,9 @@
 // distance to begin attracting the item towards the player.
 #define ITEM_GRAB_RADIUS 10
 
+// Vertical position of the indicator shown for items above the viewport
+#define ITEM_INDICATOR_Y 6
+
 static const char *item_sprite_name(ItemType type) {
 	static const char *const map[] = {
 		[ITEM_BOMB          - ITEM_FIRST] = "item/bomb",
@@ -89,7 +92,7 @@ void item_set_type(Item *item, ItemType type) {
 static void ent_draw_item(EntityInterface *ent) {
 	Item *i = ENT_CAST(ent, Item);
 
-	const int indicator_display_y = 6;
+	const int indicator_display_y = ITEM_INDICATOR_Y;
 	float y = im(i->pos);
 
 	ShaderCustomParams shader_params = { 1.0f };
@@ -126,6 +129,26 @@ static void ent_draw_item(EntityInterface *ent) {
 	});
 }
 
+static bool ent_item_visual_bounds(EntityInterface *ent, Rect *out_bounds) {
+	Item *i = ENT_CAST(ent, Item);
+	cmplx r = 0.5 * i->sprites.pickup->extent.as_cmplx;
+
+	*out_bounds = (Rect) {
+		.top_left = i->pos - r,
+		.bottom_right = i->pos + r,
+	};
+
+	// The offscreen indicator is pinned near the top edge
+	if(im(i->pos) < 0 && i->sprites.indicator) {
+		cmplx ir = 0.5 * i->sprites.indicator->extent.as_cmplx;
+		out_bounds->left = min(out_bounds->left, re(i->pos) - re(ir));
+		out_bounds->right = max(out_bounds->right, re(i->pos) + re(ir));
+		out_bounds->bottom = max(out_bounds->bottom, ITEM_INDICATOR_Y + im(ir));
+	}
+
+	return true;
+}
+
 Item *create_item(cmplx pos, cmplx v, ItemType type) {
 	if((re(pos) < 0 || re(pos) > VIEWPORT_W)) {
 		// we need this because we clamp the item position to the viewport boundary during motion
@@ -146,6 +169,7 @@ Item *create_item(cmplx pos, cmplx v, ItemType type) {
 	i->collecttime = 0;
 
 	i->ent.draw_func = ent_draw_item;
+	i->ent.visual_bounds_func = ent_item_visual_bounds;
 	ent_register(&i->ent, ENT_TYPE_ID(Item));
 
 	item_set_type(i, type);
@@ -327,30 +351,30 @@ void process_items(void) {
 				player_add_power(&global.plr, POWER_VALUE);
 				player_add_points(&global.plr, 25, item->pos);
 				player_extend_powersurge(&global.plr, PLR_POWERSURGE_POSITIVE_GAIN*3, PLR_POWERSURGE_NEGATIVE_GAIN*3);
-				play_sfx("item_generic");
+				play_sfx_handle(SFX_HANDLE("item_generic"));
 				break;
 			case ITEM_POWER_MINI:
 				player_add_power(&global.plr, POWER_VALUE_MINI);
 				player_add_points(&global.plr, 5, item->pos);
-				play_sfx("item_generic");
+				play_sfx_handle(SFX_HANDLE("item_generic"));
 				break;
 			case ITEM_SURGE:
 				player_extend_powersurge(&global.plr, PLR_POWERSURGE_POSITIVE_GAIN, PLR_POWERSURGE_NEGATIVE_GAIN);
 				player_add_points(&global.plr, 25, item->pos);
-				play_sfx("item_generic");
+				play_sfx_handle(SFX_HANDLE("item_generic"));
 				break;
 			case ITEM_POINTS:
 				player_add_points(&global.plr, round(global.plr.point_item_value * item->pickup_value), item->pos);
-				play_sfx("item_generic");
+				play_sfx_handle(SFX_HANDLE("item_generic"));
 				break;
 			case ITEM_PIV:
 				player_add_piv(&global.plr, 1, item->pos);
-				play_sfx("item_generic");
+				play_sfx_handle(SFX_HANDLE("item_generic"));
 				break;
 			case ITEM_VOLTAGE:
 				player_add_voltage(&global.plr, 1);
 				player_add_piv(&global.plr, 10, item->pos);
-				play_sfx("item_generic");
+				play_sfx_handle(SFX_HANDLE("item_generic"));
 				break;
 			case ITEM_LIFE:
 				player_add_lives(&global.plr, 1);
@@ -16,6 +16,7 @@
 	X(Enemy, __VA_ARGS__) \
 	X(Item, __VA_ARGS__) \
 	X(Laser, __VA_ARGS__) \
+	X(ParticleLayer, __VA_ARGS__) \
 	X(Player, __VA_ARGS__) \
 	X(PlayerIndicators, __VA_ARGS__) \
 	X(Projectile, __VA_ARGS__) \
@@ -13,6 +13,7 @@
 #include "config.h"
 #include "memory/allocator.h"
 #include "memory/arena.h"
+#include "profiler.h"
 #include "renderer/api.h"
 #include "util.h"
 #include "util/fbmgr.h"
@@ -503,6 +504,7 @@ static void laserdraw_commit(void) {
 		return;
 	}
 
+	ProfilerZone zone = profiler_zone_begin("Laser SDF passes");
 	dynarray_qsort(&ldraw.queue, laser_compare);
 
 	r_state_push();
@@ -523,6 +525,7 @@ static void laserdraw_commit(void) {
 	r_state_pop();
 
 	ldraw.queue.num_elements = 0;
+	profiler_zone_end(zone);
 }
 
 static void laserdraw_ent_predraw_hook(EntityInterface *ent, void *arg) {
@@ -734,24 +734,25 @@ static bool laser_collision(Laser *l, Player *plr) {
 	return false;
 }
 
+bool laser_bbox_intersects_rect(Laser *l, Rect rect) {
+	if(l->_internal.num_segments < 1) {
+		return false;
+	}
+
+	return rect_rect_intersect(rect, laser_bbox_rect(l), true, true);
+}
+
 bool laser_intersects_ellipse(Laser *l, Ellipse ellipse) {
 	// NOTE: This function does not take laser width into account.
 	// It also can't test culled parts of the laser, because culling
 	// is done at the quantization stage.
 	// But surely this won't ever be a problem, right…?
 
-	int num_segs = l->_internal.num_segments;
-
-	if(num_segs < 1) {
+	if(!laser_bbox_intersects_rect(l, ellipse_bbox(ellipse))) {
 		return false;
 	}
 
-	Rect e_bbox = ellipse_bbox(ellipse);
-	Rect l_bbox = laser_bbox_rect(l);
-
-	if(!rect_rect_intersect(e_bbox, l_bbox, true, true)) {
-		return false;
-	}
+	int num_segs = l->_internal.num_segments;
 
 	LaserSegment *segs = dynarray_get_ptr(&lintern.segments, l->_internal.segments_ofs);
 
@@ -73,6 +73,8 @@ void laser_make_static(Laser *l);
 void laser_charge(Laser *l, int t, float charge, float width);
 
 bool laser_intersects_circle(Laser *l, Circle circle);
+// Cheap conservative test against the bounding box computed during quantization
+bool laser_bbox_intersects_rect(Laser *l, Rect rect);
 bool laser_intersects_ellipse(Laser *l, Ellipse ellipse);
 
 typedef struct LaserSegment {
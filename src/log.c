@@ -27,14 +27,25 @@ typedef struct Logger {
 
 	FormatterObj formatter;
 	SDL_IOStream *out;
+	StringBuffer batch;  // only touched by the log queue thread
 	uint levels;
 } Logger;
 
-typedef struct QueuedLogEntry {
-	LIST_INTERFACE(struct QueuedLogEntry);
+// Must be a power of two
+#define LOG_QUEUE_NUM_SLOTS 1024
+#define LOG_QUEUE_SLOT_MSG_SIZE 256
+#define LOG_QUEUE_SLOT_THREAD_NAME_SIZE 32
+#define LOG_QUEUE_MAX_BATCH 64
+
+typedef struct LogQueueSlot {
+	// Vyukov-style sequence number: equals the slot's position when free,
+	// position + 1 when it holds a published entry.
+	SDL_AtomicInt seq;
 	LogEntry e;
-	char message[];
-} QueuedLogEntry;
+	char *long_message;
+	char thread_name[LOG_QUEUE_SLOT_THREAD_NAME_SIZE];
+	char message[LOG_QUEUE_SLOT_MSG_SIZE];
+} LogQueueSlot;
 
 typedef struct LogFilterEntry {
 	struct {
@@ -52,10 +63,17 @@ static struct {
 
 	struct {
 		Thread *thread;
+		LogQueueSlot *slots;
+		SDL_Semaphore *wakeup_sem;
+		SDL_AtomicInt head;
+		SDL_AtomicInt consumer_waiting;
+		SDL_AtomicInt num_dropped;
+		SDL_AtomicInt shutdown;
+
+		// Only used to synchronize log_sync() with the consumer
 		SDL_Mutex *mutex;
 		SDL_Condition *cond;
-		LIST_ANCHOR(QueuedLogEntry) queue;
-		int shutdown;
+		uint num_dispatched;
 	} queue;
 
 	DYNAMIC_ARRAY(LogFilterEntry) filters;
@@ -226,7 +244,7 @@ static LogLevel filter_entry(LogEntry *entry) {
 	return log_apply_level_diff(LOG_ALL, d);
 }
 
-static void log_dispatch(LogEntry *entry, StringBuffer *fmt_buf) {
+static void log_dispatch_internal(LogEntry *entry, StringBuffer *fmt_buf, bool batched) {
 	bool init = false;
 	LogLevel filter_lvlmask = LOG_ALL;
 
@@ -252,30 +270,90 @@ static void log_dispatch(LogEntry *entry, StringBuffer *fmt_buf) {
 				continue;
 			}
 
+			if(batched) {
+				// Accumulate; written out by log_queue_flush_batches()
+				l->formatter.format(&l->formatter, &l->batch, entry);
+				continue;
+			}
+
 			strbuf_clear(fmt_buf);
 			size_t slen = l->formatter.format(&l->formatter, fmt_buf, entry);
 			assert_nolog(fmt_buf->buf_size >= slen);
 			SDL_WriteIO(l->out, fmt_buf->start, slen);
 		}
 	}
+}
+
+static void log_dispatch(LogEntry *entry, StringBuffer *fmt_buf) {
+	log_dispatch_internal(entry, fmt_buf, false);
+}
+
+static bool log_queue_push(LogEntry *entry) {
+	const uint mask = LOG_QUEUE_NUM_SLOTS - 1;
+	uint pos = SDL_GetAtomicInt(&logging.queue.head);
+	LogQueueSlot *slot;
+
+	for(;;) {
+		slot = logging.queue.slots + (pos & mask);
+		int diff = (int)((uint)SDL_GetAtomicInt(&slot->seq) - pos);
+
+		if(diff == 0) {
+			if(SDL_CompareAndSwapAtomicInt(&logging.queue.head, pos, pos + 1)) {
+				break;
+			}
+		} else if(diff < 0) {
+			// Full
+			return false;
+		}
+
+		pos = SDL_GetAtomicInt(&logging.queue.head);
+	}
+
+	slot->e = *entry;
+
+	size_t msg_len = strlen(entry->message);
+
+	if(msg_len < sizeof(slot->message)) {
+		memcpy(slot->message, entry->message, msg_len + 1);
+		slot->e.message = slot->message;
+		slot->long_message = NULL;
+	} else {
+		slot->long_message = memcpy(mem_alloc(msg_len + 1), entry->message, msg_len + 1);
+		slot->e.message = slot->long_message;
+	}
+
+	if(entry->thread_name) {
+		strlcpy(slot->thread_name, entry->thread_name, sizeof(slot->thread_name));
+		slot->e.thread_name = slot->thread_name;
+	}
 
-	if(entry->thread) {
-		thread_decref(entry->thread);
+	SDL_SetAtomicInt(&slot->seq, pos + 1);
+	return true;
+}
+
+static void log_queue_wake_consumer(void) {
+	if(SDL_CompareAndSwapAtomicInt(&logging.queue.consumer_waiting, 1, 0)) {
+		SDL_SignalSemaphore(logging.queue.wakeup_sem);
 	}
 }
 
 static void log_dispatch_async(LogEntry *entry) {
 	for(Logger *l = logging.outputs; l; l = l->next) {
 		if(l->levels & entry->level) {
-			size_t msg_len = strlen(entry->message);
-			auto qle = ALLOC_FLEX(QueuedLogEntry, msg_len + 1);
-			memcpy(&qle->e, entry, sizeof(*entry));
-			memcpy(qle->message, entry->message, msg_len);
-			qle->e.message = qle->message;
-			SDL_LockMutex(logging.queue.mutex);
-			alist_append(&logging.queue.queue, qle);
-			SDL_BroadcastCondition(logging.queue.cond);
-			SDL_UnlockMutex(logging.queue.mutex);
+			while(!log_queue_push(entry)) {
+				if(!(entry->level & LOG_ALERT)) {
+					// Drop policy: chatty messages are discarded when the consumer can't keep up;
+					// the consumer reports how many were lost.
+					SDL_AddAtomicInt(&logging.queue.num_dropped, 1);
+					return;
+				}
+
+				// Never drop warnings and errors; wait for the consumer to make room.
+				SDL_SignalSemaphore(logging.queue.wakeup_sem);
+				SDL_DelayNS(50000);
+			}
+
+			log_queue_wake_consumer();
 			break;
 		}
 	}
@@ -318,10 +396,15 @@ static void log_internal(LogLevel lvl, const char *funcname, const char *filenam
 		.line = line,
 		.level = lvl,
 		.time = SDL_GetTicks(),
-		.thread = thread_get_current(),
 		.thread_id = thread_get_current_id(),
 	};
 
+	Thread *thread = thread_get_current();
+
+	if(thread) {
+		entry.thread_name = thread_get_name(thread);
+	}
+
 	CoTask *task = cotask_active();
 
 	if(task) {
@@ -329,10 +412,6 @@ static void log_internal(LogLevel lvl, const char *funcname, const char *filenam
 		entry.task_id = cotask_box(task).unique_id;
 	}
 
-	if(entry.thread) {
-		thread_incref(entry.thread);
-	}
-
 	if(logging.queue.thread) {
 		log_dispatch_async(&entry);
 	} else {
@@ -383,34 +462,121 @@ static void *delete_logger(List **loggers, List *logger, void *arg) {
 	return NULL;
 }
 
-static void *log_queue_thread(void *a) {
-	SDL_Mutex *mtx = logging.queue.mutex;
-	SDL_Condition *cond = logging.queue.cond;
+static LogQueueSlot *log_queue_peek(uint tail) {
+	LogQueueSlot *slot = logging.queue.slots + (tail & (LOG_QUEUE_NUM_SLOTS - 1));
+	int diff = (int)((uint)SDL_GetAtomicInt(&slot->seq) - (tail + 1));
+	return diff < 0 ? NULL : slot;
+}
+
+static void log_queue_release_slot(LogQueueSlot *slot, uint tail) {
+	mem_free(slot->long_message);
+	slot->long_message = NULL;
+	SDL_SetAtomicInt(&slot->seq, tail + LOG_QUEUE_NUM_SLOTS);
+}
+
+static void log_queue_flush_batches(void) {
+	for(Logger *l = logging.outputs; l; l = l->next) {
+		size_t len = l->batch.pos - l->batch.start;
+
+		if(len > 0) {
+			SDL_WriteIO(l->out, l->batch.start, len);
+			strbuf_clear(&l->batch);
+		}
+	}
+}
+
+static void log_queue_report_dropped(void) {
+	int num_dropped = SDL_SetAtomicInt(&logging.queue.num_dropped, 0);
+
+	if(num_dropped <= 0) {
+		return;
+	}
 
+	char msg[128];
+	snprintf(msg, sizeof(msg), "%i log messages dropped (queue overflow)", num_dropped);
+	Thread *self = thread_get_current();
+
+	LogEntry entry = {
+		.message = msg,
+		.file = _TAISEI_SRC_FILE,
+		.func = __func__,
+		.line = __LINE__,
+		.level = LOG_WARN,
+		.time = SDL_GetTicks(),
+		.thread_name = self ? thread_get_name(self) : NULL,
+		.thread_id = thread_get_current_id(),
+	};
+
+	log_dispatch_internal(&entry, NULL, true);
+}
+
+static void *log_queue_thread(void *a) {
 	MemArena *scratch = acquire_scratch_arena();
-	StringBuffer buf = { scratch };
+	uint tail = 0;
 
-	SDL_LockMutex(mtx);
+	for(Logger *l = logging.outputs; l; l = l->next) {
+		l->batch = (StringBuffer) { scratch };
+	}
 
 	for(;;) {
-		SDL_WaitCondition(cond, mtx);
-		QueuedLogEntry *qle;
-
-		while((qle = alist_pop(&logging.queue.queue)) && logging.queue.shutdown < 2) {
-			SDL_UnlockMutex(mtx);
-			log_dispatch(&qle->e, &buf);
-			mem_free(qle);
-			SDL_LockMutex(mtx);
+		int shutdown = SDL_GetAtomicInt(&logging.queue.shutdown);
+		LogQueueSlot *slot = log_queue_peek(tail);
+
+		if(!slot || shutdown > 1) {
+			if(shutdown) {
+				break;
+			}
+
+			SDL_SetAtomicInt(&logging.queue.consumer_waiting, 1);
+
+			if(log_queue_peek(tail) || SDL_GetAtomicInt(&logging.queue.shutdown)) {
+				SDL_SetAtomicInt(&logging.queue.consumer_waiting, 0);
+				continue;
+			}
+
+			SDL_WaitSemaphoreTimeout(logging.queue.wakeup_sem, 250);
+			SDL_SetAtomicInt(&logging.queue.consumer_waiting, 0);
+			continue;
 		}
 
-		SDL_BroadcastCondition(cond);
+		SDL_LockMutex(logging.queue.mutex);
 
-		if(logging.queue.shutdown) {
-			break;
+		for(int i = 0; slot && i < LOG_QUEUE_MAX_BATCH; ++i) {
+			for(Logger *l = logging.outputs; l; l = l->next) {
+				if(!l->batch.arena) {
+					// Output added after the thread started
+					l->batch = (StringBuffer) { scratch };
+				}
+			}
+
+			log_dispatch_internal(&slot->e, NULL, true);
+			log_queue_release_slot(slot, tail);
+			slot = log_queue_peek(++tail);
 		}
+
+		log_queue_report_dropped();
+		log_queue_flush_batches();
+
+		logging.queue.num_dispatched = tail;
+		SDL_BroadcastCondition(logging.queue.cond);
+		SDL_UnlockMutex(logging.queue.mutex);
+	}
+
+	// Fast shutdown: discard whatever is left
+	for(LogQueueSlot *slot; (slot = log_queue_peek(tail)); ++tail) {
+		log_queue_release_slot(slot, tail);
+	}
+
+	SDL_LockMutex(logging.queue.mutex);
+	log_queue_flush_batches();
+
+	for(Logger *l = logging.outputs; l; l = l->next) {
+		l->batch = (StringBuffer) {};
 	}
 
-	SDL_UnlockMutex(mtx);
+	logging.queue.num_dispatched = tail;
+	SDL_BroadcastCondition(logging.queue.cond);
+	SDL_UnlockMutex(logging.queue.mutex);
 
 	release_scratch_arena(scratch);
 	return NULL;
@@ -431,6 +597,17 @@ static void log_queue_init(void) {
 		return;
 	}
 
+	if(!(logging.queue.wakeup_sem = SDL_CreateSemaphore(0))) {
+		log_sdl_error(LOG_ERROR, "SDL_CreateSemaphore");
+		return;
+	}
+
+	logging.queue.slots = ALLOC_ARRAY(LOG_QUEUE_NUM_SLOTS, typeof(*logging.queue.slots));
+
+	for(int i = 0; i < LOG_QUEUE_NUM_SLOTS; ++i) {
+		SDL_SetAtomicInt(&logging.queue.slots[i].seq, i);
+	}
+
 	logging.queue.thread = thread_create("Log queue", log_queue_thread, NULL, THREAD_PRIO_LOW);
 
 	if(!logging.queue.thread) {
@@ -441,18 +618,21 @@ static void log_queue_init(void) {
 
 static void log_queue_shutdown_internal(bool force_sync) {
 	if(logging.queue.thread) {
-		SDL_LockMutex(logging.queue.mutex);
-		logging.queue.shutdown = env_get("TAISEI_LOG_ASYNC_FAST_SHUTDOWN", false) && !force_sync ? 2 : 1;
-		SDL_BroadcastCondition(logging.queue.cond);
-		SDL_UnlockMutex(logging.queue.mutex);
+		int shutdown = env_get("TAISEI_LOG_ASYNC_FAST_SHUTDOWN", false) && !force_sync ? 2 : 1;
+		SDL_SetAtomicInt(&logging.queue.shutdown, shutdown);
+		SDL_SignalSemaphore(logging.queue.wakeup_sem);
 		thread_wait(logging.queue.thread);
 		logging.queue.thread = NULL;
 	}
 
+	SDL_DestroySemaphore(logging.queue.wakeup_sem);
+	logging.queue.wakeup_sem = NULL;
 	SDL_DestroyMutex(logging.queue.mutex);
 	logging.queue.mutex = NULL;
 	SDL_DestroyCondition(logging.queue.cond);
 	logging.queue.cond = NULL;
+	mem_free(logging.queue.slots);
+	logging.queue.slots = NULL;
 }
 
 void log_queue_shutdown(void) {
@@ -485,8 +665,13 @@ void log_shutdown(void) {
 void log_sync(bool flush) {
 	SDL_LockMutex(logging.queue.mutex);
 
-	while(logging.queue.queue.first) {
-		SDL_WaitCondition(logging.queue.cond, logging.queue.mutex);
+	if(logging.queue.thread) {
+		uint target = SDL_GetAtomicInt(&logging.queue.head);
+
+		while((int)(logging.queue.num_dispatched - target) < 0) {
+			SDL_SignalSemaphore(logging.queue.wakeup_sem);
+			SDL_WaitConditionTimeout(logging.queue.cond, logging.queue.mutex, 100);
+		}
 	}
 
 	if(flush) {
@@ -580,8 +765,8 @@ static inline int thread_color(uint64_t tid) {
 }
 
 static const char *thread_name(LogEntry *entry, size_t tmpsize, char tmpbuf[tmpsize]) {
-	if(entry->thread) {
-		return thread_get_name(entry->thread);
+	if(entry->thread_name) {
+		return entry->thread_name;
 	} else {
 		snprintf(tmpbuf, tmpsize, "%llx", (unsigned long long)entry->thread_id);
 		return tmpbuf;
@@ -104,7 +104,7 @@ typedef struct LogEntry {
 	const char *module;
 	const char *func;
 	const char *task;
-	Thread *thread;
+	const char *thread_name;
 	ThreadID thread_id;
 	uint32_t task_id;
 	uint time;
@@ -7,6 +7,7 @@
  */
 
 #include "audio/audio.h"
+#include "benchmark.h"
 #include "cli.h"
 #include "coroutine/coroutine.h"
 #include "credits.h"
@@ -22,6 +23,7 @@
 #include "memory/scratch.h"
 #include "menu/mainmenu.h"
 #include "menu/savereplay.h"
+#include "profiler.h"
 #include "progress.h"
 #include "renderer/common/models.h"
 #include "renderer/common/sprite_batch.h"
@@ -64,7 +66,9 @@ attr_unused
 static void taisei_shutdown(void) {
 	log_info("Shutting down");
 
-	if(!global.is_replay_verification) {
+	if(benchmark_is_active()) {
+		benchmark_finish();
+	} else if(!global.is_replay_verification) {
 		config_save();
 		progress_save();
 	}
@@ -83,6 +87,7 @@ static void taisei_shutdown(void) {
 	stage_objpools_shutdown();
 	gamemode_shutdown();
 	taskmgr_global_shutdown();
+	profiler_shutdown();
 	audio_shutdown();
 	r_models_shutdown();
 	r_sprite_batch_shutdown();
@@ -369,6 +374,16 @@ int main(int argc, char **argv) {
 		return 0; // NO main_quit here! vfs_setup may be asynchronous.
 	}
 
+	if(ctx->cli.benchmark_report) {
+		ctx->headless = true;
+		benchmark_begin(&(BenchmarkParams) {
+			.report_path = ctx->cli.benchmark_report,
+			.seed = ctx->cli.benchmark_seed,
+			.num_frames = ctx->cli.benchmark_frames,
+			.render = ctx->cli.benchmark_render,
+		});
+	}
+
 	log_info("Girls are now preparing, please wait warmly...");
 
 	free_cli_action(&ctx->cli);
@@ -400,6 +415,7 @@ static void main_post_vfsinit(CallChainResult ccr) {
 	taskmgr_global_init();
 	gamemode_init();
 	time_init();
+	profiler_init();
 	init_global(&ctx->cli);
 	events_init();
 
@@ -530,6 +546,11 @@ static void main_singlestg_begin_game(CallChainResult ccr) {
 		global.plr.mode = ctx->plrmode;
 	}
 
+	if(benchmark_is_active()) {
+		// Nobody is at the controls: keep the player alive and firing.
+		global.plr.iddqd = true;
+	}
+
 	stage_enter(ctx->stg, &mctx->rg, CALLCHAIN(main_singlestg_end_game, ctx));
 }
 
@@ -539,6 +560,8 @@ static void main_singlestg_end_game(CallChainResult ccr) {
 
 	if(global.gameover == GAMEOVER_RESTART) {
 		main_singlestg_begin_game(ccr);
+	} else if(benchmark_is_active()) {
+		main_singlestg_cleanup(ccr);
 	} else {
 		ask_save_replay(mctx->replay_out, CALLCHAIN(main_singlestg_cleanup, ccr.ctx));
 	}
@@ -579,6 +602,10 @@ static void main_singlestg(MainContext *mctx) {
 	stagetitle_format_localized(&stg->title, sizeof(title), title);
 	log_info("Entering %s", title);
 
+	if(benchmark_is_active()) {
+		config_set_int(CONFIG_SHOT_INVERTED, true);
+	}
+
 	mctx->replay_out = alloc_replay();
 	main_singlestg_begin_game(CALLCHAIN_RESULT(ctx, NULL));
 	eventloop_run();
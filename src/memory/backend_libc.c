@@ -27,6 +27,8 @@
 #endif
 
 void mem_free(void *ptr) {
+	MEM_STATS_COUNT(num_frees);
+
 #if MEMALIGN_METHOD == MEMALIGN_METHOD_WIN32
 	_aligned_free(ptr);
 #else
@@ -35,6 +37,8 @@ void mem_free(void *ptr) {
 }
 
 void *mem_alloc(size_t size) {
+	MEM_STATS_COUNT(num_allocs);
+
 #if MEMALIGN_METHOD == MEMALIGN_METHOD_WIN32
 	void *p = NOT_NULL(_aligned_malloc(size, alignof(max_align_t)));
 	memset(p, 0, size);
@@ -45,6 +49,8 @@ void *mem_alloc(size_t size) {
 }
 
 void *mem_alloc_array(size_t num_members, size_t size) {
+	MEM_STATS_COUNT(num_allocs);
+
 #if MEMALIGN_METHOD == MEMALIGN_METHOD_WIN32
 	size_t array_size = mem_util_calc_array_size(num_members, size);
 	void *p = NOT_NULL(_aligned_malloc(array_size, alignof(max_align_t)));
@@ -61,6 +67,7 @@ void *mem_realloc(void *ptr, size_t size) {
 	}
 
 	assert_nolog(size > 0);
+	MEM_STATS_COUNT(num_reallocs);
 
 	if(size == 0) {
 		DIAGNOSTIC(push)
@@ -82,6 +89,10 @@ void *mem_alloc_aligned(size_t size, size_t alignment) {
 	assert((alignment & (alignment - 1)) == 0);
 	assert((alignment / sizeof(void*)) * sizeof(void*) == alignment);
 
+#if MEMALIGN_METHOD != MEMALIGN_METHOD_YOLO
+	MEM_STATS_COUNT(num_allocs);
+#endif
+
 #if MEMALIGN_METHOD == MEMALIGN_METHOD_C11
 	size_t nsize = ((size - 1) / alignment + 1) * alignment;
 	assert(nsize >= size);
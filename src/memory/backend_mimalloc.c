@@ -17,6 +17,7 @@
 #define MIN_ALIGNMENT alignof(max_align_t)
 
 void mem_free(void *ptr) {
+	MEM_STATS_COUNT(num_frees);
 	mi_free(ptr);
 }
 
@@ -31,10 +32,12 @@ void *mem_alloc_array(size_t num_members, size_t size) {
 
 void *mem_realloc(void *ptr, size_t size) {
 	assert_nolog(size > 0);
+	MEM_STATS_COUNT(num_reallocs);
 	return mi_realloc_aligned(ptr, size, MIN_ALIGNMENT);
 }
 
 void *mem_alloc_aligned(size_t size, size_t alignment) {
 	alignment = max(MIN_ALIGNMENT, alignment);
+	MEM_STATS_COUNT(num_allocs);
 	return mi_calloc_aligned(1, size, alignment);
 }
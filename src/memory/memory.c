@@ -12,6 +12,20 @@
 
 #include <stdlib.h>
 
+MemStatsCounters _mem_stats;
+
+void mem_stats_enable(bool enable) {
+	_mem_stats.enabled = enable;
+}
+
+void mem_stats_get(MemStats *stats) {
+	*stats = (MemStats) {
+		.num_allocs = SDL_GetAtomicInt(&_mem_stats.num_allocs),
+		.num_reallocs = SDL_GetAtomicInt(&_mem_stats.num_reallocs),
+		.num_frees = SDL_GetAtomicInt(&_mem_stats.num_frees),
+	};
+}
+
 void *mem_alloc_array_aligned(size_t num_members, size_t size, size_t alignment) {
 	return mem_alloc_aligned(mem_util_calc_array_size(num_members, size), alignment);
 }
@@ -126,3 +126,16 @@ char *mem_strdup(const char *str) {
 		mem_alloc(sizeof(_type) + (_extra_size)))
 
 void mem_install_sdl_callbacks(void);
+
+typedef struct MemStats {
+	uint32_t num_allocs;
+	uint32_t num_reallocs;
+	uint32_t num_frees;
+} MemStats;
+
+/*
+ * Allocation counting for benchmarks. Disabled by default, costing a single branch per call.
+ * The counters wrap around; only differences between two snapshots are meaningful.
+ */
+void mem_stats_enable(bool enable);
+void mem_stats_get(MemStats *stats) attr_nonnull_all;
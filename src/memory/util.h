@@ -9,6 +9,23 @@
 #pragma once
 #include "taisei.h"
 
+#include <SDL3/SDL_atomic.h>
+
+typedef struct MemStatsCounters {
+	bool enabled;
+	SDL_AtomicInt num_allocs;
+	SDL_AtomicInt num_reallocs;
+	SDL_AtomicInt num_frees;
+} MemStatsCounters;
+
+extern MemStatsCounters _mem_stats;
+
+#define MEM_STATS_COUNT(counter) do { \
+	if(UNLIKELY(_mem_stats.enabled)) { \
+		SDL_AddAtomicInt(&_mem_stats.counter, 1); \
+	} \
+} while(0)
+
 INLINE size_t mem_util_calc_array_size(size_t num_members, size_t size) {
 	size_t array_size;
 
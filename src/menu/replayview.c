@@ -15,6 +15,7 @@
 #include "audio/audio.h"
 #include "i18n/i18n.h"
 #include "plrmodes.h"
+#include "replay/index.h"
 #include "replay/struct.h"
 #include "resource/font.h"
 #include "stageinfo.h"
@@ -25,11 +26,13 @@ typedef struct ReplayviewContext {
 	MenuData *submenu;
 	MenuData *next_submenu;
 	double sub_fade;
+	ReplayIndex index;
 } ReplayviewContext;
 
 // Type of MenuEntry.arg (which should be renamed to context, probably...)
 typedef struct ReplayviewItemContext {
-	Replay *replay;
+	ReplayIndexEntry meta;  // strings are owned by the index
+	Replay *replay;         // loaded on demand
 	char *replayname;
 } ReplayviewItemContext;
 
@@ -164,6 +167,20 @@ static MenuData *replayview_sub_messagebox(MenuData *parent, const char *message
 
 static void replayview_run(MenuData *menu, void *arg) {
 	ReplayviewItemContext *ctx = arg;
+
+	if(!ctx->replay) {
+		auto rpy = ALLOC(Replay);
+
+		if(!replay_load(rpy, ctx->replayname, REPLAY_READ_META) || rpy->stages.num_elements == 0) {
+			replay_reset(rpy);
+			mem_free(rpy);
+			replayview_set_submenu(menu, replayview_sub_messagebox(menu, _("Failed to load replay")));
+			return;
+		}
+
+		ctx->replay = rpy;
+	}
+
 	Replay *rpy = ctx->replay;
 
 	if(rpy->stages.num_elements > 1) {
@@ -175,8 +192,12 @@ static void replayview_run(MenuData *menu, void *arg) {
 
 static void replayview_freearg(void *a) {
 	ReplayviewItemContext *ctx = a;
-	replay_reset(ctx->replay);
-	mem_free(ctx->replay);
+
+	if(ctx->replay) {
+		replay_reset(ctx->replay);
+		mem_free(ctx->replay);
+	}
+
 	mem_free(ctx->replayname);
 	mem_free(ctx);
 }
@@ -256,14 +277,13 @@ static void replayview_drawitem(MenuEntry *e, int item, int cnt, void *ctx) {
 		return;
 	}
 
-	Replay *rpy = ictx->replay;
+	const ReplayIndexEntry *meta = &ictx->meta;
 
 	float sizes[] = { 1.2, 2.2, 0.5, 0.55, 0.55 };
 	int columns = sizeof(sizes)/sizeof(float), i, j;
 	float base_size = (SCREEN_W - 110.0) / columns;
 
-	ReplayStage *first_stage = dynarray_get_ptr(&rpy->stages, 0);
-	time_t t = first_stage->start_time;
+	time_t t = meta->start_time;
 	struct tm *timeinfo = localtime(&t);
 
 	for(i = 0; i < columns; ++i) {
@@ -284,12 +304,12 @@ static void replayview_drawitem(MenuEntry *e, int item, int cnt, void *ctx) {
 
 			case 1:
 				a = ALIGN_LEFT;
-				strlcpy(tmp, rpy->playername, sizeof(tmp));
+				strlcpy(tmp, meta->playername, sizeof(tmp));
 				break;
 
 			case 2: {
 				a = ALIGN_RIGHT;
-				PlayerMode *plrmode = plrmode_find(first_stage->plr_char, first_stage->plr_shot);
+				PlayerMode *plrmode = plrmode_find(meta->plr_char, meta->plr_shot);
 
 				if(plrmode == NULL) {
 					strlcpy(tmp, "?????", sizeof(tmp));
@@ -302,13 +322,13 @@ static void replayview_drawitem(MenuEntry *e, int item, int cnt, void *ctx) {
 
 			case 3:
 				a = ALIGN_CENTER;
-				snprintf(tmp, sizeof(tmp), "%s", difficulty_name(first_stage->diff));
+				snprintf(tmp, sizeof(tmp), "%s", difficulty_name(meta->diff));
 				break;
 
 			case 4:
 				a = ALIGN_LEFT;
-				if(rpy->stages.num_elements == 1) {
-					StageInfo *stg = stageinfo_get_by_id(first_stage->stage);
+				if(meta->num_stages == 1) {
+					StageInfo *stg = stageinfo_get_by_id(meta->first_stage);
 
 					if(stg) {
 						char title[STAGE_MAX_TITLE_SIZE];
@@ -318,7 +338,7 @@ static void replayview_drawitem(MenuEntry *e, int item, int cnt, void *ctx) {
 						snprintf(tmp, sizeof(tmp), "?????");
 					}
 				} else {
-					snprintf(tmp, sizeof(tmp), "%i stages", rpy->stages.num_elements);
+					snprintf(tmp, sizeof(tmp), "%i stages", meta->num_stages);
 				}
 				break;
 		}
@@ -337,8 +357,15 @@ static void replayview_drawitem(MenuEntry *e, int item, int cnt, void *ctx) {
 	}
 }
 
+static void replayview_merge_index(MenuData *m, int first_new);
+
 static void replayview_logic(MenuData *m) {
 	ReplayviewContext *ctx = m->context;
+	int first_new = replay_index_poll(&ctx->index);
+
+	if(first_new >= 0) {
+		replayview_merge_index(m, first_new);
+	}
 
 	if(ctx->submenu) {
 		MenuData *sm = ctx->submenu;
@@ -387,51 +414,106 @@ static int replayview_cmp(const void *a, const void *b) {
 	ReplayviewItemContext *actx = ((MenuEntry*)a)->arg;
 	ReplayviewItemContext *bctx = ((MenuEntry*)b)->arg;
 
-	Replay *arpy = actx->replay;
-	Replay *brpy = bctx->replay;
+	uint64_t at = actx->meta.start_time;
+	uint64_t bt = bctx->meta.start_time;
 
-	return dynarray_get(&brpy->stages, 0).start_time - dynarray_get(&arpy->stages, 0).start_time;
+	return (at < bt) - (at > bt);
 }
 
-static int fill_replayview_menu(MenuData *m) {
-	VFSDir *dir = vfs_dir_open("storage/replays");
-	const char *filename;
+static int add_replayview_entries(MenuData *m, int first) {
+	ReplayviewContext *ctx = m->context;
 	int rpys = 0;
 
-	if(!dir) {
-		log_warn("VFS error: %s", vfs_get_error());
-		return -1;
-	}
+	for(uint i = first; i < ctx->index.entries.num_elements; ++i) {
+		ReplayIndexEntry *meta = dynarray_get_ptr(&ctx->index.entries, i);
 
-	char ext[5];
-	snprintf(ext, 5, ".%s", REPLAY_EXTENSION);
-
-	while((filename = vfs_dir_read(dir))) {
-		if(!strendswith(filename, ext))
-			continue;
-
-		auto rpy = ALLOC(Replay);
-		if(!replay_load(rpy, filename, REPLAY_READ_META)) {
-			mem_free(rpy);
+		if(!meta->valid) {
 			continue;
 		}
 
 		auto ictx = ALLOC(ReplayviewItemContext, {
-			.replay = rpy,
-			.replayname = mem_strdup(filename),
+			.meta = *meta,
+			.replayname = mem_strdup(meta->filename),
 		});
 
 		add_menu_entry(m, " ", replayview_run, ictx)->transition = /*rpy->numstages < 2 ? TransFadeBlack :*/ NULL;
 		++rpys;
 	}
 
-	vfs_dir_close(dir);
+	return rpys;
+}
+
+static void add_replayview_footer(MenuData *m, int rpys) {
+	ReplayviewContext *ctx = m->context;
+
+	if(rpys > 0) {
+		add_menu_separator(m);
+		add_menu_entry(m, N_("Back"), menu_action_close, NULL);
+	} else if(replay_index_is_rebuilding(&ctx->index)) {
+		add_menu_entry(m, N_("Loading replays…"), menu_action_close, NULL);
+	} else {
+		add_menu_entry(m, N_("No replays available. Play the game and record some!"), menu_action_close, NULL);
+	}
+}
+
+static int fill_replayview_menu(MenuData *m) {
+	ReplayviewContext *ctx = m->context;
+
+	if(!replay_index_open(&ctx->index)) {
+		return -1;
+	}
 
+	int rpys = add_replayview_entries(m, 0);
 	dynarray_qsort(&m->entries, replayview_cmp);
 
 	return rpys;
 }
 
+static void replayview_merge_index(MenuData *m, int first_new) {
+	// Entries rebuilt in the background; drop the footer, insert them in order and put it back.
+	// Existing items are untouched: ReplayviewItemContext.meta is a shallow copy of the index entry,
+	// so its filename and playername pointers stay valid as merging moves entries without freeing
+	// their strings. Only replayname is the item's own copy.
+
+	ReplayviewItemContext *selected = NULL;
+
+	if(m->cursor >= 0 && m->cursor < (int)m->entries.num_elements) {
+		MenuEntry *e = dynarray_get_ptr(&m->entries, m->cursor);
+
+		if(e->action == replayview_run) {
+			selected = e->arg;
+		}
+	}
+
+	while(m->entries.num_elements > 0) {
+		MenuEntry *e = dynarray_get_ptr(&m->entries, m->entries.num_elements - 1);
+
+		if(e->action == replayview_run) {
+			break;
+		}
+
+		mem_free(e->name);
+		m->entries.num_elements--;
+	}
+
+	int rpys = m->entries.num_elements + add_replayview_entries(m, first_new);
+	dynarray_qsort(&m->entries, replayview_cmp);
+	add_replayview_footer(m, rpys);
+
+	m->cursor = m->entries.num_elements - 1;
+
+	if(selected) {
+		dynarray_foreach(&m->entries, int i, MenuEntry *e, {
+			if(e->arg == selected) {
+				m->cursor = i;
+				break;
+			}
+		});
+	} else if(rpys > 0) {
+		m->cursor = 0;
+	}
+}
+
 static void replayview_menu_input(MenuData *m) {
 	ReplayviewContext *ctx = (ReplayviewContext*)m->context;
 	MenuData *sub = ctx->submenu;
@@ -453,8 +535,6 @@ static void replayview_free(MenuData *m) {
 
 		free_menu(ctx->next_submenu);
 		free_menu(ctx->submenu);
-		mem_free(m->context);
-		m->context = NULL;
 	}
 
 	dynarray_foreach_elem(&m->entries, MenuEntry *e, {
@@ -462,6 +542,13 @@ static void replayview_free(MenuData *m) {
 			replayview_freearg(e->arg);
 		}
 	});
+
+	if(m->context) {
+		ReplayviewContext *ctx = m->context;
+		replay_index_close(&ctx->index);
+		mem_free(m->context);
+		m->context = NULL;
+	}
 }
 
 MenuData *create_replayview_menu(void) {
@@ -479,13 +566,10 @@ MenuData *create_replayview_menu(void) {
 
 	int r = fill_replayview_menu(m);
 
-	if(!r) {
-		add_menu_entry(m, N_("No replays available. Play the game and record some!"), menu_action_close, NULL);
-	} else if(r < 0) {
+	if(r < 0) {
 		add_menu_entry(m, N_("There was a problem getting the replay list :("), menu_action_close, NULL);
 	} else {
-		add_menu_separator(m);
-		add_menu_entry(m, N_("Back"), menu_action_close, NULL);
+		add_replayview_footer(m, r);
 	}
 
 	return m;
@@ -0,0 +1,377 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "particle.h"
+
+#include "config.h"
+#include "dynarray.h"
+#include "global.h"
+#include "projectile.h"
+#include "random.h"
+#include "stagedraw.h"
+#include "util/glm.h"
+
+typedef struct Particle {
+	cmplx pos;
+	cmplx velocity;
+	cmplx acceleration;
+	cmplx retention;
+	Sprite *sprite;
+	ShaderProgram *shader;
+	ParticleDrawRule draw_rule;
+	Color color;
+	cmplxf scale;
+	float opacity;
+	float angle;
+	float angle_delta;
+	float timeout;
+	int birthtime;
+	BlendMode blend;
+	short max_viewport_dist;
+	uint8_t flags;
+} Particle;
+
+// Added to the sublayer that PARTICLE() would get; see fx_particle_layer()
+#define FX_SUBLAYER_BIT 0x200
+
+// One per distinct draw layer; the entity system sorts these among everything else
+DEFINE_ENTITY_TYPE(ParticleLayer, {
+	DYNAMIC_ARRAY(Particle) particles;
+});
+
+static struct {
+	DYNAMIC_ARRAY(ParticleLayer*) layers;
+	ParticleLayer *last_layer;
+	ShaderProgram *default_shader;
+	ParticleFlags draw_exclude;
+	uint count;
+} particles;
+
+static void ent_draw_particle_layer(EntityInterface *ent);
+
+static ParticleLayer *get_layer(drawlayer_t layer) {
+	if(particles.last_layer && particles.last_layer->ent.draw_layer == layer) {
+		return particles.last_layer;
+	}
+
+	dynarray_foreach_elem(&particles.layers, ParticleLayer **pl, {
+		if((*pl)->ent.draw_layer == layer) {
+			return (particles.last_layer = *pl);
+		}
+	});
+
+	auto pl = ALLOC(ParticleLayer);
+	pl->ent.draw_layer = layer;
+	pl->ent.draw_func = ent_draw_particle_layer;
+	ent_register(&pl->ent, ENT_TYPE_ID(ParticleLayer));
+	dynarray_append(&particles.layers, pl);
+
+	return (particles.last_layer = pl);
+}
+
+/*
+ * A layer entity draws all of its particles at its own position in the entity order, so FX particles can't
+ * interleave with PARTICLE()s by spawn time. Instead of sharing their sublayer and landing wherever the
+ * layer entity happens to sort, they get one of their own, above all PARTICLE()s of the same layer.
+ */
+static drawlayer_t fx_particle_layer(drawlayer_t layer, ShaderProgram *shader) {
+	if(!(layer & LAYER_LOW_MASK)) {
+		layer = projectile_particle_layer(layer, shader) | FX_SUBLAYER_BIT;
+	}
+
+	return layer;
+}
+
+void spawn_particle(ParticleArgs *args) {
+	if(IN_DRAW_CODE) {
+		log_fatal("Tried to spawn a particle while in drawing code");
+	}
+
+	assert(args->move.attraction == 0);
+
+	// Any RNG draws were already made by the caller while building the args
+	if(!stage_should_spawn_particle(args->flags & PARTFLAG_REQUIRED)) {
+		return;
+	}
+
+	Sprite *sprite = args->sprite_ptr;
+
+	if(args->sprite) {
+		sprite = prefix_get_sprite(args->sprite, "part/");
+	}
+
+	assert(sprite != NULL);
+
+	ShaderProgram *shader = args->shader_ptr;
+
+	if(!shader) {
+		shader = args->shader ? res_shader(args->shader) : particles.default_shader;
+	}
+
+	cmplxf scale = args->scale;
+
+	if(scale == 0) {
+		scale = 1+I;
+	} else if(im(scale) == 0) {
+		scale = CMPLXF(re(scale), re(scale));
+	}
+
+	drawlayer_t layer = fx_particle_layer(args->layer ?: LAYER_PARTICLE_MID, shader);
+	ParticleLayer *pl = get_layer(layer);
+
+	Particle *p = dynarray_append(&pl->particles, {
+		.pos = args->pos,
+		.velocity = args->move.velocity,
+		.acceleration = args->move.acceleration,
+		.retention = args->move.retention,
+		.sprite = sprite,
+		.shader = shader,
+		.draw_rule = args->draw_rule,
+		.color = args->color ? *args->color : *RGB(1, 1, 1),
+		.scale = scale,
+		.opacity = args->opacity ?: 1,
+		.angle = args->angle,
+		.angle_delta = args->angle_delta,
+		.timeout = args->timeout,
+		.birthtime = global.frames,
+		.max_viewport_dist = args->max_viewport_dist ?: 300,
+		.flags = args->flags,
+		.blend = args->blend ?: BLEND_PREMUL_ALPHA,
+	});
+
+	if(!(p->flags & (PARTFLAG_MANUALANGLE | PARTFLAG_NOMOVE))) {
+		p->angle = carg(p->velocity) + p->angle_delta;
+	}
+
+	++particles.count;
+}
+
+static bool particle_in_viewport(Particle *p) {
+	// Same test as projectile_in_viewport(), which ignores the scale for particles
+	real e = p->max_viewport_dist;
+	cmplx buffer = 0.5 * p->sprite->extent.as_cmplx + CMPLX(e, e);
+	cmplx br = p->pos + buffer;
+	cmplx tl = p->pos - buffer;
+
+	return !(
+		re(br) < 0 || im(br) < 0 ||
+		re(tl) > VIEWPORT_W || im(tl) > VIEWPORT_H
+	);
+}
+
+// Returns false if the particle should be removed; mirrors proj_update()
+static inline bool particle_update(Particle *p) {
+	int t = global.frames - p->birthtime;
+
+	if(p->timeout > 0 && t >= p->timeout) {
+		return false;
+	}
+
+	if(!(p->flags & PARTFLAG_NOMOVE)) {
+		cmplx v = p->velocity;
+		p->pos += v;
+		p->velocity = p->acceleration + cmul_finite(p->retention, v);
+
+		if(!(p->flags & PARTFLAG_MANUALANGLE) && v) {
+			p->angle = carg(v) + p->angle_delta;
+		}
+	}
+
+	if(p->flags & PARTFLAG_MANUALANGLE) {
+		p->angle += p->angle_delta;
+	}
+
+	return (p->flags & PARTFLAG_NOAUTOREMOVE) || particle_in_viewport(p);
+}
+
+void particles_process(void) {
+	dynarray_foreach_elem(&particles.layers, ParticleLayer **pl, {
+		auto parts = &(*pl)->particles;
+		uint live = 0;
+
+		dynarray_foreach_elem(parts, Particle *p, {
+			if(particle_update(p)) {
+				dynarray_set(parts, live++, *p);
+			}
+		});
+
+		particles.count -= parts->num_elements - live;
+		parts->num_elements = live;
+	});
+}
+
+static void particle_draw(Particle *p) {
+	int t = global.frames - p->birthtime;
+	float tf = p->timeout ? t / p->timeout : 0;
+	auto rule = &p->draw_rule;
+
+	Color color = p->color;
+	ShaderCustomParams shader_params = {{ p->opacity, 0, 0, 0 }};
+
+	SpriteParams sp = {
+		.sprite_ptr = p->sprite,
+		.shader_ptr = p->shader,
+		.color = &color,
+		.shader_params = &shader_params,
+		.blend = p->blend,
+		.pos.as_cmplx = p->pos,
+		.scale.as_cmplx = p->scale,
+		.rotation = {
+			.angle = p->angle + (float)(M_PI/2),
+			.vector = { 0, 0, 1 },
+		},
+	};
+
+	switch(rule->mode) {
+		case PARTDRAW_BASIC:
+			break;
+
+		case PARTDRAW_SCALEFADE: {
+			auto a = &rule->scalefade;
+			cmplxf scale = clerpf(a->scale0, a->scale1, tf);
+			float opacity = powf(lerpf(a->opacity0, a->opacity1, tf), a->opacity_exp);
+
+			if(re(scale) == 0 || im(scale) == 0 || opacity == 0) {
+				return;
+			}
+
+			shader_params.vector[0] *= opacity;
+			sp.scale.as_cmplx = cwmulf(sp.scale.as_cmplx, scale);
+			break;
+		}
+
+		case PARTDRAW_PETAL:
+			glm_vec3_copy(rule->petal.rot_axis, sp.rotation.vector);
+			sp.rotation.angle = DEG2RAD*t*4.0f + rule->petal.rot_angle;
+			shader_params.vector[0] *= (1.0f - tf);
+			break;
+
+		case PARTDRAW_CLEAR_EFFECT: {
+			auto a = &rule->clear_effect;
+			float etf = glm_ease_circ_out(tf);
+			float o = shader_params.vector[0];
+
+			shader_params.vector[0] = o * max(0, 1.5f * (1 - etf) - 0.5f);
+			r_draw_sprite(&sp);
+
+			sp.sprite_ptr = animation_get_frame(a->ani, a->seq, tf * (a->seq->length - 1));
+			sp.scale.as_cmplx *= a->scale * 1.5f * etf;
+			color.a *= (1 - etf);
+			shader_params.vector[0] = o;
+			sp.rotation.angle += a->angle;
+			break;
+		}
+
+		default: UNREACHABLE;
+	}
+
+	r_draw_sprite(&sp);
+}
+
+static void ent_draw_particle_layer(EntityInterface *ent) {
+	ParticleLayer *pl = ENT_CAST(ent, ParticleLayer);
+	ParticleFlags exclude = particles.draw_exclude;
+	ParticleFlags require = config_get_int(CONFIG_PARTICLES) ? 0 : PARTFLAG_REQUIRED;
+
+	// Petals rotate in 3D and must stay visible from behind
+	r_disable(RCAP_CULL_FACE);
+
+	dynarray_foreach_elem(&pl->particles, Particle *p, {
+		if((p->flags & exclude) || (p->flags & require) != require) {
+			continue;
+		}
+
+		particle_draw(p);
+	});
+}
+
+ParticleFlags particles_set_draw_exclude(ParticleFlags flags) {
+	ParticleFlags prev = particles.draw_exclude;
+	particles.draw_exclude = flags;
+	return prev;
+}
+
+uint particles_count(void) {
+	return particles.count;
+}
+
+void particles_init(void) {
+	particles = (typeof(particles)) {
+		.default_shader = res_shader("sprite_particle"),
+	};
+}
+
+void particles_shutdown(void) {
+	dynarray_foreach_elem(&particles.layers, ParticleLayer **pl, {
+		ent_unregister(&(*pl)->ent);
+		dynarray_free_data(&(*pl)->particles);
+		mem_free(*pl);
+	});
+
+	dynarray_free_data(&particles.layers);
+	particles = (typeof(particles)) {};
+}
+
+ParticleDrawRule partdraw_basic(void) {
+	return (ParticleDrawRule) { PARTDRAW_BASIC };
+}
+
+ParticleDrawRule partdraw_timeout_scalefade_exp(
+	cmplxf scale0, cmplxf scale1, float opacity0, float opacity1, float opacity_exp
+) {
+	if(im(scale0) == 0) {
+		scale0 = CMPLXF(re(scale0), re(scale0));
+	}
+
+	if(im(scale1) == 0) {
+		scale1 = CMPLXF(re(scale1), re(scale1));
+	}
+
+	return (ParticleDrawRule) {
+		.mode = PARTDRAW_SCALEFADE,
+		.scalefade = { scale0, scale1, opacity0, opacity1, opacity_exp },
+	};
+}
+
+ParticleDrawRule partdraw_timeout_scalefade(cmplxf scale0, cmplxf scale1, float opacity0, float opacity1) {
+	return partdraw_timeout_scalefade_exp(scale0, scale1, opacity0, opacity1, 1.0f);
+}
+
+ParticleDrawRule partdraw_timeout_scale(cmplxf scale0, cmplxf scale1) {
+	return partdraw_timeout_scalefade(scale0, scale1, 1, 1);
+}
+
+ParticleDrawRule partdraw_timeout_fade(float opacity0, float opacity1) {
+	return partdraw_timeout_scalefade(1+I, 1+I, opacity0, opacity1);
+}
+
+ParticleDrawRule partdraw_petal(float rot_angle, vec3 rot_axis) {
+	auto r = (ParticleDrawRule) {
+		.mode = PARTDRAW_PETAL,
+		.petal.rot_angle = rot_angle,
+	};
+
+	glm_vec3_normalize_to(rot_axis, r.petal.rot_axis);
+	return r;
+}
+
+ParticleDrawRule partdraw_petal_random(void) {
+	float x = rng_f32();
+	float y = rng_f32();
+	float z = rng_f32();
+	float rot_angle = rng_f32_angle();
+
+	return partdraw_petal(rot_angle, (vec3) { x, y, z });
+}
+
+ParticleDrawRule partdraw_clear_effect(Animation *ani, AniSequence *seq, float angle, float scale) {
+	return (ParticleDrawRule) {
+		.mode = PARTDRAW_CLEAR_EFFECT,
+		.clear_effect = { ani, seq, angle, scale },
+	};
+}
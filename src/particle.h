@@ -0,0 +1,120 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "color.h"
+#include "entity.h"
+#include "move.h"
+#include "renderer/api.h"
+#include "resource/animation.h"
+#include "resource/shader_program.h"
+#include "resource/sprite.h"
+
+/*
+ * Lightweight cosmetic particles.
+ *
+ * Unlike PARTICLE(), these are not entities: they can't be referenced after spawning, have no
+ * events, and only support a fixed set of draw rules. In exchange they are stored by value in
+ * one array per draw layer, updated in a single pass, and drawn straight into the sprite batch.
+ * Use them for high-volume fire-and-forget effects; anything that needs a task, a custom draw
+ * rule or a handle should stay a PARTICLE().
+ */
+
+typedef enum ParticleFlags {
+	PARTFLAG_REQUIRED = (1 << 0),       // Visible at "minimal" particles setting.
+	PARTFLAG_NOREFLECT = (1 << 1),      // Don't render a "reflection" of this on the Stage 1 water surface.
+	PARTFLAG_NOMOVE = (1 << 2),         // Don't update the position.
+	PARTFLAG_MANUALANGLE = (1 << 3),    // Don't automatically update the angle.
+	PARTFLAG_NOAUTOREMOVE = (1 << 4),   // Don't automatically remove when outside viewport.
+} ParticleFlags;
+
+typedef enum ParticleDrawMode {
+	PARTDRAW_BASIC,
+	PARTDRAW_SCALEFADE,
+	PARTDRAW_PETAL,
+	PARTDRAW_CLEAR_EFFECT,
+} ParticleDrawMode;
+
+typedef struct ParticleDrawRule {
+	ParticleDrawMode mode;
+
+	union {
+		struct {
+			cmplxf scale0;
+			cmplxf scale1;
+			float opacity0;
+			float opacity1;
+			float opacity_exp;
+		} scalefade;
+
+		struct {
+			vec3 rot_axis;
+			float rot_angle;
+		} petal;
+
+		struct {
+			Animation *ani;
+			AniSequence *seq;
+			float angle;
+			float scale;
+		} clear_effect;
+	};
+} ParticleDrawRule;
+
+typedef struct ParticleArgs {
+	const Color *color;
+	const char *sprite;
+	Sprite *sprite_ptr;
+	const char *shader;
+	ShaderProgram *shader_ptr;
+	ParticleDrawRule draw_rule;
+	cmplx pos;
+	MoveParams move;  // attraction is not supported
+	ParticleFlags flags;
+	BlendMode blend;
+	float angle;
+	float angle_delta;
+	int max_viewport_dist;
+	drawlayer_t layer;
+
+	cmplxf scale;
+	float opacity;
+	float timeout;
+} attr_designated_init ParticleArgs;
+
+#define FXPARTICLE(...) spawn_particle(&(ParticleArgs) { __VA_ARGS__ })
+
+// Defaults match PARTICLE(): "part/" sprite prefix, sprite_particle shader, LAYER_PARTICLE_MID.
+// Unless the layer has an explicit sublayer, FX particles draw above all PARTICLE()s in the same layer,
+// in spawn order among themselves.
+void spawn_particle(ParticleArgs *args) attr_nonnull_all;
+
+// These match the pdraw_* rules of the same name, including their RNG use.
+ParticleDrawRule partdraw_basic(void);
+ParticleDrawRule partdraw_timeout_scalefade_exp(cmplxf scale0, cmplxf scale1, float opacity0, float opacity1, float opacity_exp);
+ParticleDrawRule partdraw_timeout_scalefade(cmplxf scale0, cmplxf scale1, float opacity0, float opacity1);
+ParticleDrawRule partdraw_timeout_scale(cmplxf scale0, cmplxf scale1);
+ParticleDrawRule partdraw_timeout_fade(float opacity0, float opacity1);
+ParticleDrawRule partdraw_petal(float rot_angle, vec3 rot_axis);
+ParticleDrawRule partdraw_petal_random(void);
+
+// Draws the sprite fading out under a growing, rotated frame of the animation sequence.
+// The sequence is played once over the particle's timeout.
+ParticleDrawRule partdraw_clear_effect(Animation *ani, AniSequence *seq, float angle, float scale)
+	attr_nonnull_all;
+
+// Particles with any of these flags are skipped when drawing. Returns the previous value.
+ParticleFlags particles_set_draw_exclude(ParticleFlags flags);
+
+uint particles_count(void);
+
+void particles_init(void);
+void particles_process(void) attr_hot;
+void particles_shutdown(void);
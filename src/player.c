@@ -104,7 +104,10 @@ void player_stage_post_init(Player *plr) {
 	}
 }
 
+static void homing_index_shutdown(void);
+
 void player_free(Player *plr) {
+	homing_index_shutdown();
 	COEVENT_CANCEL_ARRAY(plr->events);
 	r_texture_destroy(plr->bomb_portrait.tex);
 	aniplayer_free(&plr->ani);
@@ -1404,7 +1407,7 @@ void player_graze(Player *plr, cmplx pos, int pts, int effect_intensity, const C
 	pos = (pos + plr->pos) * 0.5;
 
 	player_add_points(plr, pts, pos);
-	play_sfx("graze");
+	play_sfx_handle(SFX_HANDLE("graze"));
 
 	Color *c = COLOR_COPY(color);
 	color_add(c, RGBA(1, 1, 1, 1));
@@ -1729,6 +1732,99 @@ void player_preload(ResourceGroup *rg) {
 
 // FIXME: where should this be?
 
+/*
+ * Homing target index.
+ *
+ * Enemies may be moved by any task at any time, so the index can't simply be built once per frame.
+ * Instead, every query first compares the enemy list against a snapshot of (position, targetable)
+ * pairs taken when the index was last built, and rebuilds it if anything changed. This is much
+ * cheaper than the distance computations it replaces, and guarantees the exact same results as a
+ * linear scan: ties are broken by list order, and the boss wins ties against enemies.
+ */
+
+typedef struct HomingSnapshotEntry {
+	cmplx pos;
+	bool targetable;
+} HomingSnapshotEntry;
+
+typedef struct HomingTarget {
+	cmplx pos;
+	int list_index;
+} HomingTarget;
+
+static struct {
+	DYNAMIC_ARRAY(HomingSnapshotEntry) snapshot;  // all enemies, in list order
+	DYNAMIC_ARRAY(HomingTarget) sorted;           // targetable enemies, sorted by real part
+} homing_index;
+
+static int homing_target_cmp(const void *a, const void *b) {
+	const HomingTarget *ta = a, *tb = b;
+	double xa = re(ta->pos), xb = re(tb->pos);
+
+	if(xa != xb) {
+		return (xa > xb) - (xa < xb);
+	}
+
+	return ta->list_index - tb->list_index;
+}
+
+static void homing_index_update(void) {
+	auto snap = &homing_index.snapshot;
+	int i = 0;
+	bool dirty = false;
+
+	for(Enemy *e = global.enemies.first; e; e = e->next, ++i) {
+		HomingSnapshotEntry entry = { e->pos, enemy_is_targetable(e) };
+
+		if(!dirty) {
+			if(i < snap->num_elements) {
+				HomingSnapshotEntry *old = dynarray_get_ptr(snap, i);
+
+				if(old->pos == entry.pos && old->targetable == entry.targetable) {
+					continue;
+				}
+			}
+
+			dirty = true;
+			snap->num_elements = i;
+		}
+
+		dynarray_append(snap, entry);
+	}
+
+	if(!dirty) {
+		if(i == snap->num_elements) {
+			return;
+		}
+
+		snap->num_elements = i;
+	}
+
+	auto sorted = &homing_index.sorted;
+	sorted->num_elements = 0;
+
+	dynarray_foreach(snap, int idx, HomingSnapshotEntry *entry, {
+		// Enemies with NaN coordinates can never be selected, and would break the ordering
+		if(entry->targetable && !isnan(re(entry->pos))) {
+			dynarray_append(sorted, { entry->pos, idx });
+		}
+	});
+
+	dynarray_qsort(sorted, homing_target_cmp);
+}
+
+static void homing_target_consider(
+	const HomingTarget *t, cmplx org, double *mindst, int *best_index, cmplx *target
+) {
+	double dst = cabs(t->pos - org);
+
+	if(dst < *mindst || (dst == *mindst && t->list_index < *best_index)) {
+		*mindst = dst;
+		*best_index = t->list_index;
+		*target = t->pos;
+	}
+}
+
 cmplx plrutil_homing_target(cmplx org, cmplx fallback) {
 	double mindst = INFINITY;
 	cmplx target = fallback;
@@ -1738,22 +1834,65 @@ cmplx plrutil_homing_target(cmplx org, cmplx fallback) {
 		mindst = cabs(target - org);
 	}
 
-	for(Enemy *e = global.enemies.first; e; e = e->next) {
-		if(!enemy_is_targetable(e)) {
-			continue;
+	homing_index_update();
+
+	auto sorted = &homing_index.sorted;
+	int num = sorted->num_elements;
+
+	// Ties may only be broken in favor of an earlier enemy, never the boss or the fallback
+	int best_index = -1;
+
+	if(UNLIKELY(isnan(re(org)))) {
+		for(int i = 0; i < num; ++i) {
+			homing_target_consider(dynarray_get_ptr(sorted, i), org, &mindst, &best_index, &target);
 		}
 
-		double dst = cabs(e->pos - org);
+		return target;
+	}
 
-		if(dst < mindst) {
-			mindst = dst;
-			target = e->pos;
+	// Find the first target with re(pos) >= re(org), then sweep outwards in both directions.
+	// Since cabs(d) >= fabs(re(d)), a sweep can stop once the horizontal distance alone exceeds
+	// the best distance found so far.
+	int lo = 0, hi = num;
+
+	while(lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if(re(dynarray_get(sorted, mid).pos) < re(org)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
 		}
 	}
 
+	for(int i = lo; i < num; ++i) {
+		HomingTarget *t = dynarray_get_ptr(sorted, i);
+
+		if(re(t->pos) - re(org) > mindst) {
+			break;
+		}
+
+		homing_target_consider(t, org, &mindst, &best_index, &target);
+	}
+
+	for(int i = lo - 1; i >= 0; --i) {
+		HomingTarget *t = dynarray_get_ptr(sorted, i);
+
+		if(re(org) - re(t->pos) > mindst) {
+			break;
+		}
+
+		homing_target_consider(t, org, &mindst, &best_index, &target);
+	}
+
 	return target;
 }
 
+static void homing_index_shutdown(void) {
+	dynarray_free_data(&homing_index.snapshot);
+	dynarray_free_data(&homing_index.sorted);
+}
+
 void plrutil_slave_retract(BoxedPlayer bplr, cmplx *pos, real retract_time) {
 	cmplx pos0 = *pos;
 	Player *plr;
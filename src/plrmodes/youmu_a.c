@@ -607,7 +607,7 @@ TASK(youmu_mirror_shot_forward, { YoumuAController *ctrl; }) {
 
 	for(int t = 0;;) {
 		WAIT_EVENT_OR_DIE(&plr->events.shoot);
-		play_sfx_loop("generic_shot");
+		play_sfx_loop_handle(SFX_HANDLE("generic_shot"));
 
 		cmplx v = -20 * I;
 		int power_rank = player_get_effective_power(plr) / 100;
@@ -121,7 +121,7 @@ TASK(youmu_haunting_shot_basic, { YoumuBController *ctrl; }) {
 
 	for(;;) {
 		WAIT_EVENT_OR_DIE(&plr->events.shoot);
-		play_sfx_loop("generic_shot");
+		play_sfx_loop_handle(SFX_HANDLE("generic_shot"));
 
 		cmplx v = -20 * I;
 
@@ -0,0 +1,330 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "profiler.h"
+
+#include "log.h"
+#include "memory/scratch.h"
+#include "thread.h"
+#include "util/env.h"
+#include "util/strbuf.h"
+#include "util/stringops.h"
+#include "util/systime.h"
+#include "vfs/public.h"
+
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+
+// Must be a power of two
+#define PROFILER_RING_SIZE (1 << 14)
+
+// Smoothing factor for the per-frame averages, as a right shift
+#define PROFILER_AVG_SHIFT 4
+
+typedef struct ProfilerEvent {
+	const char *name;
+	hrtime_t begin;
+	hrtime_t end;
+} ProfilerEvent;
+
+typedef struct ProfilerThreadBuffer ProfilerThreadBuffer;
+
+struct ProfilerThreadBuffer {
+	ProfilerThreadBuffer *next;
+	ThreadID thread_id;
+	char thread_name[32];
+	uint head;
+	ProfilerEvent events[PROFILER_RING_SIZE];
+};
+
+typedef struct ProfilerZoneAccum {
+	const char *name;
+	hrtime_t frame_time;
+	uint frame_calls;
+	hrtime_t avg_time;
+	float avg_calls;
+} ProfilerZoneAccum;
+
+bool _profiler_enabled;
+
+static struct {
+	SDL_Mutex *mutex;
+	SDL_TLSID tls;
+	ProfilerThreadBuffer *buffers;
+	hrtime_t epoch;
+
+	struct {
+		ProfilerZoneAccum zones[PROFILER_MAX_ZONE_STATS];
+		uint num_zones;
+	} main_thread;
+
+	char *trace_on_exit;
+} profiler;
+
+void profiler_init(void) {
+	if(!env_get("TAISEI_PROFILER", false)) {
+		return;
+	}
+
+	if(!(profiler.mutex = SDL_CreateMutex())) {
+		log_sdl_error(LOG_ERROR, "SDL_CreateMutex");
+		return;
+	}
+
+	const char *trace_path = env_get("TAISEI_PROFILER_TRACE", "");
+
+	if(*trace_path) {
+		profiler.trace_on_exit = mem_strdup(trace_path);
+	}
+
+	profiler.epoch = time_get();
+	_profiler_enabled = true;
+	log_info("Profiler enabled");
+}
+
+void profiler_shutdown(void) {
+	if(!_profiler_enabled) {
+		return;
+	}
+
+	if(profiler.trace_on_exit) {
+		profiler_export_trace(profiler.trace_on_exit);
+		mem_free(profiler.trace_on_exit);
+	}
+
+	_profiler_enabled = false;
+
+	// NOTE: other threads must not be recording at this point
+	for(ProfilerThreadBuffer *b = profiler.buffers, *next; b; b = next) {
+		next = b->next;
+		mem_free(b);
+	}
+
+	SDL_DestroyMutex(profiler.mutex);
+	profiler = (typeof(profiler)) {};
+}
+
+static ProfilerThreadBuffer *profiler_get_thread_buffer(void) {
+	ProfilerThreadBuffer *buf = SDL_GetTLS(&profiler.tls);
+
+	if(LIKELY(buf)) {
+		return buf;
+	}
+
+	buf = ALLOC(ProfilerThreadBuffer, {
+		.thread_id = thread_get_current_id(),
+	});
+
+	Thread *thrd = thread_get_current();
+
+	if(thrd) {
+		strlcpy(buf->thread_name, thread_get_name(thrd), sizeof(buf->thread_name));
+	} else if(thread_current_is_main()) {
+		strlcpy(buf->thread_name, "Main", sizeof(buf->thread_name));
+	} else {
+		snprintf(buf->thread_name, sizeof(buf->thread_name), "%llx", (unsigned long long)buf->thread_id);
+	}
+
+	// The buffer is owned by the profiler and outlives the thread, so that its events can still be exported.
+	if(!SDL_SetTLS(&profiler.tls, buf, NULL)) {
+		log_sdl_error(LOG_ERROR, "SDL_SetTLS");
+	}
+
+	SDL_LockMutex(profiler.mutex);
+	buf->next = profiler.buffers;
+	profiler.buffers = buf;
+	SDL_UnlockMutex(profiler.mutex);
+
+	return buf;
+}
+
+static void profiler_accumulate_main(const char *name, hrtime_t time) {
+	auto mt = &profiler.main_thread;
+
+	for(uint i = 0; i < mt->num_zones; ++i) {
+		ProfilerZoneAccum *z = mt->zones + i;
+
+		if(z->name == name) {
+			z->frame_time += time;
+			z->frame_calls += 1;
+			return;
+		}
+	}
+
+	if(mt->num_zones < ARRAY_SIZE(mt->zones)) {
+		mt->zones[mt->num_zones++] = (ProfilerZoneAccum) {
+			.name = name,
+			.frame_time = time,
+			.frame_calls = 1,
+		};
+	}
+}
+
+void _profiler_record(const char *name, hrtime_t begin, hrtime_t end) {
+	ProfilerThreadBuffer *buf = profiler_get_thread_buffer();
+	buf->events[buf->head++ & (PROFILER_RING_SIZE - 1)] = (ProfilerEvent) {
+		.name = name,
+		.begin = begin,
+		.end = end,
+	};
+
+	if(thread_current_is_main()) {
+		profiler_accumulate_main(name, end - begin);
+	}
+}
+
+void profiler_frame_end(void) {
+	if(!profiler_enabled()) {
+		return;
+	}
+
+	auto mt = &profiler.main_thread;
+
+	for(uint i = 0; i < mt->num_zones; ++i) {
+		ProfilerZoneAccum *z = mt->zones + i;
+		z->avg_time += ((shrtime_t)z->frame_time - (shrtime_t)z->avg_time) >> PROFILER_AVG_SHIFT;
+		z->avg_calls += (z->frame_calls - z->avg_calls) / (1 << PROFILER_AVG_SHIFT);
+		z->frame_time = 0;
+		z->frame_calls = 0;
+	}
+}
+
+static int profiler_zone_stats_cmp(const void *a, const void *b) {
+	const ProfilerZoneStats *za = a, *zb = b;
+	return (za->avg_time < zb->avg_time) - (za->avg_time > zb->avg_time);
+}
+
+uint profiler_get_zone_stats(uint max_stats, ProfilerZoneStats out_stats[max_stats]) {
+	auto mt = &profiler.main_thread;
+	ProfilerZoneStats tmp[ARRAY_SIZE(mt->zones)];
+
+	for(uint i = 0; i < mt->num_zones; ++i) {
+		tmp[i] = (ProfilerZoneStats) {
+			.name = mt->zones[i].name,
+			.avg_time = mt->zones[i].avg_time,
+			.avg_calls = mt->zones[i].avg_calls,
+		};
+	}
+
+	qsort(tmp, mt->num_zones, sizeof(*tmp), profiler_zone_stats_cmp);
+
+	uint n = min(max_stats, mt->num_zones);
+	memcpy(out_stats, tmp, sizeof(*tmp) * n);
+	return n;
+}
+
+static void profiler_write_json_string(StringBuffer *sbuf, const char *str) {
+	strbuf_cat(sbuf, "\"");
+
+	for(const char *c = str; *c; ++c) {
+		if(*c == '"' || *c == '\\') {
+			strbuf_printf(sbuf, "\\%c", *c);
+		} else if((uchar)*c < 0x20) {
+			strbuf_printf(sbuf, "\\u%04x", (uchar)*c);
+		} else {
+			strbuf_ncat(sbuf, 1, c);
+		}
+	}
+
+	strbuf_cat(sbuf, "\"");
+}
+
+static void profiler_write_thread_events(SDL_IOStream *out, StringBuffer *sbuf, ProfilerThreadBuffer *buf, bool *first) {
+	uint head = buf->head;
+	uint count = min(head, PROFILER_RING_SIZE);
+
+	strbuf_clear(sbuf);
+	strbuf_printf(sbuf,
+		"%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%llu,\"args\":{\"name\":",
+		*first ? "" : ",", (unsigned long long)buf->thread_id
+	);
+	profiler_write_json_string(sbuf, buf->thread_name);
+	strbuf_cat(sbuf, "}}");
+	*first = false;
+
+	for(uint i = head - count; i != head; ++i) {
+		ProfilerEvent *e = buf->events + (i & (PROFILER_RING_SIZE - 1));
+
+		if(e->begin < profiler.epoch) {
+			continue;
+		}
+
+		strbuf_cat(sbuf, ",\n{\"name\":");
+		profiler_write_json_string(sbuf, e->name);
+		strbuf_printf(sbuf,
+			",\"ph\":\"X\",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f}",
+			(unsigned long long)buf->thread_id,
+			(e->begin - profiler.epoch) / 1000.0,
+			(e->end - e->begin) / 1000.0
+		);
+
+		if(sbuf->pos - sbuf->start > 0x10000) {
+			SDL_WriteIO(out, sbuf->start, sbuf->pos - sbuf->start);
+			strbuf_clear(sbuf);
+		}
+	}
+
+	SDL_WriteIO(out, sbuf->start, sbuf->pos - sbuf->start);
+}
+
+bool profiler_export_trace(const char *vfspath) {
+	if(!profiler_enabled()) {
+		log_warn("Profiler is disabled; set TAISEI_PROFILER=1 to enable it");
+		return false;
+	}
+
+	SDL_IOStream *out = vfs_open(vfspath, VFS_MODE_WRITE);
+
+	if(!out) {
+		log_error("VFS error: %s", vfs_get_error());
+		return false;
+	}
+
+	MemArena *scratch = acquire_scratch_arena();
+	StringBuffer sbuf = { scratch };
+	bool first = true;
+
+	strbuf_cat(&sbuf, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	SDL_WriteIO(out, sbuf.start, sbuf.pos - sbuf.start);
+
+	// NOTE: threads may still be recording while we read; at worst a few events at the tail get garbled.
+	SDL_LockMutex(profiler.mutex);
+
+	for(ProfilerThreadBuffer *b = profiler.buffers; b; b = b->next) {
+		profiler_write_thread_events(out, &sbuf, b, &first);
+	}
+
+	SDL_UnlockMutex(profiler.mutex);
+
+	SDL_WriteIO(out, "\n]}\n", 4);
+	SDL_CloseIO(out);
+	release_scratch_arena(scratch);
+
+	char *syspath = vfs_repr(vfspath, true);
+	log_info("Trace saved to %s", syspath ?: vfspath);
+	mem_free(syspath);
+
+	return true;
+}
+
+void profiler_export_trace_auto(void) {
+	SystemTime systime;
+	char timestamp[FILENAME_TIMESTAMP_MIN_BUF_SIZE];
+	get_system_time(&systime);
+	filename_timestamp(timestamp, sizeof(timestamp), systime);
+
+	if(!vfs_mkdir("storage/traces")) {
+		log_error("VFS error: %s", vfs_get_error());
+		return;
+	}
+
+	StringBuffer buf = { acquire_scratch_arena() };
+	strbuf_printf(&buf, "storage/traces/taisei_%s.json", timestamp);
+	profiler_export_trace(buf.start);
+	release_scratch_arena(buf.arena);
+}
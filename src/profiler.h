@@ -0,0 +1,82 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "hirestime.h"
+
+/*
+ * Lightweight scoped-zone profiler.
+ *
+ * Zones are recorded into per-thread ring buffers and can be exported as a Chrome trace
+ * (chrome://tracing, Perfetto). Zones recorded on the main thread are also aggregated per
+ * frame for the on-screen breakdown.
+ *
+ * Zone names must be string literals (or otherwise outlive the profiler); they are compared
+ * by pointer.
+ *
+ * When disabled (the default, see TAISEI_PROFILER), a zone costs one predictable branch.
+ */
+
+#define PROFILER_MAX_ZONE_STATS 32
+
+typedef struct ProfilerZone {
+	const char *name;
+	hrtime_t begin;
+} ProfilerZone;
+
+typedef struct ProfilerZoneStats {
+	const char *name;
+	hrtime_t avg_time;   // exponential moving average of the total time per frame
+	float avg_calls;
+} ProfilerZoneStats;
+
+extern bool _profiler_enabled;
+
+void profiler_init(void);
+void profiler_shutdown(void);
+
+void _profiler_record(const char *name, hrtime_t begin, hrtime_t end);
+
+INLINE bool profiler_enabled(void) {
+	return UNLIKELY(_profiler_enabled);
+}
+
+INLINE ProfilerZone profiler_zone_begin(const char *name) {
+	if(!profiler_enabled()) {
+		return (ProfilerZone) {};
+	}
+
+	return (ProfilerZone) { name, time_get() };
+}
+
+INLINE void profiler_zone_end(ProfilerZone zone) {
+	if(zone.name) {
+		_profiler_record(zone.name, zone.begin, time_get());
+	}
+}
+
+// Wraps a statement or block in a zone. Don't jump out of it.
+#define PROFILE_ZONE(name, ...) do { \
+	ProfilerZone _profiler_zone = profiler_zone_begin(name); \
+	__VA_ARGS__; \
+	profiler_zone_end(_profiler_zone); \
+} while(0)
+
+// Call once per main loop iteration, on the main thread.
+void profiler_frame_end(void);
+
+// Writes all events currently held in the ring buffers as a Chrome trace JSON file.
+bool profiler_export_trace(const char *vfspath) attr_nonnull_all;
+
+// Same as above, with a timestamped file name under storage/traces.
+void profiler_export_trace_auto(void);
+
+// Fills out with the aggregated main thread zones, sorted by cost. Returns the number of entries written.
+uint profiler_get_zone_stats(uint max_stats, ProfilerZoneStats out_stats[max_stats]);
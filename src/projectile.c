@@ -10,11 +10,14 @@
 
 #include "global.h"
 #include "list.h"
+#include "particle.h"
 #include "stageobjects.h"
+#include "stagedraw.h"
 #include "util/glm.h"
 #include "stage.h"
 
 static ht_ptr2int_t shader_sublayer_map;
+static uint32_t projs_generation;
 
 static ProjArgs defaults_proj = {
 	.sprite = "proj/",
@@ -206,6 +209,19 @@ static double projectile_rect_area(Projectile *p) {
 	return re(s) * im(s);
 }
 
+drawlayer_t projectile_particle_layer(drawlayer_t layer, ShaderProgram *shader) {
+	if(!(layer & LAYER_LOW_MASK)) {
+		// 1. Group by shader (hardcoded precedence).
+		drawlayer_low_t sublayer = ht_get(&shader_sublayer_map, shader, 0) & 0xf;
+		sublayer <<= 4;
+		sublayer |= 0x100;
+		// If specific blending order is required, then you should set up the sublayer manually.
+		layer |= sublayer;
+	}
+
+	return layer;
+}
+
 void projectile_set_layer(Projectile *p, drawlayer_t layer) {
 	if(!(layer & LAYER_LOW_MASK)) {
 		drawlayer_low_t sublayer;
@@ -222,12 +238,7 @@ void projectile_set_layer(Projectile *p, drawlayer_t layer) {
 				break;
 
 			case PROJ_PARTICLE:
-				// 1. Group by shader (hardcoded precedence).
-				sublayer = ht_get(&shader_sublayer_map, p->shader, 0) & 0xf;
-				sublayer <<= 4;
-				sublayer |= 0x100;
-				// If specific blending order is required, then you should set up the sublayer manually.
-				layer |= sublayer;
+				layer = projectile_particle_layer(layer, p->shader);
 				break;
 
 			default:
@@ -239,6 +250,11 @@ void projectile_set_layer(Projectile *p, drawlayer_t layer) {
 }
 
 static void ent_draw_projectile(EntityInterface *ent);
+static bool ent_projectile_visual_bounds(EntityInterface *ent, Rect *out_bounds);
+
+uint32_t projectiles_get_generation(void) {
+	return projs_generation;
+}
 
 static Projectile* _create_projectile(ProjArgs *args) {
 	if(IN_DRAW_CODE) {
@@ -272,6 +288,7 @@ static Projectile* _create_projectile(ProjArgs *args) {
 	p->_cached_angle = p->angle;
 
 	p->ent.draw_func = ent_draw_projectile;
+	p->ent.visual_bounds_func = ent_projectile_visual_bounds;
 
 	projectile_set_prototype(p, args->proto);
 
@@ -292,6 +309,10 @@ static Projectile* _create_projectile(ProjArgs *args) {
 	ent_register(&p->ent, ENT_TYPE_ID(Projectile));
 	alist_append(args->dest, p);
 
+	if(args->dest == &global.projs) {
+		++projs_generation;
+	}
+
 	return p;
 }
 
@@ -300,8 +321,54 @@ Projectile* create_projectile(ProjArgs *args) {
 	return _create_projectile(args);
 }
 
+/*
+ * Stands in for particles that would never be drawn (see stage_should_spawn_particle()).
+ * Callers may freely write to it, but it is never registered, so any handle to it unboxes to NULL:
+ * tasks bound to it are cancelled and entity arrays drop it, as if it had expired immediately.
+ * Its events are zeroed, which makes them read as already cancelled.
+ */
+static Projectile *get_dummy_particle(ProjArgs *args) {
+	static Projectile dummy;
+
+	dummy = (Projectile) {
+		.birthtime = global.frames,
+		.pos = args->pos,
+		.pos0 = args->pos,
+		.prevpos = args->pos,
+		.angle = args->angle,
+		.angle_delta = args->angle_delta,
+		.draw_rule = args->draw_rule,
+		.shader = args->shader_ptr,
+		.blend = args->blend,
+		.sprite = args->sprite_ptr,
+		.type = args->type,
+		.color = *args->color,
+		.size = args->size,
+		.flags = args->flags | PFLAG_INTERNAL_DEAD | PFLAG_NOCOLLISION | PFLAG_NOCLEAR,
+		.timeout = args->timeout,
+		.move = args->move,
+		.scale = args->scale,
+		.opacity = args->opacity,
+	};
+
+	dummy.ent.type = ENT_TYPE_ID(Projectile);
+	dummy.ent.draw_layer = LAYER_NODRAW;
+
+	return &dummy;
+}
+
 Projectile* create_particle(ProjArgs *args) {
 	process_projectile_args(args, &defaults_part);
+
+	if(
+		args->type == PROJ_PARTICLE &&
+		!stage_should_spawn_particle(args->flags & (
+			PFLAG_REQUIREDPARTICLE | PFLAG_PLRSPECIALPARTICLE | PFLAG_ALWAYSSPAWN
+		))
+	) {
+		return get_dummy_particle(args);
+	}
+
 	return _create_projectile(args);
 }
 
@@ -323,6 +390,10 @@ static void signal_event_with_collision_result(Projectile *p, CoEvent *evt, Proj
 }
 
 static void delete_projectile(ProjectileList *projlist, Projectile *p, ProjCollisionResult *col) {
+	if(projlist == &global.projs) {
+		++projs_generation;
+	}
+
 	signal_event_with_collision_result(p, &p->events.killed, col);
 	COEVENT_CANCEL_ARRAY(p->events);
 	ent_unregister(&p->ent);
@@ -503,24 +574,42 @@ bool projectile_in_viewport(Projectile *proj) {
 	return true;
 }
 
-Projectile *spawn_projectile_collision_effect(Projectile *proj) {
+// Flags that a particle spawned from this projectile should inherit
+static ParticleFlags projectile_particle_flags(Projectile *proj) {
+	ParticleFlags flags = 0;
+
+	if(proj->flags & PFLAG_NOMOVE) {
+		flags |= PARTFLAG_NOMOVE;
+	}
+
+	if(proj->flags & PFLAG_MANUALANGLE) {
+		flags |= PARTFLAG_MANUALANGLE;
+	}
+
+	if(proj->flags & PFLAG_NOAUTOREMOVE) {
+		flags |= PARTFLAG_NOAUTOREMOVE;
+	}
+
+	return flags;
+}
+
+void spawn_projectile_collision_effect(Projectile *proj) {
 	if(proj->flags & PFLAG_NOCOLLISIONEFFECT) {
-		return NULL;
+		return;
 	}
 
 	if(proj->sprite == NULL) {
-		return NULL;
+		return;
 	}
 
-	return PARTICLE(
+	FXPARTICLE(
 		.sprite_ptr = proj->sprite,
-		.size = proj->size,
 		.pos = proj->pos,
 		.color = &proj->color,
-		.flags = proj->flags | PFLAG_NOREFLECT | PFLAG_REQUIREDPARTICLE,
+		.flags = projectile_particle_flags(proj) | PARTFLAG_NOREFLECT | PARTFLAG_REQUIRED,
 		.layer = LAYER_PARTICLE_HIGH,
 		.shader_ptr = proj->shader,
-		.draw_rule = pdraw_timeout_scale(2+I, 0.0001+I),
+		.draw_rule = partdraw_timeout_scale(2+I, 0.0001+I),
 		.angle = proj->angle,
 		.move = { .velocity = 5 * cdir(proj->angle), .retention = 0.95 },
 		.timeout = 10,
@@ -613,6 +702,11 @@ void process_projectiles(ProjectileList *projlist, bool collision) {
 		apply_projectile_collision(projlist, proj, &col);
 	}
 
+	// After the move, so that anything indexed by position mid-update is not considered current
+	if(projlist == &global.projs) {
+		++projs_generation;
+	}
+
 	for(Projectile *proj = projlist->first, *next; proj; proj = next) {
 		next = proj->next;
 
@@ -772,35 +866,9 @@ static Projectile* spawn_bullet_spawning_effect(Projectile *p) {
 	return NULL;
 }
 
-static void projectile_clear_effect_draw(Projectile *p, int t, ProjDrawRuleArgs args) {
-	float o_tf = projectile_timeout_factor(p);
-	float tf = glm_ease_circ_out(o_tf);
-
-	Animation *ani = args[0].as_ptr;
-	AniSequence *seq = args[1].as_ptr;
-	float angle = args[2].as_float[0];
-	float scale = args[2].as_float[1];
-
-	SpriteParamsBuffer spbuf;
-	SpriteParams sp = projectile_sprite_params(p, &spbuf);
-
-	float o = spbuf.shader_params.vector[0];
-	spbuf.shader_params.vector[0] = o * max(0, 1.5f * (1 - tf) - 0.5f);
-
-	r_draw_sprite(&sp);
-
-	sp.sprite_ptr = animation_get_frame(ani, seq, o_tf * (seq->length - 1));
-	sp.scale.as_cmplx *= scale * (0.0f + 1.5f * tf);
-	spbuf.color.a *= (1 - tf);
-	spbuf.shader_params.vector[0] = o;
-	sp.rotation.angle += angle;
-
-	r_draw_sprite(&sp);
-}
-
-Projectile *spawn_projectile_clear_effect(Projectile *proj) {
+void spawn_projectile_clear_effect(Projectile *proj) {
 	if((proj->flags & PFLAG_NOCLEAREFFECT) || proj->sprite == NULL) {
-		return NULL;
+		return;
 	}
 
 	cmplx v = proj->move.velocity;
@@ -814,19 +882,13 @@ Projectile *spawn_projectile_clear_effect(Projectile *proj) {
 	Sprite *sprite_ref = animation_get_frame(ani, seq, 0);
 	float scale = max(proj->sprite->w, proj->sprite->h) / sprite_ref->w;
 
-	return PARTICLE(
+	FXPARTICLE(
 		.sprite_ptr = proj->sprite,
-		.size = proj->size,
 		.pos = proj->pos,
 		.color = &proj->color,
-		.flags = proj->flags | PFLAG_NOREFLECT | PFLAG_REQUIREDPARTICLE,
+		.flags = projectile_particle_flags(proj) | PARTFLAG_NOREFLECT | PARTFLAG_REQUIRED,
 		.shader_ptr = proj->shader,
-		.draw_rule = {
-			projectile_clear_effect_draw,
-			.args[0].as_ptr = ani,
-			.args[1].as_ptr = seq,
-			.args[2].as_float = { rng_angle(), scale },
-		},
+		.draw_rule = partdraw_clear_effect(ani, seq, rng_angle(), scale),
 		.angle = proj->angle,
 		.opacity = proj->opacity,
 		.scale = proj->scale,
@@ -1029,19 +1091,58 @@ ProjDrawRule pdraw_petal_random(void) {
 	return pdraw_petal(rot_angle, (vec3) { x, y, z });
 }
 
+static bool ent_projectile_visual_bounds(EntityInterface *ent, Rect *out_bounds) {
+	Projectile *p = ENT_CAST(ent, Projectile);
+
+	if(!p->sprite) {
+		return false;
+	}
+
+	auto rule = &p->draw_rule;
+	cmplxf scale = p->scale;
+
+	// Only the standard draw rules are understood; anything custom may draw anywhere.
+	if(rule->func == pdraw_scalefade_func) {
+		// The scale is interpolated between these two over the projectile's lifetime
+		cmplxf s0 = rule->args[0].as_cmplx;
+		cmplxf s1 = rule->args[1].as_cmplx;
+		scale = cwmulf(scale, CMPLXF(
+			max(fabsf(re(s0)), fabsf(re(s1))),
+			max(fabsf(im(s0)), fabsf(im(s1)))
+		));
+	} else if(rule->func == pdraw_blast_func) {
+		// Overrides the scale entirely
+		float secondary_scale = rule->args[2].as_float[0];
+		scale = max(1.0f, secondary_scale) * (1 + I);
+	} else if(rule->func != pdraw_basic_func && rule->func != pdraw_petal_func) {
+		return false;
+	}
+
+	// Radius of the circle enclosing the sprite quad, so that any rotation (even 3D) stays inside
+	cmplx ext = cwmul(p->sprite->extent.as_cmplx, CMPLX(fabsf(re(scale)), fabsf(im(scale))));
+	cmplx r = 0.5 * cabs(ext) * (1 + I);
+
+	*out_bounds = (Rect) {
+		.top_left = p->pos - r,
+		.bottom_right = p->pos + r,
+	};
+
+	return true;
+}
+
 void petal_explosion(int n, cmplx pos) {
 	for(int i = 0; i < n; i++) {
 		cmplx v = rng_dir();
 		v *= rng_range(3, 8);
 		real t = rng_real();
 
-		PARTICLE(
+		FXPARTICLE(
 			.sprite = "petal",
 			.pos = pos,
 			.color = RGBA(sin(5*t) * t, cos(5*t) * t, 0.5 * t, 0),
 			.move = move_asymptotic_simple(v, 5),
-			.draw_rule = pdraw_petal_random(),
-			.flags = (n % 2 ? 0 : PFLAG_REQUIREDPARTICLE) | PFLAG_MANUALANGLE,
+			.draw_rule = partdraw_petal_random(),
+			.flags = (n % 2 ? 0 : PARTFLAG_REQUIRED) | PARTFLAG_MANUALANGLE,
 			.layer = LAYER_PARTICLE_PETAL,
 		);
 	}
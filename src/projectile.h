@@ -79,6 +79,7 @@ typedef enum ProjFlags {
 	PFLAG_MANUALANGLE = (1 << 14),          // [ALL] Don't automatically update the angle.
 	PFLAG_NOAUTOREMOVE = (1 << 15),         // [ALL] Don't automatically remove when outside viewport.
 	PFLAG_INDESTRUCTIBLE = (1 << 16),       // [PROJ_ENEMY, PROJ_PLAYER] Projectile doesn't get destroyed on collision.
+	PFLAG_ALWAYSSPAWN = (1 << 17),          // [PROJ_PARTICLE] Spawn even if never drawn. Use if the game logic depends on its lifetime, e.g. draws RNG for it every frame.
 
 	PFLAG_NOSPAWNEFFECTS = PFLAG_NOSPAWNFADE | PFLAG_NOSPAWNFLARE,
 } ProjFlags;
@@ -241,13 +242,19 @@ bool projectile_in_viewport(Projectile *proj) attr_nonnull_all;
 void process_projectiles(ProjectileList *projlist, bool collision) attr_hot attr_nonnull_all;
 bool projectile_is_clearable(Projectile *p) attr_nonnull_all;
 
-Projectile *spawn_projectile_collision_effect(Projectile *proj) attr_nonnull_all;
-Projectile *spawn_projectile_clear_effect(Projectile *proj) attr_nonnull_all;
+// Changes whenever global.projs gains or loses projectiles, or gets processed.
+uint32_t projectiles_get_generation(void);
+
+void spawn_projectile_collision_effect(Projectile *proj) attr_nonnull_all;
+void spawn_projectile_clear_effect(Projectile *proj) attr_nonnull_all;
 Projectile *spawn_projectile_highlight_effect(Projectile *proj) attr_nonnull_all;
 
 void projectile_set_prototype(Projectile *p, ProjPrototype *proto) attr_nonnull(1);
 void projectile_set_layer(Projectile *p, drawlayer_t layer) attr_nonnull_all;
 
+// Picks the default sublayer for a particle drawn with the given shader, unless one is already set
+drawlayer_t projectile_particle_layer(drawlayer_t layer, ShaderProgram *shader);
+
 bool clear_projectile(Projectile *proj, uint flags) attr_nonnull_all;
 void kill_projectile(Projectile *proj) attr_nonnull_all;
 
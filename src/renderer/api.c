@@ -411,7 +411,9 @@ ShaderProgram* r_shader_current(void) {
 }
 
 Uniform* _r_shader_uniform(ShaderProgram *prog, const char *uniform_name, hash_t uniform_name_hash) {
-	return B.shader_uniform(prog, uniform_name, uniform_name_hash);
+	Uniform *uniform = B.shader_uniform(prog, uniform_name, uniform_name_hash);
+	_r_sprite_batch_uniform_resolved(uniform, prog);
+	return uniform;
 }
 
 UniformType r_uniform_type(Uniform *uniform) {
@@ -868,6 +870,11 @@ void r_swap(SDL_Window *window) {
 
 // uniforms garbage; hope your compiler is smart enough to inline most of this
 
+INLINE void set_uniform(Uniform *uniform, uint offset, uint count, const void *data) {
+	_r_sprite_batch_uniform_changed(uniform);
+	B.uniform(uniform, offset, count, data);
+}
+
 // TODO: verify sampler-to-texture type consistency?
 
 #define ASSERT_UTYPE(uniform, type) do { \
@@ -884,12 +891,12 @@ void r_swap(SDL_Window *window) {
 } while(0)
 
 void r_uniform_ptr_unsafe(Uniform *uniform, uint offset, uint count, void *data) {
-	if(uniform) B.uniform(uniform, offset, count, data);
+	if(uniform) set_uniform(uniform, offset, count, data);
 }
 
 void _r_uniform_ptr_float(Uniform *uniform, float value) {
 	ASSERT_UTYPE(uniform, UNIFORM_FLOAT);
-	if(uniform) B.uniform(uniform, 0, 1, &value);
+	if(uniform) set_uniform(uniform, 0, 1, &value);
 }
 
 void _r_uniform_float(const char *uniform, float value) {
@@ -898,7 +905,7 @@ void _r_uniform_float(const char *uniform, float value) {
 
 void _r_uniform_ptr_float_array(Uniform *uniform, uint offset, uint count, float elements[count]) {
 	ASSERT_UTYPE(uniform, UNIFORM_FLOAT);
-	if(uniform && count) B.uniform(uniform, offset, count, elements);
+	if(uniform && count) set_uniform(uniform, offset, count, elements);
 }
 
 void _r_uniform_float_array(const char *uniform, uint offset, uint count, float elements[count]) {
@@ -915,7 +922,7 @@ void _r_uniform_vec2(const char *uniform, float x, float y) {
 
 void _r_uniform_ptr_vec2_vec(Uniform *uniform, vec2_noalign value) {
 	ASSERT_UTYPE(uniform, UNIFORM_VEC2);
-	if(uniform) B.uniform(uniform, 0, 1, value);
+	if(uniform) set_uniform(uniform, 0, 1, value);
 }
 
 void _r_uniform_vec2_vec(const char *uniform, vec2_noalign value) {
@@ -924,7 +931,7 @@ void _r_uniform_vec2_vec(const char *uniform, vec2_noalign value) {
 
 void _r_uniform_ptr_vec2_complex(Uniform *uniform, cmplx value) {
 	ASSERT_UTYPE(uniform, UNIFORM_VEC2);
-	if(uniform) B.uniform(uniform, 0, 1, (vec2_noalign) { re(value), im(value) });
+	if(uniform) set_uniform(uniform, 0, 1, (vec2_noalign) { re(value), im(value) });
 }
 
 void _r_uniform_vec2_complex(const char *uniform, cmplx value) {
@@ -933,7 +940,7 @@ void _r_uniform_vec2_complex(const char *uniform, cmplx value) {
 
 void _r_uniform_ptr_vec2_array(Uniform *uniform, uint offset, uint count, vec2_noalign elements[count]) {
 	ASSERT_UTYPE(uniform, UNIFORM_VEC2);
-	if(uniform && count) B.uniform(uniform, offset, count, elements);
+	if(uniform && count) set_uniform(uniform, offset, count, elements);
 }
 
 void _r_uniform_vec2_array(const char *uniform, uint offset, uint count, vec2_noalign elements[count]) {
@@ -952,7 +959,7 @@ void _r_uniform_ptr_vec2_array_complex(Uniform *uniform, uint offset, uint count
 			*aptr++ = im(*eptr++);
 		} while(aptr < aend);
 
-		B.uniform(uniform, offset, count, arr);
+		set_uniform(uniform, offset, count, arr);
 	}
 }
 
@@ -962,7 +969,7 @@ void _r_uniform_vec2_array_complex(const char *uniform, uint offset, uint count,
 
 void _r_uniform_ptr_vec3(Uniform *uniform, float x, float y, float z) {
 	ASSERT_UTYPE(uniform, UNIFORM_VEC3);
-	if(uniform) B.uniform(uniform, 0, 1, (vec3_noalign) { x, y, z });
+	if(uniform) set_uniform(uniform, 0, 1, (vec3_noalign) { x, y, z });
 }
 
 void _r_uniform_vec3(const char *uniform, float x, float y, float z) {
@@ -971,7 +978,7 @@ void _r_uniform_vec3(const char *uniform, float x, float y, float z) {
 
 void _r_uniform_ptr_vec3_vec(Uniform *uniform, vec3_noalign value) {
 	ASSERT_UTYPE(uniform, UNIFORM_VEC3);
-	if(uniform) B.uniform(uniform, 0, 1, value);
+	if(uniform) set_uniform(uniform, 0, 1, value);
 }
 
 void _r_uniform_vec3_vec(const char *uniform, vec3_noalign value) {
@@ -988,7 +995,7 @@ void _r_uniform_vec3_rgb(const char *uniform, const Color *rgb) {
 
 void _r_uniform_ptr_vec3_array(Uniform *uniform, uint offset, uint count, vec3_noalign elements[count]) {
 	ASSERT_UTYPE(uniform, UNIFORM_VEC3);
-	if(uniform) B.uniform(uniform, offset, count, elements);
+	if(uniform) set_uniform(uniform, offset, count, elements);
 }
 
 void _r_uniform_vec3_array(const char *uniform, uint offset, uint count, vec3_noalign elements[count]) {
@@ -997,7 +1004,7 @@ void _r_uniform_vec3_array(const char *uniform, uint offset, uint count, vec3_no
 
 void _r_uniform_ptr_vec4(Uniform *uniform, float x, float y, float z, float w) {
 	ASSERT_UTYPE(uniform, UNIFORM_VEC4);
-	if(uniform) B.uniform(uniform, 0, 1, (vec4_noalign) { x, y, z, w });
+	if(uniform) set_uniform(uniform, 0, 1, (vec4_noalign) { x, y, z, w });
 }
 
 void _r_uniform_vec4(const char *uniform, float x, float y, float z, float w) {
@@ -1006,7 +1013,7 @@ void _r_uniform_vec4(const char *uniform, float x, float y, float z, float w) {
 
 void _r_uniform_ptr_vec4_vec(Uniform *uniform, vec4_noalign value) {
 	ASSERT_UTYPE(uniform, UNIFORM_VEC4);
-	if(uniform) B.uniform(uniform, 0, 1, value);
+	if(uniform) set_uniform(uniform, 0, 1, value);
 }
 
 void _r_uniform_vec4_vec(const char *uniform, vec4_noalign value) {
@@ -1023,7 +1030,7 @@ void _r_uniform_vec4_rgba(const char *uniform, const Color *rgba) {
 
 void _r_uniform_ptr_vec4_array(Uniform *uniform, uint offset, uint count, vec4_noalign elements[count]) {
 	ASSERT_UTYPE(uniform, UNIFORM_VEC4);
-	if(uniform) B.uniform(uniform, offset, count, elements);
+	if(uniform) set_uniform(uniform, offset, count, elements);
 }
 
 void _r_uniform_vec4_array(const char *uniform, uint offset, uint count, vec4_noalign elements[count]) {
@@ -1032,7 +1039,7 @@ void _r_uniform_vec4_array(const char *uniform, uint offset, uint count, vec4_no
 
 void _r_uniform_ptr_mat3(Uniform *uniform, mat3_noalign value) {
 	ASSERT_UTYPE(uniform, UNIFORM_MAT3);
-	if(uniform) B.uniform(uniform, 0, 1, value);
+	if(uniform) set_uniform(uniform, 0, 1, value);
 }
 
 void _r_uniform_mat3(const char *uniform, mat3_noalign value) {
@@ -1041,7 +1048,7 @@ void _r_uniform_mat3(const char *uniform, mat3_noalign value) {
 
 void _r_uniform_ptr_mat3_array(Uniform *uniform, uint offset, uint count, mat3_noalign elements[count]) {
 	ASSERT_UTYPE(uniform, UNIFORM_MAT3);
-	if(uniform) B.uniform(uniform, offset, count, elements);
+	if(uniform) set_uniform(uniform, offset, count, elements);
 }
 
 void _r_uniform_mat3_array(const char *uniform, uint offset, uint count, mat3_noalign elements[count]) {
@@ -1050,7 +1057,7 @@ void _r_uniform_mat3_array(const char *uniform, uint offset, uint count, mat3_no
 
 void _r_uniform_ptr_mat4(Uniform *uniform, mat4_noalign value) {
 	ASSERT_UTYPE(uniform, UNIFORM_MAT4);
-	if(uniform) B.uniform(uniform, 0, 1, value);
+	if(uniform) set_uniform(uniform, 0, 1, value);
 }
 
 void _r_uniform_mat4(const char *uniform, mat4_noalign value) {
@@ -1059,7 +1066,7 @@ void _r_uniform_mat4(const char *uniform, mat4_noalign value) {
 
 void _r_uniform_ptr_mat4_array(Uniform *uniform, uint offset, uint count, mat4_noalign elements[count]) {
 	ASSERT_UTYPE(uniform, UNIFORM_MAT4);
-	if(uniform) B.uniform(uniform, offset, count, elements);
+	if(uniform) set_uniform(uniform, offset, count, elements);
 }
 
 void _r_uniform_mat4_array(const char *uniform, uint offset, uint count, mat4_noalign elements[count]) {
@@ -1068,7 +1075,7 @@ void _r_uniform_mat4_array(const char *uniform, uint offset, uint count, mat4_no
 
 void _r_uniform_ptr_int(Uniform *uniform, int value) {
 	ASSERT_UTYPE(uniform, UNIFORM_INT);
-	if(uniform) B.uniform(uniform, 0, 1, &value);
+	if(uniform) set_uniform(uniform, 0, 1, &value);
 }
 
 void _r_uniform_int(const char *uniform, int value) {
@@ -1077,7 +1084,7 @@ void _r_uniform_int(const char *uniform, int value) {
 
 void _r_uniform_ptr_int_array(Uniform *uniform, uint offset, uint count, int elements[count]) {
 	ASSERT_UTYPE(uniform, UNIFORM_INT);
-	if(uniform) B.uniform(uniform, offset, count, elements);
+	if(uniform) set_uniform(uniform, offset, count, elements);
 }
 
 void _r_uniform_int_array(const char *uniform, uint offset, uint count, int elements[count]) {
@@ -1094,7 +1101,7 @@ void _r_uniform_ivec2(const char *uniform, int x, int y) {
 
 void _r_uniform_ptr_ivec2_vec(Uniform *uniform, ivec2_noalign value) {
 	ASSERT_UTYPE(uniform, UNIFORM_IVEC2);
-	if(uniform) B.uniform(uniform, 0, 1, value);
+	if(uniform) set_uniform(uniform, 0, 1, value);
 }
 
 void _r_uniform_ivec2_vec(const char *uniform, ivec2_noalign value) {
@@ -1103,7 +1110,7 @@ void _r_uniform_ivec2_vec(const char *uniform, ivec2_noalign value) {
 
 void _r_uniform_ptr_ivec2_array(Uniform *uniform, uint offset, uint count, ivec2_noalign elements[count]) {
 	ASSERT_UTYPE(uniform, UNIFORM_IVEC2);
-	if(uniform && count) B.uniform(uniform, offset, count, elements);
+	if(uniform && count) set_uniform(uniform, offset, count, elements);
 }
 
 void _r_uniform_ivec2_array(const char *uniform, uint offset, uint count, ivec2_noalign elements[count]) {
@@ -1112,7 +1119,7 @@ void _r_uniform_ivec2_array(const char *uniform, uint offset, uint count, ivec2_
 
 void _r_uniform_ptr_ivec3(Uniform *uniform, int x, int y, int z) {
 	ASSERT_UTYPE(uniform, UNIFORM_IVEC3);
-	if(uniform) B.uniform(uniform, 0, 1, (ivec3_noalign) { x, y, z });
+	if(uniform) set_uniform(uniform, 0, 1, (ivec3_noalign) { x, y, z });
 }
 
 void _r_uniform_ivec3(const char *uniform, int x, int y, int z) {
@@ -1121,7 +1128,7 @@ void _r_uniform_ivec3(const char *uniform, int x, int y, int z) {
 
 void _r_uniform_ptr_ivec3_vec(Uniform *uniform, ivec3_noalign value) {
 	ASSERT_UTYPE(uniform, UNIFORM_IVEC3);
-	if(uniform) B.uniform(uniform, 0, 1, value);
+	if(uniform) set_uniform(uniform, 0, 1, value);
 }
 
 void _r_uniform_ivec3_vec(const char *uniform, ivec3_noalign value) {
@@ -1130,7 +1137,7 @@ void _r_uniform_ivec3_vec(const char *uniform, ivec3_noalign value) {
 
 void _r_uniform_ptr_ivec3_array(Uniform *uniform, uint offset, uint count, ivec3_noalign elements[count]) {
 	ASSERT_UTYPE(uniform, UNIFORM_IVEC3);
-	if(uniform) B.uniform(uniform, offset, count, elements);
+	if(uniform) set_uniform(uniform, offset, count, elements);
 }
 
 void _r_uniform_ivec3_array(const char *uniform, uint offset, uint count, ivec3_noalign elements[count]) {
@@ -1139,7 +1146,7 @@ void _r_uniform_ivec3_array(const char *uniform, uint offset, uint count, ivec3_
 
 void _r_uniform_ptr_ivec4(Uniform *uniform, int x, int y, int z, int w) {
 	ASSERT_UTYPE(uniform, UNIFORM_IVEC4);
-	if(uniform) B.uniform(uniform, 0, 1, (ivec4_noalign) { x, y, z, w });
+	if(uniform) set_uniform(uniform, 0, 1, (ivec4_noalign) { x, y, z, w });
 }
 
 void _r_uniform_ivec4(const char *uniform, int x, int y, int z, int w) {
@@ -1148,7 +1155,7 @@ void _r_uniform_ivec4(const char *uniform, int x, int y, int z, int w) {
 
 void _r_uniform_ptr_ivec4_vec(Uniform *uniform, ivec4_noalign value) {
 	ASSERT_UTYPE(uniform, UNIFORM_IVEC4);
-	if(uniform) B.uniform(uniform, 0, 1, value);
+	if(uniform) set_uniform(uniform, 0, 1, value);
 }
 
 void _r_uniform_ivec4_vec(const char *uniform, ivec4_noalign value) {
@@ -1157,7 +1164,7 @@ void _r_uniform_ivec4_vec(const char *uniform, ivec4_noalign value) {
 
 void _r_uniform_ptr_ivec4_array(Uniform *uniform, uint offset, uint count, ivec4_noalign elements[count]) {
 	ASSERT_UTYPE(uniform, UNIFORM_IVEC4);
-	if(uniform) B.uniform(uniform, offset, count, elements);
+	if(uniform) set_uniform(uniform, offset, count, elements);
 }
 
 void _r_uniform_ivec4_array(const char *uniform, uint offset, uint count, ivec4_noalign elements[count]) {
@@ -1166,7 +1173,7 @@ void _r_uniform_ivec4_array(const char *uniform, uint offset, uint count, ivec4_
 
 void _r_uniform_ptr_sampler_ptr(Uniform *uniform, Texture *tex) {
 	ASSERT_UTYPE_SAMPLER(uniform);
-	if(uniform) B.uniform(uniform, 0, 1, &tex);
+	if(uniform) set_uniform(uniform, 0, 1, &tex);
 }
 
 void _r_uniform_sampler_ptr(const char *uniform, Texture *tex) {
@@ -1175,7 +1182,7 @@ void _r_uniform_sampler_ptr(const char *uniform, Texture *tex) {
 
 void _r_uniform_ptr_sampler(Uniform *uniform, const char *tex) {
 	ASSERT_UTYPE_SAMPLER(uniform);
-	if(uniform) B.uniform(uniform, 0, 1, (Texture*[]) { res_texture(tex) });
+	if(uniform) set_uniform(uniform, 0, 1, (Texture*[]) { res_texture(tex) });
 }
 
 void _r_uniform_sampler(const char *uniform, const char *tex) {
@@ -1184,7 +1191,7 @@ void _r_uniform_sampler(const char *uniform, const char *tex) {
 
 void _r_uniform_ptr_sampler_array_ptr(Uniform *uniform, uint offset, uint count, Texture *values[count]) {
 	ASSERT_UTYPE_SAMPLER(uniform);
-	if(uniform && count) B.uniform(uniform, offset, count, values);
+	if(uniform && count) set_uniform(uniform, offset, count, values);
 }
 
 void _r_uniform_sampler_array_ptr(const char *uniform, uint offset, uint count, Texture *values[count]) {
@@ -1201,7 +1208,7 @@ void _r_uniform_ptr_sampler_array(Uniform *uniform, uint offset, uint count, con
 			*aptr++ = res_texture(*vptr++);
 		} while(aptr < aend);
 
-		B.uniform(uniform, 0, 1, arr);
+		set_uniform(uniform, 0, 1, arr);
 	}
 }
 
@@ -11,6 +11,7 @@
 #include "config.h"
 #include "i18n/i18n.h"
 #include "memory/scratch.h"
+#include "threaded.h"
 #include "util.h"
 #include "util/choice_dialog.h"
 #include "util/env.h"
@@ -208,6 +209,10 @@ void _r_backend_init(void) {
 	UNREACHABLE;
 
 done:
+	if(env_get("TAISEI_RENDERER_THREADED", false)) {
+		_r_threaded_wrap(&_r_backend);
+	}
+
 	initialized = true;
 	release_scratch_arena(scratch);
 }
@@ -10,6 +10,50 @@
 
 #include "util/miscmath.h"
 
+// Dirty runs separated by fewer clean pages than this are uploaded as a single range
+#define CACHEDBUF_MERGE_GAP_PAGES 4
+
+#define PAGE_WORD_BITS 64
+
+INLINE size_t cachedbuf_num_pages(size_t size) {
+	return (size + CACHEDBUF_PAGE_SIZE - 1) >> CACHEDBUF_PAGE_SHIFT;
+}
+
+INLINE size_t cachedbuf_num_page_words(size_t size) {
+	return (cachedbuf_num_pages(size) + PAGE_WORD_BITS - 1) / PAGE_WORD_BITS;
+}
+
+INLINE bool cachedbuf_page_is_dirty(CachedBuffer *cbuf, size_t page) {
+	return cbuf->dirty_pages[page / PAGE_WORD_BITS] & (1ull << (page % PAGE_WORD_BITS));
+}
+
+static void cachedbuf_mark_dirty(CachedBuffer *cbuf, size_t offset, size_t size) {
+	assert(size > 0);
+	assert(offset + size <= cbuf->size);
+
+	size_t first = offset >> CACHEDBUF_PAGE_SHIFT;
+	size_t last = (offset + size - 1) >> CACHEDBUF_PAGE_SHIFT;
+	size_t first_word = first / PAGE_WORD_BITS;
+	size_t last_word = last / PAGE_WORD_BITS;
+	uint64_t first_mask = ~0ull << (first % PAGE_WORD_BITS);
+	uint64_t last_mask = ~0ull >> (PAGE_WORD_BITS - 1 - last % PAGE_WORD_BITS);
+
+	if(first_word == last_word) {
+		cbuf->dirty_pages[first_word] |= first_mask & last_mask;
+	} else {
+		cbuf->dirty_pages[first_word] |= first_mask;
+
+		for(size_t w = first_word + 1; w < last_word; ++w) {
+			cbuf->dirty_pages[w] = ~0ull;
+		}
+
+		cbuf->dirty_pages[last_word] |= last_mask;
+	}
+
+	cbuf->update_begin = min(offset, cbuf->update_begin);
+	cbuf->update_end = max(offset + size, cbuf->update_end);
+}
+
 static int64_t cachedbuf_stream_seek(void *ctx, int64_t offset, SDL_IOWhence whence) {
 	CachedBuffer *cbuf = ctx;
 
@@ -53,10 +97,10 @@ static size_t cachedbuf_stream_write(
 	}
 
 	if(LIKELY(size > 0)) {
-		memcpy(cbuf->cache + cbuf->stream_offset, data, size);
-		cbuf->update_begin = min(cbuf->stream_offset, cbuf->update_begin);
-		cbuf->update_end = max(cbuf->stream_offset + size, cbuf->update_end);
+		memcpy(cbuf->cache + offset, data, size);
+		cachedbuf_mark_dirty(cbuf, offset, size);
 		cbuf->stream_offset += size;
+		cbuf->valid_end = max(cbuf->valid_end, cbuf->stream_offset);
 	}
 
 	return size;
@@ -69,13 +113,15 @@ void cachedbuf_init(CachedBuffer *cbuf) {
 			.write = cachedbuf_stream_write,
 			.seek = cachedbuf_stream_seek,
 			.size = cachedbuf_stream_size,
-		}, cbuf))
+		}, cbuf)),
+		.update_begin = SIZE_MAX,
 	};
 }
 
 void cachedbuf_deinit(CachedBuffer *cbuf) {
 	SDL_CloseIO(cbuf->stream);
 	mem_free(cbuf->cache);
+	mem_free(cbuf->dirty_pages);
 }
 
 void cachedbuf_resize(CachedBuffer *cbuf, size_t new_size) {
@@ -85,22 +131,115 @@ void cachedbuf_resize(CachedBuffer *cbuf, size_t new_size) {
 		return;
 	}
 
+	size_t old_words = cachedbuf_num_page_words(cbuf->size);
+	size_t new_words = cachedbuf_num_page_words(new_size);
+
+	if(new_words != old_words) {
+		cbuf->dirty_pages = mem_realloc(cbuf->dirty_pages, new_words * sizeof(*cbuf->dirty_pages));
+
+		if(new_words > old_words) {
+			memset(cbuf->dirty_pages + old_words, 0, (new_words - old_words) * sizeof(*cbuf->dirty_pages));
+		}
+	}
+
 	cbuf->size = new_size;
 	cbuf->cache = mem_realloc(cbuf->cache, new_size);
-	cbuf->update_begin = min(cbuf->update_begin, new_size);
 	cbuf->update_end = min(cbuf->update_end, new_size);
+	cbuf->valid_end = min(cbuf->valid_end, new_size);
 	cbuf->stream_offset = min(cbuf->stream_offset, new_size);
+
+	if(cbuf->update_begin >= cbuf->update_end) {
+		cbuf->update_begin = SIZE_MAX;
+		cbuf->update_end = 0;
+	}
 }
 
-CachedBufferUpdate cachedbuf_flush(CachedBuffer *cbuf) {
-	CachedBufferUpdate u = {
-		.offset = cbuf->update_begin,
-		.size = cbuf->update_end - min(cbuf->update_begin, cbuf->update_end),
-		.data = cbuf->cache + cbuf->update_begin,
-	};
+void cachedbuf_invalidate(CachedBuffer *cbuf) {
+	cbuf->stream_offset = 0;
+	cbuf->valid_end = 0;
+}
+
+// Finds the first page in [page, end) whose dirty bit equals `dirty`; returns `end` if there is none.
+static size_t cachedbuf_find_page(CachedBuffer *cbuf, size_t page, size_t end, bool dirty) {
+	uint64_t skip = dirty ? 0 : ~0ull;
 
-	cbuf->update_begin = 0;
+	while(page < end) {
+		if(page % PAGE_WORD_BITS == 0 && cbuf->dirty_pages[page / PAGE_WORD_BITS] == skip) {
+			page += PAGE_WORD_BITS;
+			continue;
+		}
+
+		if(cachedbuf_page_is_dirty(cbuf, page) == dirty) {
+			return page;
+		}
+
+		++page;
+	}
+
+	return end;
+}
+
+uint cachedbuf_flush(CachedBuffer *cbuf, bool storage_lost, CachedBufferUpdate updates[CACHEDBUF_MAX_UPDATES]) {
+	if(storage_lost && cbuf->valid_end > 0) {
+		cachedbuf_mark_dirty(cbuf, 0, cbuf->valid_end);
+	}
+
+	if(cbuf->update_begin >= cbuf->update_end) {
+		return 0;
+	}
+
+	size_t first_page = cbuf->update_begin >> CACHEDBUF_PAGE_SHIFT;
+	size_t end_page = ((cbuf->update_end - 1) >> CACHEDBUF_PAGE_SHIFT) + 1;
+	uint num_updates = 0;
+
+	// Collect runs of dirty pages as page ranges first; the last one absorbs everything past the limit
+	struct { size_t begin, end; } runs[CACHEDBUF_MAX_UPDATES];
+
+	for(size_t page = first_page; page < end_page;) {
+		size_t run_begin = cachedbuf_find_page(cbuf, page, end_page, true);
+
+		if(run_begin == end_page) {
+			break;
+		}
+
+		size_t run_end = cachedbuf_find_page(cbuf, run_begin, end_page, false);
+
+		if(num_updates > 0 && (
+			run_begin - runs[num_updates - 1].end < CACHEDBUF_MERGE_GAP_PAGES ||
+			num_updates == CACHEDBUF_MAX_UPDATES
+		)) {
+			runs[num_updates - 1].end = run_end;
+		} else {
+			runs[num_updates].begin = run_begin;
+			runs[num_updates].end = run_end;
+			++num_updates;
+		}
+
+		page = run_end;
+	}
+
+	for(uint i = 0; i < num_updates; ++i) {
+		size_t begin = max(runs[i].begin << CACHEDBUF_PAGE_SHIFT, cbuf->update_begin);
+		size_t end = min(runs[i].end << CACHEDBUF_PAGE_SHIFT, cbuf->update_end);
+
+		updates[i] = (CachedBufferUpdate) {
+			.offset = begin,
+			.size = end - begin,
+			.data = cbuf->cache + begin,
+		};
+
+		cbuf->stats.bytes_uploaded += end - begin;
+	}
+
+	size_t first_word = first_page / PAGE_WORD_BITS;
+	size_t end_word = (end_page + PAGE_WORD_BITS - 1) / PAGE_WORD_BITS;
+	memset(cbuf->dirty_pages + first_word, 0, (end_word - first_word) * sizeof(*cbuf->dirty_pages));
+
+	cbuf->update_begin = SIZE_MAX;
 	cbuf->update_end = 0;
 
-	return u;
+	cbuf->stats.num_uploads += num_updates;
+	cbuf->stats.num_flushes += num_updates > 0;
+
+	return num_updates;
 }
@@ -13,13 +13,29 @@
 
 typedef struct CachedBuffer CachedBuffer;
 
+// Dirty data is tracked at this granularity
+#define CACHEDBUF_PAGE_SHIFT 8
+#define CACHEDBUF_PAGE_SIZE (1 << CACHEDBUF_PAGE_SHIFT)
+
+// Maximum number of ranges returned by cachedbuf_flush()
+#define CACHEDBUF_MAX_UPDATES 8
+
+typedef struct CachedBufferStats {
+	uint64_t bytes_uploaded;
+	uint64_t num_uploads;   // ranges
+	uint64_t num_flushes;   // flushes that uploaded anything
+} CachedBufferStats;
+
 struct CachedBuffer {
 	SDL_IOStream *stream;
 	char *cache;
+	uint64_t *dirty_pages;  // bitmap, one bit per page
 	size_t size;
-	size_t update_begin;
+	size_t update_begin;    // bounds of the dirty data, in bytes
 	size_t update_end;
+	size_t valid_end;       // end of the data written since the last cachedbuf_invalidate()
 	size_t stream_offset;
+	CachedBufferStats stats;
 };
 
 typedef struct CachedBufferUpdate {
@@ -31,4 +47,11 @@ typedef struct CachedBufferUpdate {
 void cachedbuf_init(CachedBuffer *cbuf);
 void cachedbuf_deinit(CachedBuffer *cbuf);
 void cachedbuf_resize(CachedBuffer *cbuf, size_t newsize);
-CachedBufferUpdate cachedbuf_flush(CachedBuffer *cbuf);
+
+// Marks the contents as undefined; data written before this won't be re-uploaded if the storage is lost.
+void cachedbuf_invalidate(CachedBuffer *cbuf);
+
+// Coalesces the dirty pages into at most CACHEDBUF_MAX_UPDATES ranges, writes them to `updates` and
+// clears them. Returns the number of ranges. If `storage_lost` is true (e.g. the GPU-side buffer was
+// just reallocated), all data written since the last invalidation is returned as well.
+uint cachedbuf_flush(CachedBuffer *cbuf, bool storage_lost, CachedBufferUpdate updates[CACHEDBUF_MAX_UPDATES]);
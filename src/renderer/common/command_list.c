@@ -0,0 +1,227 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "command_list.h"
+
+#define RCMDLIST_ARENA_SIZE (1 << 16)
+
+void rcmdlist_init(RenderCommandList *cl) {
+	*cl = (RenderCommandList) {};
+	marena_init(&cl->arena, RCMDLIST_ARENA_SIZE);
+}
+
+void rcmdlist_deinit(RenderCommandList *cl) {
+	dynarray_free_data(&cl->commands);
+	marena_deinit(&cl->arena);
+}
+
+void rcmdlist_reset(RenderCommandList *cl) {
+	cl->commands.num_elements = 0;
+	marena_reset(&cl->arena);
+}
+
+RenderCommand *rcmdlist_append(RenderCommandList *cl, RenderCommandType type) {
+	return dynarray_append(&cl->commands, { .type = type });
+}
+
+void *rcmdlist_memdup(RenderCommandList *cl, const void *data, size_t size) {
+	return marena_memdup(&cl->arena, data, size);
+}
+
+char *rcmdlist_strdup(RenderCommandList *cl, const char *str) {
+	return marena_strdup(&cl->arena, str);
+}
+
+static void rcmd_write_vertex_buffer(const RendererFuncs *funcs, const RenderCommand *cmd) {
+	SDL_IOStream *stream = funcs->vertex_buffer_get_stream(cmd->vbuf_write.vbuf);
+	SDL_SeekIO(stream, cmd->vbuf_write.offset, SDL_IO_SEEK_SET);
+	SDL_WriteIO(stream, cmd->vbuf_write.data, cmd->vbuf_write.size);
+}
+
+void rcmdlist_replay(RenderCommandList *cl, const RendererFuncs *funcs) {
+	dynarray_foreach_elem(&cl->commands, RenderCommand *cmd, {
+		switch(cmd->type) {
+			case RCMD_CAPABILITIES:
+				funcs->capabilities(cmd->capabilities);
+				break;
+			case RCMD_COLOR:
+				funcs->color4(cmd->color.r, cmd->color.g, cmd->color.b, cmd->color.a);
+				break;
+			case RCMD_BLEND:
+				funcs->blend(cmd->blend);
+				break;
+			case RCMD_CULL:
+				funcs->cull(cmd->cull);
+				break;
+			case RCMD_DEPTH_FUNC:
+				funcs->depth_func(cmd->depth_func);
+				break;
+			case RCMD_SHADER:
+				funcs->shader(cmd->shader);
+				break;
+			case RCMD_UNIFORM: {
+				auto u = &cmd->uniform;
+				funcs->uniform(u->uniform, u->offset, u->count, u->data);
+				break;
+			}
+			case RCMD_DRAW: {
+				auto d = &cmd->draw;
+				funcs->draw(d->varr, d->prim, d->first, d->count, d->instances, d->base_instance);
+				break;
+			}
+			case RCMD_DRAW_INDEXED: {
+				auto d = &cmd->draw;
+				funcs->draw_indexed(d->varr, d->prim, d->first, d->count, d->instances, d->base_instance);
+				break;
+			}
+			case RCMD_SCISSOR:
+				funcs->scissor(cmd->scissor);
+				break;
+			case RCMD_VSYNC:
+				funcs->vsync(cmd->vsync);
+				break;
+
+			case RCMD_FRAMEBUFFER:
+				funcs->framebuffer(cmd->framebuffer);
+				break;
+			case RCMD_FRAMEBUFFER_ATTACH: {
+				auto a = &cmd->fb_attach;
+				funcs->framebuffer_attach(a->framebuffer, a->texture, a->mipmap, a->attachment);
+				break;
+			}
+			case RCMD_FRAMEBUFFER_VIEWPORT:
+				funcs->framebuffer_viewport(cmd->fb_viewport.framebuffer, cmd->fb_viewport.viewport);
+				break;
+			case RCMD_FRAMEBUFFER_OUTPUTS: {
+				auto o = &cmd->fb_outputs;
+				funcs->framebuffer_outputs(o->framebuffer, o->config, o->write_mask);
+				break;
+			}
+			case RCMD_FRAMEBUFFER_CLEAR: {
+				auto c = &cmd->fb_clear;
+				funcs->framebuffer_clear(c->framebuffer, c->flags, &c->color, c->depth);
+				break;
+			}
+			case RCMD_FRAMEBUFFER_COPY: {
+				auto c = &cmd->fb_copy;
+				funcs->framebuffer_copy(c->dst, c->src, c->flags);
+				break;
+			}
+			case RCMD_FRAMEBUFFER_READ_ASYNC: {
+				auto r = &cmd->fb_read;
+				funcs->framebuffer_read_async(r->framebuffer, r->attachment, r->region, r->userdata, r->callback);
+				break;
+			}
+			case RCMD_FRAMEBUFFER_SET_DEBUG_LABEL:
+				funcs->framebuffer_set_debug_label(cmd->debug_label.object, cmd->debug_label.label);
+				break;
+			case RCMD_FRAMEBUFFER_DESTROY:
+				funcs->framebuffer_destroy(cmd->object);
+				break;
+
+			case RCMD_TEXTURE_FILL: {
+				auto f = &cmd->tex_fill;
+				funcs->texture_fill(f->texture, f->mipmap, f->layer, &f->image);
+				break;
+			}
+			case RCMD_TEXTURE_FILL_REGION: {
+				auto f = &cmd->tex_fill;
+				funcs->texture_fill_region(f->texture, f->mipmap, f->layer, f->x, f->y, &f->image);
+				break;
+			}
+			case RCMD_TEXTURE_CLEAR:
+				funcs->texture_clear(cmd->tex_clear.texture, &cmd->tex_clear.color);
+				break;
+			case RCMD_TEXTURE_INVALIDATE:
+				funcs->texture_invalidate(cmd->object);
+				break;
+			case RCMD_TEXTURE_SET_FILTER:
+				funcs->texture_set_filter(cmd->tex_modes.texture, cmd->tex_modes.mode1, cmd->tex_modes.mode2);
+				break;
+			case RCMD_TEXTURE_SET_WRAP:
+				funcs->texture_set_wrap(cmd->tex_modes.texture, cmd->tex_modes.mode1, cmd->tex_modes.mode2);
+				break;
+			case RCMD_TEXTURE_SET_DEBUG_LABEL:
+				funcs->texture_set_debug_label(cmd->debug_label.object, cmd->debug_label.label);
+				break;
+			case RCMD_TEXTURE_DESTROY:
+				funcs->texture_destroy(cmd->object);
+				break;
+
+			case RCMD_VERTEX_BUFFER_WRITE:
+				rcmd_write_vertex_buffer(funcs, cmd);
+				break;
+			case RCMD_VERTEX_BUFFER_INVALIDATE:
+				funcs->vertex_buffer_invalidate(cmd->object);
+				break;
+			case RCMD_VERTEX_BUFFER_SET_DEBUG_LABEL:
+				funcs->vertex_buffer_set_debug_label(cmd->debug_label.object, cmd->debug_label.label);
+				break;
+			case RCMD_VERTEX_BUFFER_DESTROY:
+				funcs->vertex_buffer_destroy(cmd->object);
+				break;
+
+			case RCMD_INDEX_BUFFER_ADD_INDICES:
+				funcs->index_buffer_add_indices(cmd->ibuf_add.ibuf, cmd->ibuf_add.size, cmd->ibuf_add.data);
+				break;
+			case RCMD_INDEX_BUFFER_SET_OFFSET:
+				funcs->index_buffer_set_offset(cmd->ibuf_offset.ibuf, cmd->ibuf_offset.offset);
+				break;
+			case RCMD_INDEX_BUFFER_INVALIDATE:
+				funcs->index_buffer_invalidate(cmd->object);
+				break;
+			case RCMD_INDEX_BUFFER_SET_DEBUG_LABEL:
+				funcs->index_buffer_set_debug_label(cmd->debug_label.object, cmd->debug_label.label);
+				break;
+			case RCMD_INDEX_BUFFER_DESTROY:
+				funcs->index_buffer_destroy(cmd->object);
+				break;
+
+			case RCMD_VERTEX_ARRAY_LAYOUT:
+				funcs->vertex_array_layout(
+					cmd->varr_layout.varr, cmd->varr_layout.nattribs, cmd->varr_layout.attribs);
+				break;
+			case RCMD_VERTEX_ARRAY_ATTACH_VERTEX_BUFFER: {
+				auto a = &cmd->varr_attach_vbuf;
+				funcs->vertex_array_attach_vertex_buffer(a->varr, a->vbuf, a->attachment);
+				break;
+			}
+			case RCMD_VERTEX_ARRAY_ATTACH_INDEX_BUFFER:
+				funcs->vertex_array_attach_index_buffer(cmd->varr_attach_ibuf.varr, cmd->varr_attach_ibuf.ibuf);
+				break;
+			case RCMD_VERTEX_ARRAY_SET_DEBUG_LABEL:
+				funcs->vertex_array_set_debug_label(cmd->debug_label.object, cmd->debug_label.label);
+				break;
+			case RCMD_VERTEX_ARRAY_DESTROY:
+				funcs->vertex_array_destroy(cmd->object);
+				break;
+
+			case RCMD_SHADER_OBJECT_SET_DEBUG_LABEL:
+				funcs->shader_object_set_debug_label(cmd->debug_label.object, cmd->debug_label.label);
+				break;
+			case RCMD_SHADER_OBJECT_DESTROY:
+				funcs->shader_object_destroy(cmd->object);
+				break;
+			case RCMD_SHADER_PROGRAM_SET_DEBUG_LABEL:
+				funcs->shader_program_set_debug_label(cmd->debug_label.object, cmd->debug_label.label);
+				break;
+			case RCMD_SHADER_PROGRAM_DESTROY:
+				funcs->shader_program_destroy(cmd->object);
+				break;
+
+			case RCMD_BEGIN_FRAME:
+				funcs->begin_frame();
+				break;
+			case RCMD_SWAP:
+				funcs->swap(cmd->window);
+				break;
+
+			default: UNREACHABLE;
+		}
+	});
+}
@@ -0,0 +1,246 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "backend.h"
+#include "dynarray.h"
+#include "memory/arena.h"
+
+/*
+ * A recorded sequence of renderer backend calls, to be replayed later (possibly on another thread)
+ * against any RendererFuncs table. Everything a command points to is either a renderer object or
+ * a copy owned by the list's arena, so the caller's buffers may be reused right after recording.
+ */
+
+typedef enum RenderCommandType {
+	RCMD_CAPABILITIES,
+	RCMD_COLOR,
+	RCMD_BLEND,
+	RCMD_CULL,
+	RCMD_DEPTH_FUNC,
+	RCMD_SHADER,
+	RCMD_UNIFORM,
+	RCMD_DRAW,
+	RCMD_DRAW_INDEXED,
+	RCMD_SCISSOR,
+	RCMD_VSYNC,
+
+	RCMD_FRAMEBUFFER,
+	RCMD_FRAMEBUFFER_ATTACH,
+	RCMD_FRAMEBUFFER_VIEWPORT,
+	RCMD_FRAMEBUFFER_OUTPUTS,
+	RCMD_FRAMEBUFFER_CLEAR,
+	RCMD_FRAMEBUFFER_COPY,
+	RCMD_FRAMEBUFFER_READ_ASYNC,
+	RCMD_FRAMEBUFFER_SET_DEBUG_LABEL,
+	RCMD_FRAMEBUFFER_DESTROY,
+
+	RCMD_TEXTURE_FILL,
+	RCMD_TEXTURE_FILL_REGION,
+	RCMD_TEXTURE_CLEAR,
+	RCMD_TEXTURE_INVALIDATE,
+	RCMD_TEXTURE_SET_FILTER,
+	RCMD_TEXTURE_SET_WRAP,
+	RCMD_TEXTURE_SET_DEBUG_LABEL,
+	RCMD_TEXTURE_DESTROY,
+
+	RCMD_VERTEX_BUFFER_WRITE,
+	RCMD_VERTEX_BUFFER_INVALIDATE,
+	RCMD_VERTEX_BUFFER_SET_DEBUG_LABEL,
+	RCMD_VERTEX_BUFFER_DESTROY,
+
+	RCMD_INDEX_BUFFER_ADD_INDICES,
+	RCMD_INDEX_BUFFER_SET_OFFSET,
+	RCMD_INDEX_BUFFER_INVALIDATE,
+	RCMD_INDEX_BUFFER_SET_DEBUG_LABEL,
+	RCMD_INDEX_BUFFER_DESTROY,
+
+	RCMD_VERTEX_ARRAY_LAYOUT,
+	RCMD_VERTEX_ARRAY_ATTACH_VERTEX_BUFFER,
+	RCMD_VERTEX_ARRAY_ATTACH_INDEX_BUFFER,
+	RCMD_VERTEX_ARRAY_SET_DEBUG_LABEL,
+	RCMD_VERTEX_ARRAY_DESTROY,
+
+	RCMD_SHADER_OBJECT_SET_DEBUG_LABEL,
+	RCMD_SHADER_OBJECT_DESTROY,
+	RCMD_SHADER_PROGRAM_SET_DEBUG_LABEL,
+	RCMD_SHADER_PROGRAM_DESTROY,
+
+	RCMD_BEGIN_FRAME,
+	RCMD_SWAP,
+
+	NUM_RCMDS,
+} RenderCommandType;
+
+typedef struct RenderCommand {
+	RenderCommandType type;
+
+	union {
+		r_capability_bits_t capabilities;
+		Color color;
+		BlendMode blend;
+		CullFaceMode cull;
+		DepthTestFunc depth_func;
+		ShaderProgram *shader;
+		IntRect scissor;
+		VsyncMode vsync;
+		Framebuffer *framebuffer;
+		SDL_Window *window;
+
+		// *_DESTROY, *_INVALIDATE
+		void *object;
+
+		// *_SET_DEBUG_LABEL
+		struct {
+			void *object;
+			const char *label;
+		} debug_label;
+
+		struct {
+			Uniform *uniform;
+			uint offset;
+			uint count;
+			const void *data;
+		} uniform;
+
+		struct {
+			VertexArray *varr;
+			Primitive prim;
+			uint first;
+			uint count;
+			uint instances;
+			uint base_instance;
+		} draw;
+
+		struct {
+			Framebuffer *framebuffer;
+			Texture *texture;
+			uint mipmap;
+			FramebufferAttachment attachment;
+		} fb_attach;
+
+		struct {
+			Framebuffer *framebuffer;
+			FloatRect viewport;
+		} fb_viewport;
+
+		struct {
+			Framebuffer *framebuffer;
+			FramebufferAttachment config[FRAMEBUFFER_MAX_OUTPUTS];
+			uint8_t write_mask;
+		} fb_outputs;
+
+		struct {
+			Framebuffer *framebuffer;
+			BufferKindFlags flags;
+			Color color;
+			float depth;
+		} fb_clear;
+
+		struct {
+			Framebuffer *dst;
+			Framebuffer *src;
+			BufferKindFlags flags;
+		} fb_copy;
+
+		struct {
+			Framebuffer *framebuffer;
+			FramebufferAttachment attachment;
+			IntRect region;
+			void *userdata;
+			FramebufferReadAsyncCallback callback;
+		} fb_read;
+
+		struct {
+			Texture *texture;
+			uint mipmap;
+			uint layer;
+			uint x;
+			uint y;
+			Pixmap image;
+		} tex_fill;
+
+		struct {
+			Texture *texture;
+			Color color;
+		} tex_clear;
+
+		// RCMD_TEXTURE_SET_FILTER, RCMD_TEXTURE_SET_WRAP
+		struct {
+			Texture *texture;
+			uint mode1;
+			uint mode2;
+		} tex_modes;
+
+		struct {
+			VertexBuffer *vbuf;
+			size_t offset;
+			size_t size;
+			const void *data;
+		} vbuf_write;
+
+		struct {
+			IndexBuffer *ibuf;
+			size_t size;
+			void *data;
+		} ibuf_add;
+
+		struct {
+			IndexBuffer *ibuf;
+			size_t offset;
+		} ibuf_offset;
+
+		struct {
+			VertexArray *varr;
+			uint nattribs;
+			VertexAttribFormat *attribs;
+		} varr_layout;
+
+		struct {
+			VertexArray *varr;
+			VertexBuffer *vbuf;
+			uint attachment;
+		} varr_attach_vbuf;
+
+		struct {
+			VertexArray *varr;
+			IndexBuffer *ibuf;
+		} varr_attach_ibuf;
+	};
+} RenderCommand;
+
+typedef struct RenderCommandList {
+	MemArena arena;
+	DYNAMIC_ARRAY(RenderCommand) commands;
+} RenderCommandList;
+
+void rcmdlist_init(RenderCommandList *cl) attr_nonnull_all;
+void rcmdlist_deinit(RenderCommandList *cl) attr_nonnull_all;
+
+// Drops all commands and their payloads
+void rcmdlist_reset(RenderCommandList *cl) attr_nonnull_all;
+
+// Appends a zero-initialized command of the given type
+RenderCommand *rcmdlist_append(RenderCommandList *cl, RenderCommandType type)
+	attr_nonnull_all attr_returns_nonnull;
+
+// Copies a payload into the list's arena
+void *rcmdlist_memdup(RenderCommandList *cl, const void *data, size_t size)
+	attr_nonnull_all attr_returns_nonnull;
+
+char *rcmdlist_strdup(RenderCommandList *cl, const char *str)
+	attr_nonnull_all attr_returns_nonnull;
+
+INLINE bool rcmdlist_is_empty(RenderCommandList *cl) {
+	return cl->commands.num_elements == 0;
+}
+
+// Calls the recorded functions of `funcs` in order
+void rcmdlist_replay(RenderCommandList *cl, const RendererFuncs *funcs) attr_nonnull_all;
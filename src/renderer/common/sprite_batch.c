@@ -7,9 +7,14 @@
  */
 
 #include "sprite_batch_internal.h"
+#include "threaded.h"
 
 #include "../api.h"
+#include "dynarray.h"
+#include "hashtable.h"
+#include "log.h"
 #include "util.h"
+#include "util/env.h"
 #include "util/glm.h"
 #include "resource/sprite.h"
 
@@ -25,25 +30,78 @@
 
 #define SIZEOF_SPRITE_ATTRIBS (offsetof(SpriteInstanceAttribs, end_of_fields))
 
-static struct SpriteBatchState {
-	// constants (set once on init and not expected to change)
-	VertexArray *varr;
-	VertexBuffer *vbuf;
-	Model quad;
-	r_feature_bits_t renderer_features;
-
-	// varying state
+// How many batches back a deferred sprite may be moved
+#define SPRITE_BATCH_REORDER_WINDOW 64
+
+typedef enum SpriteBatchFlushCause {
+	SBFLUSH_TEXTURE,
+	SBFLUSH_AUX_TEXTURE,
+	SBFLUSH_SHADER,
+	SBFLUSH_BLEND,
+	SBFLUSH_FRAMEBUFFER,
+	SBFLUSH_CAPABILITIES,
+	SBFLUSH_DEPTH_FUNC,
+	SBFLUSH_CULL_MODE,
+	SBFLUSH_PROJECTION,
+	SBFLUSH_EXTERNAL,
+
+	NUM_SPRITE_BATCH_FLUSH_CAUSES,
+} SpriteBatchFlushCause;
+
+// Everything that can't change within a single draw call
+typedef struct SpriteBatchKey {
 	mat4 projection;
 	Texture *primary_texture;
 	Texture *aux_textures[R_NUM_SPRITE_AUX_TEXTURES];
 	ShaderProgram *shader;
 	Framebuffer *framebuffer;
-	uint base_instance;
 	BlendMode blend;
 	CullFaceMode cull_mode;
 	DepthTestFunc depth_func;
-	uint num_pending;
 	r_capability_bits_t capbits;
+	bool commutative;  // only meaningful for deferred keys; see sprite_batch_key_is_commutative
+} SpriteBatchKey;
+
+typedef struct SpriteBatchBounds {
+	float x0, y0, x1, y1;  // in NDC
+} SpriteBatchBounds;
+
+typedef struct DeferredSprite {
+	SpriteInstanceAttribs attribs;
+	SpriteBatchBounds bounds;
+	uint key;
+	int next;  // next sprite in the same output batch
+} DeferredSprite;
+
+typedef struct DeferredBatch {
+	SpriteBatchBounds bounds;
+	uint key;
+	int head, tail;
+	uint count;
+} DeferredBatch;
+
+static struct SpriteBatchState {
+	// constants (set once on init and not expected to change)
+	VertexArray *varr;
+	VertexBuffer *vbuf;
+	Model quad;
+	r_feature_bits_t renderer_features;
+	bool deferred;
+
+	// varying state
+	SpriteBatchKey state;
+	uint num_pending;  // in deferred mode: sprites submitted since the last state change
+
+	struct {
+		DYNAMIC_ARRAY(DeferredSprite) sprites;
+		DYNAMIC_ARRAY(SpriteBatchKey) keys;
+		DYNAMIC_ARRAY(DeferredBatch) batches;
+		uint current_key;
+		bool key_dirty;
+	} queue;
+
+	// in deferred mode: which program each uniform handed out by _r_shader_uniform() belongs to
+	ht_ptr2ptr_t uniform_owners;
 
 #if SPRITE_BATCH_STATS
 	struct {
@@ -51,6 +109,7 @@ static struct SpriteBatchState {
 		uint sprites;
 		uint best_batch;
 		uint worst_batch;
+		uint causes[NUM_SPRITE_BATCH_FLUSH_CAUSES];
 	} frame_stats;
 #endif
 } _r_sprite_batch;
@@ -110,23 +169,29 @@ void r_sprite_batch_init(void) {
 	_r_sprite_batch.quad.vertex_array = _r_sprite_batch.varr;
 
 	_r_sprite_batch.renderer_features = r_features();
+	_r_sprite_batch.deferred = env_get("TAISEI_SPRITE_BATCH_REORDER", false);
+	_r_sprite_batch.queue.key_dirty = true;
+
+	if(_r_sprite_batch.deferred) {
+		ht_create(&_r_sprite_batch.uniform_owners);
+		log_info("Sprite reordering enabled");
+	}
 }
 
 void r_sprite_batch_shutdown(void) {
+	if(_r_sprite_batch.deferred) {
+		ht_destroy(&_r_sprite_batch.uniform_owners);
+	}
+
+	dynarray_free_data(&_r_sprite_batch.queue.sprites);
+	dynarray_free_data(&_r_sprite_batch.queue.keys);
+	dynarray_free_data(&_r_sprite_batch.queue.batches);
 	r_vertex_array_destroy(_r_sprite_batch.varr);
 	r_vertex_buffer_destroy(_r_sprite_batch.vbuf);
 }
 
-void r_flush_sprites(void) {
-	if(_r_sprite_batch.num_pending == 0) {
-		return;
-	}
-
-	uint pending = _r_sprite_batch.num_pending;
-
-	// needs to be done early to thwart recursive calls
-	_r_sprite_batch.num_pending = 0;
-
+// Draws the instances written to the vertex buffer since the last flush, using _r_sprite_batch.state
+static void _r_sprite_batch_draw(uint pending) {
 #if SPRITE_BATCH_STATS
 	if(_r_sprite_batch.frame_stats.flushes) {
 		if(pending > _r_sprite_batch.frame_stats.best_batch) {
@@ -149,30 +214,32 @@ void r_flush_sprites(void) {
 		"tex_aux2",
 	};
 
-	static_assert(ARRAY_SIZE(tex_aux_names) == ARRAY_SIZE(_r_sprite_batch.aux_textures));
+	static_assert(ARRAY_SIZE(tex_aux_names) == ARRAY_SIZE(_r_sprite_batch.state.aux_textures));
+
+	const SpriteBatchKey *st = &_r_sprite_batch.state;
 
 	r_state_push();
-	r_mat_proj_push_premade(_r_sprite_batch.projection);
+	r_mat_proj_push_premade(st->projection);
 
-	r_shader_ptr(NOT_NULL(_r_sprite_batch.shader));
-	r_uniform_sampler("tex", _r_sprite_batch.primary_texture);
+	r_shader_ptr(NOT_NULL(st->shader));
+	r_uniform_sampler("tex", st->primary_texture);
 
 	for(uint i = 0; i < ARRAY_SIZE(tex_aux_names); ++i) {
-		if(_r_sprite_batch.aux_textures[i]) {
-			r_uniform_sampler(tex_aux_names[i], _r_sprite_batch.aux_textures[i]);
+		if(st->aux_textures[i]) {
+			r_uniform_sampler(tex_aux_names[i], st->aux_textures[i]);
 		}
 	}
 
-	r_framebuffer(_r_sprite_batch.framebuffer);
-	r_blend(_r_sprite_batch.blend);
-	r_capabilities(_r_sprite_batch.capbits);
+	r_framebuffer(st->framebuffer);
+	r_blend(st->blend);
+	r_capabilities(st->capbits);
 
-	if(_r_sprite_batch.capbits & r_capability_bit(RCAP_DEPTH_TEST)) {
-		r_depth_func(_r_sprite_batch.depth_func);
+	if(st->capbits & r_capability_bit(RCAP_DEPTH_TEST)) {
+		r_depth_func(st->depth_func);
 	}
 
-	if(_r_sprite_batch.capbits & r_capability_bit(RCAP_CULL_FACE)) {
-		r_cull(_r_sprite_batch.cull_mode);
+	if(st->capbits & r_capability_bit(RCAP_CULL_FACE)) {
+		r_cull(st->cull_mode);
 	}
 
 	r_draw_model_ptr(&_r_sprite_batch.quad, pending, 0);
@@ -182,6 +249,270 @@ void r_flush_sprites(void) {
 	r_state_pop();
 }
 
+/*
+ * Deferred mode (TAISEI_SPRITE_BATCH_REORDER)
+ *
+ * Sprites are queued together with their state key and NDC bounds instead of being flushed on every
+ * state change. When the queue is flushed, each sprite is moved into the most recent earlier batch with
+ * the same key, as long as it doesn't overlap anything drawn in between (or both are blended
+ * commutatively). This assumes that sprite shaders don't move vertices outside of the quad.
+ */
+
+static bool sprite_batch_key_is_commutative(const SpriteBatchKey *key) {
+	// dst' = dst + f(src): the result doesn't depend on the order of such draws
+	if(key->capbits & r_capability_bit(RCAP_DEPTH_TEST)) {
+		return false;
+	}
+
+	UnpackedBlendMode bm;
+	r_blend_unpack(key->blend, &bm);
+
+	UnpackedBlendModePart parts[] = { bm.color, bm.alpha };
+
+	for(uint i = 0; i < ARRAY_SIZE(parts); ++i) {
+		switch(parts[i].src) {
+			case BLENDFACTOR_DST_COLOR:
+			case BLENDFACTOR_INV_DST_COLOR:
+			case BLENDFACTOR_DST_ALPHA:
+			case BLENDFACTOR_INV_DST_ALPHA:
+				return false;
+			default:
+				break;
+		}
+
+		if(parts[i].op != BLENDOP_ADD || parts[i].dst != BLENDFACTOR_ONE) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static SpriteBatchBounds sprite_batch_compute_bounds(const SpriteInstanceAttribs *attribs, mat4 projection) {
+	static const vec4 corners[] = {
+		{ -0.5, -0.5, 0, 1 },
+		{  0.5, -0.5, 0, 1 },
+		{ -0.5,  0.5, 0, 1 },
+		{  0.5,  0.5, 0, 1 },
+	};
+
+	SpriteBatchBounds b = { INFINITY, INFINITY, -INFINITY, -INFINITY };
+	mat4 mvp;
+	glm_mat4_mul(projection, (vec4*)attribs->mv_transform, mvp);
+
+	for(uint i = 0; i < ARRAY_SIZE(corners); ++i) {
+		vec4 p;
+		glm_mat4_mulv(mvp, (float*)corners[i], p);
+
+		if(p[3] <= 0) {
+			// Crosses the near plane; treat it as covering everything
+			return (SpriteBatchBounds) { -INFINITY, -INFINITY, INFINITY, INFINITY };
+		}
+
+		float x = p[0] / p[3];
+		float y = p[1] / p[3];
+		b.x0 = fminf(b.x0, x);
+		b.y0 = fminf(b.y0, y);
+		b.x1 = fmaxf(b.x1, x);
+		b.y1 = fmaxf(b.y1, y);
+	}
+
+	return b;
+}
+
+INLINE bool sprite_batch_bounds_overlap(const SpriteBatchBounds *a, const SpriteBatchBounds *b) {
+	return a->x0 < b->x1 && b->x0 < a->x1 && a->y0 < b->y1 && b->y0 < a->y1;
+}
+
+INLINE void sprite_batch_bounds_merge(SpriteBatchBounds *dst, const SpriteBatchBounds *src) {
+	dst->x0 = fminf(dst->x0, src->x0);
+	dst->y0 = fminf(dst->y0, src->y0);
+	dst->x1 = fmaxf(dst->x1, src->x1);
+	dst->y1 = fmaxf(dst->y1, src->y1);
+}
+
+static bool sprite_batch_conflicts(
+	const DeferredBatch *batch, const SpriteBatchKey *batch_key,
+	const DeferredSprite *spr, const SpriteBatchKey *spr_key
+) {
+	if(batch_key->framebuffer != spr_key->framebuffer) {
+		// Might be a render-to-texture dependency; don't bother
+		return true;
+	}
+
+	if(!sprite_batch_bounds_overlap(&batch->bounds, &spr->bounds)) {
+		return false;
+	}
+
+	return !(batch_key->commutative && spr_key->commutative);
+}
+
+static void sprite_batch_build_deferred_batches(void) {
+	auto q = &_r_sprite_batch.queue;
+
+	dynarray_foreach(&q->sprites, int i, DeferredSprite *spr, {
+		const SpriteBatchKey *spr_key = dynarray_get_ptr(&q->keys, spr->key);
+		DeferredBatch *target = NULL;
+		int window_end = max(0, (int)q->batches.num_elements - SPRITE_BATCH_REORDER_WINDOW);
+
+		for(int b = (int)q->batches.num_elements - 1; b >= window_end; --b) {
+			DeferredBatch *batch = dynarray_get_ptr(&q->batches, b);
+
+			if(batch->key == spr->key) {
+				target = batch;
+				break;
+			}
+
+			if(sprite_batch_conflicts(batch, dynarray_get_ptr(&q->keys, batch->key), spr, spr_key)) {
+				break;
+			}
+		}
+
+		spr->next = -1;
+
+		if(target) {
+			dynarray_get_ptr(&q->sprites, target->tail)->next = i;
+			target->tail = i;
+			target->count++;
+			sprite_batch_bounds_merge(&target->bounds, &spr->bounds);
+		} else {
+			dynarray_append(&q->batches, {
+				.bounds = spr->bounds,
+				.key = spr->key,
+				.head = i,
+				.tail = i,
+				.count = 1,
+			});
+		}
+	});
+}
+
+static void sprite_batch_flush_deferred(void) {
+	auto q = &_r_sprite_batch.queue;
+
+	sprite_batch_build_deferred_batches();
+
+	// Take the queue, so that recursive r_flush_sprites() calls from the draw path see it empty
+	auto sprites = q->sprites;
+	auto keys = q->keys;
+	auto batches = q->batches;
+	q->sprites = (typeof(sprites)) {};
+	q->keys = (typeof(keys)) {};
+	q->batches = (typeof(batches)) {};
+
+	SpriteBatchKey current_state = _r_sprite_batch.state;
+	SDL_IOStream *stream = r_vertex_buffer_get_stream(_r_sprite_batch.vbuf);
+
+	dynarray_foreach_elem(&batches, DeferredBatch *batch, {
+		_r_sprite_batch.state = dynarray_get(&keys, batch->key);
+
+		for(int i = batch->head; i >= 0;) {
+			DeferredSprite *spr = dynarray_get_ptr(&sprites, i);
+			SDL_WriteIO(stream, &spr->attribs, SIZEOF_SPRITE_ATTRIBS);
+			i = spr->next;
+		}
+
+		_r_sprite_batch_draw(batch->count);
+	});
+
+	_r_sprite_batch.state = current_state;
+
+	// Give the storage back for reuse
+	sprites.num_elements = keys.num_elements = batches.num_elements = 0;
+	q->sprites = sprites;
+	q->keys = keys;
+	q->batches = batches;
+	q->key_dirty = true;
+}
+
+static void _r_sprite_batch_flush(void) {
+	if(_r_sprite_batch.deferred) {
+		if(_r_sprite_batch.queue.sprites.num_elements > 0) {
+			_r_sprite_batch.num_pending = 0;
+			sprite_batch_flush_deferred();
+		}
+
+		return;
+	}
+
+	if(_r_sprite_batch.num_pending == 0) {
+		return;
+	}
+
+	uint pending = _r_sprite_batch.num_pending;
+
+	// needs to be done early to thwart recursive calls
+	_r_sprite_batch.num_pending = 0;
+
+	_r_sprite_batch_draw(pending);
+}
+
+void r_flush_sprites(void) {
+	if(_r_threaded_in_backend()) {
+		// Called back by the backend while replaying; the batch was flushed before recording
+		return;
+	}
+
+#if SPRITE_BATCH_STATS
+	if(_r_sprite_batch.num_pending > 0 || _r_sprite_batch.queue.sprites.num_elements > 0) {
+		_r_sprite_batch.frame_stats.causes[SBFLUSH_EXTERNAL]++;
+	}
+#endif
+
+	_r_sprite_batch_flush();
+}
+
+// Ends the current run of same-state sprites; in immediate mode that means flushing them
+static void _r_sprite_batch_state_changed(SpriteBatchFlushCause cause) {
+#if SPRITE_BATCH_STATS
+	if(_r_sprite_batch.num_pending > 0) {
+		_r_sprite_batch.frame_stats.causes[cause]++;
+	}
+#endif
+
+	if(_r_sprite_batch.deferred) {
+		_r_sprite_batch.num_pending = 0;
+		_r_sprite_batch.queue.key_dirty = true;
+	} else {
+		_r_sprite_batch_flush();
+	}
+}
+
+void _r_sprite_batch_uniform_resolved(Uniform *uniform, ShaderProgram *prog) {
+	if(_r_sprite_batch.deferred && uniform) {
+		ht_set(&_r_sprite_batch.uniform_owners, uniform, prog);
+	}
+}
+
+static bool sprite_batch_shader_queued(ShaderProgram *prog) {
+	dynarray_foreach_elem(&_r_sprite_batch.queue.keys, SpriteBatchKey *key, {
+		if(key->shader == prog) {
+			return true;
+		}
+	});
+
+	return false;
+}
+
+void _r_sprite_batch_uniform_changed(Uniform *uniform) {
+	if(_r_threaded_in_backend() || _r_sprite_batch.queue.sprites.num_elements == 0) {
+		return;
+	}
+
+	// Queued sprites must be drawn with the uniform values that were current when they were submitted.
+	// Writes to programs that none of them use can't affect them.
+	ShaderProgram *owner;
+
+	if(
+		ht_lookup(&_r_sprite_batch.uniform_owners, uniform, &owner) &&
+		!sprite_batch_shader_queued(owner)
+	) {
+		return;
+	}
+
+	r_flush_sprites();
+}
+
 static void _r_sprite_batch_compute_attribs(
 	const Sprite *restrict spr,
 	const SpriteParams *restrict params,
@@ -284,71 +615,121 @@ INLINE void _r_sprite_batch_process_params(
 }
 
 void r_sprite_batch_prepare_state(const SpriteStateParams *stp) {
-	if(stp->primary_texture != _r_sprite_batch.primary_texture) {
-		r_flush_sprites();
-		_r_sprite_batch.primary_texture = stp->primary_texture;
+	SpriteBatchKey *st = &_r_sprite_batch.state;
+
+	if(stp->primary_texture != st->primary_texture) {
+		_r_sprite_batch_state_changed(SBFLUSH_TEXTURE);
+		st->primary_texture = stp->primary_texture;
 	}
 
 	for(uint i = 0; i < R_NUM_SPRITE_AUX_TEXTURES; ++i) {
 		Texture *aux_tex = stp->aux_textures[i];
 
-		if(aux_tex != NULL && aux_tex != _r_sprite_batch.aux_textures[i]) {
-			r_flush_sprites();
-			_r_sprite_batch.aux_textures[i] = aux_tex;
+		if(aux_tex != NULL && aux_tex != st->aux_textures[i]) {
+			_r_sprite_batch_state_changed(SBFLUSH_AUX_TEXTURE);
+			st->aux_textures[i] = aux_tex;
 		}
 	}
 
 	assume(stp->shader != NULL);
 
-	if(stp->shader != _r_sprite_batch.shader) {
-		r_flush_sprites();
-		_r_sprite_batch.shader = stp->shader;
+	if(stp->shader != st->shader) {
+		_r_sprite_batch_state_changed(SBFLUSH_SHADER);
+		st->shader = stp->shader;
 	}
 
 	BlendMode blend = stp->blend;
 
-	if(blend != _r_sprite_batch.blend) {
-		r_flush_sprites();
-		_r_sprite_batch.blend = blend;
+	if(blend != st->blend) {
+		_r_sprite_batch_state_changed(SBFLUSH_BLEND);
+		st->blend = blend;
 	}
 
 	Framebuffer *fb = r_framebuffer_current();
 
-	if(fb != _r_sprite_batch.framebuffer) {
-		r_flush_sprites();
-		_r_sprite_batch.framebuffer = fb;
+	if(fb != st->framebuffer) {
+		_r_sprite_batch_state_changed(SBFLUSH_FRAMEBUFFER);
+		st->framebuffer = fb;
 	}
 
 	r_capability_bits_t caps = r_capabilities_current();
 	DepthTestFunc depth_func = r_depth_func_current();
 	CullFaceMode cull_mode = r_cull_current();
 
-	if(_r_sprite_batch.capbits != caps) {
-		r_flush_sprites();
-		_r_sprite_batch.capbits = caps;
+	if(st->capbits != caps) {
+		_r_sprite_batch_state_changed(SBFLUSH_CAPABILITIES);
+		st->capbits = caps;
 	}
 
-	if((caps & r_capability_bit(RCAP_DEPTH_TEST)) && _r_sprite_batch.depth_func != depth_func) {
-		r_flush_sprites();
-		_r_sprite_batch.depth_func = depth_func;
+	if((caps & r_capability_bit(RCAP_DEPTH_TEST)) && st->depth_func != depth_func) {
+		_r_sprite_batch_state_changed(SBFLUSH_DEPTH_FUNC);
+		st->depth_func = depth_func;
 	}
 
-	if((caps & r_capability_bit(RCAP_CULL_FACE)) && _r_sprite_batch.cull_mode != cull_mode) {
-		r_flush_sprites();
-		_r_sprite_batch.cull_mode = cull_mode;
+	if((caps & r_capability_bit(RCAP_CULL_FACE)) && st->cull_mode != cull_mode) {
+		_r_sprite_batch_state_changed(SBFLUSH_CULL_MODE);
+		st->cull_mode = cull_mode;
 	}
 
 	mat4 *current_projection = r_mat_proj_current_ptr();
 
-	if(memcmp(*current_projection, _r_sprite_batch.projection, sizeof(mat4))) {
-		r_flush_sprites();
-		glm_mat4_copy(*current_projection, _r_sprite_batch.projection);
+	if(memcmp(*current_projection, st->projection, sizeof(mat4))) {
+		_r_sprite_batch_state_changed(SBFLUSH_PROJECTION);
+		glm_mat4_copy(*current_projection, st->projection);
+	}
+}
+
+static bool sprite_batch_key_equal(const SpriteBatchKey *a, const SpriteBatchKey *b) {
+	return
+		a->primary_texture == b->primary_texture &&
+		a->shader == b->shader &&
+		a->framebuffer == b->framebuffer &&
+		a->blend == b->blend &&
+		a->cull_mode == b->cull_mode &&
+		a->depth_func == b->depth_func &&
+		a->capbits == b->capbits &&
+		!memcmp(a->aux_textures, b->aux_textures, sizeof(a->aux_textures)) &&
+		!memcmp(a->projection, b->projection, sizeof(a->projection));
+}
+
+// Returns the index of a queued key equal to the current state, adding one if there is none.
+// Returning to an earlier state must yield the same index, or its sprites could never be merged.
+static uint sprite_batch_find_key(void) {
+	auto q = &_r_sprite_batch.queue;
+
+	for(int i = (int)q->keys.num_elements - 1; i >= 0; --i) {
+		if(sprite_batch_key_equal(dynarray_get_ptr(&q->keys, i), &_r_sprite_batch.state)) {
+			return i;
+		}
+	}
+
+	SpriteBatchKey *key = dynarray_append(&q->keys);
+	*key = _r_sprite_batch.state;
+	key->commutative = sprite_batch_key_is_commutative(key);
+	return q->keys.num_elements - 1;
+}
+
+static void _r_sprite_batch_queue_instance(const SpriteInstanceAttribs *attribs) {
+	auto q = &_r_sprite_batch.queue;
+
+	if(q->key_dirty) {
+		q->current_key = sprite_batch_find_key();
+		q->key_dirty = false;
 	}
+
+	DeferredSprite *spr = dynarray_append(&q->sprites);
+	memcpy(&spr->attribs, attribs, SIZEOF_SPRITE_ATTRIBS);
+	spr->key = q->current_key;
+	spr->bounds = sprite_batch_compute_bounds(attribs, _r_sprite_batch.state.projection);
 }
 
 void r_sprite_batch_add_instance(const SpriteInstanceAttribs *attribs) {
-	SDL_IOStream *stream = r_vertex_buffer_get_stream(_r_sprite_batch.vbuf);
-	SDL_WriteIO(stream, attribs, SIZEOF_SPRITE_ATTRIBS);
+	if(_r_sprite_batch.deferred) {
+		_r_sprite_batch_queue_instance(attribs);
+	} else {
+		SDL_IOStream *stream = r_vertex_buffer_get_stream(_r_sprite_batch.vbuf);
+		SDL_WriteIO(stream, attribs, SIZEOF_SPRITE_ATTRIBS);
+	}
 
 	_r_sprite_batch.num_pending++;
 
@@ -399,18 +780,60 @@ void _r_sprite_batch_end_frame(void) {
 		.shader = "text_default",
 	});
 
+	static const char *const cause_names[] = {
+		[SBFLUSH_TEXTURE]      = "tex",
+		[SBFLUSH_AUX_TEXTURE]  = "aux",
+		[SBFLUSH_SHADER]       = "shader",
+		[SBFLUSH_BLEND]        = "blend",
+		[SBFLUSH_FRAMEBUFFER]  = "fb",
+		[SBFLUSH_CAPABILITIES] = "caps",
+		[SBFLUSH_DEPTH_FUNC]   = "depth",
+		[SBFLUSH_CULL_MODE]    = "cull",
+		[SBFLUSH_PROJECTION]   = "proj",
+		[SBFLUSH_EXTERNAL]     = "ext",
+	};
+
+	static_assert(ARRAY_SIZE(cause_names) == NUM_SPRITE_BATCH_FLUSH_CAUSES);
+
+	// In deferred mode these count state changes between queued sprites, not actual flushes
+	int len = snprintf(buf, sizeof(buf), "%s causes:", _r_sprite_batch.deferred ? "Break" : "Flush");
+
+	for(uint i = 0; i < NUM_SPRITE_BATCH_FLUSH_CAUSES && len < (int)sizeof(buf); ++i) {
+		len += snprintf(buf + len, sizeof(buf) - len, " %s %i", cause_names[i], _r_sprite_batch.frame_stats.causes[i]);
+	}
+
+	text_draw(buf, &(TextParams) {
+		.pos = { 0, 2 * font_get_lineskip(font) },
+		.font_ptr = font,
+		.color = RGB(1, 1, 1),
+		.shader = "text_default",
+	});
+
 	_r_sprite_batch.frame_stats = (typeof(_r_sprite_batch.frame_stats)) {};
 #endif
 }
 
-void _r_sprite_batch_texture_deleted(Texture *tex) {
-	if(_r_sprite_batch.primary_texture == tex) {
-		_r_sprite_batch.primary_texture = NULL;
+static void sprite_batch_key_forget_texture(SpriteBatchKey *key, Texture *tex) {
+	if(key->primary_texture == tex) {
+		key->primary_texture = NULL;
 	}
 
 	for(uint i = 0; i < R_NUM_SPRITE_AUX_TEXTURES; ++i) {
-		if(_r_sprite_batch.aux_textures[i] == tex) {
-			_r_sprite_batch.aux_textures[i] = NULL;
+		if(key->aux_textures[i] == tex) {
+			key->aux_textures[i] = NULL;
 		}
 	}
 }
+
+void _r_sprite_batch_texture_deleted(Texture *tex) {
+	if(_r_threaded_in_backend()) {
+		// Already handled on the main thread when the deletion was recorded
+		return;
+	}
+
+	sprite_batch_key_forget_texture(&_r_sprite_batch.state, tex);
+
+	dynarray_foreach_elem(&_r_sprite_batch.queue.keys, SpriteBatchKey *key, {
+		sprite_batch_key_forget_texture(key, tex);
+	});
+}
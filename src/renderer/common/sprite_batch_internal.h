@@ -15,3 +15,5 @@
 
 void _r_sprite_batch_end_frame(void);
 void _r_sprite_batch_texture_deleted(Texture *tex);
+void _r_sprite_batch_uniform_resolved(Uniform *uniform, ShaderProgram *prog);
+void _r_sprite_batch_uniform_changed(Uniform *uniform);
@@ -9,6 +9,7 @@
 #include "state.h"
 
 #include "backend.h"
+#include "threaded.h"
 
 #define RSTATE_STACK_SIZE 16
 
@@ -28,7 +29,7 @@ void _r_state_shutdown(void) {
 #define S (*_r_state.head)
 #define B (_r_backend.funcs)
 #define TAINT(db, code) do {\
-	if(_r_state.head && !(S.dirty_bits & (db))) { \
+	if(_r_state.head && !_r_threaded_in_backend() && !(S.dirty_bits & (db))) { \
 			S.dirty_bits |= (db); \
 			do { code } while(0); \
 		} \
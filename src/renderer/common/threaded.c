@@ -0,0 +1,1479 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "threaded.h"
+
+#include "cached_buffer.h"
+#include "command_list.h"
+#include "sprite_batch_internal.h"
+
+#include "hashtable.h"
+#include "list.h"
+#include "log.h"
+#include "pixmap/pixmap.h"
+#include "thread.h"
+#include "util.h"
+
+/*
+ * Ownership of the backend (and the GL context, if any) moves between the two threads. The render
+ * thread owns it while it has work to do; when the main thread needs to call into the backend
+ * directly, it waits for the render thread to drain everything submitted so far and takes the
+ * backend over until the next r_swap().
+ *
+ * Backend code may call back into the r_* API. Those calls go straight to the backend: they are
+ * part of the operation being executed, not something to record.
+ */
+
+typedef enum BackendOwner {
+	OWNER_MAIN,
+	OWNER_RENDER,
+} BackendOwner;
+
+typedef struct TextureShadow {
+	TextureParams params;
+} TextureShadow;
+
+typedef struct FramebufferShadow {
+	FramebufferAttachmentQueryResult attachments[FRAMEBUFFER_MAX_ATTACHMENTS];
+	FramebufferAttachment outputs[FRAMEBUFFER_MAX_OUTPUTS];
+	FloatRect viewport;
+} FramebufferShadow;
+
+typedef struct VertexBufferShadow {
+	LIST_INTERFACE(struct VertexBufferShadow);
+	VertexBuffer *vbuf;
+	CachedBuffer cbuf;  // the stream user code writes to; dirty ranges are recorded before draws
+} VertexBufferShadow;
+
+typedef struct IndexBufferShadow {
+	uint index_size;
+	size_t stream_offset;
+} IndexBufferShadow;
+
+typedef struct ProgramShadow {
+	ht_str2ptr_t uniforms;  // name -> Uniform*; misses are cached as NULL
+} ProgramShadow;
+
+typedef struct ReadRequest {
+	LIST_INTERFACE(struct ReadRequest);
+	FramebufferReadAsyncCallback callback;
+	void *userdata;
+	Pixmap pixmap;
+	bool have_pixmap;
+} ReadRequest;
+
+static struct {
+	RendererFuncs backend;
+	bool enabled;
+
+	Thread *thread;
+	SDL_Mutex *mutex;
+	SDL_Condition *cond;
+
+	// Protected by mutex
+	BackendOwner owner;
+	RenderCommandList *pending;
+	bool release_requested;
+	bool quit;
+	LIST_ANCHOR(ReadRequest) finished_reads;
+
+	// Main thread only
+	RenderCommandList lists[2];
+	RenderCommandList *recording;
+	bool main_owns_backend;
+	int main_in_backend;
+
+	// Handed over together with the backend
+	SDL_Window *gl_window;
+	SDL_GLContext gl_context;
+
+	struct {
+		r_capability_bits_t capabilities;
+		Color color;
+		BlendMode blend;
+		CullFaceMode cull;
+		DepthTestFunc depth_func;
+		ShaderProgram *shader;
+		Framebuffer *framebuffer;
+		IntRect scissor;
+		VsyncMode vsync;
+		FramebufferShadow screen;
+	} state;
+
+	ht_ptr2ptr_t textures;
+	ht_ptr2ptr_t framebuffers;
+	ht_ptr2ptr_t vertex_buffers;
+	ht_ptr2ptr_t index_buffers;
+	ht_ptr2ptr_t programs;
+	ht_ptr2int_t uniform_types;
+	LIST_ANCHOR(VertexBufferShadow) vbuf_list;
+
+	struct {
+		uint64_t frames;
+		uint64_t syncs;
+		uint64_t takeovers;
+	} stats;
+} T;
+
+static bool threaded_passthrough(void) {
+	return (T.thread && thread_get_current() == T.thread) || T.main_in_backend > 0;
+}
+
+bool _r_threaded_in_backend(void) {
+	return T.enabled && threaded_passthrough();
+}
+
+#define PASSTHROUGH(func, ...) do { \
+	if(threaded_passthrough()) { \
+		return T.backend.func(__VA_ARGS__); \
+	} \
+} while(0)
+
+#define PASSTHROUGH_VOID(func, ...) do { \
+	if(threaded_passthrough()) { \
+		T.backend.func(__VA_ARGS__); \
+		return; \
+	} \
+} while(0)
+
+/*
+ * Thread handoff
+ */
+
+static void threaded_make_current(SDL_Window *window, SDL_GLContext context) {
+	if(T.gl_context && !SDL_GL_MakeCurrent(window, context)) {
+		log_sdl_error(LOG_FATAL, "SDL_GL_MakeCurrent");
+	}
+}
+
+static void *threaded_render_thread(void *arg) {
+	bool have_context = false;
+
+	SDL_LockMutex(T.mutex);
+
+	for(;;) {
+		if(T.owner == OWNER_RENDER) {
+			if(!have_context) {
+				threaded_make_current(T.gl_window, T.gl_context);
+				have_context = true;
+			}
+
+			if(T.pending) {
+				auto cl = T.pending;
+				SDL_UnlockMutex(T.mutex);
+				rcmdlist_replay(cl, &T.backend);
+				SDL_LockMutex(T.mutex);
+				T.pending = NULL;
+				SDL_BroadcastCondition(T.cond);
+				continue;
+			}
+
+			if(T.release_requested) {
+				threaded_make_current(T.gl_window, NULL);
+				have_context = false;
+				T.owner = OWNER_MAIN;
+				T.release_requested = false;
+				SDL_BroadcastCondition(T.cond);
+				continue;
+			}
+		} else if(T.quit) {
+			break;
+		}
+
+		SDL_WaitCondition(T.cond, T.mutex);
+	}
+
+	SDL_UnlockMutex(T.mutex);
+	return NULL;
+}
+
+static void threaded_execute_recording(void) {
+	assert(T.main_owns_backend);
+
+	++T.main_in_backend;
+	rcmdlist_replay(T.recording, &T.backend);
+	--T.main_in_backend;
+
+	rcmdlist_reset(T.recording);
+}
+
+// Hands the recorded commands to the render thread, once it's done with the previous batch
+static void threaded_submit_recording(void) {
+	assert(!T.main_owns_backend);
+
+	SDL_LockMutex(T.mutex);
+
+	while(T.pending) {
+		SDL_WaitCondition(T.cond, T.mutex);
+	}
+
+	T.pending = T.recording;
+	SDL_BroadcastCondition(T.cond);
+	SDL_UnlockMutex(T.mutex);
+
+	T.recording = T.recording == T.lists ? T.lists + 1 : T.lists;
+	rcmdlist_reset(T.recording);
+}
+
+static void threaded_give_backend(void) {
+	assert(T.main_owns_backend);
+	assert(rcmdlist_is_empty(T.recording));
+
+	if(T.gl_context) {
+		// May have been re-bound to a new window in the meantime
+		T.gl_window = SDL_GL_GetCurrentWindow();
+		T.gl_context = SDL_GL_GetCurrentContext();
+		threaded_make_current(T.gl_window, NULL);
+	}
+
+	SDL_LockMutex(T.mutex);
+	T.owner = OWNER_RENDER;
+	SDL_BroadcastCondition(T.cond);
+	SDL_UnlockMutex(T.mutex);
+
+	T.main_owns_backend = false;
+}
+
+static void threaded_take_backend(void) {
+	assert(!T.main_owns_backend);
+
+	if(!rcmdlist_is_empty(T.recording)) {
+		threaded_submit_recording();
+	}
+
+	SDL_LockMutex(T.mutex);
+	T.release_requested = true;
+	SDL_BroadcastCondition(T.cond);
+
+	while(T.owner != OWNER_MAIN) {
+		SDL_WaitCondition(T.cond, T.mutex);
+	}
+
+	SDL_UnlockMutex(T.mutex);
+
+	threaded_make_current(T.gl_window, T.gl_context);
+	T.main_owns_backend = true;
+	++T.stats.takeovers;
+}
+
+// Brings the backend up to date with everything recorded so far, so that it can be called directly
+static void threaded_begin_sync(void) {
+	++T.stats.syncs;
+
+	if(!T.main_owns_backend) {
+		threaded_take_backend();
+	}
+
+	threaded_execute_recording();
+	++T.main_in_backend;
+}
+
+static void threaded_end_sync(void) {
+	assert(T.main_in_backend > 0);
+	--T.main_in_backend;
+}
+
+#define SYNC_CALL(func, ...) ({ \
+	threaded_begin_sync(); \
+	auto _result = T.backend.func(__VA_ARGS__); \
+	threaded_end_sync(); \
+	_result; \
+})
+
+#define SYNC_CALL_VOID(func, ...) do { \
+	threaded_begin_sync(); \
+	T.backend.func(__VA_ARGS__); \
+	threaded_end_sync(); \
+} while(0)
+
+INLINE RenderCommand *record(RenderCommandType type) {
+	return rcmdlist_append(T.recording, type);
+}
+
+static const char *record_label(const char *label) {
+	return label ? rcmdlist_strdup(T.recording, label) : NULL;
+}
+
+static void threaded_deliver_reads(void) {
+	SDL_LockMutex(T.mutex);
+	auto reads = T.finished_reads;
+	T.finished_reads = (typeof(reads)) {};
+	SDL_UnlockMutex(T.mutex);
+
+	for(ReadRequest *rq; (rq = alist_pop(&reads));) {
+		rq->callback(rq->have_pixmap ? &rq->pixmap : NULL, rq->userdata);
+		mem_free(rq->pixmap.data.untyped);
+		mem_free(rq);
+	}
+}
+
+/*
+ * Shadow lookups
+ */
+
+static TextureShadow *texture_shadow(Texture *tex) {
+	TextureShadow *s = ht_get(&T.textures, tex, NULL);
+
+	if(UNLIKELY(!s)) {
+		s = ALLOC(TextureShadow);
+		SYNC_CALL_VOID(texture_get_params, tex, &s->params);
+		ht_set(&T.textures, tex, s);
+	}
+
+	return s;
+}
+
+static void framebuffer_shadow_init(Framebuffer *fb, FramebufferShadow *s) {
+	T.backend.framebuffer_outputs(fb, s->outputs, 0x00);
+	T.backend.framebuffer_viewport_current(fb, &s->viewport);
+
+	for(uint i = 0; i < ARRAY_SIZE(s->attachments); ++i) {
+		s->attachments[i] = T.backend.framebuffer_query_attachment(fb, i);
+	}
+}
+
+static FramebufferShadow *framebuffer_shadow(Framebuffer *fb) {
+	if(!fb) {
+		return &T.state.screen;
+	}
+
+	FramebufferShadow *s = ht_get(&T.framebuffers, fb, NULL);
+
+	if(UNLIKELY(!s)) {
+		s = ALLOC(FramebufferShadow);
+		threaded_begin_sync();
+		framebuffer_shadow_init(fb, s);
+		threaded_end_sync();
+		ht_set(&T.framebuffers, fb, s);
+	}
+
+	return s;
+}
+
+static VertexBufferShadow *vertex_buffer_shadow(VertexBuffer *vbuf) {
+	return NOT_NULL(ht_get(&T.vertex_buffers, vbuf, NULL));
+}
+
+static IndexBufferShadow *index_buffer_shadow(IndexBuffer *ibuf) {
+	IndexBufferShadow *s = ht_get(&T.index_buffers, ibuf, NULL);
+
+	if(UNLIKELY(!s)) {
+		threaded_begin_sync();
+		s = ALLOC(IndexBufferShadow, {
+			.index_size = T.backend.index_buffer_get_index_size(ibuf),
+		});
+		s->stream_offset = T.backend.index_buffer_get_offset(ibuf) * s->index_size;
+		threaded_end_sync();
+		ht_set(&T.index_buffers, ibuf, s);
+	}
+
+	return s;
+}
+
+static void program_shadow_free(ProgramShadow *s) {
+	ht_str2ptr_iter_t iter;
+	ht_iter_begin(&s->uniforms, &iter);
+
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		if(iter.value) {
+			ht_unset(&T.uniform_types, iter.value);
+		}
+	}
+
+	ht_iter_end(&iter);
+	ht_destroy(&s->uniforms);
+	mem_free(s);
+}
+
+static void forget_program(ShaderProgram *prog) {
+	ProgramShadow *s = ht_get(&T.programs, prog, NULL);
+
+	if(s) {
+		program_shadow_free(s);
+		ht_unset(&T.programs, prog);
+	}
+}
+
+static void forget_object(ht_ptr2ptr_t *ht, void *obj) {
+	void *s = ht_get(ht, obj, NULL);
+
+	if(s) {
+		mem_free(s);
+		ht_unset(ht, obj);
+	}
+}
+
+// Records the data written to the vertex buffer streams since the last draw
+static void flush_vertex_buffers(void) {
+	for(VertexBufferShadow *s = T.vbuf_list.first; s; s = s->next) {
+		if(s->cbuf.update_begin >= s->cbuf.update_end) {
+			continue;
+		}
+
+		CachedBufferUpdate updates[CACHEDBUF_MAX_UPDATES];
+		uint num_updates = cachedbuf_flush(&s->cbuf, false, updates);
+
+		for(uint i = 0; i < num_updates; ++i) {
+			auto cmd = record(RCMD_VERTEX_BUFFER_WRITE);
+			cmd->vbuf_write.vbuf = s->vbuf;
+			cmd->vbuf_write.offset = updates[i].offset;
+			cmd->vbuf_write.size = updates[i].size;
+			cmd->vbuf_write.data = rcmdlist_memdup(T.recording, updates[i].data, updates[i].size);
+		}
+	}
+}
+
+/*
+ * Lifecycle
+ */
+
+static void threaded_post_init(void) {
+	SYNC_CALL_VOID(post_init);
+
+	T.thread = thread_create("Render", threaded_render_thread, NULL, THREAD_PRIO_HIGH);
+
+	if(!T.thread) {
+		log_warn("Couldn't start the render thread; rendering will not be threaded");
+		return;
+	}
+
+	log_info("Render thread started");
+}
+
+static void threaded_shutdown(void) {
+	threaded_begin_sync();
+	threaded_end_sync();
+
+	if(T.thread) {
+		SDL_LockMutex(T.mutex);
+		T.quit = true;
+		SDL_BroadcastCondition(T.cond);
+		SDL_UnlockMutex(T.mutex);
+		thread_wait(T.thread);
+		T.thread = NULL;
+	}
+
+	log_debug(
+		"%"PRIu64" frames, %"PRIu64" synchronous calls, %"PRIu64" backend takeovers",
+		T.stats.frames, T.stats.syncs, T.stats.takeovers
+	);
+
+	threaded_deliver_reads();
+	T.backend.shutdown();
+	threaded_deliver_reads();
+
+	ht_ptr2ptr_t *hts[] = { &T.textures, &T.framebuffers, &T.index_buffers };
+
+	for(uint i = 0; i < ARRAY_SIZE(hts); ++i) {
+		ht_ptr2ptr_iter_t iter;
+		ht_iter_begin(hts[i], &iter);
+
+		for(; iter.has_data; ht_iter_next(&iter)) {
+			mem_free(iter.value);
+		}
+
+		ht_iter_end(&iter);
+		ht_destroy(hts[i]);
+	}
+
+	for(VertexBufferShadow *s; (s = alist_pop(&T.vbuf_list));) {
+		cachedbuf_deinit(&s->cbuf);
+		mem_free(s);
+	}
+
+	ht_ptr2ptr_iter_t iter;
+	ht_iter_begin(&T.programs, &iter);
+
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		program_shadow_free(iter.value);
+	}
+
+	ht_iter_end(&iter);
+	ht_destroy(&T.programs);
+	ht_destroy(&T.uniform_types);
+	ht_destroy(&T.vertex_buffers);
+
+	rcmdlist_deinit(T.lists);
+	rcmdlist_deinit(T.lists + 1);
+	SDL_DestroyCondition(T.cond);
+	SDL_DestroyMutex(T.mutex);
+	T.enabled = false;
+}
+
+static SDL_Window *threaded_create_window(const char *title, int x, int y, int w, int h, uint32_t flags) {
+	threaded_begin_sync();
+	SDL_Window *window = T.backend.create_window(title, x, y, w, h, flags);
+
+	// Nothing can query the state before there is a window, so this is where the shadows start
+	auto b = &T.backend;
+	T.state.capabilities = b->capabilities_current();
+	T.state.color = *b->color_current();
+	T.state.blend = b->blend_current();
+	T.state.cull = b->cull_current();
+	T.state.depth_func = b->depth_func_current();
+	T.state.shader = b->shader_current();
+	T.state.framebuffer = b->framebuffer_current();
+	T.state.vsync = b->vsync_current();
+	b->scissor_current(&T.state.scissor);
+	b->framebuffer_viewport_current(NULL, &T.state.screen.viewport);
+
+	if(!T.gl_context) {
+		T.gl_context = SDL_GL_GetCurrentContext();
+	}
+
+	threaded_end_sync();
+	return window;
+}
+
+static void threaded_unclaim_window(SDL_Window *window) {
+	SYNC_CALL_VOID(unclaim_window, window);
+}
+
+static void threaded_begin_frame(void) {
+	PASSTHROUGH_VOID(begin_frame);
+	record(RCMD_BEGIN_FRAME);
+}
+
+static void threaded_swap(SDL_Window *window) {
+	PASSTHROUGH_VOID(swap, window);
+
+	r_flush_sprites();
+	record(RCMD_SWAP)->window = window;
+
+	if(T.main_owns_backend) {
+		threaded_execute_recording();
+
+		if(T.thread) {
+			threaded_give_backend();
+		}
+	} else {
+		threaded_submit_recording();
+	}
+
+	++T.stats.frames;
+	threaded_deliver_reads();
+}
+
+/*
+ * Global state
+ */
+
+static void threaded_capabilities(r_capability_bits_t capbits) {
+	PASSTHROUGH_VOID(capabilities, capbits);
+	T.state.capabilities = capbits;
+	record(RCMD_CAPABILITIES)->capabilities = capbits;
+}
+
+static r_capability_bits_t threaded_capabilities_current(void) {
+	PASSTHROUGH(capabilities_current);
+	return T.state.capabilities;
+}
+
+static void threaded_color4(float r, float g, float b, float a) {
+	PASSTHROUGH_VOID(color4, r, g, b, a);
+	T.state.color = (Color) { r, g, b, a };
+	record(RCMD_COLOR)->color = T.state.color;
+}
+
+static const Color *threaded_color_current(void) {
+	PASSTHROUGH(color_current);
+	return &T.state.color;
+}
+
+static void threaded_blend(BlendMode mode) {
+	PASSTHROUGH_VOID(blend, mode);
+	T.state.blend = mode;
+	record(RCMD_BLEND)->blend = mode;
+}
+
+static BlendMode threaded_blend_current(void) {
+	PASSTHROUGH(blend_current);
+	return T.state.blend;
+}
+
+static void threaded_cull(CullFaceMode mode) {
+	PASSTHROUGH_VOID(cull, mode);
+	T.state.cull = mode;
+	record(RCMD_CULL)->cull = mode;
+}
+
+static CullFaceMode threaded_cull_current(void) {
+	PASSTHROUGH(cull_current);
+	return T.state.cull;
+}
+
+static void threaded_depth_func(DepthTestFunc func) {
+	PASSTHROUGH_VOID(depth_func, func);
+	T.state.depth_func = func;
+	record(RCMD_DEPTH_FUNC)->depth_func = func;
+}
+
+static DepthTestFunc threaded_depth_func_current(void) {
+	PASSTHROUGH(depth_func_current);
+	return T.state.depth_func;
+}
+
+static void threaded_scissor(IntRect scissor) {
+	PASSTHROUGH_VOID(scissor, scissor);
+	T.state.scissor = scissor;
+	record(RCMD_SCISSOR)->scissor = scissor;
+}
+
+static void threaded_scissor_current(IntRect *scissor) {
+	PASSTHROUGH_VOID(scissor_current, scissor);
+	*scissor = T.state.scissor;
+}
+
+static void threaded_vsync(VsyncMode mode) {
+	PASSTHROUGH_VOID(vsync, mode);
+	T.state.vsync = mode;
+	record(RCMD_VSYNC)->vsync = mode;
+}
+
+static VsyncMode threaded_vsync_current(void) {
+	PASSTHROUGH(vsync_current);
+	return T.state.vsync;
+}
+
+/*
+ * Drawing
+ */
+
+static void threaded_draw(VertexArray *varr, Primitive prim, uint firstvert, uint count, uint instances, uint base_instance) {
+	PASSTHROUGH_VOID(draw, varr, prim, firstvert, count, instances, base_instance);
+	r_flush_sprites();
+	flush_vertex_buffers();
+
+	auto cmd = record(RCMD_DRAW);
+	cmd->draw.varr = varr;
+	cmd->draw.prim = prim;
+	cmd->draw.first = firstvert;
+	cmd->draw.count = count;
+	cmd->draw.instances = instances;
+	cmd->draw.base_instance = base_instance;
+}
+
+static void threaded_draw_indexed(VertexArray *varr, Primitive prim, uint firstidx, uint count, uint instances, uint base_instance) {
+	PASSTHROUGH_VOID(draw_indexed, varr, prim, firstidx, count, instances, base_instance);
+	r_flush_sprites();
+	flush_vertex_buffers();
+
+	auto cmd = record(RCMD_DRAW_INDEXED);
+	cmd->draw.varr = varr;
+	cmd->draw.prim = prim;
+	cmd->draw.first = firstidx;
+	cmd->draw.count = count;
+	cmd->draw.instances = instances;
+	cmd->draw.base_instance = base_instance;
+}
+
+/*
+ * Shaders
+ */
+
+static ShaderObject *threaded_shader_object_compile(ShaderSource *source) {
+	PASSTHROUGH(shader_object_compile, source);
+	return SYNC_CALL(shader_object_compile, source);
+}
+
+static void threaded_shader_object_destroy(ShaderObject *shobj) {
+	PASSTHROUGH_VOID(shader_object_destroy, shobj);
+	record(RCMD_SHADER_OBJECT_DESTROY)->object = shobj;
+}
+
+static void threaded_shader_object_set_debug_label(ShaderObject *shobj, const char *label) {
+	PASSTHROUGH_VOID(shader_object_set_debug_label, shobj, label);
+	auto cmd = record(RCMD_SHADER_OBJECT_SET_DEBUG_LABEL);
+	cmd->debug_label.object = shobj;
+	cmd->debug_label.label = record_label(label);
+}
+
+static const char *threaded_shader_object_get_debug_label(ShaderObject *shobj) {
+	PASSTHROUGH(shader_object_get_debug_label, shobj);
+	return SYNC_CALL(shader_object_get_debug_label, shobj);
+}
+
+static bool threaded_shader_object_transfer(ShaderObject *dst, ShaderObject *src) {
+	PASSTHROUGH(shader_object_transfer, dst, src);
+	return SYNC_CALL(shader_object_transfer, dst, src);
+}
+
+static ShaderProgram *threaded_shader_program_link(uint num_objects, ShaderObject *shobjs[num_objects]) {
+	PASSTHROUGH(shader_program_link, num_objects, shobjs);
+	return SYNC_CALL(shader_program_link, num_objects, shobjs);
+}
+
+static void threaded_shader_program_destroy(ShaderProgram *prog) {
+	PASSTHROUGH_VOID(shader_program_destroy, prog);
+	forget_program(prog);
+	record(RCMD_SHADER_PROGRAM_DESTROY)->object = prog;
+}
+
+static void threaded_shader_program_set_debug_label(ShaderProgram *prog, const char *label) {
+	PASSTHROUGH_VOID(shader_program_set_debug_label, prog, label);
+	auto cmd = record(RCMD_SHADER_PROGRAM_SET_DEBUG_LABEL);
+	cmd->debug_label.object = prog;
+	cmd->debug_label.label = record_label(label);
+}
+
+static const char *threaded_shader_program_get_debug_label(ShaderProgram *prog) {
+	PASSTHROUGH(shader_program_get_debug_label, prog);
+	return SYNC_CALL(shader_program_get_debug_label, prog);
+}
+
+static bool threaded_shader_program_transfer(ShaderProgram *dst, ShaderProgram *src) {
+	PASSTHROUGH(shader_program_transfer, dst, src);
+
+	// The source program is consumed. Uniforms of the destination stay valid and keep their
+	// types, but ones that didn't exist before may exist now.
+	forget_program(src);
+
+	ProgramShadow *s = ht_get(&T.programs, dst, NULL);
+
+	if(s) {
+		ht_str2ptr_t uniforms;
+		ht_create(&uniforms);
+
+		ht_str2ptr_iter_t iter;
+		ht_iter_begin(&s->uniforms, &iter);
+
+		for(; iter.has_data; ht_iter_next(&iter)) {
+			if(iter.value) {
+				ht_set(&uniforms, iter.key, iter.value);
+			}
+		}
+
+		ht_iter_end(&iter);
+		ht_destroy(&s->uniforms);
+		s->uniforms = uniforms;
+	}
+
+	return SYNC_CALL(shader_program_transfer, dst, src);
+}
+
+static void threaded_shader(ShaderProgram *prog) {
+	PASSTHROUGH_VOID(shader, prog);
+	T.state.shader = prog;
+	record(RCMD_SHADER)->shader = prog;
+}
+
+static ShaderProgram *threaded_shader_current(void) {
+	PASSTHROUGH(shader_current);
+	return T.state.shader;
+}
+
+static Uniform *threaded_shader_uniform(ShaderProgram *prog, const char *uniform_name, hash_t uniform_name_hash) {
+	PASSTHROUGH(shader_uniform, prog, uniform_name, uniform_name_hash);
+
+	ProgramShadow *s = ht_get(&T.programs, prog, NULL);
+
+	if(!s) {
+		s = ALLOC(ProgramShadow);
+		ht_create(&s->uniforms);
+		ht_set(&T.programs, prog, s);
+	}
+
+	void *uniform;
+
+	if(ht_lookup_prehashed(&s->uniforms, uniform_name, uniform_name_hash, &uniform)) {
+		return uniform;
+	}
+
+	threaded_begin_sync();
+	uniform = T.backend.shader_uniform(prog, uniform_name, uniform_name_hash);
+
+	if(uniform) {
+		ht_set(&T.uniform_types, uniform, T.backend.uniform_type(uniform));
+	}
+
+	threaded_end_sync();
+
+	ht_set(&s->uniforms, uniform_name, uniform);
+	return uniform;
+}
+
+static UniformType threaded_uniform_type(Uniform *uniform) {
+	PASSTHROUGH(uniform_type, uniform);
+
+	int64_t type;
+
+	if(ht_lookup(&T.uniform_types, uniform, &type)) {
+		return type;
+	}
+
+	return SYNC_CALL(uniform_type, uniform);
+}
+
+static void threaded_uniform(Uniform *uniform, uint offset, uint count, const void *data) {
+	PASSTHROUGH_VOID(uniform, uniform, offset, count, data);
+
+	auto tinfo = r_uniform_type_info(threaded_uniform_type(uniform));
+	size_t size = (size_t)count * tinfo->elements * tinfo->element_size;
+
+	auto cmd = record(RCMD_UNIFORM);
+	cmd->uniform.uniform = uniform;
+	cmd->uniform.offset = offset;
+	cmd->uniform.count = count;
+	cmd->uniform.data = rcmdlist_memdup(T.recording, data, size);
+}
+
+/*
+ * Textures
+ */
+
+static Texture *threaded_texture_create(const TextureParams *params) {
+	PASSTHROUGH(texture_create, params);
+
+	threaded_begin_sync();
+	Texture *tex = T.backend.texture_create(params);
+
+	if(tex) {
+		auto s = ALLOC(TextureShadow);
+		T.backend.texture_get_params(tex, &s->params);
+		ht_set(&T.textures, tex, s);
+	}
+
+	threaded_end_sync();
+	return tex;
+}
+
+static void threaded_texture_get_params(Texture *tex, TextureParams *params) {
+	PASSTHROUGH_VOID(texture_get_params, tex, params);
+	*params = texture_shadow(tex)->params;
+}
+
+static void threaded_texture_get_size(Texture *tex, uint mipmap, uint *width, uint *height) {
+	PASSTHROUGH_VOID(texture_get_size, tex, mipmap, width, height);
+
+	auto p = &texture_shadow(tex)->params;
+	mipmap = min(mipmap, p->mipmaps - 1);
+
+	if(width) {
+		*width = max(1, p->width >> mipmap);
+	}
+
+	if(height) {
+		*height = max(1, p->height >> mipmap);
+	}
+}
+
+static const char *threaded_texture_get_debug_label(Texture *tex) {
+	PASSTHROUGH(texture_get_debug_label, tex);
+	return SYNC_CALL(texture_get_debug_label, tex);
+}
+
+static void threaded_texture_set_debug_label(Texture *tex, const char *label) {
+	PASSTHROUGH_VOID(texture_set_debug_label, tex, label);
+	auto cmd = record(RCMD_TEXTURE_SET_DEBUG_LABEL);
+	cmd->debug_label.object = tex;
+	cmd->debug_label.label = record_label(label);
+}
+
+static void threaded_texture_set_filter(Texture *tex, TextureFilterMode fmin, TextureFilterMode fmag) {
+	PASSTHROUGH_VOID(texture_set_filter, tex, fmin, fmag);
+
+	auto p = &texture_shadow(tex)->params;
+	p->filter.min = fmin;
+	p->filter.mag = fmag;
+
+	auto cmd = record(RCMD_TEXTURE_SET_FILTER);
+	cmd->tex_modes.texture = tex;
+	cmd->tex_modes.mode1 = fmin;
+	cmd->tex_modes.mode2 = fmag;
+}
+
+static void threaded_texture_set_wrap(Texture *tex, TextureWrapMode ws, TextureWrapMode wt) {
+	PASSTHROUGH_VOID(texture_set_wrap, tex, ws, wt);
+
+	auto p = &texture_shadow(tex)->params;
+	p->wrap.s = ws;
+	p->wrap.t = wt;
+
+	auto cmd = record(RCMD_TEXTURE_SET_WRAP);
+	cmd->tex_modes.texture = tex;
+	cmd->tex_modes.mode1 = ws;
+	cmd->tex_modes.mode2 = wt;
+}
+
+static void threaded_texture_destroy(Texture *tex) {
+	PASSTHROUGH_VOID(texture_destroy, tex);
+	_r_sprite_batch_texture_deleted(tex);
+	forget_object(&T.textures, tex);
+	record(RCMD_TEXTURE_DESTROY)->object = tex;
+}
+
+static void threaded_texture_invalidate(Texture *tex) {
+	PASSTHROUGH_VOID(texture_invalidate, tex);
+	record(RCMD_TEXTURE_INVALIDATE)->object = tex;
+}
+
+static void record_texture_fill(
+	RenderCommandType type, Texture *tex, uint mipmap, uint layer, uint x, uint y, const Pixmap *image_data
+) {
+	auto cmd = record(type);
+	cmd->tex_fill.texture = tex;
+	cmd->tex_fill.mipmap = mipmap;
+	cmd->tex_fill.layer = layer;
+	cmd->tex_fill.x = x;
+	cmd->tex_fill.y = y;
+	cmd->tex_fill.image = *image_data;
+	cmd->tex_fill.image.data.untyped = rcmdlist_memdup(
+		T.recording, image_data->data.untyped, image_data->data_size);
+}
+
+static void threaded_texture_fill(Texture *tex, uint mipmap, uint layer, const Pixmap *image_data) {
+	PASSTHROUGH_VOID(texture_fill, tex, mipmap, layer, image_data);
+	record_texture_fill(RCMD_TEXTURE_FILL, tex, mipmap, layer, 0, 0, image_data);
+}
+
+static void threaded_texture_fill_region(Texture *tex, uint mipmap, uint layer, uint x, uint y, const Pixmap *image_data) {
+	PASSTHROUGH_VOID(texture_fill_region, tex, mipmap, layer, x, y, image_data);
+	record_texture_fill(RCMD_TEXTURE_FILL_REGION, tex, mipmap, layer, x, y, image_data);
+}
+
+static bool threaded_texture_dump(Texture *tex, uint mipmap, uint layer, Pixmap *dst) {
+	PASSTHROUGH(texture_dump, tex, mipmap, layer, dst);
+	r_flush_sprites();
+	return SYNC_CALL(texture_dump, tex, mipmap, layer, dst);
+}
+
+static void threaded_texture_clear(Texture *tex, const Color *clr) {
+	PASSTHROUGH_VOID(texture_clear, tex, clr);
+	r_flush_sprites();
+
+	auto cmd = record(RCMD_TEXTURE_CLEAR);
+	cmd->tex_clear.texture = tex;
+	cmd->tex_clear.color = *clr;
+}
+
+static bool threaded_texture_transfer(Texture *dst, Texture *src) {
+	PASSTHROUGH(texture_transfer, dst, src);
+
+	_r_sprite_batch_texture_deleted(dst);
+	_r_sprite_batch_texture_deleted(src);
+	forget_object(&T.textures, src);
+
+	threaded_begin_sync();
+	bool result = T.backend.texture_transfer(dst, src);
+	T.backend.texture_get_params(dst, &texture_shadow(dst)->params);
+	threaded_end_sync();
+
+	return result;
+}
+
+/*
+ * Framebuffers
+ */
+
+static Framebuffer *threaded_framebuffer_create(void) {
+	PASSTHROUGH(framebuffer_create);
+
+	threaded_begin_sync();
+	Framebuffer *fb = T.backend.framebuffer_create();
+
+	if(fb) {
+		auto s = ALLOC(FramebufferShadow);
+		framebuffer_shadow_init(fb, s);
+		ht_set(&T.framebuffers, fb, s);
+	}
+
+	threaded_end_sync();
+	return fb;
+}
+
+static const char *threaded_framebuffer_get_debug_label(Framebuffer *fb) {
+	PASSTHROUGH(framebuffer_get_debug_label, fb);
+	return SYNC_CALL(framebuffer_get_debug_label, fb);
+}
+
+static void threaded_framebuffer_set_debug_label(Framebuffer *fb, const char *label) {
+	PASSTHROUGH_VOID(framebuffer_set_debug_label, fb, label);
+	auto cmd = record(RCMD_FRAMEBUFFER_SET_DEBUG_LABEL);
+	cmd->debug_label.object = fb;
+	cmd->debug_label.label = record_label(label);
+}
+
+static void threaded_framebuffer_destroy(Framebuffer *fb) {
+	PASSTHROUGH_VOID(framebuffer_destroy, fb);
+	forget_object(&T.framebuffers, fb);
+	record(RCMD_FRAMEBUFFER_DESTROY)->object = fb;
+}
+
+static void threaded_framebuffer_attach(Framebuffer *fb, Texture *tex, uint mipmap, FramebufferAttachment attachment) {
+	PASSTHROUGH_VOID(framebuffer_attach, fb, tex, mipmap, attachment);
+
+	framebuffer_shadow(fb)->attachments[attachment] = (FramebufferAttachmentQueryResult) {
+		.texture = tex,
+		.miplevel = mipmap,
+	};
+
+	auto cmd = record(RCMD_FRAMEBUFFER_ATTACH);
+	cmd->fb_attach.framebuffer = fb;
+	cmd->fb_attach.texture = tex;
+	cmd->fb_attach.mipmap = mipmap;
+	cmd->fb_attach.attachment = attachment;
+}
+
+static void threaded_framebuffer_viewport(Framebuffer *fb, FloatRect vp) {
+	PASSTHROUGH_VOID(framebuffer_viewport, fb, vp);
+	framebuffer_shadow(fb)->viewport = vp;
+
+	auto cmd = record(RCMD_FRAMEBUFFER_VIEWPORT);
+	cmd->fb_viewport.framebuffer = fb;
+	cmd->fb_viewport.viewport = vp;
+}
+
+static void threaded_framebuffer_viewport_current(Framebuffer *fb, FloatRect *vp) {
+	PASSTHROUGH_VOID(framebuffer_viewport_current, fb, vp);
+	*vp = framebuffer_shadow(fb)->viewport;
+}
+
+static FramebufferAttachmentQueryResult threaded_framebuffer_query_attachment(Framebuffer *fb, FramebufferAttachment attachment) {
+	PASSTHROUGH(framebuffer_query_attachment, fb, attachment);
+	return framebuffer_shadow(fb)->attachments[attachment];
+}
+
+static void threaded_framebuffer_outputs(Framebuffer *fb, FramebufferAttachment config[FRAMEBUFFER_MAX_OUTPUTS], uint8_t write_mask) {
+	PASSTHROUGH_VOID(framebuffer_outputs, fb, config, write_mask);
+
+	auto s = framebuffer_shadow(fb);
+
+	if(write_mask == 0x00) {
+		memcpy(config, s->outputs, sizeof(s->outputs));
+		return;
+	}
+
+	auto cmd = record(RCMD_FRAMEBUFFER_OUTPUTS);
+	cmd->fb_outputs.framebuffer = fb;
+	cmd->fb_outputs.write_mask = write_mask;
+
+	for(uint i = 0; i < FRAMEBUFFER_MAX_OUTPUTS; ++i) {
+		if(write_mask & (1 << i)) {
+			s->outputs[i] = config[i];
+			cmd->fb_outputs.config[i] = config[i];
+		}
+	}
+}
+
+static void threaded_framebuffer_clear(Framebuffer *fb, BufferKindFlags flags, const Color *colorval, float depthval) {
+	PASSTHROUGH_VOID(framebuffer_clear, fb, flags, colorval, depthval);
+	r_flush_sprites();
+
+	auto cmd = record(RCMD_FRAMEBUFFER_CLEAR);
+	cmd->fb_clear.framebuffer = fb;
+	cmd->fb_clear.flags = flags;
+	cmd->fb_clear.depth = depthval;
+
+	if(colorval) {
+		cmd->fb_clear.color = *colorval;
+	}
+}
+
+static void threaded_framebuffer_copy(Framebuffer *dst, Framebuffer *src, BufferKindFlags flags) {
+	PASSTHROUGH_VOID(framebuffer_copy, dst, src, flags);
+	r_flush_sprites();
+
+	auto cmd = record(RCMD_FRAMEBUFFER_COPY);
+	cmd->fb_copy.dst = dst;
+	cmd->fb_copy.src = src;
+	cmd->fb_copy.flags = flags;
+}
+
+static IntExtent threaded_framebuffer_get_size(Framebuffer *fb) {
+	PASSTHROUGH(framebuffer_get_size, fb);
+	return SYNC_CALL(framebuffer_get_size, fb);
+}
+
+// Called by the backend, on whichever thread owns it; the result is delivered on the main thread
+static void threaded_read_done(const Pixmap *pixmap, void *userdata) {
+	ReadRequest *rq = userdata;
+
+	if(pixmap) {
+		pixmap_copy_alloc(pixmap, &rq->pixmap);
+		rq->have_pixmap = true;
+	}
+
+	SDL_LockMutex(T.mutex);
+	alist_append(&T.finished_reads, rq);
+	SDL_UnlockMutex(T.mutex);
+}
+
+static void threaded_framebuffer_read_async(
+	Framebuffer *fb, FramebufferAttachment attachment, IntRect region,
+	void *userdata, FramebufferReadAsyncCallback callback
+) {
+	PASSTHROUGH_VOID(framebuffer_read_async, fb, attachment, region, userdata, callback);
+	r_flush_sprites();
+
+	auto cmd = record(RCMD_FRAMEBUFFER_READ_ASYNC);
+	cmd->fb_read.framebuffer = fb;
+	cmd->fb_read.attachment = attachment;
+	cmd->fb_read.region = region;
+	cmd->fb_read.callback = threaded_read_done;
+	cmd->fb_read.userdata = ALLOC(ReadRequest, {
+		.callback = callback,
+		.userdata = userdata,
+	});
+}
+
+static void threaded_framebuffer(Framebuffer *fb) {
+	PASSTHROUGH_VOID(framebuffer, fb);
+	T.state.framebuffer = fb;
+	record(RCMD_FRAMEBUFFER)->framebuffer = fb;
+}
+
+static Framebuffer *threaded_framebuffer_current(void) {
+	PASSTHROUGH(framebuffer_current);
+	return T.state.framebuffer;
+}
+
+/*
+ * Vertex buffers
+ */
+
+static VertexBuffer *threaded_vertex_buffer_create(size_t capacity, void *data) {
+	PASSTHROUGH(vertex_buffer_create, capacity, data);
+
+	VertexBuffer *vbuf = SYNC_CALL(vertex_buffer_create, capacity, data);
+
+	if(vbuf) {
+		auto s = ALLOC(VertexBufferShadow, { .vbuf = vbuf });
+		cachedbuf_init(&s->cbuf);
+		cachedbuf_resize(&s->cbuf, capacity);
+
+		if(data) {
+			memcpy(s->cbuf.cache, data, capacity);
+			s->cbuf.valid_end = capacity;
+		}
+
+		alist_append(&T.vbuf_list, s);
+		ht_set(&T.vertex_buffers, vbuf, s);
+	}
+
+	return vbuf;
+}
+
+static const char *threaded_vertex_buffer_get_debug_label(VertexBuffer *vbuf) {
+	PASSTHROUGH(vertex_buffer_get_debug_label, vbuf);
+	return SYNC_CALL(vertex_buffer_get_debug_label, vbuf);
+}
+
+static void threaded_vertex_buffer_set_debug_label(VertexBuffer *vbuf, const char *label) {
+	PASSTHROUGH_VOID(vertex_buffer_set_debug_label, vbuf, label);
+	auto cmd = record(RCMD_VERTEX_BUFFER_SET_DEBUG_LABEL);
+	cmd->debug_label.object = vbuf;
+	cmd->debug_label.label = record_label(label);
+}
+
+static void threaded_vertex_buffer_destroy(VertexBuffer *vbuf) {
+	PASSTHROUGH_VOID(vertex_buffer_destroy, vbuf);
+
+	auto s = vertex_buffer_shadow(vbuf);
+	alist_unlink(&T.vbuf_list, s);
+	ht_unset(&T.vertex_buffers, vbuf);
+	cachedbuf_deinit(&s->cbuf);
+	mem_free(s);
+
+	record(RCMD_VERTEX_BUFFER_DESTROY)->object = vbuf;
+}
+
+static void threaded_vertex_buffer_invalidate(VertexBuffer *vbuf) {
+	PASSTHROUGH_VOID(vertex_buffer_invalidate, vbuf);
+	cachedbuf_invalidate(&vertex_buffer_shadow(vbuf)->cbuf);
+	record(RCMD_VERTEX_BUFFER_INVALIDATE)->object = vbuf;
+}
+
+static SDL_IOStream *threaded_vertex_buffer_get_stream(VertexBuffer *vbuf) {
+	PASSTHROUGH(vertex_buffer_get_stream, vbuf);
+	return vertex_buffer_shadow(vbuf)->cbuf.stream;
+}
+
+/*
+ * Index buffers
+ */
+
+static IndexBuffer *threaded_index_buffer_create(uint index_size, size_t max_elements) {
+	PASSTHROUGH(index_buffer_create, index_size, max_elements);
+
+	IndexBuffer *ibuf = SYNC_CALL(index_buffer_create, index_size, max_elements);
+
+	if(ibuf) {
+		auto s = ALLOC(IndexBufferShadow, { .index_size = index_size });
+		ht_set(&T.index_buffers, ibuf, s);
+	}
+
+	return ibuf;
+}
+
+static size_t threaded_index_buffer_get_capacity(IndexBuffer *ibuf) {
+	PASSTHROUGH(index_buffer_get_capacity, ibuf);
+	return SYNC_CALL(index_buffer_get_capacity, ibuf);
+}
+
+static uint threaded_index_buffer_get_index_size(IndexBuffer *ibuf) {
+	PASSTHROUGH(index_buffer_get_index_size, ibuf);
+	return index_buffer_shadow(ibuf)->index_size;
+}
+
+static const char *threaded_index_buffer_get_debug_label(IndexBuffer *ibuf) {
+	PASSTHROUGH(index_buffer_get_debug_label, ibuf);
+	return SYNC_CALL(index_buffer_get_debug_label, ibuf);
+}
+
+static void threaded_index_buffer_set_debug_label(IndexBuffer *ibuf, const char *label) {
+	PASSTHROUGH_VOID(index_buffer_set_debug_label, ibuf, label);
+	auto cmd = record(RCMD_INDEX_BUFFER_SET_DEBUG_LABEL);
+	cmd->debug_label.object = ibuf;
+	cmd->debug_label.label = record_label(label);
+}
+
+static void threaded_index_buffer_set_offset(IndexBuffer *ibuf, size_t offset) {
+	PASSTHROUGH_VOID(index_buffer_set_offset, ibuf, offset);
+
+	auto s = index_buffer_shadow(ibuf);
+	s->stream_offset = offset * s->index_size;
+
+	auto cmd = record(RCMD_INDEX_BUFFER_SET_OFFSET);
+	cmd->ibuf_offset.ibuf = ibuf;
+	cmd->ibuf_offset.offset = offset;
+}
+
+static size_t threaded_index_buffer_get_offset(IndexBuffer *ibuf) {
+	PASSTHROUGH(index_buffer_get_offset, ibuf);
+	auto s = index_buffer_shadow(ibuf);
+	return s->stream_offset / s->index_size;
+}
+
+static void threaded_index_buffer_add_indices(IndexBuffer *ibuf, size_t data_size, void *data) {
+	PASSTHROUGH_VOID(index_buffer_add_indices, ibuf, data_size, data);
+
+	index_buffer_shadow(ibuf)->stream_offset += data_size;
+
+	auto cmd = record(RCMD_INDEX_BUFFER_ADD_INDICES);
+	cmd->ibuf_add.ibuf = ibuf;
+	cmd->ibuf_add.size = data_size;
+	cmd->ibuf_add.data = rcmdlist_memdup(T.recording, data, data_size);
+}
+
+static void threaded_index_buffer_invalidate(IndexBuffer *ibuf) {
+	PASSTHROUGH_VOID(index_buffer_invalidate, ibuf);
+	index_buffer_shadow(ibuf)->stream_offset = 0;
+	record(RCMD_INDEX_BUFFER_INVALIDATE)->object = ibuf;
+}
+
+static void threaded_index_buffer_destroy(IndexBuffer *ibuf) {
+	PASSTHROUGH_VOID(index_buffer_destroy, ibuf);
+	forget_object(&T.index_buffers, ibuf);
+	record(RCMD_INDEX_BUFFER_DESTROY)->object = ibuf;
+}
+
+/*
+ * Vertex arrays
+ */
+
+static VertexArray *threaded_vertex_array_create(void) {
+	PASSTHROUGH(vertex_array_create);
+	return SYNC_CALL(vertex_array_create);
+}
+
+static const char *threaded_vertex_array_get_debug_label(VertexArray *varr) {
+	PASSTHROUGH(vertex_array_get_debug_label, varr);
+	return SYNC_CALL(vertex_array_get_debug_label, varr);
+}
+
+static void threaded_vertex_array_set_debug_label(VertexArray *varr, const char *label) {
+	PASSTHROUGH_VOID(vertex_array_set_debug_label, varr, label);
+	auto cmd = record(RCMD_VERTEX_ARRAY_SET_DEBUG_LABEL);
+	cmd->debug_label.object = varr;
+	cmd->debug_label.label = record_label(label);
+}
+
+static void threaded_vertex_array_destroy(VertexArray *varr) {
+	PASSTHROUGH_VOID(vertex_array_destroy, varr);
+	record(RCMD_VERTEX_ARRAY_DESTROY)->object = varr;
+}
+
+static void threaded_vertex_array_layout(VertexArray *varr, uint nattribs, VertexAttribFormat attribs[nattribs]) {
+	PASSTHROUGH_VOID(vertex_array_layout, varr, nattribs, attribs);
+
+	auto cmd = record(RCMD_VERTEX_ARRAY_LAYOUT);
+	cmd->varr_layout.varr = varr;
+	cmd->varr_layout.nattribs = nattribs;
+	cmd->varr_layout.attribs = rcmdlist_memdup(T.recording, attribs, sizeof(*attribs) * nattribs);
+}
+
+static void threaded_vertex_array_attach_vertex_buffer(VertexArray *varr, VertexBuffer *vbuf, uint attachment) {
+	PASSTHROUGH_VOID(vertex_array_attach_vertex_buffer, varr, vbuf, attachment);
+
+	auto cmd = record(RCMD_VERTEX_ARRAY_ATTACH_VERTEX_BUFFER);
+	cmd->varr_attach_vbuf.varr = varr;
+	cmd->varr_attach_vbuf.vbuf = vbuf;
+	cmd->varr_attach_vbuf.attachment = attachment;
+}
+
+static void threaded_vertex_array_attach_index_buffer(VertexArray *varr, IndexBuffer *ibuf) {
+	PASSTHROUGH_VOID(vertex_array_attach_index_buffer, varr, ibuf);
+
+	auto cmd = record(RCMD_VERTEX_ARRAY_ATTACH_INDEX_BUFFER);
+	cmd->varr_attach_ibuf.varr = varr;
+	cmd->varr_attach_ibuf.ibuf = ibuf;
+}
+
+static VertexBuffer *threaded_vertex_array_get_vertex_attachment(VertexArray *varr, uint attachment) {
+	PASSTHROUGH(vertex_array_get_vertex_attachment, varr, attachment);
+	return SYNC_CALL(vertex_array_get_vertex_attachment, varr, attachment);
+}
+
+static IndexBuffer *threaded_vertex_array_get_index_attachment(VertexArray *varr) {
+	PASSTHROUGH(vertex_array_get_index_attachment, varr);
+	return SYNC_CALL(vertex_array_get_index_attachment, varr);
+}
+
+/*
+ * Setup
+ */
+
+bool _r_threaded_wrap(RendererBackend *backend) {
+	// sdlgpu must acquire swapchain textures on the thread that created the window, and gles30's
+	// framebuffer copy fallback goes through the main thread's state stack.
+	if(strcmp(backend->name, "gl33") && strcmp(backend->name, "null")) {
+		log_warn("Threaded rendering is not supported by the %s backend", backend->name);
+		return false;
+	}
+
+	auto b = &backend->funcs;
+
+	T = (typeof(T)) {
+		.backend = *b,
+		.enabled = true,
+		.mutex = SDL_CreateMutex(),
+		.cond = SDL_CreateCondition(),
+		.owner = OWNER_MAIN,
+		.main_owns_backend = true,
+		.recording = T.lists,
+		.gl_context = SDL_GL_GetCurrentContext(),
+		.gl_window = SDL_GL_GetCurrentWindow(),
+	};
+
+	if(!T.mutex || !T.cond) {
+		log_sdl_error(LOG_FATAL, T.mutex ? "SDL_CreateCondition" : "SDL_CreateMutex");
+	}
+
+	rcmdlist_init(T.lists);
+	rcmdlist_init(T.lists + 1);
+
+	ht_create(&T.textures);
+	ht_create(&T.framebuffers);
+	ht_create(&T.vertex_buffers);
+	ht_create(&T.index_buffers);
+	ht_create(&T.programs);
+	ht_create(&T.uniform_types);
+
+	// features, shader_language_supported and texture_type_query only consult static tables;
+	// they may also be called from loader threads, so those stay as they are.
+	b->post_init = threaded_post_init;
+	b->shutdown = threaded_shutdown;
+	b->create_window = threaded_create_window;
+	b->capabilities = threaded_capabilities;
+	b->capabilities_current = threaded_capabilities_current;
+	b->draw = threaded_draw;
+	b->draw_indexed = threaded_draw_indexed;
+	b->color4 = threaded_color4;
+	b->color_current = threaded_color_current;
+	b->blend = threaded_blend;
+	b->blend_current = threaded_blend_current;
+	b->cull = threaded_cull;
+	b->cull_current = threaded_cull_current;
+	b->depth_func = threaded_depth_func;
+	b->depth_func_current = threaded_depth_func_current;
+	b->shader_object_compile = threaded_shader_object_compile;
+	b->shader_object_destroy = threaded_shader_object_destroy;
+	b->shader_object_set_debug_label = threaded_shader_object_set_debug_label;
+	b->shader_object_get_debug_label = threaded_shader_object_get_debug_label;
+	b->shader_object_transfer = threaded_shader_object_transfer;
+	b->shader_program_link = threaded_shader_program_link;
+	b->shader_program_destroy = threaded_shader_program_destroy;
+	b->shader_program_set_debug_label = threaded_shader_program_set_debug_label;
+	b->shader_program_get_debug_label = threaded_shader_program_get_debug_label;
+	b->shader_program_transfer = threaded_shader_program_transfer;
+	b->shader = threaded_shader;
+	b->shader_current = threaded_shader_current;
+	b->shader_uniform = threaded_shader_uniform;
+	b->uniform = threaded_uniform;
+	b->uniform_type = threaded_uniform_type;
+	b->texture_create = threaded_texture_create;
+	b->texture_get_params = threaded_texture_get_params;
+	b->texture_get_size = threaded_texture_get_size;
+	b->texture_get_debug_label = threaded_texture_get_debug_label;
+	b->texture_set_debug_label = threaded_texture_set_debug_label;
+	b->texture_set_filter = threaded_texture_set_filter;
+	b->texture_set_wrap = threaded_texture_set_wrap;
+	b->texture_destroy = threaded_texture_destroy;
+	b->texture_invalidate = threaded_texture_invalidate;
+	b->texture_fill = threaded_texture_fill;
+	b->texture_fill_region = threaded_texture_fill_region;
+	b->texture_dump = threaded_texture_dump;
+	b->texture_clear = threaded_texture_clear;
+	b->texture_transfer = threaded_texture_transfer;
+	b->framebuffer_create = threaded_framebuffer_create;
+	b->framebuffer_get_debug_label = threaded_framebuffer_get_debug_label;
+	b->framebuffer_set_debug_label = threaded_framebuffer_set_debug_label;
+	b->framebuffer_destroy = threaded_framebuffer_destroy;
+	b->framebuffer_attach = threaded_framebuffer_attach;
+	b->framebuffer_viewport = threaded_framebuffer_viewport;
+	b->framebuffer_viewport_current = threaded_framebuffer_viewport_current;
+	b->framebuffer_query_attachment = threaded_framebuffer_query_attachment;
+	b->framebuffer_outputs = threaded_framebuffer_outputs;
+	b->framebuffer_clear = threaded_framebuffer_clear;
+	b->framebuffer_copy = threaded_framebuffer_copy;
+	b->framebuffer_get_size = threaded_framebuffer_get_size;
+	b->framebuffer_read_async = threaded_framebuffer_read_async;
+	b->framebuffer = threaded_framebuffer;
+	b->framebuffer_current = threaded_framebuffer_current;
+	b->vertex_buffer_create = threaded_vertex_buffer_create;
+	b->vertex_buffer_get_debug_label = threaded_vertex_buffer_get_debug_label;
+	b->vertex_buffer_set_debug_label = threaded_vertex_buffer_set_debug_label;
+	b->vertex_buffer_destroy = threaded_vertex_buffer_destroy;
+	b->vertex_buffer_invalidate = threaded_vertex_buffer_invalidate;
+	b->vertex_buffer_get_stream = threaded_vertex_buffer_get_stream;
+	b->index_buffer_create = threaded_index_buffer_create;
+	b->index_buffer_get_capacity = threaded_index_buffer_get_capacity;
+	b->index_buffer_get_index_size = threaded_index_buffer_get_index_size;
+	b->index_buffer_get_debug_label = threaded_index_buffer_get_debug_label;
+	b->index_buffer_set_debug_label = threaded_index_buffer_set_debug_label;
+	b->index_buffer_set_offset = threaded_index_buffer_set_offset;
+	b->index_buffer_get_offset = threaded_index_buffer_get_offset;
+	b->index_buffer_add_indices = threaded_index_buffer_add_indices;
+	b->index_buffer_invalidate = threaded_index_buffer_invalidate;
+	b->index_buffer_destroy = threaded_index_buffer_destroy;
+	b->vertex_array_create = threaded_vertex_array_create;
+	b->vertex_array_get_debug_label = threaded_vertex_array_get_debug_label;
+	b->vertex_array_set_debug_label = threaded_vertex_array_set_debug_label;
+	b->vertex_array_destroy = threaded_vertex_array_destroy;
+	b->vertex_array_layout = threaded_vertex_array_layout;
+	b->vertex_array_attach_vertex_buffer = threaded_vertex_array_attach_vertex_buffer;
+	b->vertex_array_attach_index_buffer = threaded_vertex_array_attach_index_buffer;
+	b->vertex_array_get_vertex_attachment = threaded_vertex_array_get_vertex_attachment;
+	b->vertex_array_get_index_attachment = threaded_vertex_array_get_index_attachment;
+	b->scissor = threaded_scissor;
+	b->scissor_current = threaded_scissor_current;
+	b->vsync = threaded_vsync;
+	b->vsync_current = threaded_vsync_current;
+	b->swap = threaded_swap;
+
+	if(T.backend.unclaim_window) {
+		b->unclaim_window = threaded_unclaim_window;
+	}
+
+	if(T.backend.begin_frame) {
+		b->begin_frame = threaded_begin_frame;
+	}
+
+	log_info("Threaded rendering enabled (experimental)");
+	return true;
+}
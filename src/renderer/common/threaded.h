@@ -0,0 +1,30 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "backend.h"
+
+/*
+ * Experimental threaded renderer.
+ *
+ * Replaces the backend's functions with a proxy that records the main thread's draw calls, state
+ * changes and buffer updates into a command list. At r_swap(), the list is handed to a dedicated
+ * render thread, which replays it on the real backend while the main thread goes on to the next
+ * frame. Queries are answered from state shadowed on the main thread; anything that needs a
+ * result from the backend (object creation, shader compilation, etc.) waits for the render thread
+ * to finish and then runs on the main thread.
+ */
+
+// Returns false if the backend can't be driven from another thread
+bool _r_threaded_wrap(RendererBackend *backend) attr_nonnull_all;
+
+// True while backend code is being executed on behalf of the proxy, on either thread.
+// Main-thread-only renderer state (sprite batch, state stack) must not be touched then.
+bool _r_threaded_in_backend(void);
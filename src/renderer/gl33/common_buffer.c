@@ -37,6 +37,7 @@ void gl33_buffer_init(CommonBuffer *cbuf, size_t capacity, void *data, GLenum us
 		if(data != NULL) {
 			glBufferSubData(target, 0, data_size, data);
 			memcpy(cbuf->cachedbuf.cache, data, data_size);
+			cbuf->cachedbuf.valid_end = data_size;
 		}
 	});
 
@@ -44,6 +45,10 @@ void gl33_buffer_init(CommonBuffer *cbuf, size_t capacity, void *data, GLenum us
 }
 
 void gl33_buffer_destroy(CommonBuffer *cbuf) {
+	auto stats = &cbuf->cachedbuf.stats;
+	log_debug("%s: uploaded %"PRIu64" bytes in %"PRIu64" ranges, %"PRIu64" flushes",
+		cbuf->debug_label, stats->bytes_uploaded, stats->num_uploads, stats->num_flushes);
+
 	gl33_buffer_deleted(cbuf);
 	glDeleteBuffers(1, &cbuf->gl_handle);
 	cachedbuf_deinit(&cbuf->cachedbuf);
@@ -57,7 +62,7 @@ void gl33_buffer_invalidate(CommonBuffer *cbuf) {
 		cbuf->commited_size = cbuf->cachedbuf.size;
 		glBufferData(gl33_bindidx_to_glenum(cbuf->bindidx), cbuf->commited_size, NULL, cbuf->gl_usage_hint);
 	});
-	cbuf->cachedbuf.stream_offset = 0;
+	cachedbuf_invalidate(&cbuf->cachedbuf);
 }
 
 void gl33_buffer_resize(CommonBuffer *cbuf, size_t new_size) {
@@ -66,23 +71,28 @@ void gl33_buffer_resize(CommonBuffer *cbuf, size_t new_size) {
 }
 
 void gl33_buffer_flush(CommonBuffer *cbuf) {
-	auto update = cachedbuf_flush(&cbuf->cachedbuf);
+	bool resize = cbuf->cachedbuf.size != cbuf->commited_size;
+	CachedBufferUpdate updates[CACHEDBUF_MAX_UPDATES];
+	uint num_updates = cachedbuf_flush(&cbuf->cachedbuf, resize, updates);
 
-	if(!update.size) {
+	if(!num_updates) {
 		return;
 	}
 
 	GL33_BUFFER_TEMP_BIND(cbuf, {
 		GLenum target = gl33_bindidx_to_glenum(cbuf->bindidx);
 
-		if(cbuf->cachedbuf.size != cbuf->commited_size) {
+		if(resize) {
 			log_debug("Resizing buffer %u (%s) from %zu to %zu",
 				cbuf->gl_handle, cbuf->debug_label, cbuf->commited_size, cbuf->cachedbuf.size
 			);
-			glBufferData(target, cbuf->cachedbuf.size, cbuf->cachedbuf.cache, cbuf->gl_usage_hint);
+			// Only the data written since the last invalidation is uploaded below, not the whole cache
+			glBufferData(target, cbuf->cachedbuf.size, NULL, cbuf->gl_usage_hint);
 			cbuf->commited_size = cbuf->cachedbuf.size;
-		} else {
-			glBufferSubData(target, update.offset, update.size, update.data);
+		}
+
+		for(uint i = 0; i < num_updates; ++i) {
+			glBufferSubData(target, updates[i].offset, updates[i].size, updates[i].data);
 		}
 	});
 }
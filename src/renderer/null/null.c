@@ -8,89 +8,480 @@
 
 #include "../api.h"
 #include "../common/backend.h"
+#include "../common/cached_buffer.h"
+#include "../common/shaderlib/shaderlib.h"
+#include "record.h"
+
+#include "hashtable.h"
+#include "log.h"
+#include "util/env.h"
+#include "util/stringops.h"
+
+/*
+ * Nothing is rendered, but objects and render state are tracked like in the real backends, so that the amount of
+ * rendering work can be measured on machines without a GPU (see record.h).
+ */
 
 static char placeholder;
-static Color dummycolor;
+
+static struct {
+	SDL_Window *window;
+	Color color;
+	BlendMode blend;
+	CullFaceMode cull;
+	DepthTestFunc depth_func;
+	r_capability_bits_t capabilities;
+	ShaderProgram *shader;
+	Framebuffer *framebuffer;
+	FloatRect default_fb_viewport;
+	IntRect scissor;
+	VsyncMode vsync;
+
+	// State as of the last draw call or clear
+	struct {
+		ShaderProgram *shader;
+		Framebuffer *framebuffer;
+		BlendMode blend;
+		CullFaceMode cull;
+		DepthTestFunc depth_func;
+		r_capability_bits_t capabilities;
+		IntRect scissor;
+	} applied;
+
+	NullFrameStats stats;
+} R;
+
+static void null_sync_framebuffer(Framebuffer *fb) {
+	if(R.applied.framebuffer != fb) {
+		R.applied.framebuffer = fb;
+		R.stats.framebuffer_switches++;
+	}
+}
+
+#define SYNC_STATE(field) do { \
+	if(memcmp(&R.applied.field, &R.field, sizeof(R.field))) { \
+		R.applied.field = R.field; \
+		R.stats.state_changes++; \
+	} \
+} while(0)
+
+static void null_sync_draw_state(void) {
+	null_sync_framebuffer(R.framebuffer);
+
+	if(R.applied.shader != R.shader) {
+		R.applied.shader = R.shader;
+		R.stats.shader_switches++;
+	}
+
+	SYNC_STATE(blend);
+	SYNC_STATE(cull);
+	SYNC_STATE(depth_func);
+	SYNC_STATE(capabilities);
+	SYNC_STATE(scissor);
+}
+
+#undef SYNC_STATE
 
 static SDL_Window* null_create_window(const char *title, int x, int y, int w, int h, uint32_t flags) {
-	return SDL_CreateWindow(title, w, h, flags);
+	R.window = SDL_CreateWindow(title, w, h, flags);
+
+	if(R.window) {
+		int pw, ph;
+		SDL_GetWindowSizeInPixels(R.window, &pw, &ph);
+		R.default_fb_viewport = (FloatRect) { 0, 0, pw, ph };
+	}
+
+	return R.window;
+}
+
+static bool null_init(RendererBackend *backend, char *opts) {
+	R.default_fb_viewport = (FloatRect) { 0, 0, 800, 600 };
+
+	const char *record_path = env_get("TAISEI_NULL_RECORD", "");
+
+	if(*record_path) {
+		null_record_begin(record_path);
+	}
+
+	return true;
 }
 
-static bool null_init(RendererBackend *backend, char *opts) { return true; }
 static void null_post_init(void) { }
-static void null_shutdown(void) { }
+
+static void null_shutdown(void) {
+	null_record_end();
+}
 
 static r_feature_bits_t null_features(void) { return ~0; }
 
-static void null_capabilities(r_capability_bits_t capbits) { }
-static r_capability_bits_t null_capabilities_current(void) { return (r_capability_bits_t)-1; }
+static void null_capabilities(r_capability_bits_t capbits) { R.capabilities = capbits; }
+static r_capability_bits_t null_capabilities_current(void) { return R.capabilities; }
+
+static void null_color4(float r, float g, float b, float a) { R.color = (Color) { r, g, b, a }; }
+static const Color* null_color_current(void) { return &R.color; }
 
-static void null_color4(float r, float g, float b, float a) { }
-static const Color* null_color_current(void) { return &dummycolor; }
+static void null_blend(BlendMode mode) { R.blend = mode; }
+static BlendMode null_blend_current(void) { return R.blend; }
 
-static void null_blend(BlendMode mode) { }
-static BlendMode null_blend_current(void) { return BLEND_NONE; }
+static void null_cull(CullFaceMode mode) { R.cull = mode; }
+static CullFaceMode null_cull_current(void) { return R.cull; }
 
-static void null_cull(CullFaceMode mode) { }
-static CullFaceMode null_cull_current(void) { return CULL_BACK; }
+static void null_depth_func(DepthTestFunc func) { R.depth_func = func; }
+static DepthTestFunc null_depth_func_current(void) { return R.depth_func; }
 
-static void null_depth_func(DepthTestFunc func) { }
-static DepthTestFunc null_depth_func_current(void) { return DEPTH_LESS; }
+/*
+ * Shaders
+ */
+
+struct ShaderObject {
+	ht_str2int_t uniforms;  // name -> UniformType
+	char debug_label[R_DEBUG_LABEL_SIZE];
+};
+
+struct ShaderProgram {
+	ht_str2ptr_t uniforms;  // name -> Uniform
+	char debug_label[R_DEBUG_LABEL_SIZE];
+};
+
+struct Uniform {
+	ShaderProgram *prog;
+	UniformType type;
+};
 
 static bool null_shader_language_supported(const ShaderLangInfo *lang, SPIRVTranspileOptions *transpile_opts) { return true; }
 
-static ShaderObject* null_shader_object_compile(ShaderSource *source) { return (void*)&placeholder; }
-static void null_shader_object_destroy(ShaderObject *shobj) { }
-static void null_shader_object_set_debug_label(ShaderObject *shobj, const char *label) { }
-static const char* null_shader_object_get_debug_label(ShaderObject *shobj) { return "Null shader object"; }
-static bool null_shader_object_transfer(ShaderObject *dst, ShaderObject *src) { return true; }
+static UniformType null_glsl_uniform_type(const char *name, size_t len) {
+	static const struct {
+		const char *name;
+		UniformType type;
+	} types[] = {
+		{ "float",       UNIFORM_FLOAT },
+		{ "vec2",        UNIFORM_VEC2 },
+		{ "vec3",        UNIFORM_VEC3 },
+		{ "vec4",        UNIFORM_VEC4 },
+		{ "int",         UNIFORM_INT },
+		{ "ivec2",       UNIFORM_IVEC2 },
+		{ "ivec3",       UNIFORM_IVEC3 },
+		{ "ivec4",       UNIFORM_IVEC4 },
+		{ "sampler2D",   UNIFORM_SAMPLER_2D },
+		{ "samplerCube", UNIFORM_SAMPLER_CUBE },
+		{ "mat3",        UNIFORM_MAT3 },
+		{ "mat4",        UNIFORM_MAT4 },
+	};
+
+	for(uint i = 0; i < ARRAY_SIZE(types); ++i) {
+		if(strlen(types[i].name) == len && !memcmp(types[i].name, name, len)) {
+			return types[i].type;
+		}
+	}
+
+	return UNIFORM_UNKNOWN;
+}
+
+static const char *glsl_skip_space(const char *p, const char *end) {
+	while(p < end && isspace((unsigned char)*p)) {
+		++p;
+	}
+
+	return p;
+}
+
+static const char *glsl_skip_ident(const char *p, const char *end) {
+	while(p < end && (isalnum((unsigned char)*p) || *p == '_')) {
+		++p;
+	}
+
+	return p;
+}
+
+static bool glsl_is_precision_qualifier(const char *tok, size_t len) {
+	return
+		(len == 4 && !memcmp(tok, "lowp", len)) ||
+		(len == 7 && !memcmp(tok, "mediump", len)) ||
+		(len == 5 && !memcmp(tok, "highp", len));
+}
+
+static void null_shader_object_scan_line(ShaderObject *shobj, const char *p, const char *end) {
+	p = glsl_skip_space(p, end);
+	const char *tok_end = glsl_skip_ident(p, end);
+	size_t len = tok_end - p;
+
+	if(len == 7 && !memcmp(p, "UNIFORM", len)) {
+		// UNIFORM(location)
+		if(!(p = memchr(tok_end, ')', end - tok_end))) {
+			return;
+		}
+
+		++p;
+	} else if(len == 7 && !memcmp(p, "uniform", len)) {
+		p = tok_end;
+	} else {
+		return;
+	}
+
+	const char *type;
+	size_t type_len;
+
+	do {
+		type = glsl_skip_space(p, end);
+		p = glsl_skip_ident(type, end);
+		type_len = p - type;
+	} while(type_len && glsl_is_precision_qualifier(type, type_len));
+
+	UniformType utype = null_glsl_uniform_type(type, type_len);
+
+	if(utype == UNIFORM_UNKNOWN) {
+		// Also skips uniform blocks
+		return;
+	}
+
+	for(;;) {
+		const char *name = glsl_skip_space(p, end);
+		p = glsl_skip_ident(name, end);
+
+		if(p == name) {
+			return;
+		}
+
+		char buf[128];
+		size_t name_len = p - name;
+
+		if(name_len < sizeof(buf)) {
+			memcpy(buf, name, name_len);
+			buf[name_len] = 0;
+			ht_set(&shobj->uniforms, buf, utype);
+		}
+
+		// Skip the array size, if any, and move on to the next declarator
+		while(p < end && *p != ',' && *p != ';') {
+			++p;
+		}
+
+		if(p == end || *p == ';') {
+			return;
+		}
+
+		++p;
+	}
+}
+
+/*
+ * The real backends get uniform types from the shader compiler. There isn't one here, so scan the GLSL source for
+ * declarations instead. This only handles one declaration per line, optionally through the UNIFORM() macro, which
+ * is how our shaders are written. Writes to uniforms that aren't found are dropped by the API and not counted.
+ */
+static void null_shader_object_scan_uniforms(ShaderObject *shobj, const ShaderSource *source) {
+	if(source->lang.lang != SHLANG_GLSL || !source->content) {
+		return;
+	}
+
+	const char *p = source->content;
+	const char *end = p + source->content_size;
 
-static ShaderProgram* null_shader_program_link(uint num_objects, ShaderObject *shobjs[num_objects]) { return (void*)&placeholder; }
-static void null_shader_program_destroy(ShaderProgram *prog) { }
-static void null_shader_program_set_debug_label(ShaderProgram *prog, const char *label) { }
-static const char* null_shader_program_get_debug_label(ShaderProgram *prog) { return "Null shader program"; }
-static bool null_shader_program_transfer(ShaderProgram *dst, ShaderProgram *src) { return true; }
+	while(p < end) {
+		const char *eol = memchr(p, '\n', end - p) ?: end;
+		null_shader_object_scan_line(shobj, p, eol);
+		p = eol + 1;
+	}
+}
 
-static void null_shader(ShaderProgram *prog) { }
-static ShaderProgram* null_shader_current(void) { return (void*)&placeholder; }
+static ShaderObject* null_shader_object_compile(ShaderSource *source) {
+	auto shobj = ALLOC(ShaderObject);
+	ht_create(&shobj->uniforms);
+	strlcpy(shobj->debug_label, "null shader object", sizeof(shobj->debug_label));
+	null_shader_object_scan_uniforms(shobj, source);
+	return shobj;
+}
+
+static void null_shader_object_destroy(ShaderObject *shobj) {
+	ht_destroy(&shobj->uniforms);
+	mem_free(shobj);
+}
+
+static void null_shader_object_set_debug_label(ShaderObject *shobj, const char *label) {
+	strlcpy(shobj->debug_label, label, sizeof(shobj->debug_label));
+}
+
+static const char* null_shader_object_get_debug_label(ShaderObject *shobj) {
+	return shobj->debug_label;
+}
+
+static bool null_shader_object_transfer(ShaderObject *dst, ShaderObject *src) {
+	ht_destroy(&dst->uniforms);
+	*dst = *src;
+	mem_free(src);
+	return true;
+}
+
+static ShaderProgram* null_shader_program_link(uint num_objects, ShaderObject *shobjs[num_objects]) {
+	auto prog = ALLOC(ShaderProgram);
+	ht_create(&prog->uniforms);
+	strlcpy(prog->debug_label, "null shader program", sizeof(prog->debug_label));
+
+	for(uint i = 0; i < num_objects; ++i) {
+		ht_str2int_iter_t iter;
+		ht_iter_begin(&shobjs[i]->uniforms, &iter);
+
+		for(; iter.has_data; ht_iter_next(&iter)) {
+			if(!ht_get(&prog->uniforms, iter.key, NULL)) {
+				auto uni = ALLOC(Uniform, {
+					.prog = prog,
+					.type = iter.value,
+				});
+
+				ht_set(&prog->uniforms, iter.key, uni);
+			}
+		}
+
+		ht_iter_end(&iter);
+	}
+
+	return prog;
+}
+
+static void null_shader_program_free_uniforms(ShaderProgram *prog) {
+	ht_str2ptr_iter_t iter;
+	ht_iter_begin(&prog->uniforms, &iter);
+
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		mem_free(iter.value);
+	}
+
+	ht_iter_end(&iter);
+	ht_destroy(&prog->uniforms);
+}
+
+static void null_shader_program_destroy(ShaderProgram *prog) {
+	if(R.applied.shader == prog) {
+		// Make sure the next draw counts as a switch, even if a new program gets the same address
+		R.applied.shader = (void*)&placeholder;
+	}
+
+	null_shader_program_free_uniforms(prog);
+	mem_free(prog);
+}
+
+static void null_shader_program_set_debug_label(ShaderProgram *prog, const char *label) {
+	strlcpy(prog->debug_label, label, sizeof(prog->debug_label));
+}
+
+static const char* null_shader_program_get_debug_label(ShaderProgram *prog) {
+	return prog->debug_label;
+}
+
+static bool null_shader_program_transfer(ShaderProgram *dst, ShaderProgram *src) {
+	// Uniform pointers may be cached by users, so existing ones must stay valid.
+	ht_str2ptr_iter_t iter;
+	ht_iter_begin(&src->uniforms, &iter);
+
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		Uniform *unew = iter.value;
+		Uniform *uold = ht_get(&dst->uniforms, iter.key, NULL);
+
+		if(uold) {
+			uold->type = unew->type;
+			mem_free(unew);
+		} else {
+			unew->prog = dst;
+			ht_set(&dst->uniforms, iter.key, unew);
+		}
+	}
+
+	ht_iter_end(&iter);
+	ht_destroy(&src->uniforms);
+	mem_free(src);
+	return true;
+}
+
+static void null_shader(ShaderProgram *prog) { R.shader = prog; }
+static ShaderProgram* null_shader_current(void) { return R.shader; }
 
 static Uniform* null_shader_uniform(ShaderProgram *prog, const char *uniform_name, hash_t uniform_name_hash) {
-	return NULL;
+	if(!prog) {
+		return NULL;
+	}
+
+	return ht_get(&prog->uniforms, uniform_name, NULL);
 }
 
-static void null_uniform(Uniform *uniform, uint offset, uint count, const void *data) { }
+static void null_uniform(Uniform *uniform, uint offset, uint count, const void *data) {
+	const UniformTypeInfo *tinfo = r_uniform_type_info(uniform->type);
+	R.stats.uniform_writes++;
+	R.stats.uniform_write_bytes += (uint64_t)count * tinfo->elements * tinfo->element_size;
+}
 
-static UniformType null_uniform_type(Uniform *uniform) { return UNIFORM_FLOAT; }
+static UniformType null_uniform_type(Uniform *uniform) { return uniform->type; }
 
-static void null_draw(VertexArray *varr, Primitive prim, uint first, uint count, uint instances, uint base_instance) { }
+/*
+ * Textures
+ */
+
+struct Texture {
+	TextureParams params;
+	char debug_label[R_DEBUG_LABEL_SIZE];
+};
 
 static Texture* null_texture_create(const TextureParams *params) {
-	return (void*)&placeholder;
+	auto tex = ALLOC(Texture, { .params = *params });
+	auto p = &tex->params;
+	uint max_mipmaps = r_texture_util_max_num_miplevels(p->width, p->height);
+
+	if(p->mipmaps == 0) {
+		p->mipmaps = p->mipmap_mode == TEX_MIPMAP_AUTO ? max_mipmaps : 1;
+	} else if(p->mipmaps > max_mipmaps) {
+		p->mipmaps = max_mipmaps;
+	}
+
+	strlcpy(tex->debug_label, "null texture", sizeof(tex->debug_label));
+	return tex;
 }
 
 static void null_texture_get_size(Texture *tex, uint mipmap, uint *width, uint *height) {
-	if(width) *width = 1;
-	if(height) *height = 1;
+	if(mipmap >= tex->params.mipmaps) {
+		mipmap = tex->params.mipmaps - 1;
+	}
+
+	if(width) *width = max(1u, tex->params.width >> mipmap);
+	if(height) *height = max(1u, tex->params.height >> mipmap);
 }
 
 static void null_texture_get_params(Texture *tex, TextureParams *params) {
-	*params = (typeof(*params)) {
-		.width = 1,
-		.height = 1,
-		.type = TEX_TYPE_RGBA,
-	};
+	*params = tex->params;
+}
+
+static void null_texture_set_debug_label(Texture *tex, const char *label) {
+	strlcpy(tex->debug_label, label, sizeof(tex->debug_label));
+}
+
+static const char* null_texture_get_debug_label(Texture *tex) {
+	return tex->debug_label;
+}
+
+static void null_texture_set_filter(Texture *tex, TextureFilterMode fmin, TextureFilterMode fmag) {
+	tex->params.filter.min = fmin;
+	tex->params.filter.mag = fmag;
+}
+
+static void null_texture_set_wrap(Texture *tex, TextureWrapMode ws, TextureWrapMode wt) {
+	tex->params.wrap.s = ws;
+	tex->params.wrap.t = wt;
+}
+
+static void null_texture_fill(Texture *tex, uint mipmap, uint layer, const Pixmap *image_data) {
+	R.stats.texture_fills++;
+	R.stats.texture_fill_bytes += image_data->data_size;
+}
+
+static void null_texture_fill_region(Texture *tex, uint mipmap, uint layer, uint x, uint y, const Pixmap *image_data) {
+	R.stats.texture_fills++;
+	R.stats.texture_fill_bytes += image_data->data_size;
 }
 
-static void null_texture_set_debug_label(Texture *tex, const char *label) { }
-static const char* null_texture_get_debug_label(Texture *tex) { return "null texture"; }
-static void null_texture_set_filter(Texture *tex, TextureFilterMode fmin, TextureFilterMode fmag) { }
-static void null_texture_set_wrap(Texture *tex, TextureWrapMode fmin, TextureWrapMode fmag) { }
-static void null_texture_fill(Texture *tex, uint mipmap, uint layer, const Pixmap *image_data) { }
-static void null_texture_fill_region(Texture *tex, uint mipmap, uint layer, uint x, uint y, const Pixmap *image_data) { }
 static bool null_texture_dump(Texture *tex, uint mipmap, uint layer, Pixmap *dst) { return false; }
 static void null_texture_invalidate(Texture *tex) { }
-static void null_texture_destroy(Texture *tex) { }
-static void null_texture_clear(Texture *tex, const Color *color) { }
+static void null_texture_destroy(Texture *tex) { mem_free(tex); }
+static void null_texture_clear(Texture *tex, const Color *color) { R.stats.clears++; }
+
 static bool null_texture_type_query(TextureType type, TextureFlags flags, PixmapFormat pxfmt, TextureTypeQueryResult *result) {
 	if(result) {
 		result->optimal_pixmap_format = pxfmt;
@@ -99,93 +490,342 @@ static bool null_texture_type_query(TextureType type, TextureFlags flags, Pixmap
 
 	return true;
 }
-static bool null_texture_transfer(Texture *dst, Texture *src) { return true; }
 
-static FloatRect default_fb_viewport = { 0, 0, 800, 600 };
+static bool null_texture_transfer(Texture *dst, Texture *src) {
+	*dst = *src;
+	mem_free(src);
+	return true;
+}
+
+/*
+ * Framebuffers
+ */
 
-static Framebuffer* null_framebuffer_create(void) { return (void*)&placeholder; }
-static void null_framebuffer_set_debug_label(Framebuffer *fb, const char *label) { }
-static const char* null_framebuffer_get_debug_label(Framebuffer *fb) { return "null framebuffer"; }
-static void null_framebuffer_attach(Framebuffer *framebuffer, Texture *tex, uint mipmap, FramebufferAttachment attachment) { }
-static FramebufferAttachmentQueryResult null_framebuffer_query_attachment(Framebuffer *fb, FramebufferAttachment attachment) {
-	return (FramebufferAttachmentQueryResult) {
-		.texture = (void*)&placeholder,
-		.miplevel = 0,
+struct Framebuffer {
+	FramebufferAttachmentQueryResult attachments[FRAMEBUFFER_MAX_ATTACHMENTS];
+	FramebufferAttachment output_mapping[FRAMEBUFFER_MAX_OUTPUTS];
+	FloatRect viewport;
+	char debug_label[R_DEBUG_LABEL_SIZE];
+};
+
+static Framebuffer* null_framebuffer_create(void) {
+	auto fb = ALLOC(Framebuffer);
+	strlcpy(fb->debug_label, "null framebuffer", sizeof(fb->debug_label));
+
+	for(int i = 0; i < FRAMEBUFFER_MAX_OUTPUTS; ++i) {
+		fb->output_mapping[i] = FRAMEBUFFER_ATTACH_COLOR0 + i;
+	}
+
+	return fb;
+}
+
+static void null_framebuffer_set_debug_label(Framebuffer *fb, const char *label) {
+	strlcpy(fb->debug_label, label, sizeof(fb->debug_label));
+}
+
+static const char* null_framebuffer_get_debug_label(Framebuffer *fb) {
+	return fb->debug_label;
+}
+
+static void null_framebuffer_attach(Framebuffer *fb, Texture *tex, uint mipmap, FramebufferAttachment attachment) {
+	assert(attachment >= 0 && attachment < FRAMEBUFFER_MAX_ATTACHMENTS);
+	fb->attachments[attachment] = (FramebufferAttachmentQueryResult) {
+		.texture = tex,
+		.miplevel = mipmap,
 	};
 }
+
+static FramebufferAttachmentQueryResult null_framebuffer_query_attachment(Framebuffer *fb, FramebufferAttachment attachment) {
+	assert(attachment >= 0 && attachment < FRAMEBUFFER_MAX_ATTACHMENTS);
+	return fb->attachments[attachment];
+}
+
 static void null_framebuffer_outputs(Framebuffer *fb, FramebufferAttachment config[FRAMEBUFFER_MAX_OUTPUTS], uint8_t write_mask) {
-	if(write_mask == 0x00) {
-		for(int i = 0; i < FRAMEBUFFER_MAX_OUTPUTS; ++i) {
-			config[i] = FRAMEBUFFER_ATTACH_COLOR0 + i;
+	for(int i = 0; i < FRAMEBUFFER_MAX_OUTPUTS; ++i) {
+		if(write_mask & (1 << i)) {
+			fb->output_mapping[i] = config[i];
+		} else if(write_mask == 0x00) {
+			config[i] = fb->output_mapping[i];
 		}
 	}
 }
-static void null_framebuffer_destroy(Framebuffer *framebuffer) { }
-static void null_framebuffer_viewport(Framebuffer *framebuffer, FloatRect vp) { }
-static void null_framebuffer_viewport_current(Framebuffer *framebuffer, FloatRect *vp) { *vp = default_fb_viewport; }
-static void null_framebuffer(Framebuffer *framebuffer) { }
-static Framebuffer* null_framebuffer_current(void) { return (void*)&placeholder; }
-static void null_framebuffer_clear(Framebuffer *framebuffer, BufferKindFlags flags, const Color *colorval, float depthval) { }
+
+static void null_framebuffer_destroy(Framebuffer *fb) {
+	if(R.applied.framebuffer == fb) {
+		// Make sure the next draw counts as a switch, even if a new framebuffer gets the same address
+		R.applied.framebuffer = (void*)&placeholder;
+	}
+
+	mem_free(fb);
+}
+
+static void null_framebuffer_viewport(Framebuffer *fb, FloatRect vp) {
+	*(fb ? &fb->viewport : &R.default_fb_viewport) = vp;
+}
+
+static void null_framebuffer_viewport_current(Framebuffer *fb, FloatRect *vp) {
+	*vp = fb ? fb->viewport : R.default_fb_viewport;
+}
+
+static void null_framebuffer(Framebuffer *fb) { R.framebuffer = fb; }
+static Framebuffer* null_framebuffer_current(void) { return R.framebuffer; }
+
+static void null_framebuffer_clear(Framebuffer *fb, BufferKindFlags flags, const Color *colorval, float depthval) {
+	null_sync_framebuffer(fb);
+	R.stats.clears++;
+}
+
 static void null_framebuffer_copy(Framebuffer *dst, Framebuffer *src, BufferKindFlags flags) { }
-static IntExtent null_framebuffer_get_size(Framebuffer *framebuffer) { return (IntExtent) { 64, 64 }; }
+
+static IntExtent null_framebuffer_get_size(Framebuffer *fb) {
+	if(!fb) {
+		IntExtent size = { 64, 64 };
+
+		if(R.window) {
+			SDL_GetWindowSizeInPixels(R.window, &size.w, &size.h);
+		}
+
+		return size;
+	}
+
+	IntExtent fb_size = {};
+
+	for(uint i = 0; i < FRAMEBUFFER_MAX_ATTACHMENTS; ++i) {
+		auto a = &fb->attachments[i];
+
+		if(a->texture) {
+			uint w, h;
+			null_texture_get_size(a->texture, a->miplevel, &w, &h);
+
+			if(fb_size.w == 0 && fb_size.h == 0) {
+				fb_size = (IntExtent) { w, h };
+			} else {
+				fb_size.w = min(fb_size.w, (int)w);
+				fb_size.h = min(fb_size.h, (int)h);
+			}
+		}
+	}
+
+	return fb_size;
+}
 
 static void null_framebuffer_read_async(Framebuffer *framebuffer, FramebufferAttachment attachment, IntRect region, void *userdata, FramebufferReadAsyncCallback callback) {
 	callback(NULL, userdata);
 }
 
-static int64_t null_vertex_buffer_stream_seek(void *ctx, int64_t offset, SDL_IOWhence whence) { return 0; }
-static int64_t null_vertex_buffer_stream_size(void *ctx) { return (1 << 16); }
-static size_t null_vertex_buffer_stream_write(void *ctx, const void *data, size_t size, SDL_IOStatus *status) { return size; }
+/*
+ * Buffers keep a CPU-side cache like the real backends do. Dirty data is "uploaded" when a draw call uses the buffer.
+ */
+
+struct VertexBuffer {
+	CachedBuffer cachedbuf;
+	char debug_label[R_DEBUG_LABEL_SIZE];
+};
+
+struct IndexBuffer {
+	CachedBuffer cachedbuf;
+	uint index_size;
+	char debug_label[R_DEBUG_LABEL_SIZE];
+};
+
+static void null_buffer_flush(CachedBuffer *cbuf) {
+	CachedBufferUpdate updates[CACHEDBUF_MAX_UPDATES];
+	uint64_t uploaded = cbuf->stats.bytes_uploaded;
+	cachedbuf_flush(cbuf, false, updates);
+	R.stats.buffer_upload_bytes += cbuf->stats.bytes_uploaded - uploaded;
+}
+
+static void null_buffer_init(CachedBuffer *cbuf, size_t capacity, void *data) {
+	cachedbuf_init(cbuf);
+	cachedbuf_resize(cbuf, capacity);
+
+	if(data) {
+		memcpy(cbuf->cache, data, capacity);
+		cbuf->valid_end = capacity;
+		R.stats.buffer_upload_bytes += capacity;
+	}
+}
+
+static void null_buffer_log_stats(CachedBuffer *cbuf, const char *label) {
+	auto stats = &cbuf->stats;
+	log_debug("%s: uploaded %"PRIu64" bytes in %"PRIu64" ranges, %"PRIu64" flushes",
+		label, stats->bytes_uploaded, stats->num_uploads, stats->num_flushes);
+}
 
 static SDL_IOStream* null_vertex_buffer_get_stream(VertexBuffer *vbuf) {
-	static SDL_IOStream *dummy;
+	return vbuf->cachedbuf.stream;
+}
 
-	if(dummy) {
-		return dummy;
+static VertexBuffer* null_vertex_buffer_create(size_t capacity, void *data) {
+	auto vbuf = ALLOC(VertexBuffer);
+	strlcpy(vbuf->debug_label, "null vertex buffer", sizeof(vbuf->debug_label));
+	null_buffer_init(&vbuf->cachedbuf, capacity, data);
+	return vbuf;
+}
+
+static void null_vertex_buffer_set_debug_label(VertexBuffer *vbuf, const char *label) {
+	strlcpy(vbuf->debug_label, label, sizeof(vbuf->debug_label));
+}
+
+static const char* null_vertex_buffer_get_debug_label(VertexBuffer *vbuf) {
+	return vbuf->debug_label;
+}
+
+static void null_vertex_buffer_destroy(VertexBuffer *vbuf) {
+	null_buffer_log_stats(&vbuf->cachedbuf, vbuf->debug_label);
+	cachedbuf_deinit(&vbuf->cachedbuf);
+	mem_free(vbuf);
+}
+
+static void null_vertex_buffer_invalidate(VertexBuffer *vbuf) {
+	cachedbuf_invalidate(&vbuf->cachedbuf);
+}
+
+static IndexBuffer* null_index_buffer_create(uint index_size, size_t max_elements) {
+	auto ibuf = ALLOC(IndexBuffer, { .index_size = index_size });
+	strlcpy(ibuf->debug_label, "null index buffer", sizeof(ibuf->debug_label));
+	null_buffer_init(&ibuf->cachedbuf, max_elements * index_size, NULL);
+	return ibuf;
+}
+
+static size_t null_index_buffer_get_capacity(IndexBuffer *ibuf) {
+	return ibuf->cachedbuf.size / ibuf->index_size;
+}
+
+static uint null_index_buffer_get_index_size(IndexBuffer *ibuf) {
+	return ibuf->index_size;
+}
+
+static const char* null_index_buffer_get_debug_label(IndexBuffer *ibuf) {
+	return ibuf->debug_label;
+}
+
+static void null_index_buffer_set_debug_label(IndexBuffer *ibuf, const char *label) {
+	strlcpy(ibuf->debug_label, label, sizeof(ibuf->debug_label));
+}
+
+static void null_index_buffer_set_offset(IndexBuffer *ibuf, size_t offset) {
+	ibuf->cachedbuf.stream_offset = offset * ibuf->index_size;
+}
+
+static size_t null_index_buffer_get_offset(IndexBuffer *ibuf) {
+	return ibuf->cachedbuf.stream_offset / ibuf->index_size;
+}
+
+static void null_index_buffer_add_indices(IndexBuffer *ibuf, size_t data_size, void *data) {
+	SDL_WriteIO(ibuf->cachedbuf.stream, data, data_size);
+}
+
+static void null_index_buffer_destroy(IndexBuffer *ibuf) {
+	null_buffer_log_stats(&ibuf->cachedbuf, ibuf->debug_label);
+	cachedbuf_deinit(&ibuf->cachedbuf);
+	mem_free(ibuf);
+}
+
+static void null_index_buffer_invalidate(IndexBuffer *ibuf) {
+	cachedbuf_invalidate(&ibuf->cachedbuf);
+}
+
+/*
+ * Vertex arrays
+ */
+
+struct VertexArray {
+	VertexBuffer **attachments;
+	IndexBuffer *index_attachment;
+	uint num_attachments;
+	char debug_label[R_DEBUG_LABEL_SIZE];
+};
+
+static VertexArray* null_vertex_array_create(void) {
+	auto varr = ALLOC(VertexArray);
+	strlcpy(varr->debug_label, "null vertex array", sizeof(varr->debug_label));
+	return varr;
+}
+
+static void null_vertex_array_set_debug_label(VertexArray *varr, const char *label) {
+	strlcpy(varr->debug_label, label, sizeof(varr->debug_label));
+}
+
+static const char* null_vertex_array_get_debug_label(VertexArray *varr) {
+	return varr->debug_label;
+}
+
+static void null_vertex_array_destroy(VertexArray *varr) {
+	mem_free(varr->attachments);
+	mem_free(varr);
+}
+
+static void null_vertex_array_attach_vertex_buffer(VertexArray *varr, VertexBuffer *vbuf, uint attachment) {
+	if(attachment >= varr->num_attachments) {
+		varr->attachments = mem_realloc(varr->attachments, (attachment + 1) * sizeof(*varr->attachments));
+		memset(varr->attachments + varr->num_attachments, 0,
+			(attachment + 1 - varr->num_attachments) * sizeof(*varr->attachments));
+		varr->num_attachments = attachment + 1;
 	}
 
-	return (dummy = SDL_OpenIO(&(SDL_IOStreamInterface) {
-		.version = sizeof(SDL_IOStreamInterface),
-		.seek = null_vertex_buffer_stream_seek,
-		.size = null_vertex_buffer_stream_size,
-		.write = null_vertex_buffer_stream_write,
-	}, NULL));
-}
-
-static VertexBuffer* null_vertex_buffer_create(size_t capacity, void *data) { return (void*)&placeholder; }
-static void null_vertex_buffer_set_debug_label(VertexBuffer *vbuf, const char *label) { }
-static const char* null_vertex_buffer_get_debug_label(VertexBuffer *vbuf) { return "null vertex buffer"; }
-static void null_vertex_buffer_destroy(VertexBuffer *vbuf) { }
-static void null_vertex_buffer_invalidate(VertexBuffer *vbuf) { }
-
-static IndexBuffer* null_index_buffer_create(uint index_size, size_t max_elements) { return (void*)&placeholder; }
-static size_t null_index_buffer_get_capacity(IndexBuffer *ibuf) { return UINT32_MAX; }
-static uint null_index_buffer_get_index_size(IndexBuffer *ibuf) { return sizeof(uint32_t); }
-static const char* null_index_buffer_get_debug_label(IndexBuffer *ibuf) { return "null index buffer"; }
-static void null_index_buffer_set_debug_label(IndexBuffer *ibuf, const char *label) { }
-static void null_index_buffer_set_offset(IndexBuffer *ibuf, size_t offset) { }
-static size_t null_index_buffer_get_offset(IndexBuffer *ibuf) { return 0; }
-static void null_index_buffer_add_indices(IndexBuffer *ibuf, size_t data_size, void *data) { }
-static void null_index_buffer_destroy(IndexBuffer *ibuf) { }
-static void null_index_buffer_invalidate(IndexBuffer *ibuf) { }
-
-static VertexArray* null_vertex_array_create(void) { return (void*)&placeholder; }
-static void null_vertex_array_set_debug_label(VertexArray *varr, const char *label) { }
-static const char* null_vertex_array_get_debug_label(VertexArray *varr) { return "null vertex array"; }
-static void null_vertex_array_destroy(VertexArray *varr) { }
-static void null_vertex_array_attach_vertex_buffer(VertexArray *varr, VertexBuffer *vbuf, uint attachment) { }
-static void null_vertex_array_attach_index_buffer(VertexArray *varr, IndexBuffer *vbuf) { }
-static VertexBuffer* null_vertex_array_get_vertex_attachment(VertexArray *varr, uint attachment) { return (void*)&placeholder; }
-static IndexBuffer* null_vertex_array_get_index_attachment(VertexArray *varr) { return (void*)&placeholder; }
+	varr->attachments[attachment] = vbuf;
+}
+
+static void null_vertex_array_attach_index_buffer(VertexArray *varr, IndexBuffer *ibuf) {
+	varr->index_attachment = ibuf;
+}
+
+static VertexBuffer* null_vertex_array_get_vertex_attachment(VertexArray *varr, uint attachment) {
+	if(attachment >= varr->num_attachments) {
+		return NULL;
+	}
+
+	return varr->attachments[attachment];
+}
+
+static IndexBuffer* null_vertex_array_get_index_attachment(VertexArray *varr) {
+	return varr->index_attachment;
+}
+
 static void null_vertex_array_layout(VertexArray *varr, uint nattribs, VertexAttribFormat attribs[nattribs]) { }
 
-static void null_scissor(IntRect scissor) { }
-static void null_scissor_current(IntRect *scissor) { *scissor = (IntRect) {}; }
+/*
+ * Drawing
+ */
 
-static void null_vsync(VsyncMode mode) { }
-static VsyncMode null_vsync_current(void) { return VSYNC_NONE; }
+static void null_draw_common(VertexArray *varr, uint count, uint instances) {
+	null_sync_draw_state();
 
-static void null_swap(SDL_Window *window) { }
+	for(uint i = 0; i < varr->num_attachments; ++i) {
+		if(varr->attachments[i]) {
+			null_buffer_flush(&varr->attachments[i]->cachedbuf);
+		}
+	}
+
+	instances = max(instances, 1u);
+	R.stats.draws++;
+	R.stats.instances += instances;
+	R.stats.vertices += (uint64_t)count * instances;
+}
+
+static void null_draw(VertexArray *varr, Primitive prim, uint first, uint count, uint instances, uint base_instance) {
+	null_draw_common(varr, count, instances);
+}
+
+static void null_draw_indexed(VertexArray *varr, Primitive prim, uint first, uint count, uint instances, uint base_instance) {
+	if(varr->index_attachment) {
+		null_buffer_flush(&varr->index_attachment->cachedbuf);
+	}
+
+	null_draw_common(varr, count, instances);
+}
+
+static void null_scissor(IntRect scissor) { R.scissor = scissor; }
+static void null_scissor_current(IntRect *scissor) { *scissor = R.scissor; }
+
+static void null_vsync(VsyncMode mode) { R.vsync = mode; }
+static VsyncMode null_vsync_current(void) { return R.vsync; }
+
+static void null_swap(SDL_Window *window) {
+	null_record_frame(&R.stats);
+	R.stats = (NullFrameStats) {};
+}
 
 RendererBackend _r_backend_null = {
 	.name = "null",
@@ -198,7 +838,7 @@ RendererBackend _r_backend_null = {
 		.capabilities = null_capabilities,
 		.capabilities_current = null_capabilities_current,
 		.draw = null_draw,
-		.draw_indexed = null_draw,
+		.draw_indexed = null_draw_indexed,
 		.color4 = null_color4,
 		.color_current = null_color_current,
 		.blend = null_blend,
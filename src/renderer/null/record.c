@@ -0,0 +1,66 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "record.h"
+
+#include "log.h"
+#include "memory/scratch.h"
+#include "util/strbuf.h"
+
+static struct {
+	SDL_IOStream *out;
+	uint64_t frames;
+} rec;
+
+bool null_record_begin(const char *path) {
+	assert(rec.out == NULL);
+
+	if(!(rec.out = SDL_IOFromFile(path, "w"))) {
+		log_sdl_error(LOG_ERROR, "SDL_IOFromFile");
+		return false;
+	}
+
+	rec.frames = 0;
+	log_info("Recording renderer statistics to %s", path);
+	return true;
+}
+
+void null_record_frame(const NullFrameStats *stats) {
+	if(!rec.out) {
+		return;
+	}
+
+	MemArena *scratch = acquire_scratch_arena();
+	StringBuffer buf = { scratch };
+
+	strbuf_printf(&buf, "{\"frame\": %"PRIu64, rec.frames++);
+
+	#define NULL_FRAME_STATS_WRITE(name) \
+		strbuf_printf(&buf, ", \"" #name "\": %"PRIu64, stats->name);
+	NULL_FRAME_STATS(NULL_FRAME_STATS_WRITE)
+	#undef NULL_FRAME_STATS_WRITE
+
+	strbuf_cat(&buf, "}\n");
+
+	if(SDL_WriteIO(rec.out, buf.start, buf.pos - buf.start) != buf.pos - buf.start) {
+		log_sdl_error(LOG_ERROR, "SDL_WriteIO");
+		null_record_end();
+	}
+
+	release_scratch_arena(scratch);
+}
+
+void null_record_end(void) {
+	if(!rec.out) {
+		return;
+	}
+
+	SDL_CloseIO(rec.out);
+	rec.out = NULL;
+	log_info("Recorded renderer statistics for %"PRIu64" frames", rec.frames);
+}
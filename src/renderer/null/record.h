@@ -0,0 +1,42 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+/*
+ * Per-frame statistics collected by the null renderer. When TAISEI_NULL_RECORD is set, they are
+ * written to that file as JSON Lines, one object per swapped frame.
+ *
+ * Switches and state changes are counted when the state is actually used by a draw or clear,
+ * the same way the real backends defer applying it.
+ */
+
+#define NULL_FRAME_STATS(X) \
+	X(draws) \
+	X(instances) \
+	X(vertices) \
+	X(buffer_upload_bytes) \
+	X(texture_fills) \
+	X(texture_fill_bytes) \
+	X(clears) \
+	X(framebuffer_switches) \
+	X(shader_switches) \
+	X(state_changes) \
+	X(uniform_writes) \
+	X(uniform_write_bytes) \
+
+typedef struct NullFrameStats {
+	#define NULL_FRAME_STATS_DECLARE(name) uint64_t name;
+	NULL_FRAME_STATS(NULL_FRAME_STATS_DECLARE)
+	#undef NULL_FRAME_STATS_DECLARE
+} NullFrameStats;
+
+bool null_record_begin(const char *path) attr_nonnull_all;
+void null_record_frame(const NullFrameStats *stats) attr_nonnull_all;
+void null_record_end(void);
@@ -21,6 +21,10 @@ void sdlgpu_buffer_set_debug_label(CommonBuffer *cbuf, const char *label) {
 	sdlgpu_buffer_update_debug_label(cbuf);
 }
 
+void sdlgpu_buffer_mark_drawn(CommonBuffer *cbuf) {
+	cbuf->draw_frame = sdlgpu.frame.counter + 1;
+}
+
 CommonBuffer *sdlgpu_buffer_create(SDL_GPUBufferUsageFlags usage, size_t alloc_size) {
 	CommonBuffer *cbuf = mem_alloc(alloc_size);
 	cachedbuf_init(&cbuf->cachedbuf);
@@ -30,6 +34,10 @@ CommonBuffer *sdlgpu_buffer_create(SDL_GPUBufferUsageFlags usage, size_t alloc_s
 }
 
 void sdlgpu_buffer_destroy(CommonBuffer *cbuf) {
+	auto stats = &cbuf->cachedbuf.stats;
+	log_debug("%s: uploaded %"PRIu64" bytes in %"PRIu64" ranges, %"PRIu64" flushes",
+		cbuf->debug_label, stats->bytes_uploaded, stats->num_uploads, stats->num_flushes);
+
 	SDL_ReleaseGPUTransferBuffer(sdlgpu.device, cbuf->transferbuf);
 	SDL_ReleaseGPUBuffer(sdlgpu.device, cbuf->gpubuf);
 	cachedbuf_deinit(&cbuf->cachedbuf);
@@ -38,7 +46,7 @@ void sdlgpu_buffer_destroy(CommonBuffer *cbuf) {
 
 void sdlgpu_buffer_invalidate(CommonBuffer *cbuf) {
 	// FIXME do we need to do anything here?
-	cbuf->cachedbuf.stream_offset = 0;
+	cachedbuf_invalidate(&cbuf->cachedbuf);
 }
 
 void sdlgpu_buffer_resize(CommonBuffer *cbuf, size_t new_size) {
@@ -92,17 +100,41 @@ SDL_IOStream *sdlgpu_buffer_get_stream(CommonBuffer *cbuf) {
 }
 
 void sdlgpu_buffer_flush(CommonBuffer *cbuf) {
-	CachedBufferUpdate update = cachedbuf_flush(&cbuf->cachedbuf);
+	bool resized = sdlgpu_buffer_resize_gpubuf(cbuf);
+	CachedBufferUpdate updates[CACHEDBUF_MAX_UPDATES];
+	uint num_updates = cachedbuf_flush(&cbuf->cachedbuf, resized, updates);
 
-	if(sdlgpu_buffer_resize_gpubuf(cbuf)) {
-		// TODO: instead of reuploading the whole buffer, track the part that was ever updated
-		update.data = cbuf->cachedbuf.cache;
-		update.size = cbuf->cachedbuf.size;
-		update.offset = 0;
+	if(!num_updates) {
+		return;
 	}
 
-	if(!update.size) {
-		return;
+	// Cycling discards the previous contents, so it's only safe if everything that's still valid is being replaced
+	bool cycle = (
+		num_updates == 1 &&
+		updates[0].offset == 0 &&
+		updates[0].size >= cbuf->cachedbuf.valid_end
+	);
+
+	if(!cycle && cbuf->draw_frame == sdlgpu.frame.counter + 1) {
+		// Uploads are submitted before this frame's draws, so an in-place partial update would also
+		// be seen by draws recorded earlier in the frame. Cycle instead, which leaves those draws with
+		// the old contents, and re-upload everything that's still valid into the new storage.
+		auto stats = &cbuf->cachedbuf.stats;
+
+		for(uint i = 0; i < num_updates; ++i) {
+			stats->bytes_uploaded -= updates[i].size;
+		}
+
+		updates[0] = (CachedBufferUpdate) {
+			.data = cbuf->cachedbuf.cache,
+			.size = cbuf->cachedbuf.valid_end,
+			.offset = 0,
+		};
+
+		stats->bytes_uploaded += updates[0].size;
+		stats->num_uploads -= num_updates - 1;
+		num_updates = 1;
+		cycle = true;
 	}
 
 	uint8_t *mapped = SDL_MapGPUTransferBuffer(sdlgpu.device, cbuf->transferbuf, true);
@@ -112,17 +144,22 @@ void sdlgpu_buffer_flush(CommonBuffer *cbuf) {
 		return;
 	}
 
-	memcpy(mapped + update.offset, update.data, update.size);
+	for(uint i = 0; i < num_updates; ++i) {
+		memcpy(mapped + updates[i].offset, updates[i].data, updates[i].size);
+	}
+
 	SDL_UnmapGPUTransferBuffer(sdlgpu.device, cbuf->transferbuf);
 
 	auto copypass = sdlgpu_begin_or_resume_copy_pass(CBUF_UPLOAD);
 
-	SDL_UploadToGPUBuffer(copypass, &(SDL_GPUTransferBufferLocation) {
-		.transfer_buffer = cbuf->transferbuf,
-		.offset = update.offset,
-	}, &(SDL_GPUBufferRegion) {
-		.buffer = cbuf->gpubuf,
-		.offset = update.offset,
-		.size = update.size,
-	}, true);
+	for(uint i = 0; i < num_updates; ++i) {
+		SDL_UploadToGPUBuffer(copypass, &(SDL_GPUTransferBufferLocation) {
+			.transfer_buffer = cbuf->transferbuf,
+			.offset = updates[i].offset,
+		}, &(SDL_GPUBufferRegion) {
+			.buffer = cbuf->gpubuf,
+			.offset = updates[i].offset,
+			.size = updates[i].size,
+		}, cycle);
+	}
 }
@@ -20,6 +20,7 @@ struct CommonBuffer {
 	SDL_GPUTransferBuffer *transferbuf;
 	SDL_GPUBufferUsageFlags usage;
 	size_t commited_size;
+	uint draw_frame;  // frame counter + 1 as of the last draw that read this buffer; 0 if never
 	char debug_label[R_DEBUG_LABEL_SIZE];
 };
 
@@ -29,4 +30,8 @@ void sdlgpu_buffer_invalidate(CommonBuffer *cbuf);
 void sdlgpu_buffer_resize(CommonBuffer *cbuf, size_t new_size);
 SDL_IOStream *sdlgpu_buffer_get_stream(CommonBuffer *cbuf);
 void sdlgpu_buffer_flush(CommonBuffer *cbuf);
+
+// Must be called for every buffer a draw call reads, so that later flushes in the same frame don't
+// overwrite data the draw still needs.
+void sdlgpu_buffer_mark_drawn(CommonBuffer *cbuf);
 void sdlgpu_buffer_set_debug_label(CommonBuffer *cbuf, const char *label);
@@ -708,8 +708,10 @@ static void sdlgpu_draw_generic(
 
 	for(uint i = 0; i < ARRAY_SIZE(vbuf_bindings); ++i) {
 		uint slot = varr->binding_to_attachment_map[i];
+		auto cbuf = &dynarray_get(&varr->attachments, slot)->cbuf;
+		sdlgpu_buffer_mark_drawn(cbuf);
 		vbuf_bindings[i] = (SDL_GPUBufferBinding) {
-			.buffer = dynarray_get(&varr->attachments, slot)->cbuf.gpubuf,
+			.buffer = cbuf->gpubuf,
 		};
 	}
 
@@ -800,6 +802,7 @@ static void sdlgpu_draw_generic(
 				UNREACHABLE;
 		}
 
+		sdlgpu_buffer_mark_drawn(&varr->index_attachment->cbuf);
 		SDL_BindGPUIndexBuffer(pass, &(SDL_GPUBufferBinding) {
 			.buffer = varr->index_attachment->cbuf.gpubuf,
 			.offset = 0,
@@ -0,0 +1,385 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "index.h"
+
+#include "replay.h"
+#include "struct.h"
+
+#include "log.h"
+#include "memory/scratch.h"
+#include "util/strbuf.h"
+#include "util/stringops.h"
+#include "vfs/public.h"
+
+#define REPLAY_INDEX_PATH "cache/replay_index.bin"
+#define REPLAY_INDEX_MAGIC "TSRI"
+#define REPLAY_INDEX_VERSION 1
+#define REPLAY_INDEX_MAX_ENTRIES (1 << 20)
+
+static void replay_index_entry_free(ReplayIndexEntry *e) {
+	mem_free(e->filename);
+	mem_free(e->playername);
+}
+
+static void replay_index_entries_free(ReplayIndexEntryArray *entries) {
+	dynarray_foreach_elem(entries, ReplayIndexEntry *e, {
+		replay_index_entry_free(e);
+	});
+
+	dynarray_free_data(entries);
+}
+
+static int replay_index_entry_cmp_filename(const void *a, const void *b) {
+	const ReplayIndexEntry *ea = a, *eb = b;
+	return strcmp(ea->filename, eb->filename);
+}
+
+static bool replay_index_entry_is_fresh(const ReplayIndexEntry *e, VFSInfo info) {
+	// Without size and mtime there's nothing to validate the entry against
+	if(info.size == 0 && info.mtime == 0) {
+		return false;
+	}
+
+	return e->file_size == info.size && e->file_mtime == info.mtime;
+}
+
+/*
+ * Serialization
+ */
+
+static bool write_string(SDL_IOStream *out, const char *s) {
+	size_t len = s ? strlen(s) : 0;
+	assert(len <= UINT16_MAX);
+	return SDL_WriteU16LE(out, len) && SDL_WriteIO(out, s, len) == len;
+}
+
+static bool read_string(SDL_IOStream *in, char **out) {
+	uint16_t len;
+
+	if(!SDL_ReadU16LE(in, &len)) {
+		return false;
+	}
+
+	char *s = mem_alloc(len + 1);
+
+	if(SDL_ReadIO(in, s, len) != len) {
+		mem_free(s);
+		return false;
+	}
+
+	s[len] = 0;
+	*out = s;
+	return true;
+}
+
+static bool replay_index_write_entry(SDL_IOStream *out, const ReplayIndexEntry *e) {
+	bool ok =
+		write_string(out, e->filename) &&
+		SDL_WriteU64LE(out, e->file_size) &&
+		SDL_WriteS64LE(out, e->file_mtime) &&
+		SDL_WriteU8(out, e->valid);
+
+	if(ok && e->valid) {
+		ok =
+			write_string(out, e->playername) &&
+			SDL_WriteU64LE(out, e->start_time) &&
+			SDL_WriteU16LE(out, e->first_stage) &&
+			SDL_WriteU16LE(out, e->num_stages) &&
+			SDL_WriteU8(out, e->plr_char) &&
+			SDL_WriteU8(out, e->plr_shot) &&
+			SDL_WriteU8(out, e->diff);
+	}
+
+	return ok;
+}
+
+static bool replay_index_read_entry(SDL_IOStream *in, ReplayIndexEntry *e) {
+	*e = (ReplayIndexEntry) {};
+	uint8_t valid;
+
+	bool ok =
+		read_string(in, &e->filename) &&
+		SDL_ReadU64LE(in, &e->file_size) &&
+		SDL_ReadS64LE(in, &e->file_mtime) &&
+		SDL_ReadU8(in, &valid);
+
+	if(ok && (e->valid = valid)) {
+		ok =
+			read_string(in, &e->playername) &&
+			SDL_ReadU64LE(in, &e->start_time) &&
+			SDL_ReadU16LE(in, &e->first_stage) &&
+			SDL_ReadU16LE(in, &e->num_stages) &&
+			SDL_ReadU8(in, &e->plr_char) &&
+			SDL_ReadU8(in, &e->plr_shot) &&
+			SDL_ReadU8(in, &e->diff);
+	}
+
+	if(!ok) {
+		replay_index_entry_free(e);
+	}
+
+	return ok;
+}
+
+static void replay_index_load(ReplayIndexEntryArray *entries) {
+	SDL_IOStream *in = vfs_open(REPLAY_INDEX_PATH, VFS_MODE_READ);
+
+	if(!in) {
+		return;
+	}
+
+	char magic[sizeof(REPLAY_INDEX_MAGIC) - 1];
+	uint16_t version;
+	uint32_t count;
+
+	if(
+		SDL_ReadIO(in, magic, sizeof(magic)) != sizeof(magic) ||
+		memcmp(magic, REPLAY_INDEX_MAGIC, sizeof(magic)) ||
+		!SDL_ReadU16LE(in, &version) ||
+		version != REPLAY_INDEX_VERSION ||
+		!SDL_ReadU32LE(in, &count) ||
+		count > REPLAY_INDEX_MAX_ENTRIES
+	) {
+		log_warn("Ignoring invalid or outdated replay index");
+		SDL_CloseIO(in);
+		return;
+	}
+
+	dynarray_ensure_capacity(entries, count);
+
+	for(uint32_t i = 0; i < count; ++i) {
+		if(!replay_index_read_entry(in, dynarray_append(entries))) {
+			log_warn("Replay index is truncated");
+			entries->num_elements--;
+			break;
+		}
+	}
+
+	SDL_CloseIO(in);
+}
+
+static void replay_index_save(ReplayIndex *idx) {
+	SDL_IOStream *out = vfs_open(REPLAY_INDEX_PATH, VFS_MODE_WRITE);
+
+	if(!out) {
+		log_error("VFS error: %s", vfs_get_error());
+		return;
+	}
+
+	bool ok =
+		SDL_WriteIO(out, REPLAY_INDEX_MAGIC, sizeof(REPLAY_INDEX_MAGIC) - 1) == sizeof(REPLAY_INDEX_MAGIC) - 1 &&
+		SDL_WriteU16LE(out, REPLAY_INDEX_VERSION) &&
+		SDL_WriteU32LE(out, idx->entries.num_elements);
+
+	for(uint i = 0; ok && i < idx->entries.num_elements; ++i) {
+		ok = replay_index_write_entry(out, dynarray_get_ptr(&idx->entries, i));
+	}
+
+	if(!ok) {
+		log_sdl_error(LOG_ERROR, "SDL_WriteIO");
+	}
+
+	SDL_CloseIO(out);
+	idx->dirty = false;
+}
+
+/*
+ * Background rebuild
+ */
+
+static void replay_index_fill_entry(ReplayIndexEntry *e) {
+	Replay rpy = {};
+
+	if(!replay_load(&rpy, e->filename, REPLAY_READ_META) || rpy.stages.num_elements == 0) {
+		replay_reset(&rpy);
+		e->valid = false;
+		return;
+	}
+
+	ReplayStage *first = dynarray_get_ptr(&rpy.stages, 0);
+
+	e->valid = true;
+	e->playername = mem_strdup(rpy.playername ? rpy.playername : "");
+	e->start_time = first->start_time;
+	e->first_stage = first->stage;
+	e->num_stages = rpy.stages.num_elements;
+	e->plr_char = first->plr_char;
+	e->plr_shot = first->plr_shot;
+	e->diff = first->diff;
+
+	replay_reset(&rpy);
+}
+
+static void *replay_index_rebuild_task(void *arg) {
+	ReplayIndexEntryArray *stale = arg;
+
+	dynarray_foreach_elem(stale, ReplayIndexEntry *e, {
+		replay_index_fill_entry(e);
+	});
+
+	return stale;
+}
+
+static void replay_index_free_stale(void *arg) {
+	ReplayIndexEntryArray *stale = arg;
+	replay_index_entries_free(stale);
+	mem_free(stale);
+}
+
+bool replay_index_open(ReplayIndex *idx) {
+	*idx = (ReplayIndex) {};
+
+	VFSDir *dir = vfs_dir_open("storage/replays");
+
+	if(!dir) {
+		log_warn("VFS error: %s", vfs_get_error());
+		return false;
+	}
+
+	ReplayIndexEntryArray cached = {};
+	replay_index_load(&cached);
+	dynarray_qsort(&cached, replay_index_entry_cmp_filename);
+
+	auto stale = ALLOC(ReplayIndexEntryArray);
+	StringBuffer pathbuf = { acquire_scratch_arena() };
+	const char *filename;
+	uint num_reused = 0;
+
+	while((filename = vfs_dir_read(dir))) {
+		if(!strendswith(filename, "." REPLAY_EXTENSION)) {
+			continue;
+		}
+
+		strbuf_clear(&pathbuf);
+		strbuf_printf(&pathbuf, "storage/replays/%s", filename);
+		VFSInfo info = vfs_query(pathbuf.start);
+
+		if(info.error || !info.exists || info.is_dir) {
+			continue;
+		}
+
+		ReplayIndexEntry *cached_entry = NULL;
+
+		if(cached.num_elements > 0) {
+			cached_entry = bsearch(
+				&(ReplayIndexEntry) { .filename = (char*)filename },
+				cached.data, cached.num_elements, sizeof(*cached.data),
+				replay_index_entry_cmp_filename
+			);
+		}
+
+		if(cached_entry && replay_index_entry_is_fresh(cached_entry, info)) {
+			// Steal the cached entry; leave a dummy behind so the array stays sorted
+			dynarray_append(&idx->entries, *cached_entry);
+			cached_entry->filename = mem_strdup(cached_entry->filename);
+			cached_entry->playername = NULL;
+			++num_reused;
+		} else {
+			dynarray_append(stale, {
+				.filename = mem_strdup(filename),
+				.file_size = info.size,
+				.file_mtime = info.mtime,
+			});
+		}
+	}
+
+	release_scratch_arena(pathbuf.arena);
+	vfs_dir_close(dir);
+
+	// Entries for deleted files are dropped
+	idx->dirty = num_reused != cached.num_elements;
+	replay_index_entries_free(&cached);
+
+	log_debug("%u replay index entries reused, %u stale", num_reused, stale->num_elements);
+
+	if(stale->num_elements == 0) {
+		replay_index_free_stale(stale);
+		return true;
+	}
+
+	idx->pending = stale;
+	idx->rebuild_task = taskmgr_global_submit((TaskParams) {
+		.callback = replay_index_rebuild_task,
+		.userdata = stale,
+	});
+
+	if(!idx->rebuild_task) {
+		log_warn("Failed to submit the replay index rebuild task; rebuilding synchronously");
+		replay_index_rebuild_task(stale);
+	}
+
+	return true;
+}
+
+bool replay_index_is_rebuilding(ReplayIndex *idx) {
+	return idx->pending != NULL;
+}
+
+static int replay_index_merge_pending(ReplayIndex *idx) {
+	ReplayIndexEntryArray *stale = NOT_NULL(idx->pending);
+	int first_new = idx->entries.num_elements;
+
+	dynarray_ensure_capacity(&idx->entries, idx->entries.num_elements + stale->num_elements);
+
+	dynarray_foreach_elem(stale, ReplayIndexEntry *e, {
+		dynarray_append(&idx->entries, *e);
+	});
+
+	// Entries are now owned by idx->entries
+	dynarray_free_data(stale);
+	mem_free(stale);
+	idx->pending = NULL;
+	idx->dirty = true;
+
+	return first_new;
+}
+
+int replay_index_poll(ReplayIndex *idx) {
+	if(!idx->pending) {
+		return -1;
+	}
+
+	if(idx->rebuild_task) {
+		if(task_status(idx->rebuild_task) != TASK_FINISHED) {
+			return -1;
+		}
+
+		task_finish(idx->rebuild_task, NULL);
+		idx->rebuild_task = NULL;
+	}
+
+	int first_new = replay_index_merge_pending(idx);
+	replay_index_save(idx);
+	return first_new;
+}
+
+void replay_index_close(ReplayIndex *idx) {
+	if(idx->rebuild_task) {
+		if(task_cancel(idx->rebuild_task)) {
+			task_detach(idx->rebuild_task);
+			replay_index_free_stale(NOT_NULL(idx->pending));
+			idx->pending = NULL;
+		} else {
+			// Already running; might as well keep the results
+			task_finish(idx->rebuild_task, NULL);
+		}
+
+		idx->rebuild_task = NULL;
+	}
+
+	if(idx->pending) {
+		replay_index_merge_pending(idx);
+	}
+
+	if(idx->dirty) {
+		replay_index_save(idx);
+	}
+
+	replay_index_entries_free(&idx->entries);
+}
@@ -0,0 +1,58 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "dynarray.h"
+#include "taskmanager.h"
+
+/*
+ * Persistent index of replay metadata, used by the replay browser.
+ *
+ * Entries are keyed by file name, size and modification time, and hold just enough information
+ * to list and sort the replays. Entries for new or modified files are rebuilt in the background;
+ * full metadata should be loaded with replay_load() only when actually needed.
+ */
+
+typedef struct ReplayIndexEntry {
+	char *filename;         // relative to storage/replays
+	char *playername;
+	uint64_t file_size;
+	int64_t file_mtime;
+	uint64_t start_time;    // of the first stage
+	uint16_t first_stage;   // stage ID of the first stage
+	uint16_t num_stages;
+	uint8_t plr_char;
+	uint8_t plr_shot;
+	uint8_t diff;
+	bool valid;             // false if the file could not be read; it won't be retried until it changes
+} ReplayIndexEntry;
+
+typedef DYNAMIC_ARRAY(ReplayIndexEntry) ReplayIndexEntryArray;
+
+typedef struct ReplayIndex {
+	ReplayIndexEntryArray entries;
+	ReplayIndexEntryArray *pending;  // stale entries, owned by rebuild_task while it's running
+	Task *rebuild_task;
+	bool dirty;
+} ReplayIndex;
+
+// Scans storage/replays and starts rebuilding stale entries in the background.
+// Returns false if the replay directory could not be read.
+bool replay_index_open(ReplayIndex *idx) attr_nonnull_all;
+
+// Returns true while stale entries are being rebuilt.
+bool replay_index_is_rebuilding(ReplayIndex *idx) attr_nonnull_all;
+
+// If the background rebuild has finished, merges its results into idx->entries, saves the index,
+// and returns the position of the first new entry. Otherwise returns -1.
+int replay_index_poll(ReplayIndex *idx) attr_nonnull_all;
+
+// Cancels or waits for the background rebuild, saves the index if needed, and frees everything.
+void replay_index_close(ReplayIndex *idx) attr_nonnull_all;
@@ -158,6 +158,8 @@ static float global_font_scale(void) {
 }
 
 static void reload_fonts(float quality);
+static void text_layout_cache_invalidate(void);
+static void text_layout_cache_shutdown(void);
 
 static bool fonts_event(SDL_Event *event, void *arg) {
 	if(!IS_TAISEI_EVENT(event->type)) {
@@ -272,6 +274,7 @@ static void shutdown_fonts(void) {
 	r_texture_destroy(globals.render_tex);
 	r_framebuffer_destroy(globals.render_buf);
 	events_unregister_handler(fonts_event);
+	text_layout_cache_shutdown();
 	FT_Done_Library(globals.lib);
 	SDL_DestroyMutex(globals.mutex.new_face);
 	SDL_DestroyMutex(globals.mutex.done_face);
@@ -423,7 +426,12 @@ bool font_get_kerning_enabled(Font *font) {
 }
 
 void font_set_kerning_enabled(Font *font, bool newval) {
-	font->kerning = (newval && FT_HAS_KERNING(font->face));
+	bool kerning = (newval && FT_HAS_KERNING(font->face));
+
+	if(font->kerning != kerning) {
+		font->kerning = kerning;
+		text_layout_cache_invalidate();
+	}
 }
 
 // TODO: Figure out sensible values for these; maybe make them depend on font size in some way.
@@ -802,6 +810,7 @@ static void wipe_glyph_cache(Font *font) {
 	ht_unset_all(&font->ftindex_to_glyph_ofs);
 
 	font->glyphs.num_elements = 0;
+	text_layout_cache_invalidate();
 }
 
 static void free_font_resources(Font *font) {
@@ -1249,7 +1258,233 @@ static void set_batch_texture(SpriteStateParams *stp, Texture *tex) {
 	}
 }
 
-static float _text_ucs4_draw(Font *font, size_t ucs4len, const uint32_t ucs4text[ucs4len], const TextParams *params) {
+/*
+ * Text layout cache.
+ *
+ * Laying out a string (UTF-8 decoding, shortening, wrapping, glyph lookups, kerning) is
+ * expensive compared to emitting the resulting sprites, and most text (HUD labels, menus,
+ * dialog) is drawn unchanged for many frames in a row. Positioned glyph runs are cached
+ * relative to the text origin, keyed by the source text and the layout-relevant parameters.
+ * Anything that invalidates glyphs (font reloads, kerning changes) bumps the generation,
+ * which implicitly discards all entries.
+ */
+
+#define TEXT_LAYOUT_CACHE_SIZE 128  // must be a power of two
+#define TEXT_LAYOUT_CACHE_WAYS 4
+
+typedef enum TextLayoutSource {
+	TEXT_LAYOUT_UTF8,
+	TEXT_LAYOUT_UTF8_WRAPPED,
+	TEXT_LAYOUT_UCS4,
+} TextLayoutSource;
+
+typedef struct TextLayoutGlyph {
+	Texture *tex;
+	FloatRect tex_area;
+	FloatExtent imgdims;
+	float x, y;
+	charcode_t charcode;
+} TextLayoutGlyph;
+
+typedef struct TextLayout {
+	DYNAMIC_ARRAY(TextLayoutGlyph) glyphs;
+	DYNAMIC_ARRAY(char) key_data;
+	Font *font;
+	uint32_t key_hash;
+	uint generation;
+	uint last_used;
+	float max_width;
+	float wrap_width;
+	TextLayoutSource source;
+	Alignment align;
+	TextBBox bbox;
+	float start_x;  // pen position of the first line after alignment
+	float end_x;    // final pen position; the return value of text_draw(), unscaled
+} TextLayout;
+
+static struct {
+	TextLayout slots[TEXT_LAYOUT_CACHE_SIZE];
+	SDL_AtomicInt generation;  // fonts may be freed on loader threads
+	uint use_counter;
+} layout_cache = { .generation = { 1 } };
+
+static void text_layout_cache_invalidate(void) {
+	SDL_AddAtomicInt(&layout_cache.generation, 1);
+}
+
+static void text_layout_cache_shutdown(void) {
+	for(int i = 0; i < ARRAY_SIZE(layout_cache.slots); ++i) {
+		dynarray_free_data(&layout_cache.slots[i].glyphs);
+		dynarray_free_data(&layout_cache.slots[i].key_data);
+	}
+
+	layout_cache = (typeof(layout_cache)) { .generation = { 1 } };
+}
+
+static uint32_t text_layout_hash(
+	Font *font, TextLayoutSource source, size_t size, const void *data
+) {
+	// FNV1a, seeded with the font pointer and source type
+	uint32_t hash = 0x811c9dc5 ^ htutil_hashfunc_uint64((uintptr_t)font ^ source);
+	const uint8_t *bytes = data;
+
+	for(size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x1000193;
+	}
+
+	return hash;
+}
+
+static bool text_layout_matches(
+	const TextLayout *l, uint generation, Font *font, TextLayoutSource source, uint32_t hash,
+	size_t size, const void *data, const TextParams *params, float wrap_width
+) {
+	return
+		l->generation == generation &&
+		l->key_hash == hash &&
+		l->font == font &&
+		l->source == source &&
+		l->align == params->align &&
+		l->max_width == params->max_width &&
+		l->wrap_width == wrap_width &&
+		l->key_data.num_elements == size &&
+		!memcmp(l->key_data.data, data, size);
+}
+
+static void text_layout_build(
+	TextLayout *l, Font *font, size_t ucs4len, const uint32_t ucs4text[ucs4len]
+) {
+	Cursor c = cursor_init(font);
+	float y = 0;
+
+	l->glyphs.num_elements = 0;
+	text_ucs4_bbox(font, ucs4len, ucs4text, 0, &l->bbox);
+	adjust_xpos(font, ucs4len, ucs4text, l->align, 0, &c.x);
+	l->start_x = c.x;
+
+	const uint32_t *tptr = ucs4text;
+	const uint32_t *tend = tptr + ucs4len;
+
+	while(tptr < tend && *tptr) {
+		uint32_t uchar = *tptr++;
+
+		if(uchar == '\n') {
+			cursor_reset(&c);
+			adjust_xpos(font, tend - tptr, tptr, l->align, 0, &c.x);
+			y += font->metrics.lineskip;
+			continue;
+		}
+
+		Glyph *glyph = get_glyph(font, uchar);
+
+		if(glyph == NULL) {
+			continue;
+		}
+
+		float x = cursor_advance(&c, glyph);
+
+		if(glyph->sprite.tex == NULL) {
+			continue;
+		}
+
+		Sprite *spr = &glyph->sprite;
+		FloatOffset ofs = spr->padding.offset;
+		FloatExtent imgdims = spr->extent;
+		imgdims.as_cmplx -= spr->padding.extent.as_cmplx;
+
+		dynarray_append(&l->glyphs, {
+			.tex = spr->tex,
+			.tex_area = spr->tex_area,
+			.imgdims = imgdims,
+			.x = x + glyph->metrics.bearing_x + spr->w * 0.5f + ofs.x,
+			.y = y - glyph->metrics.bearing_y + spr->h * 0.5f - font->metrics.descent + ofs.y,
+			.charcode = uchar,
+		});
+	}
+
+	l->end_x = c.x;
+}
+
+static TextLayout *text_layout_get(
+	Font *font, TextLayoutSource source, size_t size, const void *data,
+	const TextParams *params, float wrap_width
+) {
+	uint32_t hash = text_layout_hash(font, source, size, data);
+	uint generation = SDL_GetAtomicInt(&layout_cache.generation);
+	uint set = (hash & (TEXT_LAYOUT_CACHE_SIZE - 1)) & ~(TEXT_LAYOUT_CACHE_WAYS - 1);
+	TextLayout *victim = NULL;
+
+	for(uint i = set; i < set + TEXT_LAYOUT_CACHE_WAYS; ++i) {
+		TextLayout *l = layout_cache.slots + i;
+
+		if(text_layout_matches(l, generation, font, source, hash, size, data, params, wrap_width)) {
+			l->last_used = ++layout_cache.use_counter;
+			return l;
+		}
+
+		if(
+			victim == NULL ||
+			(victim->generation == generation && (
+				l->generation != generation ||
+				l->last_used < victim->last_used
+			))
+		) {
+			victim = l;
+		}
+	}
+
+	TextLayout *l = NOT_NULL(victim);
+	l->font = font;
+	l->key_hash = hash;
+	l->generation = generation;
+	l->last_used = ++layout_cache.use_counter;
+	l->max_width = params->max_width;
+	l->wrap_width = wrap_width;
+	l->source = source;
+	l->align = params->align;
+	dynarray_set_elements(&l->key_data, size, (char*)data);
+
+	if(source == TEXT_LAYOUT_UCS4) {
+		size_t len = size / sizeof(uint32_t);
+		uint32_t buf[len + 1];
+		memcpy(buf, data, size);
+
+		if(params->max_width > 0) {
+			len = text_ucs4_shorten(font, len, buf, params->max_width);
+		}
+
+		text_layout_build(l, font, len, buf);
+		return l;
+	}
+
+	MemArena *scratch = NULL;
+	const char *text = data;
+
+	if(source == TEXT_LAYOUT_UTF8_WRAPPED) {
+		scratch = acquire_scratch_arena();
+		StringBuffer wbuf = { scratch };
+		text_wrap(font, text, wrap_width, &wbuf);
+		text = wbuf.start;
+	}
+
+	uint32_t buf[strlen(text) + 1];
+	size_t len = utf8_to_ucs4(text, ARRAY_SIZE(buf), buf);
+
+	if(params->max_width > 0) {
+		len = text_ucs4_shorten(font, len, buf, params->max_width);
+	}
+
+	text_layout_build(l, font, len, buf);
+
+	if(scratch) {
+		release_scratch_arena(scratch);
+	}
+
+	return l;
+}
+
+static float text_layout_draw(Font *font, const TextLayout *l, const TextParams *params) {
 	SpriteStateParams batch_state_params;
 
 	memcpy(batch_state_params.aux_textures, params->aux_textures, sizeof(batch_state_params.aux_textures));
@@ -1268,21 +1503,14 @@ static float _text_ucs4_draw(Font *font, size_t ucs4len, const uint32_t ucs4text
 
 	batch_state_params.primary_texture = NULL;
 
-	TextBBox bbox;
-	float y = params->pos.y;
 	float scale = font->metrics.scale;
 	float iscale = 1.0f / scale;
 
-	Cursor c = cursor_init(font);
-	c.x = params->pos.x;
-
 	struct {
 		struct { float min, max; } x, y;
 		float w, h;
 	} overlay;
 
-	text_ucs4_bbox(font, ucs4len, ucs4text, 0, &bbox);
-
 	Color color;
 
 	if(params->color == NULL) {
@@ -1306,26 +1534,20 @@ static float _text_ucs4_draw(Font *font, size_t ucs4len, const uint32_t ucs4text
 	r_mat_tex_current(mat_texture);
 	r_mat_mv_current(mat_model);
 
-	glm_translate(mat_model, (vec3) { c.x, y } );
+	glm_translate(mat_model, (vec3) { params->pos.x, params->pos.y } );
 	glm_scale(mat_model, (vec3) { iscale, iscale, 1 } );
 
-	float orig_x = c.x;
-	float orig_y = y;
-	c.x = y = 0;
-
-	adjust_xpos(font, ucs4len, ucs4text, params->align, 0, &c.x);
-
 	if(params->overlay_projection) {
 		FloatRect *op = params->overlay_projection;
-		overlay.x.min = (op->x - orig_x) * scale;
+		overlay.x.min = (op->x - params->pos.x) * scale;
 		overlay.x.max = overlay.x.min + op->w * scale;
-		overlay.y.min = (op->y - orig_y) * scale;
+		overlay.y.min = (op->y - params->pos.y) * scale;
 		overlay.y.max = overlay.y.min + op->h * scale;
 	} else {
-		overlay.x.min = bbox.x.min + c.x;
-		overlay.x.max = bbox.x.max + c.x;
-		overlay.y.min = bbox.y.min - font->metrics.descent;
-		overlay.y.max = bbox.y.max - font->metrics.descent;
+		overlay.x.min = l->bbox.x.min + l->start_x;
+		overlay.x.max = l->bbox.x.max + l->start_x;
+		overlay.y.min = l->bbox.y.min - font->metrics.descent;
+		overlay.y.max = l->bbox.y.max - font->metrics.descent;
 	}
 
 	overlay.w = overlay.x.max - overlay.x.min;
@@ -1334,106 +1556,55 @@ static float _text_ucs4_draw(Font *font, size_t ucs4len, const uint32_t ucs4text
 	glm_scale(mat_texture, (vec3) { 1/overlay.w, 1/overlay.h, 1.0 });
 	glm_translate(mat_texture, (vec3) { -overlay.x.min, overlay.y.min, 0 });
 
-	const uint32_t *tptr = ucs4text;
-	const uint32_t *tend = tptr + ucs4len;
-
-	while(tptr < tend && *tptr) {
-		uint32_t uchar = *tptr++;
-
-		if(uchar == '\n') {
-			cursor_reset(&c);
-			adjust_xpos(font, tend - tptr, tptr, params->align, 0, &c.x);
-			y += font->metrics.lineskip;
-			continue;
-		}
-
-		Glyph *glyph = get_glyph(font, uchar);
-
-		if(glyph == NULL) {
-			continue;
-		}
-
-		float x = cursor_advance(&c, glyph);
-
-		if(glyph->sprite.tex == NULL) {
-			continue;
-		}
-
-		Sprite *spr = &glyph->sprite;
-		set_batch_texture(&batch_state_params, spr->tex);
+	dynarray_foreach_elem(&l->glyphs, const TextLayoutGlyph *g, {
+		set_batch_texture(&batch_state_params, g->tex);
 
 		SpriteInstanceAttribs attribs;
 		attribs.rgba = color;
 		attribs.custom = shader_params;
 
-		FloatOffset ofs = spr->padding.offset;
-		FloatExtent imgdims = spr->extent;
-		imgdims.as_cmplx -= spr->padding.extent.as_cmplx;
-
-		float g_x = x + glyph->metrics.bearing_x + spr->w * 0.5f + ofs.x;
-		float g_y = y - glyph->metrics.bearing_y + spr->h * 0.5f - font->metrics.descent + ofs.y;
-
 		glm_translate_to(mat_texture, (vec3) {
-			g_x - imgdims.w * 0.5f,
-			g_y + overlay.h - imgdims.h * 0.5f
+			g->x - g->imgdims.w * 0.5f,
+			g->y + overlay.h - g->imgdims.h * 0.5f
 		}, attribs.tex_transform);
-		glm_scale(attribs.tex_transform, (vec3) { imgdims.w, imgdims.h, 1.0 });
+		glm_scale(attribs.tex_transform, (vec3) { g->imgdims.w, g->imgdims.h, 1.0 });
 
-		glm_translate_to(mat_model, (vec3) { g_x, g_y }, attribs.mv_transform);
-		glm_scale(attribs.mv_transform, (vec3) { imgdims.w, imgdims.h, 1.0 } );
+		glm_translate_to(mat_model, (vec3) { g->x, g->y }, attribs.mv_transform);
+		glm_scale(attribs.mv_transform, (vec3) { g->imgdims.w, g->imgdims.h, 1.0 } );
 
-		attribs.texrect = spr->tex_area;
+		attribs.texrect = g->tex_area;
 
 		// NOTE: Glyphs have their sprite w/h unadjusted for scale.
-		attribs.sprite_size.w = imgdims.w * iscale;
-		attribs.sprite_size.h = imgdims.h * iscale;
+		attribs.sprite_size.w = g->imgdims.w * iscale;
+		attribs.sprite_size.h = g->imgdims.h * iscale;
 
 		if(params->glyph_callback.func != NULL) {
 			params->glyph_callback.func(
-				font, uchar, &attribs, params->glyph_callback.userdata);
+				font, g->charcode, &attribs, params->glyph_callback.userdata);
 		}
 
 		r_sprite_batch_add_instance(&attribs);
-	}
-
-	return c.x * iscale;
-}
-
-static float _text_draw(Font *font, const char *text, const TextParams *params) {
-	uint32_t buf[strlen(text) + 1];
-	size_t len = utf8_to_ucs4(text, ARRAY_SIZE(buf), buf);
-
-	if(params->max_width > 0) {
-		len  = text_ucs4_shorten(font, len, buf, params->max_width);
-	}
+	});
 
-	return _text_ucs4_draw(font, len, buf, params);
+	return l->end_x * iscale;
 }
 
 float text_draw(const char *text, const TextParams *params) {
-	return _text_draw(font_from_params(params), text, params);
+	Font *font = font_from_params(params);
+	auto l = text_layout_get(font, TEXT_LAYOUT_UTF8, strlen(text) + 1, text, params, 0);
+	return text_layout_draw(font, l, params);
 }
 
 float text_ucs4_draw(size_t len, const uint32_t text[len], const TextParams *params) {
 	Font *font = font_from_params(params);
-
-	if(params->max_width > 0) {
-		uint32_t buf[len];
-		memcpy(buf, text, sizeof(buf));
-		size_t l = text_ucs4_shorten(font, len, buf, params->max_width);
-		return _text_ucs4_draw(font, l, buf, params);
-	}
-
-	return _text_ucs4_draw(font, len, text, params);
+	auto l = text_layout_get(font, TEXT_LAYOUT_UCS4, len * sizeof(*text), text, params, 0);
+	return text_layout_draw(font, l, params);
 }
 
 float text_draw_wrapped(const char *text, float max_width, const TextParams *params) {
 	Font *font = font_from_params(params);
-	StringBuffer buf = { acquire_scratch_arena() };
-	text_wrap(font, text, max_width, &buf);
-	auto r = _text_draw(font, buf.start, params);
-	release_scratch_arena(buf.arena);
-	return r;
+	auto l = text_layout_get(font, TEXT_LAYOUT_UTF8_WRAPPED, strlen(text) + 1, text, params, max_width);
+	return text_layout_draw(font, l, params);
 }
 
 void text_render(const char *text, Font *font, Sprite *out_sprite, TextBBox *out_bbox) {
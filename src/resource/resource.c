@@ -161,8 +161,10 @@ typedef struct FileWatchHandlerData {
 
 static struct {
 	hrtime_t frame_threshold;
+	hrtime_t finalize_time_this_frame;
 	uchar loaded_this_frame : 1;
 	struct {
+		hrtime_t finalize_budget;
 		uchar no_async_load : 1;
 		uchar no_preload : 1;
 		uchar no_unload : 1;
@@ -204,7 +206,7 @@ static inline InternalResLoadState *loadstate_internal(ResourceLoadState *st) {
 	return UNION_CAST(ResourceLoadState*, InternalResLoadState*, st);
 }
 
-static InternalResource *preload_resource_internal(ResourceType type, const char *name, ResourceFlags flags);
+static InternalResource *preload_resource_internal(ResourceType type, const char *name, ResourceFlags flags, bool is_dependency);
 
 #if DEBUG_LOCKS
 
@@ -473,7 +475,7 @@ static uint32_t ires_make_dependent_one(InternalResource *ires, InternalResource
 
 void res_load_dependency(ResourceLoadState *st, ResourceType type, const char *name) {
 	InternalResLoadState *ist = loadstate_internal(st);
-	InternalResource *dep = preload_resource_internal(type, name, st->flags & ~RESF_RELOAD);
+	InternalResource *dep = preload_resource_internal(type, name, st->flags & ~RESF_RELOAD, true);
 	InternalResource *ires = ist->ires;
 	ires_lock(ires);
 	dynarray_append(&ires->dependencies, dep);
@@ -797,7 +799,7 @@ static void res_group_preload_one(
 		return;
 	}
 
-	InternalResource *ires = preload_resource_internal(type, name, flags | RESF_PRELOAD);
+	InternalResource *ires = preload_resource_internal(type, name, flags | RESF_PRELOAD, false);
 	res_group_add_ires(rg, ires, false);
 }
 
@@ -1152,6 +1154,7 @@ static bool should_defer_load(InternalResLoadState *st) {
 
 	if(ft.next != res_gstate.frame_threshold) {
 		res_gstate.frame_threshold = ft.next;
+		res_gstate.finalize_time_this_frame = 0;
 		res_gstate.loaded_this_frame = false;
 	}
 
@@ -1159,6 +1162,12 @@ static bool should_defer_load(InternalResLoadState *st) {
 		return false;
 	}
 
+	hrtime_t budget = res_gstate.env.finalize_budget ?: ft.target / 4;
+
+	if(res_gstate.finalize_time_this_frame >= budget) {
+		return true;
+	}
+
 	shrtime_t t = time_get();
 
 	if(tnext - t < tmin) {
@@ -1168,6 +1177,32 @@ static bool should_defer_load(InternalResLoadState *st) {
 	return false;
 }
 
+/*
+ * Whether all pending dependencies are only waiting to be finalized on the main thread,
+ * i.e. waiting for them won't block on a worker.
+ */
+static bool dependencies_ready_to_finalize(InternalResLoadState *st) {
+	dynarray_foreach_elem(&st->ires->dependencies, InternalResource **pdep, {
+		InternalResource *dep = *pdep;
+		ires_lock(dep);
+
+		bool ready =
+			dep->status != RES_STATUS_LOADING || (
+				dep->load != NULL &&
+				dep->load->ready_to_finalize &&
+				dependencies_ready_to_finalize(dep->load)
+			);
+
+		ires_unlock(dep);
+
+		if(!ready) {
+			return false;
+		}
+	});
+
+	return true;
+}
+
 static bool resource_asyncload_handler(SDL_Event *evt, void *arg) {
 	assert(thread_current_is_main());
 
@@ -1185,17 +1220,29 @@ static bool resource_asyncload_handler(SDL_Event *evt, void *arg) {
 		return true;
 	}
 
+	hrtime_t finalize_start = time_get();
 	ires_lock(ires);
 
 	ResourceStatus dep_status = pump_dependencies(st);
 
+	if(
+		dep_status == RES_STATUS_LOADING &&
+		!(st->st.flags & RESF_RELOAD) &&
+		dependencies_ready_to_finalize(st)
+	) {
+		// The rest of the dependency chain is only waiting for us, so finalize it right away
+		// (in dependency order) instead of advancing it by one link per frame.
+		dep_status = wait_for_dependencies(st);
+	}
+
 	if(dep_status == RES_STATUS_LOADING) {
 		LOAD_DBG("Deferring %s '%s' because some dependencies are not satisfied", type_name(ires->res.type), st->st.name);
 
-		// FIXME: Make this less braindead.
-		// This will retry every frame until dependencies are satisfied.
+		// Some dependencies are still being loaded by workers; their own events will come
+		// through once they're done. Retry next frame.
 		ires_unlock(ires);
 		events_defer(evt);
+		res_gstate.finalize_time_this_frame += time_get() - finalize_start;
 		return true;
 	}
 
@@ -1220,6 +1267,7 @@ static bool resource_asyncload_handler(SDL_Event *evt, void *arg) {
 	}
 
 	ires_unlock(ires);
+	res_gstate.finalize_time_this_frame += time_get() - finalize_start;
 	return true;
 }
 
@@ -1239,16 +1287,26 @@ static InternalResLoadState *make_persistent_loadstate(InternalResLoadState *st_
 	return st;
 }
 
-static void load_resource_async(InternalResLoadState *st_transient) {
+static void load_resource_async(InternalResLoadState *st_transient, bool is_dependency) {
 	InternalResLoadState *st = make_persistent_loadstate(st_transient);
-	st->async_task = taskmgr_global_submit((TaskParams) { load_resource_async_task, st });
+
+	// Dependencies jump the queue: whatever requested them can't complete until they do, and
+	// with everything else already queued they'd otherwise be the last to start. This way the
+	// leaves of the dependency graph (textures, shader objects) get loaded first and in parallel,
+	// instead of being run one by one by the workers that end up waiting for them.
+	st->async_task = taskmgr_global_submit((TaskParams) {
+		.callback = load_resource_async_task,
+		.userdata = st,
+		.topmost = is_dependency,
+	});
 }
 
 attr_nonnull(1)
 static void load_resource(
 	InternalResource *ires,
 	ResourceFlags flags,
-	bool async
+	bool async,
+	bool is_dependency
 ) {
 	ResourceHandler *handler = get_ires_handler(ires);
 	const char *typename = type_name(handler->type);
@@ -1293,7 +1351,7 @@ static void load_resource(
 		ires->dependencies.num_elements = 0;
 
 		if(async) {
-			load_resource_async(&st);
+			load_resource_async(&st, is_dependency);
 		} else {
 			lstate_set_status(&st, LOAD_NONE);
 			PROTECT_FLAGS(&st, handler->procs.load(&st.st));
@@ -1352,7 +1410,7 @@ static bool reload_resource(InternalResource *ires, ResourceFlags flags, bool as
 
 	ires_lock(transient);
 	ires->reload_buddy = transient;
-	load_resource(transient, flags, async);
+	load_resource(transient, flags, async, false);
 	ires_unlock(transient);
 
 	if(!ires->dependents.num_elements_occupied) {
@@ -1517,7 +1575,7 @@ Resource *_res_get_prehashed(ResourceType type, const char *name, hash_t hash, R
 			}
 		}
 
-		load_resource(ires, flags, false);
+		load_resource(ires, flags, false, false);
 		ires_cond_broadcast(ires);
 
 		if(ires->status == RES_STATUS_FAILED) {
@@ -1555,13 +1613,13 @@ Resource *_res_get_prehashed(ResourceType type, const char *name, hash_t hash, R
 }
 
 static InternalResource *preload_resource_internal(
-	ResourceType type, const char *name, ResourceFlags flags
+	ResourceType type, const char *name, ResourceFlags flags, bool is_dependency
 ) {
 	InternalResource *ires;
 
 	if(try_begin_load_resource(type, name, ht_str2ptr_hash(name), &ires)) {
 		ires_lock(ires);
-		load_resource(ires, flags, !res_gstate.env.no_async_load);
+		load_resource(ires, flags, !res_gstate.env.no_async_load, is_dependency);
 		ires_unlock(ires);
 	} else {
 		// NOTE: try_begin_load_resource() does an implicit incref on success
@@ -1673,6 +1731,7 @@ void res_init(void) {
 	res_gstate.env.no_preload = env_get("TAISEI_NOPRELOAD", false);
 	res_gstate.env.no_unload = env_get("TAISEI_NOUNLOAD", false);
 	res_gstate.env.preload_required = env_get("TAISEI_PRELOAD_REQUIRED", false);
+	res_gstate.env.finalize_budget = max(0, env_get("TAISEI_RES_FINALIZE_BUDGET_US", 0)) * (HRTIME_RESOLUTION / 1000000);
 
 	ht_watch2iresset_create(&res_gstate.watch_to_iresset);
 	res_group_init(&res_gstate.default_group);
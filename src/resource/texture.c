@@ -22,6 +22,8 @@ ResourceHandler texture_res_handler = {
 	.subdir = TEX_PATH_PREFIX,
 
 	.procs = {
+		.init = texture_loader_init,
+		.shutdown = texture_loader_shutdown,
 		.find = texture_loader_path,
 		.check = texture_loader_check_path,
 		.load = texture_loader_stage1,
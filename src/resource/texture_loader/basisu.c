@@ -11,6 +11,7 @@
 
 #include "pixmap/pixmap.h"
 #include "rwops/rwops_sha256.h"
+#include "taskmanager.h"
 #include "util.h"
 #include "util/env.h"
 #include "util/io.h"
@@ -345,6 +346,7 @@ static PixmapFormat texture_loader_basisu_pick_and_apply_compressed_format(
 
 struct basisu_load_data {
 	char *filebuf;
+	size_t filesize;
 	basist_transcoder *tc;
 	uint mip_bias;
 	PixmapFormat px_decode_format;
@@ -632,6 +634,8 @@ static bool texture_loader_basisu_init_mipmaps(
 static bool texture_loader_basisu_load_pixmap(
 	const char *ctx,
 	struct basisu_load_data *bld,
+	basist_transcoder *tc,
+	bool *transcoding_started,
 	TextureLoadData *ld,
 	basist_transcode_level_params *param,
 	Pixmap *out_pixmap
@@ -639,11 +643,11 @@ static bool texture_loader_basisu_load_pixmap(
 	basist_image_level_desc level_desc;
 	TRY_BOOL(
 		basist_transcoder_get_image_level_desc,
-		bld->tc, param->image_index, param->level_index, &level_desc
+		tc, param->image_index, param->level_index, &level_desc
 	);
 
 	struct basis_size_info size_info = texture_loader_basisu_get_transcoded_size_info(
-		ld, bld->tc, param->image_index, param->level_index, param->format
+		ld, tc, param->image_index, param->level_index, param->format
 	);
 
 	if(size_info.block_size == 0) {
@@ -667,23 +671,36 @@ static bool texture_loader_basisu_load_pixmap(
 		data_size,
 		out_pixmap
 	)) {
-		if(!bld->transcoding_started) {
-			TRY_BOOL(basist_transcoder_start_transcoding, bld->tc);
-			bld->transcoding_started = true;
+		// We own the cache entry now, and must release it even if transcoding fails.
+		bool transcoded = *transcoding_started;
+
+		if(!transcoded) {
+			transcoded = *transcoding_started = basist_transcoder_start_transcoding(tc);
 		}
 
-		out_pixmap->data_size = data_size;
-		out_pixmap->data.untyped = mem_alloc(out_pixmap->data_size);
-		param->output_blocks = out_pixmap->data.untyped;
-		param->output_blocks_size = size_info.num_blocks;
+		if(transcoded) {
+			out_pixmap->data_size = data_size;
+			out_pixmap->data.untyped = mem_alloc(out_pixmap->data_size);
+			param->output_blocks = out_pixmap->data.untyped;
+			param->output_blocks_size = size_info.num_blocks;
+
+			transcoded = basist_transcoder_transcode_image_level(tc, param);
+		}
 
-		TRY_BOOL(basist_transcoder_transcode_image_level, bld->tc, param);
+		if(transcoded) {
+			out_pixmap->format = bld->px_decode_format;
+			out_pixmap->width = level_desc.orig_width;
+			out_pixmap->height = level_desc.orig_height;
+		}
 
-		out_pixmap->format = bld->px_decode_format;
-		out_pixmap->width = level_desc.orig_width;
-		out_pixmap->height = level_desc.orig_height;
+		texture_loader_basisu_cache(bld->basis_hash, param, &level_desc, transcoded ? out_pixmap : NULL);
 
-		texture_loader_basisu_cache(bld->basis_hash, param, &level_desc, out_pixmap);
+		if(!transcoded) {
+			log_error("%s: Failed to transcode image %u level %u",
+				ctx, param->image_index, param->level_index
+			);
+			return false;
+		}
 	}
 
 	if(bld->is_uncompressed_fallback) {
@@ -705,6 +722,89 @@ static bool texture_loader_basisu_load_pixmap(
 	return true;
 }
 
+/*
+ * Every image level is loaded by a separate job, so that cache misses can be transcoded in
+ * parallel. Transcoders are not thread-safe; each job borrows the one of the thread it runs on.
+ */
+
+struct basisu_level_job {
+	struct basisu_load_data *bld;
+	TextureLoadData *ld;
+	Pixmap *out_pixmap;
+	basist_transcode_level_params param;
+	bool y_flipped;
+	bool ok;
+};
+
+static void *texture_loader_basisu_level_job(void *arg) {
+	struct basisu_level_job *job = arg;
+	struct basisu_load_data *bld = job->bld;
+	const char *ctx = job->ld->st->name;
+	basist_transcoder *tc = texture_loader_basisu_get_transcoder();
+
+	if(UNLIKELY(!tc)) {
+		return NULL;
+	}
+
+	if(tc == bld->tc) {
+		job->ok = texture_loader_basisu_load_pixmap(
+			ctx, bld, tc, &bld->transcoding_started, job->ld, &job->param, job->out_pixmap
+		);
+	} else {
+		assert(!basist_transcoder_get_ready_to_transcode(tc));
+		basist_transcoder_set_data(tc, (basist_data) { .data = bld->filebuf, .size = bld->filesize });
+
+		bool transcoding_started = false;
+		job->ok = texture_loader_basisu_load_pixmap(
+			ctx, bld, tc, &transcoding_started, job->ld, &job->param, job->out_pixmap
+		);
+
+		if(transcoding_started) {
+			basist_transcoder_stop_transcoding(tc);
+		}
+
+		basist_transcoder_set_data(tc, (basist_data) {});
+	}
+
+	if(job->ok && job->y_flipped) {
+		pixmap_flip_y_inplace(job->out_pixmap);
+	}
+
+	return NULL;
+}
+
+static bool texture_loader_basisu_run_level_jobs(uint num_jobs, struct basisu_level_job jobs[num_jobs]) {
+	assume(num_jobs >= 1);
+	Task *tasks[num_jobs];
+
+	for(uint i = 1; i < num_jobs; ++i) {
+		tasks[i] = taskmgr_global_submit((TaskParams) {
+			.callback = texture_loader_basisu_level_job,
+			.userdata = jobs + i,
+			.topmost = true,
+		});
+	}
+
+	// The first job is the base level (of the first face), which is the most expensive one.
+	// Run it here rather than idle while waiting.
+	texture_loader_basisu_level_job(jobs);
+	bool ok = jobs[0].ok;
+
+	for(uint i = 1; i < num_jobs; ++i) {
+		if(tasks[i]) {
+			if(!task_finish(tasks[i], NULL)) {
+				log_error("Internal error: basisu level job failed");
+			}
+		} else {
+			texture_loader_basisu_level_job(jobs + i);
+		}
+
+		ok = ok && jobs[i].ok;
+	}
+
+	return ok;
+}
+
 void texture_loader_basisu(TextureLoadData *ld) {
 	struct basisu_load_data bld = {};
 
@@ -724,8 +824,7 @@ void texture_loader_basisu(TextureLoadData *ld) {
 		return;
 	}
 
-	size_t filesize;
-	bld.filebuf = read_basis_file(rw_in, &filesize, sizeof(bld.basis_hash), bld.basis_hash);
+	bld.filebuf = read_basis_file(rw_in, &bld.filesize, sizeof(bld.basis_hash), bld.basis_hash);
 	SDL_CloseIO(rw_in);
 
 	if(UNLIKELY(!bld.filebuf)) {
@@ -736,7 +835,7 @@ void texture_loader_basisu(TextureLoadData *ld) {
 
 	assert(!basist_transcoder_get_ready_to_transcode(bld.tc));
 
-	basist_transcoder_set_data(bld.tc, (basist_data) { .data = bld.filebuf, .size = filesize });
+	basist_transcoder_set_data(bld.tc, (basist_data) { .data = bld.filebuf, .size = bld.filesize });
 	log_info("%s: Loaded Basis Universal data from %s", ctx, basis_file);
 
 	basist_file_info file_info = {};
@@ -884,38 +983,39 @@ void texture_loader_basisu(TextureLoadData *ld) {
 	bld.swizzle_supported = r_supports(RFEAT_TEXTURE_SWIZZLE);
 	bld.transcoding_started = false;
 
-	switch(ld->params.class) {
-		case TEXTURE_CLASS_2D: {
-			p.image_index = 0;
-			for(uint mip = 0; mip < ld->params.mipmaps; ++mip) {
-				p.level_index = mip + bld.mip_bias;
-				TRY_SILENT(texture_loader_basisu_load_pixmap, ctx, &bld, ld, &p, ld->pixmaps + mip);
-				if(file_info.y_flipped) {
-					pixmap_flip_y_inplace(ld->pixmaps + mip);
-				}
+	uint num_jobs = ld->num_pixmaps;
+	struct basisu_level_job jobs[num_jobs];
+	uint num_faces = ld->params.class == TEXTURE_CLASS_CUBEMAP ? 6 : 1;
+
+	for(uint face = 0; face < num_faces; ++face) {
+		for(uint mip = 0; mip < ld->params.mipmaps; ++mip) {
+			auto job = &jobs[face * ld->params.mipmaps + mip];
+			*job = (struct basisu_level_job) {
+				.bld = &bld,
+				.ld = ld,
+				.param = p,
+				.y_flipped = file_info.y_flipped,
+			};
+
+			job->param.image_index = face;
+			job->param.level_index = mip + bld.mip_bias;
+
+			switch(ld->params.class) {
+				case TEXTURE_CLASS_2D:
+					job->out_pixmap = ld->pixmaps + mip;
+					break;
+
+				case TEXTURE_CLASS_CUBEMAP:
+					job->out_pixmap = &ld->cubemaps[mip].faces[face];
+					break;
+
+				default: UNREACHABLE;
 			}
-
-			break;
 		}
-
-		case TEXTURE_CLASS_CUBEMAP:
-			for(int face = 0; face < 6; ++face) {
-				p.image_index = face;
-				for(uint mip = 0; mip < ld->params.mipmaps; ++mip) {
-					p.level_index = mip + bld.mip_bias;
-					Pixmap *px = &ld->cubemaps[mip].faces[face];
-					TRY_SILENT(texture_loader_basisu_load_pixmap, ctx, &bld, ld, &p, px);
-					if(file_info.y_flipped) {
-						pixmap_flip_y_inplace(px);
-					}
-				}
-			}
-
-			break;
-
-		default: UNREACHABLE;
 	}
 
+	TRY_SILENT(texture_loader_basisu_run_level_jobs, num_jobs, jobs);
+
 	if(bld.is_uncompressed_fallback && !bld.swizzle_supported) {
 		ld->params.swizzle = (SwizzleMask) { "rgba" };
 	}
@@ -9,20 +9,59 @@
 #include "basisu_cache.h"
 #include "basisu.h"
 
+#include "dynarray.h"
+#include "hashtable.h"
 #include "log.h"
+#include "memory/scratch.h"
 #include "pixmap/pixmap.h"
 #include "rwops/rwops_zstd.h"
+#include "thread.h"
+#include "util/env.h"
+#include "util/strbuf.h"
+#include "util/stringops.h"
 
 #include <basisu_transcoder_c_api.h>
 
-// FIXME: The cache is not atomic.
-// This may be a problem if multiple threads are loading identical .basis files,
-// or if multiple Taisei instances are running for some reason.
+/*
+ * Entries are written under a temporary name and renamed into place, so readers (including other instances of the
+ * game) never see partial files. Within the process, concurrent requests for the same level wait for the first one
+ * to finish transcoding instead of duplicating the work.
+ *
+ * Each source texture gets its own directory. The directories used during a session are stamped on shutdown, and the
+ * least recently used ones are evicted when the cache exceeds TAISEI_BASISU_CACHE_MAX_SIZE. The preprocessed texture
+ * cache (see preprocess.c) uses the same layout and shares the size limit.
+ */
+
+#define CACHE_DIR "cache/textures"
+#define CACHE_SUBDIR_PREFIX "basisu-"
+#define CACHE_PREPROCESSED_SUBDIR_PREFIX "preprocessed-"
+#define CACHE_STAMP_NAME "lastused"
 
 enum {
 	ENTRY_PATH_SIZE = 256,
+	DEFAULT_MAX_CACHE_SIZE_MB = 512,
 };
 
+static struct {
+	SDL_Mutex *mutex;
+	SDL_Condition *cond;
+	ht_str2int_t inflight;  // entry paths currently being transcoded
+	ht_str2int_t used;      // cache subdirectories used during this session
+} cache;
+
+void texture_loader_basisu_cache_init(void) {
+	if(!(cache.mutex = SDL_CreateMutex())) {
+		log_sdl_error(LOG_FATAL, "SDL_CreateMutex");
+	}
+
+	if(!(cache.cond = SDL_CreateCondition())) {
+		log_sdl_error(LOG_FATAL, "SDL_CreateCondition");
+	}
+
+	ht_create(&cache.inflight);
+	ht_create(&cache.used);
+}
+
 static bool texture_loader_basisu_make_cache_path(
 	const char *basisu_hash,
 	const basist_transcode_level_params *tc_params,
@@ -31,7 +70,7 @@ static bool texture_loader_basisu_make_cache_path(
 ) {
 	int len = snprintf(
 		buf, bufsize,
-		"cache/textures/basisu-%s/%u_%u_%s_%x",
+		CACHE_DIR "/" CACHE_SUBDIR_PREFIX "%s/%u_%u_%s_%x",
 		basisu_hash,
 		tc_params->image_index,
 		tc_params->level_index,
@@ -47,20 +86,13 @@ static bool texture_loader_basisu_make_cache_path(
 	return true;
 }
 
-bool texture_loader_basisu_load_cached(
-	const char *basisu_hash,
-	const basist_transcode_level_params *tc_params,
+static bool texture_loader_basisu_read_entry(
+	const char *path,
 	const basist_image_level_desc *level_desc,
 	PixmapFormat expected_px_format,
 	uint32_t expected_size,
 	Pixmap *out_pixmap
 ) {
-	char path[ENTRY_PATH_SIZE];
-
-	if(!texture_loader_basisu_make_cache_path(basisu_hash, tc_params, sizeof(path), path)) {
-		return false;
-	}
-
 	if(!vfs_query(path).exists) {
 		BASISU_DEBUG("%s not found", path);
 		return false;
@@ -69,7 +101,8 @@ bool texture_loader_basisu_load_cached(
 	SDL_IOStream *rw = vfs_open(path, VFS_MODE_READ);
 
 	if(!rw) {
-		log_error("VFS error: %s", vfs_get_error());
+		// May have been evicted by another instance in the meantime
+		log_warn("VFS error: %s", vfs_get_error());
 		return false;
 	}
 
@@ -80,7 +113,7 @@ bool texture_loader_basisu_load_cached(
 
 	if(!deserialize_ok) {
 		log_error("%s: Failed to deserialize cached pixmap", path);
-		return false;
+		goto bad_entry;
 	}
 
 	if(out_pixmap->format != expected_px_format) {
@@ -134,14 +167,30 @@ bool texture_loader_basisu_load_cached(
 bad_entry:
 	mem_free(out_pixmap->data.untyped);
 	out_pixmap->data.untyped = NULL;
+	// Will be replaced by the caller
+	vfs_delete(path);
 	return false;
 }
 
-bool texture_loader_basisu_cache(
+void texture_loader_cache_mark_used(const char *subdir) {
+	SDL_LockMutex(cache.mutex);
+	ht_set(&cache.used, subdir, 1);
+	SDL_UnlockMutex(cache.mutex);
+}
+
+static void texture_loader_basisu_wait_inflight(const char *path) {
+	while(ht_get(&cache.inflight, path, 0)) {
+		SDL_WaitCondition(cache.cond, cache.mutex);
+	}
+}
+
+bool texture_loader_basisu_load_cached(
 	const char *basisu_hash,
 	const basist_transcode_level_params *tc_params,
 	const basist_image_level_desc *level_desc,
-	const Pixmap *pixmap
+	PixmapFormat expected_px_format,
+	uint32_t expected_size,
+	Pixmap *out_pixmap
 ) {
 	char path[ENTRY_PATH_SIZE];
 
@@ -149,12 +198,50 @@ bool texture_loader_basisu_cache(
 		return false;
 	}
 
+	char subdir[ENTRY_PATH_SIZE];
+	snprintf(subdir, sizeof(subdir), CACHE_SUBDIR_PREFIX "%s", basisu_hash);
+	texture_loader_cache_mark_used(subdir);
+
+	SDL_LockMutex(cache.mutex);
+
+	for(;;) {
+		texture_loader_basisu_wait_inflight(path);
+		SDL_UnlockMutex(cache.mutex);
+
+		if(texture_loader_basisu_read_entry(path, level_desc, expected_px_format, expected_size, out_pixmap)) {
+			return true;
+		}
+
+		SDL_LockMutex(cache.mutex);
+
+		if(!ht_get(&cache.inflight, path, 0)) {
+			// Claim it; the caller has to transcode this level and call texture_loader_basisu_cache()
+			ht_set(&cache.inflight, path, 1);
+			SDL_UnlockMutex(cache.mutex);
+			return false;
+		}
+
+		// Someone else got to it first; wait for them and try again
+	}
+}
+
+static void texture_loader_basisu_release(const char *path) {
+	SDL_LockMutex(cache.mutex);
+	ht_unset(&cache.inflight, path);
+	SDL_BroadcastCondition(cache.cond);
+	SDL_UnlockMutex(cache.mutex);
+}
+
+static bool texture_loader_basisu_write_entry(const char *path, const Pixmap *pixmap) {
 	if(!vfs_mkparents(path)) {
 		log_error("VFS error: %s", vfs_get_error());
 		return false;
 	}
 
-	SDL_IOStream *rw = vfs_open(path, VFS_MODE_WRITE);
+	char tmp_path[ENTRY_PATH_SIZE + 32];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%llx.tmp", path, (unsigned long long)thread_get_current_id());
+
+	SDL_IOStream *rw = vfs_open(tmp_path, VFS_MODE_WRITE);
 
 	if(!rw) {
 		log_error("VFS error: %s", vfs_get_error());
@@ -166,14 +253,226 @@ bool texture_loader_basisu_cache(
 	PixmapSaveOptions opts = PIXMAP_DEFAULT_SAVE_OPTIONS;
 	opts.file_format = PIXMAP_FILEFORMAT_INTERNAL;
 	bool serialize_ok = pixmap_save_stream(rw, pixmap, &opts);
-	SDL_CloseIO(rw);
+	serialize_ok = SDL_CloseIO(rw) && serialize_ok;
 
 	if(!serialize_ok) {
-		log_error("%s: Failed to serialize pixmap", path);
+		log_error("%s: Failed to serialize pixmap", tmp_path);
+		vfs_delete(tmp_path);
 		return false;
 	}
 
-	BASISU_DEBUG("Cached pixmap at %s", path);
+	if(!vfs_rename(tmp_path, path)) {
+		log_error("VFS error: %s", vfs_get_error());
+		vfs_delete(tmp_path);
+		return false;
+	}
 
 	return true;
 }
+
+bool texture_loader_basisu_cache(
+	const char *basisu_hash,
+	const basist_transcode_level_params *tc_params,
+	const basist_image_level_desc *level_desc,
+	const Pixmap *pixmap
+) {
+	char path[ENTRY_PATH_SIZE];
+
+	if(!texture_loader_basisu_make_cache_path(basisu_hash, tc_params, sizeof(path), path)) {
+		return false;
+	}
+
+	bool ok = pixmap && texture_loader_basisu_write_entry(path, pixmap);
+	texture_loader_basisu_release(path);
+
+	if(ok) {
+		BASISU_DEBUG("Cached pixmap at %s", path);
+	}
+
+	return ok;
+}
+
+/*
+ * LRU eviction
+ */
+
+typedef struct CacheDirInfo {
+	char *name;
+	uint64_t size;
+	int64_t last_used;
+} CacheDirInfo;
+
+static void texture_loader_basisu_stamp_used(void) {
+	SDL_Time now;
+
+	if(!SDL_GetCurrentTime(&now)) {
+		log_sdl_error(LOG_WARN, "SDL_GetCurrentTime");
+		return;
+	}
+
+	StringBuffer buf = { acquire_scratch_arena() };
+
+	ht_str2int_iter_t iter;
+	ht_iter_begin(&cache.used, &iter);
+
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		strbuf_clear(&buf);
+		strbuf_printf(&buf, CACHE_DIR "/%s/" CACHE_STAMP_NAME, iter.key);
+
+		SDL_IOStream *rw = vfs_open(buf.start, VFS_MODE_WRITE);
+
+		if(!rw) {
+			continue;
+		}
+
+		SDL_WriteS64LE(rw, now);
+		SDL_CloseIO(rw);
+	}
+
+	ht_iter_end(&iter);
+	release_scratch_arena(buf.arena);
+}
+
+static bool texture_loader_basisu_scan_dir(CacheDirInfo *info, StringBuffer *pathbuf) {
+	strbuf_clear(pathbuf);
+	strbuf_printf(pathbuf, CACHE_DIR "/%s", info->name);
+	size_t dirpath_len = pathbuf->pos - pathbuf->start;
+
+	VFSDir *dir = vfs_dir_open(pathbuf->start);
+
+	if(!dir) {
+		return false;
+	}
+
+	const char *filename;
+
+	while((filename = vfs_dir_read(dir))) {
+		pathbuf->pos = pathbuf->start + dirpath_len;
+		strbuf_printf(pathbuf, "/%s", filename);
+
+		if(!strcmp(filename, CACHE_STAMP_NAME)) {
+			SDL_IOStream *rw = vfs_open(pathbuf->start, VFS_MODE_READ);
+
+			if(rw) {
+				SDL_ReadS64LE(rw, &info->last_used);
+				SDL_CloseIO(rw);
+			}
+		}
+
+		info->size += vfs_query(pathbuf->start).size;
+	}
+
+	vfs_dir_close(dir);
+	return true;
+}
+
+static void texture_loader_basisu_delete_dir(const char *name, StringBuffer *pathbuf) {
+	strbuf_clear(pathbuf);
+	strbuf_printf(pathbuf, CACHE_DIR "/%s", name);
+	char **files;
+	size_t num_files;
+
+	if((files = vfs_dir_list_sorted(pathbuf->start, &num_files, vfs_dir_list_order_ascending, NULL))) {
+		size_t dirpath_len = pathbuf->pos - pathbuf->start;
+
+		for(size_t i = 0; i < num_files; ++i) {
+			pathbuf->pos = pathbuf->start + dirpath_len;
+			strbuf_printf(pathbuf, "/%s", files[i]);
+			vfs_delete(pathbuf->start);
+		}
+
+		vfs_dir_list_free(files, num_files);
+		pathbuf->pos = pathbuf->start + dirpath_len;
+		*pathbuf->pos = 0;
+	}
+
+	if(!vfs_delete(pathbuf->start)) {
+		log_warn("VFS error: %s", vfs_get_error());
+	}
+}
+
+static int cache_dir_info_cmp_age(const void *a, const void *b) {
+	const CacheDirInfo *da = a, *db = b;
+	return (da->last_used > db->last_used) - (da->last_used < db->last_used);
+}
+
+static void texture_loader_basisu_evict(void) {
+	int64_t max_size_mb = env_get("TAISEI_BASISU_CACHE_MAX_SIZE", DEFAULT_MAX_CACHE_SIZE_MB);
+
+	if(max_size_mb <= 0) {
+		return;
+	}
+
+	uint64_t max_size = (uint64_t)max_size_mb << 20;
+
+	VFSDir *dir = vfs_dir_open(CACHE_DIR);
+
+	if(!dir) {
+		return;
+	}
+
+	DYNAMIC_ARRAY(CacheDirInfo) dirs = {};
+	const char *name;
+
+	while((name = vfs_dir_read(dir))) {
+		if(
+			strstartswith(name, CACHE_SUBDIR_PREFIX) ||
+			strstartswith(name, CACHE_PREPROCESSED_SUBDIR_PREFIX)
+		) {
+			dynarray_append(&dirs, { .name = mem_strdup(name) });
+		}
+	}
+
+	vfs_dir_close(dir);
+
+	StringBuffer pathbuf = { acquire_scratch_arena() };
+	uint64_t total_size = 0;
+
+	dynarray_foreach_elem(&dirs, CacheDirInfo *d, {
+		texture_loader_basisu_scan_dir(d, &pathbuf);
+		total_size += d->size;
+	});
+
+	if(total_size > max_size) {
+		// Directories without a stamp sort first, so entries left over by old versions go first
+		dynarray_qsort(&dirs, cache_dir_info_cmp_age);
+		uint num_evicted = 0;
+		uint64_t evicted_size = 0;
+
+		dynarray_foreach_elem(&dirs, CacheDirInfo *d, {
+			if(total_size - evicted_size <= max_size) {
+				break;
+			}
+
+			texture_loader_basisu_delete_dir(d->name, &pathbuf);
+			evicted_size += d->size;
+			++num_evicted;
+		});
+
+		log_info("Evicted %u texture cache entries (%"PRIu64" KiB); %"PRIu64" KiB remain",
+			num_evicted, evicted_size >> 10, (total_size - evicted_size) >> 10);
+	}
+
+	release_scratch_arena(pathbuf.arena);
+
+	dynarray_foreach_elem(&dirs, CacheDirInfo *d, {
+		mem_free(d->name);
+	});
+
+	dynarray_free_data(&dirs);
+}
+
+void texture_loader_basisu_cache_shutdown(void) {
+	if(!cache.mutex) {
+		return;
+	}
+
+	texture_loader_basisu_stamp_used();
+	texture_loader_basisu_evict();
+
+	ht_destroy(&cache.inflight);
+	ht_destroy(&cache.used);
+	SDL_DestroyCondition(cache.cond);
+	SDL_DestroyMutex(cache.mutex);
+	cache = (typeof(cache)) {};
+}
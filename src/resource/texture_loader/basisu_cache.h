@@ -13,6 +13,15 @@
 
 #include <basisu_transcoder_c_api.h>
 
+void texture_loader_basisu_cache_init(void);
+void texture_loader_basisu_cache_shutdown(void);
+
+// Marks a subdirectory of cache/textures as used during this session, for the LRU eviction on shutdown.
+// Only the basisu- and preprocessed- subdirectories are ever evicted.
+void texture_loader_cache_mark_used(const char *subdir) attr_nonnull_all;
+
+// On a miss, the entry is claimed by the caller: other threads requesting it will block until
+// texture_loader_basisu_cache() is called for it, which must happen even if transcoding fails.
 bool texture_loader_basisu_load_cached(
 	const char *basisu_hash,
 	const basist_transcode_level_params *tc_params,
@@ -22,9 +31,11 @@ bool texture_loader_basisu_load_cached(
 	Pixmap *out_pixmap
 ) attr_nonnull_all attr_nodiscard;
 
+// Writes the entry claimed by a failed texture_loader_basisu_load_cached() call and releases it.
+// Pass pixmap=NULL to release it without writing anything.
 bool texture_loader_basisu_cache(
 	const char *basisu_hash,
 	const basist_transcode_level_params *tc_params,
 	const basist_image_level_desc *level_desc,
 	const Pixmap *pixmap
-) attr_nonnull_all;
+) attr_nonnull(1, 2, 3);
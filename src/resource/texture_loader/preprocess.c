@@ -0,0 +1,548 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "preprocess.h"
+
+#include "basisu_cache.h"
+#include "log.h"
+#include "rwops/rwops_zstd.h"
+#include "thread.h"
+#include "util/env.h"
+#include "util/miscmath.h"
+#include "util/stringops.h"
+#include "vfs/public.h"
+
+// One directory per entry, so that the basisu cache's LRU eviction can manage these too
+#define PREPROCESS_CACHE_DIR "cache/textures/"
+#define PREPROCESS_CACHE_SUBDIR_PREFIX "preprocessed-"
+#define PREPROCESS_CACHE_ENTRY_NAME "texture"
+// Marks a source that turned out to need no preprocessing
+#define PREPROCESS_CACHE_SKIP_ENTRY_NAME "none"
+#define PREPROCESS_CACHE_VERSION 2
+
+enum {
+	ENTRY_PATH_SIZE = sizeof(PREPROCESS_CACHE_DIR PREPROCESS_CACHE_SUBDIR_PREFIX PREPROCESS_CACHE_ENTRY_NAME) +
+		TEXTURE_PREPROCESS_CACHE_KEY_SIZE + 32,
+};
+
+typedef struct PreprocessParams {
+	uint num_channels;
+	uint num_color_channels;
+	bool srgb_roundtrip;  // sRGB texture: the shader sees (and writes) linear values
+	bool linearize;
+	bool multiply_alpha;
+	const Pixmap *alphamap;
+	const uint32_t *alphamap_columns;
+} PreprocessParams;
+
+bool texture_loader_cpu_preprocess_enabled(void) {
+	return !env_get("TAISEI_TEXTURE_GPU_PREPROCESS", false);
+}
+
+/*
+ * Pixel processing
+ */
+
+// Same as in shader/lib/util.glslh
+static float srgb_to_linear(float c) {
+	if(c <= 0.04045f) {
+		return c / 12.92f;
+	}
+
+	return powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linear_to_srgb(float c) {
+	if(c <= 0.0031308f) {
+		return 12.92f * c;
+	}
+
+	return 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+}
+
+// round(a * b / 255), exact for all 8-bit inputs
+INLINE uint8_t mul_unorm8(uint a, uint b) {
+	uint t = a * b + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+static bool is_format_supported(PixmapFormat fmt) {
+	if(PIXMAP_FORMAT_IS_COMPRESSED(fmt)) {
+		return false;
+	}
+
+	uint depth = PIXMAP_FORMAT_DEPTH(fmt);
+
+	if(PIXMAP_FORMAT_IS_FLOAT(fmt)) {
+		return depth == 32;
+	}
+
+	return depth == 8 || depth == 16;
+}
+
+static float alphamap_value(const Pixmap *am, uint32_t row, uint32_t col) {
+	size_t i = (size_t)row * am->width + col;
+
+	if(am->format == PIXMAP_FORMAT_R8) {
+		return am->data.r8[i].r * (1.0f / UINT8_MAX);
+	}
+
+	return am->data.r16[i].r * (1.0f / UINT16_MAX);
+}
+
+// Fast path for the common case: premultiplied alpha in an RGBA8 texture, without colorspace conversion
+static void preprocess_rgba8_premultiply(Pixmap *px, const PreprocessParams *p) {
+	PixelRGBA8 *restrict data = px->data.rgba8;
+
+	for(uint32_t y = 0; y < px->height; ++y) {
+		PixelRGBA8 *restrict row = data + (size_t)y * px->width;
+
+		for(uint32_t x = 0; x < px->width; ++x) {
+			uint a = row[x].a;
+			row[x].r = mul_unorm8(row[x].r, a);
+			row[x].g = mul_unorm8(row[x].g, a);
+			row[x].b = mul_unorm8(row[x].b, a);
+		}
+
+		if(p->alphamap && p->alphamap->format == PIXMAP_FORMAT_R8) {
+			uint32_t arow = ((2 * y + 1) * (uint64_t)p->alphamap->height) / (2 * px->height);
+			const PixelR8 *restrict amrow = p->alphamap->data.r8 + (size_t)arow * p->alphamap->width;
+
+			for(uint32_t x = 0; x < px->width; ++x) {
+				row[x].a = mul_unorm8(row[x].a, amrow[p->alphamap_columns[x]].r);
+			}
+		} else if(p->alphamap) {
+			uint32_t arow = ((2 * y + 1) * (uint64_t)p->alphamap->height) / (2 * px->height);
+
+			for(uint32_t x = 0; x < px->width; ++x) {
+				float a = row[x].a * alphamap_value(p->alphamap, arow, p->alphamap_columns[x]);
+				row[x].a = (uint8_t)(a + 0.5f);
+			}
+		}
+	}
+}
+
+static void decode_row(const void *src, PixmapFormat fmt, size_t num_values, float *restrict dst) {
+	switch(PIXMAP_FORMAT_DEPTH(fmt)) {
+		case 16: {
+			const uint16_t *restrict s = src;
+			for(size_t i = 0; i < num_values; ++i) {
+				dst[i] = s[i] * (1.0f / UINT16_MAX);
+			}
+			break;
+		}
+
+		case 32:
+			memcpy(dst, src, num_values * sizeof(*dst));
+			break;
+
+		default: UNREACHABLE;
+	}
+}
+
+static void encode_row(const float *restrict src, PixmapFormat fmt, size_t num_values, void *dst) {
+	switch(PIXMAP_FORMAT_DEPTH(fmt)) {
+		case 8: {
+			uint8_t *restrict d = dst;
+			for(size_t i = 0; i < num_values; ++i) {
+				d[i] = (uint8_t)(clamp(src[i], 0.0f, 1.0f) * UINT8_MAX + 0.5f);
+			}
+			break;
+		}
+
+		case 16: {
+			uint16_t *restrict d = dst;
+			for(size_t i = 0; i < num_values; ++i) {
+				d[i] = (uint16_t)(clamp(src[i], 0.0f, 1.0f) * UINT16_MAX + 0.5f);
+			}
+			break;
+		}
+
+		case 32:
+			memcpy(dst, src, num_values * sizeof(*src));
+			break;
+
+		default: UNREACHABLE;
+	}
+}
+
+static void preprocess_generic(Pixmap *px, const PreprocessParams *p) {
+	uint nc = p->num_channels;
+	uint ncolor = p->num_color_channels;
+	size_t row_values = (size_t)px->width * nc;
+	size_t row_size = row_values * PIXMAP_FORMAT_DEPTH(px->format) / 8;
+	bool decode_srgb = p->linearize || p->srgb_roundtrip;
+
+	// Per-channel decoding tables for 8-bit data, so that the sRGB curve doesn't have to be evaluated per pixel
+	float lut8_color[256], lut8_alpha[256];
+
+	if(PIXMAP_FORMAT_DEPTH(px->format) == 8) {
+		for(uint i = 0; i < ARRAY_SIZE(lut8_color); ++i) {
+			lut8_alpha[i] = i * (1.0f / UINT8_MAX);
+			lut8_color[i] = decode_srgb ? srgb_to_linear(lut8_alpha[i]) : lut8_alpha[i];
+		}
+	}
+
+	auto row = ALLOC_ARRAY(row_values, float);
+
+	for(uint32_t y = 0; y < px->height; ++y) {
+		void *data = (char*)px->data.untyped + y * row_size;
+
+		if(PIXMAP_FORMAT_DEPTH(px->format) == 8) {
+			const uint8_t *restrict src = data;
+
+			for(size_t i = 0; i < row_values; ++i) {
+				row[i] = (i % nc < ncolor ? lut8_color : lut8_alpha)[src[i]];
+			}
+		} else {
+			decode_row(data, px->format, row_values, row);
+
+			if(decode_srgb) {
+				for(size_t i = 0; i < row_values; ++i) {
+					if(i % nc < ncolor) {
+						row[i] = srgb_to_linear(row[i]);
+					}
+				}
+			}
+		}
+
+		if(p->multiply_alpha) {
+			assert(nc == 4);
+
+			for(uint32_t x = 0; x < px->width; ++x) {
+				float *restrict pixel = row + x * 4;
+				pixel[0] *= pixel[3];
+				pixel[1] *= pixel[3];
+				pixel[2] *= pixel[3];
+			}
+		}
+
+		if(p->alphamap && nc == 4) {
+			uint32_t arow = ((2 * y + 1) * (uint64_t)p->alphamap->height) / (2 * px->height);
+
+			for(uint32_t x = 0; x < px->width; ++x) {
+				row[x * 4 + 3] *= alphamap_value(p->alphamap, arow, p->alphamap_columns[x]);
+			}
+		}
+
+		if(p->srgb_roundtrip) {
+			for(uint32_t x = 0; x < px->width; ++x) {
+				float *restrict pixel = row + x * nc;
+
+				for(uint c = 0; c < ncolor; ++c) {
+					pixel[c] = linear_to_srgb(pixel[c]);
+				}
+			}
+		}
+
+		encode_row(row, px->format, row_values, data);
+	}
+
+	mem_free(row);
+}
+
+bool texture_loader_preprocess_pixmaps(TextureLoadData *ld) {
+	if(
+		ld->params.class != TEXTURE_CLASS_2D ||
+		ld->num_pixmaps != 1 ||
+		!is_format_supported(ld->pixmaps->format)
+	) {
+		return false;
+	}
+
+	Pixmap *px = ld->pixmaps;
+	Pixmap *am = ld->preprocess.apply_alphamap ? &ld->alphamap : NULL;
+
+	if(am && am->format != PIXMAP_FORMAT_R8 && am->format != PIXMAP_FORMAT_R16) {
+		return false;
+	}
+
+	uint nc = pixmap_format_layout(px->format);
+
+	PreprocessParams p = {
+		.num_channels = nc,
+		.num_color_channels = min(nc, 3),
+		// On an sRGB texture, the shader would have premultiplied in linear space
+		.srgb_roundtrip = (ld->params.flags & TEX_FLAG_SRGB) && ld->preprocess.multiply_alpha && nc == 4,
+		.linearize = ld->preprocess.linearize,
+		.multiply_alpha = ld->preprocess.multiply_alpha && nc == 4,
+		.alphamap = am,
+	};
+
+	uint32_t *columns = NULL;
+
+	if(am) {
+		// Nearest-neighbor sampling at the pixel centers, like the shader does
+		columns = ALLOC_ARRAY(px->width, uint32_t);
+
+		for(uint32_t x = 0; x < px->width; ++x) {
+			columns[x] = ((2 * x + 1) * (uint64_t)am->width) / (2 * px->width);
+		}
+
+		p.alphamap_columns = columns;
+	}
+
+	if(
+		px->format == PIXMAP_FORMAT_RGBA8 &&
+		p.multiply_alpha &&
+		!p.linearize &&
+		!p.srgb_roundtrip
+	) {
+		preprocess_rgba8_premultiply(px, &p);
+	} else {
+		preprocess_generic(px, &p);
+	}
+
+	mem_free(columns);
+	mem_free(ld->alphamap.data.untyped);
+	ld->alphamap.data.untyped = NULL;
+	ld->preprocess = (typeof(ld->preprocess)) {};
+
+	return true;
+}
+
+/*
+ * Cache
+ */
+
+static void make_entry_path(const char *key, const char *entry_name, char path[ENTRY_PATH_SIZE]) {
+	snprintf(path, ENTRY_PATH_SIZE, PREPROCESS_CACHE_DIR PREPROCESS_CACHE_SUBDIR_PREFIX "%s/%s", key, entry_name);
+}
+
+// Keeps the entry from being evicted on shutdown. Only done for entries that exist.
+static void mark_entry_used(const char *key) {
+	char subdir[ENTRY_PATH_SIZE];
+	snprintf(subdir, sizeof(subdir), PREPROCESS_CACHE_SUBDIR_PREFIX "%s", key);
+	texture_loader_cache_mark_used(subdir);
+}
+
+// Which uncompressed formats the renderer can sample as sRGB. This decides whether an sRGB texture is
+// linearized on load (see texture_loader_try_set_texture_type), and whether alpha is premultiplied in linear space.
+static uint native_srgb_formats(TextureFlags flags) {
+	if(!(flags & TEX_FLAG_SRGB)) {
+		return 0;
+	}
+
+	static const PixmapFormat formats[] = {
+		PIXMAP_FORMAT_R8,  PIXMAP_FORMAT_RG8,  PIXMAP_FORMAT_RGB8,  PIXMAP_FORMAT_RGBA8,
+		PIXMAP_FORMAT_R16, PIXMAP_FORMAT_RG16, PIXMAP_FORMAT_RGB16, PIXMAP_FORMAT_RGBA16,
+	};
+
+	uint mask = 0;
+
+	for(uint i = 0; i < ARRAY_SIZE(formats); ++i) {
+		TextureTypeQueryResult qr;
+
+		if(r_texture_type_query(r_texture_type_from_pixmap_format(formats[i]), flags, formats[i], &qr)) {
+			mask |= 1u << i;
+		}
+	}
+
+	return mask;
+}
+
+bool texture_loader_preprocess_possible(TextureLoadData *ld) {
+	if(ld->params.class != TEXTURE_CLASS_2D) {
+		return false;
+	}
+
+	if(ld->src_paths.alphamap || (ld->params.flags & TEX_FLAG_SRGB)) {
+		return true;
+	}
+
+	if(!ld->preprocess.multiply_alpha) {
+		return false;
+	}
+
+	// Without an explicit format, whether there's an alpha channel to premultiply depends on the source
+	return !ld->preferred_format || pixmap_format_layout(ld->preferred_format) == PIXMAP_LAYOUT_RGBA;
+}
+
+// Everything besides the source data that may affect the result.
+// Whether the chosen texture type is still supported is validated when loading the entry.
+static void hash_load_params(TextureLoadData *ld, SHA256State *sha256) {
+	char params[128];
+	int len = snprintf(params, sizeof(params), "%d:%s:%x:%x:%x:%d:%d",
+		PREPROCESS_CACHE_VERSION,
+		r_backend_name(),
+		ld->preferred_format,
+		ld->params.flags,
+		native_srgb_formats(ld->params.flags),
+		ld->preprocess.multiply_alpha,
+		ld->src_paths.alphamap != NULL
+	);
+	assert(len > 0 && len < sizeof(params));
+	sha256_update(sha256, (uint8_t*)params, len);
+}
+
+static void finalize_key(SHA256State *sha256, char key[TEXTURE_PREPROCESS_CACHE_KEY_SIZE]) {
+	uint8_t raw_hash[SHA256_BLOCK_SIZE];
+	sha256_final(sha256, raw_hash, sizeof(raw_hash));
+	hexdigest(raw_hash, sizeof(raw_hash), key, TEXTURE_PREPROCESS_CACHE_KEY_SIZE);
+}
+
+void texture_loader_preprocess_cache_key(
+	TextureLoadData *ld,
+	SHA256State *sha256,
+	char key[TEXTURE_PREPROCESS_CACHE_KEY_SIZE]
+) {
+	hash_load_params(ld, sha256);
+	finalize_key(sha256, key);
+}
+
+void texture_loader_preprocess_skip_key(
+	TextureLoadData *ld,
+	int64_t source_size,
+	char key[TEXTURE_PREPROCESS_CACHE_KEY_SIZE]
+) {
+	SHA256State *sha256 = sha256_new();
+	char source[64];
+	int len = snprintf(source, sizeof(source), "skip:%lli:", (long long)source_size);
+	assert(len > 0 && len < sizeof(source));
+	sha256_update(sha256, (uint8_t*)source, len);
+	sha256_update(sha256, (uint8_t*)ld->src_paths.main, strlen(ld->src_paths.main));
+	hash_load_params(ld, sha256);
+	finalize_key(sha256, key);
+	sha256_free(sha256);
+}
+
+bool texture_loader_preprocess_load_skip(const char *key) {
+	char path[ENTRY_PATH_SIZE];
+	make_entry_path(key, PREPROCESS_CACHE_SKIP_ENTRY_NAME, path);
+
+	if(!vfs_query(path).exists) {
+		return false;
+	}
+
+	mark_entry_used(key);
+	return true;
+}
+
+bool texture_loader_preprocess_cache_skip(TextureLoadData *ld, const char *key) {
+	char path[ENTRY_PATH_SIZE];
+	make_entry_path(key, PREPROCESS_CACHE_SKIP_ENTRY_NAME, path);
+
+	if(!vfs_mkparents(path)) {
+		log_error("VFS error: %s", vfs_get_error());
+		return false;
+	}
+
+	// Only its existence matters, so a partially written entry is fine
+	SDL_IOStream *rw = vfs_open(path, VFS_MODE_WRITE);
+
+	if(!rw || !SDL_CloseIO(rw)) {
+		log_error("VFS error: %s", vfs_get_error());
+		return false;
+	}
+
+	mark_entry_used(key);
+	log_debug("%s: Recorded that the texture needs no preprocessing at %s", ld->st->name, path);
+	return true;
+}
+
+bool texture_loader_preprocess_load_cached(TextureLoadData *ld, const char *key) {
+	char path[ENTRY_PATH_SIZE];
+	make_entry_path(key, PREPROCESS_CACHE_ENTRY_NAME, path);
+
+	if(!vfs_query(path).exists) {
+		return false;
+	}
+
+	SDL_IOStream *rw = vfs_open(path, VFS_MODE_READ);
+
+	if(!rw) {
+		log_error("VFS error: %s", vfs_get_error());
+		return false;
+	}
+
+	rw = SDL_RWWrapZstdReader(rw, -1, true);
+
+	uint32_t type, flags;
+	Pixmap px = {};
+
+	bool deserialize_ok =
+		SDL_ReadU32LE(rw, &type) &&
+		SDL_ReadU32LE(rw, &flags) &&
+		pixmap_load_stream(rw, PIXMAP_FILEFORMAT_INTERNAL, &px, 0);
+	SDL_CloseIO(rw);
+
+	if(!deserialize_ok) {
+		log_error("%s: Failed to deserialize cached pixmap", path);
+		mem_free(px.data.untyped);
+		return false;
+	}
+
+	TextureTypeQueryResult qr;
+
+	if(
+		!r_texture_type_query(type, flags, px.format, &qr) ||
+		qr.optimal_pixmap_format != px.format
+	) {
+		log_debug("%s: Cache entry not usable with this renderer", path);
+		mem_free(px.data.untyped);
+		return false;
+	}
+
+	ld->params.type = type;
+	ld->params.flags = flags;
+	ld->params.width = px.width;
+	ld->params.height = px.height;
+	ld->preferred_format = px.format;
+	ld->preprocess = (typeof(ld->preprocess)) {};
+	*ld->pixmaps = px;
+
+	mark_entry_used(key);
+	log_debug("%s: Loaded preprocessed texture from %s", ld->st->name, path);
+	return true;
+}
+
+bool texture_loader_preprocess_cache(TextureLoadData *ld, const char *key) {
+	char path[ENTRY_PATH_SIZE], tmp_path[ENTRY_PATH_SIZE];
+	make_entry_path(key, PREPROCESS_CACHE_ENTRY_NAME, path);
+	// Written under a temporary name first, so that a concurrent reader never sees a partial entry
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%llx.tmp", path, (unsigned long long)thread_get_current_id());
+
+	if(!vfs_mkparents(path)) {
+		log_error("VFS error: %s", vfs_get_error());
+		return false;
+	}
+
+	SDL_IOStream *rw = vfs_open(tmp_path, VFS_MODE_WRITE);
+
+	if(!rw) {
+		log_error("VFS error: %s", vfs_get_error());
+		return false;
+	}
+
+	rw = SDL_RWWrapZstdWriter(rw, RW_ZSTD_LEVEL_DEFAULT, true);
+
+	PixmapSaveOptions opts = PIXMAP_DEFAULT_SAVE_OPTIONS;
+	opts.file_format = PIXMAP_FILEFORMAT_INTERNAL;
+
+	bool serialize_ok =
+		SDL_WriteU32LE(rw, ld->params.type) &&
+		SDL_WriteU32LE(rw, ld->params.flags) &&
+		pixmap_save_stream(rw, ld->pixmaps, &opts);
+	serialize_ok = SDL_CloseIO(rw) && serialize_ok;
+
+	if(!serialize_ok) {
+		log_error("%s: Failed to serialize pixmap", tmp_path);
+		vfs_delete(tmp_path);
+		return false;
+	}
+
+	if(!vfs_rename(tmp_path, path)) {
+		log_error("VFS error: %s", vfs_get_error());
+		vfs_delete(tmp_path);
+		return false;
+	}
+
+	mark_entry_used(key);
+	log_debug("%s: Cached preprocessed texture at %s", ld->st->name, path);
+	return true;
+}
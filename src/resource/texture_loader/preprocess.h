@@ -0,0 +1,69 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "texture_loader.h"
+#include "util/sha256.h"
+
+/*
+ * CPU implementation of the texture_post_load shader (linearization, alpha premultiplication,
+ * alphamap application), run in the async load stage instead of rendering the texture into a
+ * new one on the main thread.
+ *
+ * Results can be cached in storage, keyed by the source file contents and load parameters, so
+ * that later loads can skip both decoding and preprocessing. Sources that turn out to need no
+ * preprocessing get an empty entry keyed by their path and size instead, so that later loads
+ * don't hash them at all. A stale one only costs a missed caching opportunity, since whether
+ * preprocessing is needed is still decided after decoding.
+ */
+
+enum {
+	TEXTURE_PREPROCESS_CACHE_KEY_SIZE = SHA256_HEXDIGEST_SIZE,
+};
+
+typedef struct TexturePreprocessCacheKeys {
+	char skip[TEXTURE_PREPROCESS_CACHE_KEY_SIZE];    // from the main source's path and size
+	char result[TEXTURE_PREPROCESS_CACHE_KEY_SIZE];  // from the source contents
+} TexturePreprocessCacheKeys;
+
+// False if TAISEI_TEXTURE_GPU_PREPROCESS is set.
+bool texture_loader_cpu_preprocess_enabled(void);
+
+// Whether a texture with these load parameters may need preprocessing, decided before loading anything.
+// If not, the cache doesn't need to be consulted.
+bool texture_loader_preprocess_possible(TextureLoadData *ld) attr_nonnull_all;
+
+// Applies ld->preprocess to ld->pixmaps[0] and clears it.
+// Returns false and leaves ld untouched if the formats are not supported; the GPU path must be used then.
+bool texture_loader_preprocess_pixmaps(TextureLoadData *ld) attr_nonnull_all attr_nodiscard;
+
+// Finalizes sha256 (which must have been fed the source file contents) into a cache key.
+// Must be called before any of the load parameters are adjusted for the renderer.
+void texture_loader_preprocess_cache_key(
+	TextureLoadData *ld,
+	SHA256State *sha256,
+	char key[TEXTURE_PREPROCESS_CACHE_KEY_SIZE]
+) attr_nonnull_all;
+
+// Like texture_loader_preprocess_cache_key, but from the size of the main source file instead of its contents.
+void texture_loader_preprocess_skip_key(
+	TextureLoadData *ld,
+	int64_t source_size,
+	char key[TEXTURE_PREPROCESS_CACHE_KEY_SIZE]
+) attr_nonnull_all;
+
+// Whether the source has been found to need no preprocessing before.
+bool texture_loader_preprocess_load_skip(const char *key) attr_nonnull_all;
+bool texture_loader_preprocess_cache_skip(TextureLoadData *ld, const char *key) attr_nonnull_all;
+
+// On success, ld->pixmaps[0] and ld->params are set up for a direct upload.
+bool texture_loader_preprocess_load_cached(TextureLoadData *ld, const char *key) attr_nonnull_all attr_nodiscard;
+
+bool texture_loader_preprocess_cache(TextureLoadData *ld, const char *key) attr_nonnull_all;
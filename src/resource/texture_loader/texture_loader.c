@@ -8,7 +8,10 @@
 
 #include "texture_loader.h"
 #include "basisu.h"
+#include "basisu_cache.h"
+#include "preprocess.h"
 
+#include "rwops/rwops_sha256.h"
 #include "util.h"
 #include "util/io.h"
 #include "util/kvparser.h"
@@ -71,6 +74,14 @@ char *texture_loader_path(const char *basename) {
 	return texture_loader_source_path(basename);
 }
 
+void texture_loader_init(void) {
+	texture_loader_basisu_cache_init();
+}
+
+void texture_loader_shutdown(void) {
+	texture_loader_basisu_cache_shutdown();
+}
+
 bool texture_loader_check_path(const char *path) {
 	return
 		strendswith(path, TEX_EXTENSION) ||
@@ -474,6 +485,151 @@ static bool load_pixmap(
 	return result;
 }
 
+static void *read_stream(SDL_IOStream *stream, size_t *out_size, SHA256State *sha256) {
+	if(sha256 && UNLIKELY(!(stream = SDL_RWWrapSHA256(stream, sha256, true)))) {
+		log_sdl_error(LOG_ERROR, "SDL_RWWrapSHA256");
+		return NULL;
+	}
+
+	void *buf = SDL_LoadFile_IO(stream, out_size, true);
+
+	if(UNLIKELY(!buf)) {
+		log_sdl_error(LOG_ERROR, "SDL_LoadFile_IO");
+	}
+
+	return buf;
+}
+
+static void *read_source_file(TextureLoadData *ld, const char *path, size_t *out_size, SHA256State *sha256) {
+	SDL_IOStream *stream = res_open_file(ld->st, path, VFS_MODE_READ);
+
+	if(UNLIKELY(!stream)) {
+		log_error("VFS error: %s", vfs_get_error());
+		return NULL;
+	}
+
+	return read_stream(stream, out_size, sha256);
+}
+
+static bool decode_pixmap(const void *buf, size_t size, Pixmap *dst, PixmapFormat preferred_format) {
+	SDL_IOStream *stream = SDL_IOFromConstMem(buf, size);
+
+	if(UNLIKELY(!stream)) {
+		log_sdl_error(LOG_ERROR, "SDL_IOFromConstMem");
+		return false;
+	}
+
+	bool result = pixmap_load_stream(stream, PIXMAP_FILEFORMAT_AUTO, dst, preferred_format);
+	SDL_CloseIO(stream);
+	return result;
+}
+
+typedef enum PreprocessCacheStatus {
+	PREPROCESS_CACHE_UNUSED,  // not consulted, or the source is known to need no preprocessing
+	PREPROCESS_CACHE_MISS,    // the keys are valid; the result should be stored
+	PREPROCESS_CACHE_HIT,     // ld holds the preprocessed texture
+} PreprocessCacheStatus;
+
+// Decodes the source files directly, without reading them into memory first
+static bool texture_loader_decode_pixmaps_2d(TextureLoadData *ld, SDL_IOStream *main_stream) {
+	ResourceLoadState *st = ld->st;
+	bool ok = pixmap_load_stream(main_stream, PIXMAP_FILEFORMAT_AUTO, ld->pixmaps, ld->preferred_format);
+	SDL_CloseIO(main_stream);
+
+	if(!ok) {
+		log_error("%s: Couldn't load texture image %s", st->name, ld->src_paths.main);
+		return false;
+	}
+
+	if(ld->src_paths.alphamap && !load_pixmap(ld, ld->src_paths.alphamap, &ld->alphamap, PIXMAP_FORMAT_R8)) {
+		log_error("%s: Couldn't load texture alphamap %s", st->name, ld->src_paths.alphamap);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Loads the main image and the alphamap of a 2D texture into ld.
+ * If cache_keys is not NULL, the preprocessed texture cache is tried first. Unless the source is known to need
+ * no preprocessing, its files are hashed to compute the keys; on a hit, nothing is decoded.
+ */
+static bool texture_loader_load_pixmaps_2d(
+	TextureLoadData *ld, TexturePreprocessCacheKeys *cache_keys, PreprocessCacheStatus *out_status
+) {
+	ResourceLoadState *st = ld->st;
+	SHA256State *sha256 = NULL;
+	void *main_buf = NULL, *alphamap_buf = NULL;
+	size_t main_size, alphamap_size;
+	bool ok = false;
+
+	*out_status = PREPROCESS_CACHE_UNUSED;
+
+	SDL_IOStream *main_stream = res_open_file(st, ld->src_paths.main, VFS_MODE_READ);
+
+	if(UNLIKELY(!main_stream)) {
+		log_error("VFS error: %s", vfs_get_error());
+		log_error("%s: Couldn't read texture image %s", st->name, ld->src_paths.main);
+		return false;
+	}
+
+	if(cache_keys) {
+		texture_loader_preprocess_skip_key(ld, SDL_GetIOSize(main_stream), cache_keys->skip);
+
+		// With an alphamap there's always something to do, so there's no point in looking
+		if(!ld->src_paths.alphamap && texture_loader_preprocess_load_skip(cache_keys->skip)) {
+			cache_keys = NULL;
+		}
+	}
+
+	if(!cache_keys) {
+		return texture_loader_decode_pixmaps_2d(ld, main_stream);
+	}
+
+	sha256 = sha256_new();
+
+	if(!(main_buf = read_stream(main_stream, &main_size, sha256))) {
+		log_error("%s: Couldn't read texture image %s", st->name, ld->src_paths.main);
+		goto done;
+	}
+
+	if(
+		ld->src_paths.alphamap &&
+		!(alphamap_buf = read_source_file(ld, ld->src_paths.alphamap, &alphamap_size, sha256))
+	) {
+		log_error("%s: Couldn't read texture alphamap %s", st->name, ld->src_paths.alphamap);
+		goto done;
+	}
+
+	texture_loader_preprocess_cache_key(ld, sha256, cache_keys->result);
+
+	if(texture_loader_preprocess_load_cached(ld, cache_keys->result)) {
+		*out_status = PREPROCESS_CACHE_HIT;
+		ok = true;
+		goto done;
+	}
+
+	*out_status = PREPROCESS_CACHE_MISS;
+
+	if(!decode_pixmap(main_buf, main_size, ld->pixmaps, ld->preferred_format)) {
+		log_error("%s: Couldn't load texture image %s", st->name, ld->src_paths.main);
+		goto done;
+	}
+
+	if(alphamap_buf && !decode_pixmap(alphamap_buf, alphamap_size, &ld->alphamap, PIXMAP_FORMAT_R8)) {
+		log_error("%s: Couldn't load texture alphamap %s", st->name, ld->src_paths.alphamap);
+		goto done;
+	}
+
+	ok = true;
+
+done:
+	sha256_free(sha256);
+	mem_free(main_buf);
+	mem_free(alphamap_buf);
+	return ok;
+}
+
 static void texture_loader_cubemap_from_pixmaps(TextureLoadData *ld) {
 	ResourceLoadState *st = ld->st;
 
@@ -690,18 +846,18 @@ void texture_loader_stage1(ResourceLoadState *st) {
 	ld->num_pixmaps = 1;
 	ld->pixmaps = ALLOC_ARRAY(1, typeof(*ld->pixmaps));
 
-	if(!load_pixmap(ld, ld->src_paths.main, ld->pixmaps, ld->preferred_format)) {
-		log_error("%s: Couldn't load texture image %s", st->name, ld->src_paths.main);
+	bool cpu_preprocess = texture_loader_cpu_preprocess_enabled();
+	bool use_cache = cpu_preprocess && texture_loader_preprocess_possible(ld);
+	TexturePreprocessCacheKeys cache_keys;
+	PreprocessCacheStatus cache_status;
+
+	if(!texture_loader_load_pixmaps_2d(ld, use_cache ? &cache_keys : NULL, &cache_status)) {
 		texture_loader_failed(ld);
 		return;
 	}
 
-	if(
-		ld->src_paths.alphamap &&
-		!load_pixmap(ld, ld->src_paths.alphamap, &ld->alphamap, PIXMAP_FORMAT_R8)
-	) {
-		log_error("%s: Couldn't load texture alphamap %s", st->name, ld->src_paths.alphamap);
-		texture_loader_failed(ld);
+	if(cache_status == PREPROCESS_CACHE_HIT) {
+		texture_loader_continue(ld);
 		return;
 	}
 
@@ -730,6 +886,16 @@ void texture_loader_stage1(ResourceLoadState *st) {
 	ld->params.width = ld->pixmaps->width;
 	ld->params.height = ld->pixmaps->height;
 
+	if(!is_preprocess_needed(ld)) {
+		if(cache_status == PREPROCESS_CACHE_MISS) {
+			texture_loader_preprocess_cache_skip(ld, cache_keys.skip);
+		}
+	} else if(cpu_preprocess && texture_loader_preprocess_pixmaps(ld)) {
+		if(cache_status == PREPROCESS_CACHE_MISS) {
+			texture_loader_preprocess_cache(ld, cache_keys.result);
+		}
+	}
+
 	texture_loader_continue(ld);
 }
 
@@ -839,6 +1005,7 @@ static void texture_loader_stage2(ResourceLoadState *st) {
 	Texture *texture;
 
 	if(preprocess_needed) {
+		// The CPU path in texture_loader_stage1() couldn't handle this one (or is disabled).
 		// Create transient texture that we'll just render into another one and discard.
 		// Doesn't need mipmaps and filtering.
 
@@ -46,6 +46,9 @@ typedef struct TextureLoadData {
 	ResourceLoadState *st;
 } TextureLoadData;
 
+void texture_loader_init(void);
+void texture_loader_shutdown(void);
+
 char *texture_loader_source_path(const char *basename);
 char *texture_loader_path(const char *basename);
 bool texture_loader_check_path(const char *path);
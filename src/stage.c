@@ -9,6 +9,7 @@
 #include "stage.h"
 
 #include "audio/audio.h"
+#include "benchmark.h"
 #include "common_tasks.h"  // IWYU pragma: keep
 #include "config.h"
 #include "dynstage.h"
@@ -20,7 +21,9 @@
 #include "log.h"
 #include "menu/gameovermenu.h"
 #include "menu/ingamemenu.h"
+#include "particle.h"
 #include "player.h"
+#include "profiler.h"
 #include "replay/demoplayer.h"
 #include "replay/stage.h"
 #include "replay/state.h"
@@ -664,36 +667,243 @@ static void stage_input(StageFrameState *fstate) {
 	player_applymovement(&global.plr);
 }
 
-void stage_clear_hazards_predicate(bool (*predicate)(EntityInterface *ent, void *arg), void *arg, ClearHazardsFlags flags) {
+/*
+ * Broad-phase grid over global.projs for the area clears (bombs, boss shockwaves, etc.)
+ *
+ * Stage scripts move projectiles from task code at any point in the frame, so the grid can't be
+ * maintained incrementally. Instead it's rebuilt by the first area clear after projectiles have been
+ * processed, created or deleted, or after any task has run; a series of clears issued back to back
+ * (e.g. Master Spark) shares a single build. Candidates are visited in list order, and if clearing
+ * one wakes up a task, the rest of the list is walked linearly, so the results are exactly the same
+ * as testing every projectile.
+ *
+ * The same grid also answers proximity counts, e.g. for the PIV awarded when an enemy dies; a whole
+ * wave dying in one frame then shares a single build, as long as no task runs in between.
+ */
+
+#define HAZARD_GRID_CELL_SIZE 32
+#define HAZARD_GRID_COLS ((VIEWPORT_W + HAZARD_GRID_CELL_SIZE - 1) / HAZARD_GRID_CELL_SIZE)
+#define HAZARD_GRID_ROWS ((VIEWPORT_H + HAZARD_GRID_CELL_SIZE - 1) / HAZARD_GRID_CELL_SIZE)
+#define HAZARD_GRID_CELLS (HAZARD_GRID_COLS * HAZARD_GRID_ROWS)
+
+typedef struct HazardGridProj {
+	Projectile *proj;
+	uint cell;
+} HazardGridProj;
+
+static struct {
+	DYNAMIC_ARRAY(HazardGridProj) projs;  // in list order
+	DYNAMIC_ARRAY(uint32_t) cell_entries;  // indices into projs, grouped by cell
+	DYNAMIC_ARRAY(uint64_t) candidates;    // bitmap over projs
+	uint32_t cell_ofs[HAZARD_GRID_CELLS + 1];
+	Projectile *tail;
+	uint32_t projs_generation;
+	uint32_t task_resume_count;
+	bool built;
+} hazard_grid;
+
+static void hazard_grid_shutdown(void) {
+	dynarray_free_data(&hazard_grid.projs);
+	dynarray_free_data(&hazard_grid.cell_entries);
+	dynarray_free_data(&hazard_grid.candidates);
+	hazard_grid = (typeof(hazard_grid)) {};
+}
+
+static int hazard_grid_coord(real v, int num_cells) {
+	// Out-of-viewport positions go into the border cells; fmin/fmax also take care of NaN.
+	return fmax(0, fmin(num_cells - 1, floor(v / HAZARD_GRID_CELL_SIZE)));
+}
+
+static uint hazard_grid_cell(cmplx pos) {
+	return hazard_grid_coord(im(pos), HAZARD_GRID_ROWS) * HAZARD_GRID_COLS +
+	       hazard_grid_coord(re(pos), HAZARD_GRID_COLS);
+}
+
+static bool hazard_grid_is_current(void) {
+	return
+		hazard_grid.built &&
+		hazard_grid.projs_generation == projectiles_get_generation() &&
+		hazard_grid.task_resume_count == cotask_get_resume_count();
+}
+
+static void hazard_grid_rebuild(void) {
+	auto g = &hazard_grid;
+
+	g->projs.num_elements = 0;
+	memset(g->cell_ofs, 0, sizeof(g->cell_ofs));
+
+	for(Projectile *p = global.projs.first; p; p = p->next) {
+		uint cell = hazard_grid_cell(p->pos);
+		dynarray_append(&g->projs, { p, cell });
+		++g->cell_ofs[cell + 1];
+	}
+
+	for(uint i = 1; i < ARRAY_SIZE(g->cell_ofs); ++i) {
+		g->cell_ofs[i] += g->cell_ofs[i - 1];
+	}
+
+	uint32_t cursors[HAZARD_GRID_CELLS];
+	memcpy(cursors, g->cell_ofs, sizeof(cursors));
+
+	dynarray_size_t n = g->projs.num_elements;
+	dynarray_ensure_capacity(&g->cell_entries, n);
+	g->cell_entries.num_elements = n;
+
+	dynarray_foreach(&g->projs, dynarray_size_t i, HazardGridProj *gp, {
+		dynarray_set(&g->cell_entries, cursors[gp->cell]++, i);
+	});
+
+	g->tail = global.projs.last;
+	g->projs_generation = projectiles_get_generation();
+	g->task_resume_count = cotask_get_resume_count();
+	g->built = true;
+}
+
+static bool clear_hazards_test_projectile(
+	Projectile *p, bool (*predicate)(EntityInterface *ent, void *arg), void *arg, bool force
+) {
+	if(!force && !projectile_is_clearable(p)) {
+		return false;
+	}
+
+	return !predicate || predicate(&p->ent, arg);
+}
+
+static void clear_hazards_projectiles_linear(
+	Projectile *first, bool (*predicate)(EntityInterface *ent, void *arg), void *arg, ClearHazardsFlags flags
+) {
 	bool force = flags & CLEAR_HAZARDS_FORCE;
 
-	if(flags & CLEAR_HAZARDS_BULLETS) {
-		for(Projectile *p = global.projs.first, *next; p; p = next) {
-			next = p->next;
+	for(Projectile *p = first, *next; p; p = next) {
+		next = p->next;
+
+		if(clear_hazards_test_projectile(p, predicate, arg, force)) {
+			clear_projectile(p, flags);
+		}
+	}
+}
+
+static void clear_hazards_projectiles_in_area(
+	Rect area, bool (*predicate)(EntityInterface *ent, void *arg), void *arg, ClearHazardsFlags flags
+) {
+	auto g = &hazard_grid;
+	bool force = flags & CLEAR_HAZARDS_FORCE;
+
+	if(!hazard_grid_is_current()) {
+		hazard_grid_rebuild();
+	}
+
+	dynarray_size_t num_projs = g->projs.num_elements;
+	dynarray_size_t num_words = (num_projs + 63) / 64;
+
+	if(num_words > 0) {
+		dynarray_ensure_capacity(&g->candidates, num_words);
+		g->candidates.num_elements = num_words;
+		memset(g->candidates.data, 0, num_words * sizeof(*g->candidates.data));
+	}
+
+	int x0 = hazard_grid_coord(re(area.top_left), HAZARD_GRID_COLS);
+	int x1 = hazard_grid_coord(re(area.bottom_right), HAZARD_GRID_COLS);
+	int y0 = hazard_grid_coord(im(area.top_left), HAZARD_GRID_ROWS);
+	int y1 = hazard_grid_coord(im(area.bottom_right), HAZARD_GRID_ROWS);
+
+	for(int y = y0; y <= y1; ++y) {
+		// Cells of a row are contiguous in cell_entries
+		uint32_t begin = g->cell_ofs[y * HAZARD_GRID_COLS + x0];
+		uint32_t end = g->cell_ofs[y * HAZARD_GRID_COLS + x1 + 1];
+
+		for(uint32_t e = begin; e < end; ++e) {
+			uint32_t idx = dynarray_get(&g->cell_entries, e);
+			g->candidates.data[idx / 64] |= UINT64_C(1) << (idx % 64);
+		}
+	}
 
-			if(!force && !projectile_is_clearable(p)) {
+	uint32_t task_resume_count = g->task_resume_count;
+
+	for(dynarray_size_t w = 0; w < num_words; ++w) {
+		for(uint64_t bits = g->candidates.data[w]; bits; bits &= bits - 1) {
+			Projectile *p = dynarray_get(&g->projs, w * 64 + __builtin_ctzll(bits)).proj;
+			Projectile *next = p->next;
+
+			if(!clear_hazards_test_projectile(p, predicate, arg, force)) {
 				continue;
 			}
 
-			if(!predicate || predicate(&p->ent, arg)) {
-				clear_projectile(p, flags);
+			clear_projectile(p, flags);
+
+			if(UNLIKELY(cotask_get_resume_count() != task_resume_count)) {
+				// An event handler ran and may have moved or spawned projectiles; the grid is stale.
+				clear_hazards_projectiles_linear(next, predicate, arg, flags);
+				return;
 			}
 		}
 	}
 
-	if(flags & CLEAR_HAZARDS_LASERS) {
-		for(Laser *l = global.lasers.first, *next; l; l = next) {
-			next = l->next;
+	clear_hazards_projectiles_linear(g->tail ? g->tail->next : global.projs.first, predicate, arg, flags);
+}
 
-			if(!force && !laser_is_clearable(l)) {
-				continue;
-			}
+uint stage_count_projectiles_in_circle(Circle area, bool (*predicate)(Projectile *p, void *arg), void *arg) {
+	auto g = &hazard_grid;
+
+	if(!hazard_grid_is_current()) {
+		hazard_grid_rebuild();
+	}
+
+	// Any projectile created, deleted or moved since the build would have invalidated the grid,
+	// so every projectile is in the cell its current position maps to.
+	int x0 = hazard_grid_coord(re(area.origin) - area.radius, HAZARD_GRID_COLS);
+	int x1 = hazard_grid_coord(re(area.origin) + area.radius, HAZARD_GRID_COLS);
+	int y0 = hazard_grid_coord(im(area.origin) - area.radius, HAZARD_GRID_ROWS);
+	int y1 = hazard_grid_coord(im(area.origin) + area.radius, HAZARD_GRID_ROWS);
+	uint count = 0;
+
+	for(int y = y0; y <= y1; ++y) {
+		uint32_t begin = g->cell_ofs[y * HAZARD_GRID_COLS + x0];
+		uint32_t end = g->cell_ofs[y * HAZARD_GRID_COLS + x1 + 1];
+
+		for(uint32_t e = begin; e < end; ++e) {
+			Projectile *p = dynarray_get(&g->projs, dynarray_get(&g->cell_entries, e)).proj;
 
-			if(!predicate || predicate(&l->ent, arg)) {
-				clear_laser(l, flags);
+			if((!predicate || predicate(p, arg)) && cabs(p->pos - area.origin) < area.radius) {
+				++count;
 			}
 		}
 	}
+
+	assert(g->task_resume_count == cotask_get_resume_count());
+	return count;
+}
+
+static void clear_hazards_lasers(
+	const Rect *area, bool (*predicate)(EntityInterface *ent, void *arg), void *arg, ClearHazardsFlags flags
+) {
+	bool force = flags & CLEAR_HAZARDS_FORCE;
+
+	for(Laser *l = global.lasers.first, *next; l; l = next) {
+		next = l->next;
+
+		if(!force && !laser_is_clearable(l)) {
+			continue;
+		}
+
+		if(area && !laser_bbox_intersects_rect(l, *area)) {
+			continue;
+		}
+
+		if(!predicate || predicate(&l->ent, arg)) {
+			clear_laser(l, flags);
+		}
+	}
+}
+
+void stage_clear_hazards_predicate(bool (*predicate)(EntityInterface *ent, void *arg), void *arg, ClearHazardsFlags flags) {
+	if(flags & CLEAR_HAZARDS_BULLETS) {
+		clear_hazards_projectiles_linear(global.projs.first, predicate, arg, flags);
+	}
+
+	if(flags & CLEAR_HAZARDS_LASERS) {
+		clear_hazards_lasers(NULL, predicate, arg, flags);
+	}
 }
 
 void stage_clear_hazards(ClearHazardsFlags flags) {
@@ -736,6 +946,19 @@ static bool ellipse_predicate(EntityInterface *ent, void *varg) {
 	}
 }
 
+// The predicate must reject everything outside of bbox
+static void stage_clear_hazards_in_bbox(
+	Rect bbox, bool (*predicate)(EntityInterface *ent, void *arg), void *arg, ClearHazardsFlags flags
+) {
+	if(flags & CLEAR_HAZARDS_BULLETS) {
+		clear_hazards_projectiles_in_area(bbox, predicate, arg, flags);
+	}
+
+	if(flags & CLEAR_HAZARDS_LASERS) {
+		clear_hazards_lasers(&bbox, predicate, arg, flags);
+	}
+}
+
 void stage_clear_hazards_at(cmplx origin, double radius, ClearHazardsFlags flags) {
 	Circle area = { origin, radius };
 
@@ -743,11 +966,16 @@ void stage_clear_hazards_at(cmplx origin, double radius, ClearHazardsFlags flags
 		return;
 	}
 
-	stage_clear_hazards_predicate(proximity_predicate, &area, flags);
+	Rect bbox = {
+		.top_left = origin - radius * (1 + I),
+		.bottom_right = origin + radius * (1 + I),
+	};
+
+	stage_clear_hazards_in_bbox(bbox, proximity_predicate, &area, flags);
 }
 
 void stage_clear_hazards_in_ellipse(Ellipse e, ClearHazardsFlags flags) {
-	stage_clear_hazards_predicate(ellipse_predicate, &e, flags);
+	stage_clear_hazards_in_bbox(ellipse_bbox(e), ellipse_predicate, &e, flags);
 }
 
 TASK(clear_dialog) {
@@ -782,8 +1010,10 @@ static void stage_free(void) {
 	}
 
 	lasers_shutdown();
+	particles_shutdown();
 	projectiles_free();
 	stagetext_free();
+	hazard_grid_shutdown();
 }
 
 static void stage_finalize(CallChainResult ccr) {
@@ -983,7 +1213,7 @@ static LogicFrameAction stage_logic_frame(void *arg) {
 		// Usually stage_comain will do this
 		events_poll(NULL, 0);
 	} else {
-		cosched_run_tasks(&fstate->sched);
+		PROFILE_ZONE("cosched_run_tasks", cosched_run_tasks(&fstate->sched));
 		update_all_sfx();
 		stage_replay_sync(fstate);
 
@@ -1113,12 +1343,13 @@ TASK(stage_comain, { StageFrameState *fstate; }) {
 
 	for(;;YIELD) {
 		process_input(fstate);
-		process_boss(&global.boss);
-		process_enemies(&global.enemies);
-		process_projectiles(&global.projs, true);
-		process_items();
-		process_lasers();
-		process_projectiles(&global.particles, false);
+		PROFILE_ZONE("process_boss", process_boss(&global.boss));
+		PROFILE_ZONE("process_enemies", process_enemies(&global.enemies));
+		PROFILE_ZONE("process_projectiles", process_projectiles(&global.projs, true));
+		PROFILE_ZONE("process_items", process_items());
+		PROFILE_ZONE("process_lasers", process_lasers());
+		PROFILE_ZONE("process_particles", process_projectiles(&global.particles, false));
+		PROFILE_ZONE("process_fx_particles", particles_process());
 
 		if(global.dialog) {
 			dialog_update(global.dialog);
@@ -1187,6 +1418,7 @@ static void _stage_enter(
 	stage_preload(stage, rg);
 	stage_draw_init();
 	lasers_init();
+	particles_init();
 
 	rng_make_active(&global.rand_game);
 	stage_start(stage);
@@ -1207,7 +1439,7 @@ static void _stage_enter(
 		log_debug("REPLAY_PLAY mode: %d events, stage: \"%s\"", rstg->events.num_elements, title);
 	} else {
 		start_time = (uint64_t)time(0);
-		seed = makeseed();
+		seed = benchmark_is_active() ? benchmark_get_seed() : makeseed();
 
 		StageProgress *p = NOT_NULL(stageinfo_get_progress(stage, global.diff, true));
 		progress_register_stage_played(p, global.plr.mode);
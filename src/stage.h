@@ -48,6 +48,10 @@ void stage_clear_hazards_at(cmplx origin, double radius, ClearHazardsFlags flags
 void stage_clear_hazards_in_ellipse(Ellipse e, ClearHazardsFlags flags);
 void stage_clear_hazards_predicate(bool (*predicate)(EntityInterface *ent, void *arg), void *arg, ClearHazardsFlags flags);
 
+// Counts projectiles in global.projs that are strictly within the circle and pass the predicate.
+// The predicate must not have side effects.
+uint stage_count_projectiles_in_circle(Circle area, bool (*predicate)(Projectile *p, void *arg), void *arg);
+
 void stage_set_voltage_thresholds(uint easy, uint normal, uint hard, uint lunatic);
 
 bool stage_is_cleared(void);
@@ -12,6 +12,8 @@
 #include "events.h"
 #include "global.h"
 #include "i18n/i18n.h"
+#include "particle.h"
+#include "profiler.h"
 #include "replay/struct.h"
 #include "resource/postprocess.h"
 #include "stageobjects.h"
@@ -33,6 +35,15 @@
 #define SPELL_INTRO_DURATION 120
 #define SPELL_INTRO_TIME_FACTOR 0.8
 
+// Dynamic resolution controller tuning. Load is frame time relative to the frame budget.
+#define DYNRES_LOAD_HIGH 1.1      // scale down when missing frames by this much on average
+#define DYNRES_LOAD_LOW 0.7       // scale up when this much of the budget is spent working, or less
+#define DYNRES_LOAD_SMOOTHING 0.1
+#define DYNRES_STEP 0.05
+#define DYNRES_COOLDOWN_DOWN 30
+#define DYNRES_COOLDOWN_UP 90
+#define DYNRES_WARMUP 120
+
 static struct {
 	struct {
 		ShaderProgram *shader;
@@ -68,8 +79,19 @@ static struct {
 		float target_alpha;
 	} clear_screen;
 
+	struct {
+		float scale;
+		float min_scale;
+		float max_scale;
+		double load;
+		double work_load;
+		int cooldown;
+		bool enabled;
+	} dynres;
+
 	bool framerate_graphs;
 	bool objpool_stats;
+	bool simulate_hidden_particles;
 
 	#ifdef DEBUG
 		Sprite dummy;
@@ -135,11 +157,21 @@ typedef struct StageFramebufferResizeParams {
 	struct { float worst, best; } scale;
 	StageFBPair scaling_base;
 	int refs;
+	bool dynamic;
 } StageFramebufferResizeParams;
 
 static void stage_framebuffer_resize_strategy(void *userdata, IntExtent *out_dimensions, FloatRect *out_viewport) {
 	StageFramebufferResizeParams *rp = userdata;
-	set_fb_size(rp->scaling_base, &out_dimensions->w, &out_dimensions->h, rp->scale.worst, rp->scale.best);
+	float scale_worst = rp->scale.worst;
+	float scale_best = rp->scale.best;
+
+	if(rp->dynamic) {
+		// Allocate for the largest scale; lower ones only shrink the viewport
+		scale_worst *= stagedraw.dynres.max_scale;
+		scale_best *= stagedraw.dynres.max_scale;
+	}
+
+	set_fb_size(rp->scaling_base, &out_dimensions->w, &out_dimensions->h, scale_worst, scale_best);
 	*out_viewport = (FloatRect) { 0, 0, out_dimensions->w, out_dimensions->h };
 }
 
@@ -193,9 +225,9 @@ static void stage_draw_setup_framebuffers(void) {
 	a_color->attachment = FRAMEBUFFER_ATTACH_COLOR0;
 	a_depth->attachment = FRAMEBUFFER_ATTACH_DEPTH;
 
-	StageFramebufferResizeParams rp_fg =     { .scaling_base = FBPAIR_FG,     .scale.best = 1, .scale.worst = 1 };
+	StageFramebufferResizeParams rp_fg =     { .scaling_base = FBPAIR_FG,     .scale.best = 1, .scale.worst = 1, .dynamic = true };
 	StageFramebufferResizeParams rp_fg_aux = { .scaling_base = FBPAIR_FG_AUX, .scale.best = 1, .scale.worst = 1 };
-	StageFramebufferResizeParams rp_bg =     { .scaling_base = FBPAIR_BG,     .scale.best = 1, .scale.worst = 1 };
+	StageFramebufferResizeParams rp_bg =     { .scaling_base = FBPAIR_BG,     .scale.best = 1, .scale.worst = 1, .dynamic = true };
 	StageFramebufferResizeParams rp_bg_aux = { .scaling_base = FBPAIR_BG_AUX, .scale.best = 1, .scale.worst = 1 };
 
 	// Set up some parameters shared by all attachments
@@ -328,6 +360,17 @@ void stage_draw_preload(ResourceGroup *rg) {
 
 	stagedraw.framerate_graphs = env_get("TAISEI_FRAMERATE_GRAPHS", GRAPHS_DEFAULT);
 	stagedraw.objpool_stats = env_get("TAISEI_OBJPOOL_STATS", OBJPOOLSTATS_DEFAULT);
+	stagedraw.simulate_hidden_particles = env_get("TAISEI_SIMULATE_HIDDEN_PARTICLES", false);
+
+	auto dynres = &stagedraw.dynres;
+	dynres->enabled = env_get("TAISEI_DYNAMIC_RESOLUTION", false);
+
+	if(dynres->enabled) {
+		dynres->max_scale = clamp(env_get("TAISEI_DYNAMIC_RESOLUTION_MAX", 1.0), 0.1, 2.0);
+		dynres->min_scale = clamp(env_get("TAISEI_DYNAMIC_RESOLUTION_MIN", 0.5), 0.1, dynres->max_scale);
+	} else {
+		dynres->max_scale = dynres->min_scale = 1;
+	}
 
 	if(stagedraw.framerate_graphs) {
 		res_group_preload(rg, RES_SHADER_PROGRAM, RESF_DEFAULT,
@@ -335,7 +378,7 @@ void stage_draw_preload(ResourceGroup *rg) {
 		NULL);
 	}
 
-	if(stagedraw.objpool_stats) {
+	if(stagedraw.objpool_stats || profiler_enabled()) {
 		res_group_preload(rg, RES_FONT, RESF_DEFAULT,
 			"monotiny",
 		NULL);
@@ -359,6 +402,12 @@ void stage_draw_init(void) {
 	stagedraw.dummy.h = 1;
 	#endif
 
+	// Bounds are set in preload; the allocation only depends on max_scale
+	stagedraw.dynres.scale = stagedraw.dynres.max_scale;
+	stagedraw.dynres.load = 1;
+	stagedraw.dynres.work_load = 1;
+	stagedraw.dynres.cooldown = DYNRES_WARMUP;
+
 	stage_draw_setup_framebuffers();
 
 	stagedraw.clear_screen.alpha = 0;
@@ -849,6 +898,16 @@ bool stage_should_draw_particle(Projectile *p) {
 	return (p->flags & PFLAG_REQUIREDPARTICLE) || config_get_int(CONFIG_PARTICLES);
 }
 
+bool stage_should_spawn_particle(bool required) {
+	if(required || stagedraw.simulate_hidden_particles) {
+		return true;
+	}
+
+	// Nothing is drawn while verifying replays, so skip them there too; this also makes
+	// --verify-replay exercise the skipping path regardless of the user's settings.
+	return config_get_int(CONFIG_PARTICLES) && !global.is_replay_verification;
+}
+
 static bool stage_draw_predicate(EntityInterface *ent) {
 	if(ent->type == ENT_TYPE_ID(Projectile)) {
 		Projectile *p = ENT_CAST(ent, Projectile);
@@ -969,9 +1028,10 @@ void stage_draw_end_noshake(void) {
 }
 
 void stage_draw_viewport(void) {
+	Framebuffer *fg = stagedraw.fb_pairs[FBPAIR_FG].front;
 	FloatRect dest_vp;
 	r_framebuffer_viewport_current(r_framebuffer_current(), &dest_vp);
-	r_uniform_sampler("tex", r_framebuffer_get_attachment(stagedraw.fb_pairs[FBPAIR_FG].front, FRAMEBUFFER_ATTACH_COLOR0));
+	r_uniform_sampler("tex", r_framebuffer_get_attachment(fg, FRAMEBUFFER_ATTACH_COLOR0));
 
 	// CAUTION: Very intricate pixel perfect scaling that will ruin your day.
 	float facw = dest_vp.w / SCREEN_W;
@@ -980,14 +1040,68 @@ void stage_draw_viewport(void) {
 	float scale = fach;
 
 	r_mat_mv_push();
+	r_mat_tex_push();
+	framebuffer_viewport_texcoord_scale(fg, FRAMEBUFFER_ATTACH_COLOR0);
 	r_mat_mv_scale(1/facw, 1/fach, 1);
 	r_mat_mv_translate(roundf(facw * VIEWPORT_X), roundf(fach * VIEWPORT_Y), 0);
 	r_mat_mv_scale(roundf(scale * VIEWPORT_W), roundf(scale * VIEWPORT_H), 1);
 	r_mat_mv_translate(0.5, 0.5, 0);
 	r_draw_quad();
+	r_mat_tex_pop();
 	r_mat_mv_pop();
 }
 
+static void dynres_set_viewport(StageFBPair id, float fraction) {
+	FBPair *pair = stage_get_fbpair(id);
+	uint w, h;
+	r_texture_get_size(r_framebuffer_get_attachment(pair->front, FRAMEBUFFER_ATTACH_COLOR0), 0, &w, &h);
+	fbpair_viewport(pair, 0, 0, fmaxf(1, roundf(w * fraction)), fmaxf(1, roundf(h * fraction)));
+}
+
+static void dynres_update(void) {
+	auto dynres = &stagedraw.dynres;
+
+	if(!dynres->enabled) {
+		return;
+	}
+
+	// The render interval catches missed frames; work time tells whether there's headroom.
+	// Work time stops before the buffer swap, so waiting for vsync doesn't count against it.
+	double budget = HRTIME_RESOLUTION / (double)FPS;
+	auto render = &global.fps.render;
+	auto work = &global.fps.work;
+	double interval = render->frametimes[ARRAY_SIZE(render->frametimes) - 1];
+	double worktime = work->frametimes[ARRAY_SIZE(work->frametimes) - 1];
+
+	interval /= budget * get_effective_frameskip();
+	worktime /= budget;
+
+	dynres->load = lerp(dynres->load, interval, DYNRES_LOAD_SMOOTHING);
+	dynres->work_load = lerp(dynres->work_load, worktime, DYNRES_LOAD_SMOOTHING);
+
+	float prev_scale = dynres->scale;
+
+	if(dynres->cooldown > 0) {
+		--dynres->cooldown;
+	} else if(dynres->load > DYNRES_LOAD_HIGH && dynres->scale > dynres->min_scale) {
+		dynres->scale = fmaxf(dynres->min_scale, dynres->scale - DYNRES_STEP);
+		dynres->cooldown = DYNRES_COOLDOWN_DOWN;
+	} else if(dynres->work_load < DYNRES_LOAD_LOW && dynres->scale < dynres->max_scale) {
+		dynres->scale = fminf(dynres->max_scale, dynres->scale + DYNRES_STEP);
+		dynres->cooldown = DYNRES_COOLDOWN_UP;
+	}
+
+	if(dynres->scale != prev_scale) {
+		log_debug("Scale %.2f -> %.2f (load %.2f, work %.2f)",
+			prev_scale, dynres->scale, dynres->load, dynres->work_load);
+	}
+
+	// Re-applied every frame, since a resize resets the viewports
+	float fraction = dynres->scale / dynres->max_scale;
+	dynres_set_viewport(FBPAIR_BG, fraction);
+	dynres_set_viewport(FBPAIR_FG, fraction);
+}
+
 static void compute_bg_color_filter(mat3 matrix, vec3 offset) {
 	float brigthness = config_get_float(CONFIG_BG_BRIGHTNESS) * 2.0f;
 	float saturation = config_get_float(CONFIG_BG_SATURATION);
@@ -1029,8 +1143,10 @@ void stage_draw_scene(StageInfo *stage) {
 
 	bool draw_bg = !config_get_int(CONFIG_NO_STAGEBG) && !key_nobg;
 
+	dynres_update();
+
 	if(draw_bg) {
-		stage_render_bg(stage);
+		PROFILE_ZONE("Stage background", stage_render_bg(stage));
 	}
 
 	// prepare for 2D rendering into the game viewport framebuffer
@@ -1058,7 +1174,7 @@ void stage_draw_scene(StageInfo *stage) {
 	}
 
 	// draw the 2D objects
-	stage_draw_objects();
+	PROFILE_ZONE("ent_draw", stage_draw_objects());
 
 	end_viewport_shake();
 
@@ -1076,6 +1192,8 @@ void stage_draw_scene(StageInfo *stage) {
 
 	coevent_signal(&stagedraw.events.postprocess_after_overlay);
 
+	ProfilerZone pp_zone = profiler_zone_begin("Postprocessing");
+
 	// stage postprocessing
 	apply_shader_rules(global.stage->procs->postprocess_rules, foreground);
 
@@ -1090,6 +1208,8 @@ void stage_draw_scene(StageInfo *stage) {
 		NULL
 	);
 
+	profiler_zone_end(pp_zone);
+
 	stagedraw.current_postprocess_fbpair = NULL;
 
 	// prepare for 2D rendering into the main framebuffer (actual screen)
@@ -1100,7 +1220,7 @@ void stage_draw_scene(StageInfo *stage) {
 	stage_draw_viewport();
 
 	// draw HUD
-	stage_draw_hud();
+	PROFILE_ZONE("HUD", stage_draw_hud());
 
 	// draw dialog
 	dialog_draw(global.dialog);
@@ -1238,6 +1358,40 @@ static void stage_draw_hud_objpool_stats(float x, float y, float width) {
 		.align = ALIGN_RIGHT,
 	});
 
+	y += lineskip;
+
+	auto draw_stats = ent_pop_draw_stats();
+
+	text_draw("Drawn | culled:", &(TextParams) {
+		.pos = { x, y },
+		.font_ptr = font,
+		.align = ALIGN_LEFT,
+	});
+
+	snprintf(buf, sizeof(buf), "%u | %7u", draw_stats.drawn, draw_stats.culled);
+
+	text_draw(buf, &(TextParams) {
+		.pos = { x + width, y },
+		.font_ptr = font,
+		.align = ALIGN_RIGHT,
+	});
+
+	y += lineskip;
+
+	text_draw("FX particles:", &(TextParams) {
+		.pos = { x, y },
+		.font_ptr = font,
+		.align = ALIGN_LEFT,
+	});
+
+	snprintf(buf, sizeof(buf), "%u", particles_count());
+
+	text_draw(buf, &(TextParams) {
+		.pos = { x + width, y },
+		.font_ptr = font,
+		.align = ALIGN_RIGHT,
+	});
+
 	y += lineskip * 1.5;
 
 	const char *const names[] = {
@@ -1271,6 +1425,44 @@ static void stage_draw_hud_objpool_stats(float x, float y, float width) {
 	r_shader_ptr(sh_prev);
 }
 
+static float stage_draw_hud_profiler_stats(float x, float y, float width) {
+	char buf[64];
+	ProfilerZoneStats stats[8];
+	uint num_stats = profiler_get_zone_stats(ARRAY_SIZE(stats), stats);
+
+	Font *font = res_font("monotiny");
+
+	ShaderProgram *sh_prev = r_shader_current();
+	r_shader("text_hud");
+
+	float lineskip = font_get_lineskip(font);
+
+	for(uint i = 0; i < num_stats; ++i) {
+		snprintf(buf, sizeof(buf), "%.0fx %6.3fms",
+			stats[i].avg_calls,
+			stats[i].avg_time / (double)(HRTIME_RESOLUTION / 1000)
+		);
+
+		text_draw(stats[i].name, &(TextParams) {
+			.pos = { x, y },
+			.font_ptr = font,
+			.align = ALIGN_LEFT,
+			.max_width = width * 0.5,
+		});
+
+		text_draw(buf, &(TextParams) {
+			.pos = { x + width, y },
+			.font_ptr = font,
+			.align = ALIGN_RIGHT,
+		});
+
+		y += lineskip;
+	}
+
+	r_shader_ptr(sh_prev);
+	return y + lineskip * 0.5;
+}
+
 struct labels_s {
 	struct {
 		float next_life;
@@ -1515,8 +1707,14 @@ static void stage_draw_hud_text(struct labels_s* labels) {
 		});
 	}
 
+	float stats_ypos = 440;
+
+	if(profiler_enabled()) {
+		stats_ypos = stage_draw_hud_profiler_stats(0, stats_ypos, HUD_EFFECTIVE_WIDTH);
+	}
+
 	if(stagedraw.objpool_stats) {
-		stage_draw_hud_objpool_stats(0, 440, HUD_EFFECTIVE_WIDTH);
+		stage_draw_hud_objpool_stats(0, stats_ypos, HUD_EFFECTIVE_WIDTH);
 	}
 }
 
@@ -46,6 +46,11 @@ void stage_draw_end_noshake(void);
 
 bool stage_should_draw_particle(Projectile *p);
 
+// False if a particle would never be drawn, so it need not be spawned at all.
+// `required` should be set for particles visible at the minimal particles setting, and for
+// those drawn by other means, like the Power Surge effect.
+bool stage_should_spawn_particle(bool required);
+
 void stage_display_clear_screen(const StageClearBonus *bonus);
 
 FBPair *stage_get_fbpair(StageFBPair id) attr_returns_nonnull;
@@ -9,6 +9,7 @@
 #include "draw.h"
 
 #include "global.h"
+#include "particle.h"
 #include "stagedraw.h"
 #include "stageutils.h"
 #include "util/glm.h"
@@ -64,6 +65,7 @@ static bool reflect_draw_predicate(EntityInterface *ent) {
 		case ENT_TYPE_ID(Player):
 		case ENT_TYPE_ID(Boss):
 		case ENT_TYPE_ID(Enemy):
+		case ENT_TYPE_ID(ParticleLayer):
 			return true;
 
 		case ENT_TYPE_ID(Projectile): {
@@ -112,7 +114,9 @@ static void stage1_water_render_reflections(void) {
 	r_shader("sprite_default");
 	r_blend(BLEND_PREMUL_ALPHA);
 	r_mat_proj_push_ortho(VIEWPORT_W, VIEWPORT_H);
+	ParticleFlags prev_exclude = particles_set_draw_exclude(PARTFLAG_NOREFLECT);
 	ent_draw(reflect_draw_predicate);
+	particles_set_draw_exclude(prev_exclude);
 	r_mat_proj_pop();
 }
 
@@ -204,37 +204,29 @@ static void stage2_bg_leaves_draw(vec3 pos) {
 	r_state_pop();
 }
 
-static void stage2_bg_ground_draw(vec3 pos) {
+static void stage2_bg_ground_draw(uint num_instances, vec3 positions[num_instances]) {
 	r_state_push();
 
-	r_mat_mv_push();
-	r_mat_mv_translate_v(pos);
-
 	r_blend(BLEND_NONE);
-	r_shader("pbr");
+	r_shader("pbr_instanced");
 	PBREnvironment env = {};
 	stage2_bg_setup_pbr_env(&stage_3d_context.cam, STAGE2_MAX_LIGHTS, &env);
 
-	pbr_draw_model(&stage2_draw_data->models.ground, &env);
+	pbr_draw_model_instanced(&stage2_draw_data->models.ground, &env, num_instances, positions);
 
-	r_mat_mv_pop();
 	r_state_pop();
 }
 
-static void stage2_bg_ground_rocks_draw(vec3 pos) {
+static void stage2_bg_ground_rocks_draw(uint num_instances, vec3 positions[num_instances]) {
 	r_state_push();
 
-	r_mat_mv_push();
-	r_mat_mv_translate_v(pos);
-
 	r_blend(BLEND_NONE);
-	r_shader("pbr");
+	r_shader("pbr_instanced");
 	PBREnvironment env = {};
 	stage2_bg_setup_pbr_env(&stage_3d_context.cam, STAGE2_MAX_LIGHTS, &env);
 
-	pbr_draw_model(&stage2_draw_data->models.rocks, &env);
+	pbr_draw_model_instanced(&stage2_draw_data->models.rocks, &env, num_instances, positions);
 
-	r_mat_mv_pop();
 	r_state_pop();
 }
 
@@ -445,8 +437,8 @@ static void stage3d_hinalights_draw(vec3 pos) {
 void stage2_draw(void) {
 	Stage3DSegment segs[] = {
 		{ stage2_bg_branch_draw, stage2_bg_branch_pos },
-		{ stage2_bg_ground_rocks_draw, stage2_bg_pos},
-		{ stage2_bg_ground_draw, stage2_bg_pos},
+		{ .draw_instanced = stage2_bg_ground_rocks_draw, .pos = stage2_bg_pos },
+		{ .draw_instanced = stage2_bg_ground_draw, .pos = stage2_bg_pos },
 		{ stage2_bg_water_draw, stage2_bg_water_pos},
 		{ stage2_bg_water_draw, stage2_bg_water_start_pos},
 		{ stage2_bg_leaves_draw, stage2_bg_branch_pos },
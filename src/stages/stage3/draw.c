@@ -62,36 +62,32 @@ static void stage3_bg_setup_pbr_env(Camera3D *cam, PBREnvironment *env) {
 	env->disable_tonemap = true;
 }
 
-static void stage3_bg_ground_draw(vec3 pos) {
+static void stage3_bg_ground_draw(uint num_instances, vec3 positions[num_instances]) {
 	r_state_push();
-	r_mat_mv_push();
-	r_mat_mv_translate_v(pos);
 
-	r_shader("pbr");
+	r_shader("pbr_instanced");
 
 	PBREnvironment env = {};
 	stage3_bg_setup_pbr_env(&stage_3d_context.cam, &env);
 
-	pbr_draw_model(&stage3_draw_data->models.trees, &env);
-	pbr_draw_model(&stage3_draw_data->models.rocks, &env);
-	pbr_draw_model(&stage3_draw_data->models.ground, &env);
+	pbr_draw_model_instanced(&stage3_draw_data->models.trees, &env, num_instances, positions);
+	pbr_draw_model_instanced(&stage3_draw_data->models.rocks, &env, num_instances, positions);
+	pbr_draw_model_instanced(&stage3_draw_data->models.ground, &env, num_instances, positions);
 
-	r_mat_mv_pop();
 	r_state_pop();
 }
 
-static void stage3_bg_leaves_draw(vec3 pos) {
+static void stage3_bg_leaves_draw(uint num_instances, vec3 positions[num_instances]) {
 	r_state_push();
 	r_mat_mv_push();
-	r_mat_mv_translate_v(pos);
 	r_mat_mv_translate(0, 0, -0.0002);
 
-	r_shader("pbr_roughness_alpha_discard");
+	r_shader("pbr_roughness_alpha_discard_instanced");
 
 	PBREnvironment env = {};
 	stage3_bg_setup_pbr_env(&stage_3d_context.cam, &env);
 
-	pbr_draw_model(&stage3_draw_data->models.leaves, &env);
+	pbr_draw_model_instanced(&stage3_draw_data->models.leaves, &env, num_instances, positions);
 
 	r_mat_mv_pop();
 	r_state_pop();
@@ -158,8 +154,8 @@ static bool stage3_glitch(Framebuffer *fb) {
 
 void stage3_draw(void) {
 	Stage3DSegment segments[] = {
-		{ stage3_bg_leaves_draw, stage3_bg_pos },
-		{ stage3_bg_ground_draw, stage3_bg_pos },
+		{ .draw_instanced = stage3_bg_leaves_draw, .pos = stage3_bg_pos },
+		{ .draw_instanced = stage3_bg_ground_draw, .pos = stage3_bg_pos },
 	};
 	r_clear(BUFFER_COLOR, RGB(0.12, 0.11, 0.10), 1);
 	stage3d_draw(&stage_3d_context, 120, ARRAY_SIZE(segments), segments);
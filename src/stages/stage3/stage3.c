@@ -124,8 +124,8 @@ static void stage3_preload(ResourceGroup *rg) {
 	res_group_preload(rg, RES_SHADER_PROGRAM, RESF_DEFAULT,
 		"glitch",
 		"maristar_bombbg",
-		"pbr",
-		"pbr_roughness_alpha_discard",
+		"pbr_instanced",
+		"pbr_roughness_alpha_discard_instanced",
 		"stage3_wriggle_bg",
 		"zbuf_fog_tonemap",
 	NULL);
@@ -68,6 +68,9 @@ static bool stage4_water(Framebuffer *fb) {
 	r_shader("ssr_water");
 	r_uniform_sampler("depth", r_framebuffer_get_attachment(fb, FRAMEBUFFER_ATTACH_DEPTH));
 	r_uniform_sampler("tex", r_framebuffer_get_attachment(fb, FRAMEBUFFER_ATTACH_COLOR0));
+	vec2 ss_texcoord_scale;
+	framebuffer_viewport_texcoord_ratio(fb, FRAMEBUFFER_ATTACH_COLOR0, ss_texcoord_scale);
+	r_uniform_vec2_vec("ss_texcoord_scale", ss_texcoord_scale);
 	r_uniform_float("time", global.frames * 0.002);
 	r_uniform_vec2("wave_offset", -global.frames * 0.0005, 0);
 	r_uniform_float("wave_height", 0.005);
@@ -75,26 +75,25 @@ static void stage5_bg_setup_pbr_env(Camera3D *cam, PBREnvironment *env) {
 	camera3d_apply_inverse_transforms(cam, env->cam_inverse_transform);
 }
 
-static void stage5_stairs_draw(vec3 pos) {
+static void stage5_stairs_draw(uint num_instances, vec3 positions[num_instances]) {
 	r_state_push();
-	r_mat_mv_push();
-	r_mat_mv_translate(pos[0], pos[1], pos[2]);
 
-	r_shader("pbr");
+	r_shader("pbr_instanced");
 
 	PBREnvironment env = {};
 	stage5_bg_setup_pbr_env(&stage_3d_context.cam, &env);
 
-	pbr_draw_model(&stage5_draw_data->models.metal, &env);
-	pbr_draw_model(&stage5_draw_data->models.stairs, &env);
-	pbr_draw_model(&stage5_draw_data->models.wall, &env);
+	pbr_draw_model_instanced(&stage5_draw_data->models.metal, &env, num_instances, positions);
+	pbr_draw_model_instanced(&stage5_draw_data->models.stairs, &env, num_instances, positions);
+	pbr_draw_model_instanced(&stage5_draw_data->models.wall, &env, num_instances, positions);
 
-	r_mat_mv_pop();
 	r_state_pop();
 }
 
 void stage5_draw(void) {
-	stage3d_draw(&stage_3d_context, 50, 1, (Stage3DSegment[]) { stage5_stairs_draw, stage5_stairs_pos });
+	stage3d_draw(&stage_3d_context, 50, 1, (Stage3DSegment[]) {
+		{ .draw_instanced = stage5_stairs_draw, .pos = stage5_stairs_pos },
+	});
 }
 
 static bool stage5_fog(Framebuffer *fb) {
@@ -104,7 +104,7 @@ static void stage5_preload(ResourceGroup *rg) {
 		"stage5/metal",
 	NULL);
 	res_group_preload(rg, RES_SHADER_PROGRAM, RESF_DEFAULT,
-		"pbr",
+		"pbr_instanced",
 		"zbuf_fog",
 	NULL);
 	res_group_preload(rg, RES_ANIM, RESF_DEFAULT,
@@ -218,12 +218,31 @@ void pbr_draw_model(const PBRModel *pmdl, const PBREnvironment *env) {
 	r_draw_model_ptr(NOT_NULL(pmdl->mdl), 0, 0);
 }
 
+void pbr_draw_model_instanced(
+	const PBRModel *pmdl,
+	const PBREnvironment *env,
+	uint num_instances,
+	vec3 positions[num_instances]
+) {
+	if(num_instances == 0) {
+		return;
+	}
+
+	pbr_set_material_uniforms(NOT_NULL(pmdl->mat), env);
+
+	for(uint i = 0; i < num_instances; i += STAGE3D_MAX_INSTANCES) {
+		uint batch = min(num_instances - i, STAGE3D_MAX_INSTANCES);
+		r_uniform_vec3_array("instance_offsets", 0, batch, positions + i);
+		r_draw_model_ptr(NOT_NULL(pmdl->mdl), batch, 0);
+	}
+}
+
 void pbr_load_model(PBRModel *pmdl, const char *model_name, const char *mat_name) {
 	pmdl->mdl = res_model(model_name);
 	pmdl->mat = res_material(mat_name);
 }
 
-void stage3d_draw_segment(Stage3D *s, SegmentPositionRule pos_rule, SegmentDrawRule draw_rule, float maxrange) {
+static void stage3d_generate_positions(Stage3D *s, SegmentPositionRule pos_rule, float maxrange) {
 	s->positions.num_elements = 0;
 
 	// TODO maybe get rid of the return value
@@ -232,12 +251,24 @@ void stage3d_draw_segment(Stage3D *s, SegmentPositionRule pos_rule, SegmentDrawR
 	if(num < s->positions.num_elements) {
 		s->positions.num_elements = num;
 	}
+}
+
+void stage3d_draw_segment(Stage3D *s, SegmentPositionRule pos_rule, SegmentDrawRule draw_rule, float maxrange) {
+	stage3d_generate_positions(s, pos_rule, maxrange);
 
 	dynarray_foreach_elem(&s->positions, vec3 *p, {
 		draw_rule(*p);
 	});
 }
 
+void stage3d_draw_segment_instanced(Stage3D *s, SegmentPositionRule pos_rule, SegmentInstancedDrawRule draw_rule, float maxrange) {
+	stage3d_generate_positions(s, pos_rule, maxrange);
+
+	if(s->positions.num_elements > 0) {
+		draw_rule(s->positions.num_elements, s->positions.data);
+	}
+}
+
 void stage3d_draw(Stage3D *s, float maxrange, uint nsegments, const Stage3DSegment segments[nsegments]) {
 	r_mat_mv_push();
 	stage3d_apply_transforms(s, *r_mat_mv_current_ptr());
@@ -247,7 +278,12 @@ void stage3d_draw(Stage3D *s, float maxrange, uint nsegments, const Stage3DSegme
 
 	for(uint i = 0; i < nsegments; ++i) {
 		const Stage3DSegment *seg = segments + i;
-		stage3d_draw_segment(s, seg->pos, seg->draw, maxrange);
+
+		if(seg->draw_instanced) {
+			stage3d_draw_segment_instanced(s, seg->pos, seg->draw_instanced, maxrange);
+		} else {
+			stage3d_draw_segment(s, seg->pos, seg->draw, maxrange);
+		}
 	}
 
 	r_mat_mv_pop();
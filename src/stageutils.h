@@ -16,11 +16,15 @@
 typedef struct Stage3D Stage3D;
 
 typedef void (*SegmentDrawRule)(vec3 pos);
+typedef void (*SegmentInstancedDrawRule)(uint num_instances, vec3 positions[num_instances]);
 typedef uint (*SegmentPositionRule)(Stage3D *s3d, vec3 q, float maxrange); // returns number of elements written to Stage3D pos_buffer
 
 typedef struct Stage3DSegment {
 	SegmentDrawRule draw;
 	SegmentPositionRule pos;
+	// If set, called once with all positions instead of calling draw for each one.
+	// Intended for segments that only translate a model per position; see pbr_draw_model_instanced.
+	SegmentInstancedDrawRule draw_instanced;
 } Stage3DSegment;
 
 typedef union Camera3DRotation {
@@ -48,6 +52,9 @@ typedef struct PointLight3D {
 // NOTE: should match PBR_MAX_LIGHTS in lib/pbr.glslh
 #define STAGE3D_MAX_LIGHTS 6
 
+// NOTE: should match PBR_MAX_INSTANCES in lib/pbr.glslh
+#define STAGE3D_MAX_INSTANCES 32
+
 // NOTE: should match definitions in lib/pbr_features.glslh
 #define PBR_FEATURE_DIFFUSE_MAP         1
 #define PBR_FEATURE_NORMAL_MAP          2
@@ -89,6 +96,7 @@ void stage3d_shutdown(Stage3D *s);
 void stage3d_apply_transforms(Stage3D *s, mat4 mat);
 void stage3d_apply_inverse_transforms(Stage3D *s, mat4 mat);
 void stage3d_draw_segment(Stage3D *s, SegmentPositionRule pos_rule, SegmentDrawRule draw_rule, float maxrange);
+void stage3d_draw_segment_instanced(Stage3D *s, SegmentPositionRule pos_rule, SegmentInstancedDrawRule draw_rule, float maxrange);
 void stage3d_draw(Stage3D *s, float maxrange, uint nsegments, const Stage3DSegment segments[nsegments]);
 
 void camera3d_init(Camera3D *cam) attr_nonnull(1);
@@ -115,6 +123,18 @@ void camera3d_fill_point_light_uniform_vectors(
 
 void pbr_set_material_uniforms(const PBRMaterial *m, const PBREnvironment *env) attr_nonnull_all;
 void pbr_draw_model(const PBRModel *pmdl, const PBREnvironment *env) attr_nonnull_all;
+
+/*
+ * Draws the model once per position, offset by that position in model space, with as few draw
+ * calls as possible. Equivalent to calling pbr_draw_model() after r_mat_mv_translate_v(pos) for
+ * each position. Requires one of the *_instanced PBR shaders to be bound.
+ */
+void pbr_draw_model_instanced(
+	const PBRModel *pmdl,
+	const PBREnvironment *env,
+	uint num_instances,
+	vec3 positions[num_instances]
+) attr_nonnull(1, 2);
 void pbr_load_model(PBRModel *pmdl, const char *model_name, const char *mat_name);
 
 /*
@@ -165,15 +165,42 @@ double draw_fraction(double value, Alignment a, double pos_x, double pos_y, Font
 	return pos_x;
 }
 
+void framebuffer_viewport_texcoord_ratio(Framebuffer *fb, FramebufferAttachment attachment, vec2 ratio) {
+	// Size of the framebuffer's viewport relative to its attachment, i.e. the texture coordinates
+	// of the viewport's far corner. The viewport is assumed to be anchored at the origin.
+	FloatRect vp;
+	r_framebuffer_viewport_current(fb, &vp);
+
+	uint w, h;
+	r_texture_get_size(r_framebuffer_get_attachment(fb, attachment), 0, &w, &h);
+
+	ratio[0] = vp.w / w;
+	ratio[1] = vp.h / h;
+}
+
+void framebuffer_viewport_texcoord_scale(Framebuffer *fb, FramebufferAttachment attachment) {
+	// Maps [0, 1] texture coordinates onto the framebuffer's viewport, so that a framebuffer
+	// rendered into a sub-rect of its attachments can be sampled as if it was full-sized.
+	vec2 ratio;
+	framebuffer_viewport_texcoord_ratio(fb, attachment, ratio);
+
+	if(ratio[0] != 1 || ratio[1] != 1) {
+		r_mat_tex_scale(ratio[0], ratio[1], 1);
+	}
+}
+
 void draw_framebuffer_attachment(Framebuffer *fb, double width, double height, FramebufferAttachment attachment) {
 	CullFaceMode cull_saved = r_cull_current();
 	r_cull(CULL_BACK);
 
 	r_mat_mv_push();
+	r_mat_tex_push();
 	r_uniform_sampler("tex", r_framebuffer_get_attachment(fb, attachment));
+	framebuffer_viewport_texcoord_scale(fb, attachment);
 	r_mat_mv_scale(width, height, 1);
 	r_mat_mv_translate(0.5, 0.5, 0);
 	r_draw_quad();
+	r_mat_tex_pop();
 	r_mat_mv_pop();
 
 	r_cull(cull_saved);
@@ -48,5 +48,7 @@ typedef struct DrawFragmentsParams {
 
 void draw_fragments(const DrawFragmentsParams *params);
 double draw_fraction(double value, Alignment a, double pos_x, double pos_y, Font *f_int, Font *f_fract, const Color *c_int, const Color *c_fract, bool zero_pad);
+void framebuffer_viewport_texcoord_ratio(Framebuffer *fb, FramebufferAttachment attachment, vec2 ratio);
+void framebuffer_viewport_texcoord_scale(Framebuffer *fb, FramebufferAttachment attachment);
 void draw_framebuffer_tex(Framebuffer *fb, double width, double height);
 void draw_framebuffer_attachment(Framebuffer *fb, double width, double height, FramebufferAttachment attachment);
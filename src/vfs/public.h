@@ -23,6 +23,11 @@ typedef struct VFSInfo {
 	uchar exists      : 1;
 	uchar is_dir      : 1;
 	uchar is_readonly : 1;
+
+	// Only provided by backends that have this information (currently syspath); 0 otherwise.
+	// mtime is in backend-specific units and should only be compared for equality.
+	uint64_t size;
+	int64_t mtime;
 } VFSInfo;
 
 #define VFSINFO_ERROR ((VFSInfo) { .error = true, 0 })
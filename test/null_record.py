@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+
+# Plays a replay on the null renderer with TAISEI_NULL_RECORD set, and checks that every recorded line is a JSON
+# object with the expected counters.
+
+import json
+import os
+import subprocess
+import sys
+
+STATS = (
+    'draws',
+    'instances',
+    'vertices',
+    'buffer_upload_bytes',
+    'texture_fills',
+    'texture_fill_bytes',
+    'clears',
+    'framebuffer_switches',
+    'shader_switches',
+    'state_changes',
+    'uniform_writes',
+    'uniform_write_bytes',
+)
+
+
+def main(taisei, replay, record_path, report_path):
+    env = dict(os.environ, TAISEI_NULL_RECORD=record_path)
+
+    if os.path.exists(record_path):
+        os.remove(record_path)
+
+    subprocess.run([
+        taisei, '-R', replay,
+        '--benchmark', report_path,
+        '--benchmark-render',
+    ], env=env, check=True)
+
+    num_frames = 0
+    total_draws = 0
+
+    with open(record_path, 'r', encoding='utf8') as f:
+        for lineno, line in enumerate(f, 1):
+            try:
+                obj = json.loads(line)
+            except json.JSONDecodeError as e:
+                sys.exit(f'{record_path}:{lineno}: {e}')
+
+            if obj.get('frame') != num_frames:
+                sys.exit(f'{record_path}:{lineno}: expected frame {num_frames}, got {obj.get("frame")!r}')
+
+            for key in STATS:
+                if not isinstance(obj.get(key), int) or obj[key] < 0:
+                    sys.exit(f'{record_path}:{lineno}: bad or missing {key!r}')
+
+            total_draws += obj['draws']
+            num_frames += 1
+
+    if not num_frames:
+        sys.exit(f'{record_path}: no frames recorded')
+
+    if not total_draws:
+        sys.exit(f'{record_path}: no draws recorded in {num_frames} frames')
+
+    print(f'{num_frames} frames, {total_draws} draws')
+
+
+if __name__ == '__main__':
+    main(*sys.argv[1:])
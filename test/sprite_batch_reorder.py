@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+
+# Renders a replay on the null renderer twice, with and without TAISEI_SPRITE_BATCH_REORDER, and checks that
+# reordering reduces the number of draw calls recorded by TAISEI_NULL_RECORD.
+
+import json
+import os
+import subprocess
+import sys
+
+
+def count_draws(taisei, replay, record_path, report_path, reorder):
+    env = dict(
+        os.environ,
+        TAISEI_NULL_RECORD=record_path,
+        TAISEI_SPRITE_BATCH_REORDER=str(int(reorder)),
+    )
+
+    if os.path.exists(record_path):
+        os.remove(record_path)
+
+    subprocess.run([
+        taisei, '-R', replay,
+        '--benchmark', report_path,
+        '--benchmark-render',
+    ], env=env, check=True)
+
+    num_frames = 0
+    total_draws = 0
+
+    with open(record_path, 'r', encoding='utf8') as f:
+        for line in f:
+            total_draws += json.loads(line)['draws']
+            num_frames += 1
+
+    if not total_draws:
+        sys.exit(f'{record_path}: no draws recorded in {num_frames} frames')
+
+    return num_frames, total_draws
+
+
+def main(taisei, replay, outdir):
+    results = {}
+
+    for reorder in (False, True):
+        name = 'reorder' if reorder else 'plain'
+        results[reorder] = count_draws(
+            taisei, replay,
+            os.path.join(outdir, f'sprite-batch-{name}.jsonl'),
+            os.path.join(outdir, f'sprite-batch-{name}-benchmark.json'),
+            reorder,
+        )
+        print(f'{name}: {results[reorder][0]} frames, {results[reorder][1]} draws')
+
+    if results[True][0] != results[False][0]:
+        sys.exit(f'frame counts differ: {results[False][0]} without reordering, {results[True][0]} with')
+
+    if results[True][1] >= results[False][1]:
+        sys.exit(f'reordering did not reduce draws: {results[False][1]} -> {results[True][1]}')
+
+
+if __name__ == '__main__':
+    main(*sys.argv[1:])